@@ -1,143 +1,751 @@
 #include "bufpool.h"
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include "file_util.h"
+#include "fsm_page.h"
 #include "my_sys.h"
-#include "mysql/service_mysql_alloc.h"
-#include "page.h"
 #include "tablespace.h"
 
+PSI_mutex_key prefetch_mutex_key;
+PSI_cond_key prefetch_cond_key;
+PSI_mutex_key buf_pool_resize_mutex_key;
 
-void buf::BufPool::init_buffer_pool(PSI_memory_key, int bufPoolSize) {
-  this->maxPageCount = bufPoolSize;
+/**
+ * Allocates bufPoolSize pages split evenly between the instances, in
+ * chunks of chunkPages frames per instance. Pages are read and written
+ * through an aio engine picked from aioConfig.
+ * @return false if the frames could not be allocated
+ */
+bool buf::BufPool::init_buffer_pool(PSI_memory_key buf, uint64_t bufPoolSize,
+                                    int instanceCount, HugePageMode hugePages,
+                                    uint64_t chunkPages,
+                                    const file_handler::AioConfig &aioConfig) {
+  uint64_t count = instanceCount > 0 ? instanceCount : 1;
+  if (count > MAX_INSTANCE_COUNT) {
+    count = MAX_INSTANCE_COUNT;
+  }
+  this->memoryKey = buf;
+  this->hugePageMode = hugePages;
+  this->chunkPages = chunkPages > 0 ? chunkPages : DEFAULT_CHUNK_PAGES;
+  this->stats.reset(new BufPoolStats());
+  this->tablespaceCache.init();
+  this->aio = file_handler::AioEngine::create(aioConfig);
+  mysql_mutex_init(buf_pool_resize_mutex_key, &this->resizeMutex,
+                   MY_MUTEX_INIT_FAST);
+  mysql_mutex_init(prefetch_mutex_key, &this->prefetchMutex, MY_MUTEX_INIT_FAST);
+  mysql_cond_init(prefetch_cond_key, &this->prefetchCond);
+  for (uint64_t i = 0; i < count; i++) {
+    BufPoolInstance *instance = new BufPoolInstance();
+    instance->init(this->stats.get(), &this->tablespaceCache, this->aio);
+    this->instances.push_back(instance);
+  }
+  if (!resize(bufPoolSize)) {
+    deinit_buffer_pool();
+    return false;
+  }
+  return true;
 }
 
-void buf::BufPool::deinit_buffer_pool() {
-  releaseAllPage();
+/**
+ * Logs the inserts to redoLog from now on. Called before the pool is used
+ * by other threads, nullptr stops logging.
+ */
+void buf::BufPool::setRedoLog(redo::RedoLog *redoLog) {
+  this->redoLog = redoLog;
+  for (BufPoolInstance *instance : this->instances) {
+    instance->setRedoLog(redoLog);
+  }
 }
 
-void buf::BufPool::releaseAllPage() {
-  if (this->elements == nullptr) {
-    return;
+/**
+ * Writes back and syncs every dirty page and releases the pool.
+ * @return false if a page could not be written back or synced, the log
+ * must then be kept from its last checkpoint on
+ */
+bool buf::BufPool::deinit_buffer_pool() {
+  stopReadAhead();
+  bool flushed = true;
+  for (BufPoolInstance *instance : this->instances) {
+    flushed = instance->deinit() && flushed;
+    delete instance;
+  }
+  this->instances.clear();
+  for (FrameArena *chunk : this->chunks) {
+    chunk->deinit();
+    delete chunk;
+  }
+  this->chunks.clear();
+  // the instances flushed their dirty pages through them
+  if (this->aio != nullptr) {
+    this->aio->stop();
+    delete this->aio;
+    this->aio = nullptr;
   }
+  flushed = this->tablespaceCache.syncWritten() && flushed;
+  this->tablespaceCache.deinit();
+  mysql_cond_destroy(&this->prefetchCond);
+  mysql_mutex_destroy(&this->prefetchMutex);
+  mysql_mutex_destroy(&this->resizeMutex);
+  return flushed;
+}
 
-  for(Element *element = this->elements; element != nullptr;) {
-    Element *tmp = element->next;
-    free(element);
-    element = tmp;
+/**
+ * Grows or shrinks the pool to bufPoolSize pages split evenly between the
+ * instances, at least one per instance. Chunks are added while the pool is
+ * smaller and removed while it stays at least as large without them, so a
+ * shrinking pool keeps the chunk bufPoolSize falls into. Pages of a removed
+ * chunk are moved to the remaining frames, or evicted when there is no
+ * room, a batch at a time so that the pool stays usable meanwhile.
+ * @return false if a chunk could not be allocated
+ */
+bool buf::BufPool::resize(uint64_t bufPoolSize) {
+  uint64_t pagesPerInstance =
+      std::max<uint64_t>(bufPoolSize / this->instances.size(), 1);
+  mysql_mutex_lock(&this->resizeMutex);
+  uint64_t currentPages = 0;
+  for (const FrameArena *chunk : this->chunks) {
+    currentPages += getChunkPages(chunk);
+  }
+  bool resized = true;
+  while (currentPages < pagesPerInstance) {
+    uint64_t chunkPages =
+        std::min(this->chunkPages, pagesPerInstance - currentPages);
+    if (!addChunk(chunkPages)) {
+      resized = false;
+      break;
+    }
+    currentPages += chunkPages;
+  }
+  while (this->chunks.size() > 1 &&
+         currentPages - getChunkPages(this->chunks.back()) >=
+             pagesPerInstance) {
+    currentPages -= getChunkPages(this->chunks.back());
+    removeChunk();
   }
+  mysql_mutex_unlock(&this->resizeMutex);
+  return resized;
 }
 
-void buf::BufPool::readFromFile(tablespace_id tablespaceId, page_id pageId,
-                                const char *tablespacePath) {
-  tablespace::TablespaceHandler tablespaceHandler =
-      tablespace::TablespaceHandler(tablespacePath);
-  page::PageHandler pageHandler = page::PageHandler(pageId);
-  pageHandler.readFromFile(tablespaceHandler.getFileDescriptor());
+uint64_t buf::BufPool::getChunkPages(const FrameArena *chunk) const {
+  return chunk->getFrameCount() / this->instances.size();
+}
 
-  Element *newElement = new Element(tablespaceId, pageHandler);
-  Element *lastElement = getLastElement();
-  if (lastElement == nullptr) {
-    this->elements = newElement;
-  } else {
-    lastElement->next = newElement;
+bool buf::BufPool::addChunk(uint64_t pagesPerInstance) {
+  mysql_mutex_assert_owner(&this->resizeMutex);
+  FrameArena *chunk = new FrameArena();
+  if (!chunk->init(this->memoryKey, pagesPerInstance * this->instances.size(),
+                   this->hugePageMode)) {
+    delete chunk;
+    return false;
   }
+  this->chunks.push_back(chunk);
+  for (uint64_t i = 0; i < this->instances.size(); i++) {
+    this->instances[i]->addFrames(chunk->getFrame(i * pagesPerInstance),
+                                  pagesPerInstance);
+  }
+  return true;
 }
 
-buf::Element *buf::BufPool::getLastElement() const {
-  Element *element = this->elements;
-  if (element == nullptr) {
-    return nullptr;
+/**
+ * Withdraws the frames of the last chunk from every instance and unmaps
+ * it. Waits for the pages of the chunk that are pinned or dirty.
+ */
+void buf::BufPool::removeChunk() {
+  mysql_mutex_assert_owner(&this->resizeMutex);
+  FrameArena *chunk = this->chunks.back();
+  uint64_t pagesPerInstance = getChunkPages(chunk);
+  for (uint64_t i = 0; i < this->instances.size(); i++) {
+    this->instances[i]->withdrawFrames(chunk->getFrame(i * pagesPerInstance),
+                                       pagesPerInstance);
   }
-  while(element->next != nullptr) {
-    element = element->next;
+  uint64_t lastRemaining = UINT64_MAX;
+  while (true) {
+    uint64_t remaining = 0;
+    for (BufPoolInstance *instance : this->instances) {
+      remaining += instance->withdrawBatch(RESIZE_BATCH_SIZE);
+    }
+    if (remaining == 0) {
+      break;
+    }
+    if (remaining == lastRemaining) {
+      // only pinned or dirty pages are left, give them time to be released
+      // or written back
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    lastRemaining = remaining;
   }
-  return element;
+  for (BufPoolInstance *instance : this->instances) {
+    instance->releaseWithdrawnFrames();
+  }
+  this->chunks.pop_back();
+  chunk->deinit();
+  delete chunk;
 }
 
-bool buf::BufPool::existPage(tablespace_id tablespaceId, page_id pageId) const {
-  Element *element = this->elements;
-  bool exists = false;
-  if (element == nullptr) {
-    return false;
+buf::BufPoolInstance *buf::BufPool::getInstance(tablespace_id tablespaceId,
+                                                page_id pageId) const {
+  if (this->instances.size() == 1) {
+    return this->instances[0];
+  }
+  size_t hash = PageKeyHash()(PageKey{tablespaceId, pageId / INSTANCE_PAGE_GROUP});
+  return this->instances[hash % this->instances.size()];
+}
+
+buf::PageGuard buf::BufPool::fixPage(tablespace_id tablespaceId,
+                                     page_id pageId,
+                                     const char *tablespacePath,
+                                     LatchMode mode) {
+  return getInstance(tablespaceId, pageId)
+      ->fixPage(tablespaceId, pageId, tablespacePath, mode);
+}
+
+int buf::BufPool::read(uchar *buf, ReadDescriptor readDescriptor) {
+  return getInstance(readDescriptor.tablespaceId, readDescriptor.pageId)
+      ->read(buf, readDescriptor);
+}
+
+/**
+ * Appends the tuple to the page. The free space map learns how much room
+ * a page has only when it turns out full, so that it is not changed on
+ * every write.
+ */
+buf::WriteResult buf::BufPool::write(uchar *buf,
+                                     WriteDescriptor writeDescriptor) {
+  WriteResult result =
+      getInstance(writeDescriptor.tablespaceId, writeDescriptor.pageId)
+          ->write(buf, writeDescriptor);
+  if (result == WriteResult::PAGE_FULL) {
+    updateFreeSpace(writeDescriptor.tablespaceId, writeDescriptor.pageId,
+                    writeDescriptor.tablespacePath);
+  }
+  return result;
+}
+
+/**
+ * Records the free space of pageId in the free space map. Its map page is
+ * only marked dirty when the category of the page changes. It is written
+ * after the redo up to now, so that a page it maps was chained before. A
+ * page given room moves the search hint of findPageWithSpace() back to
+ * its map page.
+ */
+void buf::BufPool::updateFreeSpace(tablespace_id tablespaceId, page_id pageId,
+                                   const char *tablespacePath) {
+  uint32_t freeBytes = 0;
+  {
+    PageGuard guard =
+        fixPage(tablespaceId, pageId, tablespacePath, LatchMode::SHARED);
+    if (!guard.isValid()) {
+      return;
+    }
+    page::Header &header = guard.getPageHandler().getPageHeader();
+    if (header.freeEnd > header.freeBegin) {
+      freeBytes = header.freeEnd - header.freeBegin;
+    }
+  }
+  PageGuard fsmGuard = fixPage(tablespaceId, page::getFsmPageId(pageId),
+                               tablespacePath, LatchMode::EXCLUSIVE);
+  if (!fsmGuard.isValid()) {
+    return;
+  }
+  page::FsmPage fsmPage(fsmGuard.getPageHandler());
+  uint8_t category = page::toFsmCategory(freeBytes);
+  if (!fsmPage.setCategory(pageId, category)) {
+    return;
   }
-  while(true) {
-    if (element->tableSpaceId == tablespaceId &&
-        element->getPageHandler().getPageHeader().id == pageId) {
-      exists = true;
+  lsn_t lsn = this->redoLog != nullptr ? this->redoLog->getCurrentLsn() : 0;
+  fsmGuard.markDirty(lsn);
+  fsmGuard.getPageHandler().getPageHeader().lsn = lsn;
+  // under the latch of the map page, so a search that read it before does
+  // not move the hint past it afterwards
+  if (category > 0) {
+    tablespace::TablespaceGuard tablespace =
+        this->tablespaceCache.get(tablespaceId, tablespacePath);
+    if (tablespace.isValid()) {
+      tablespace.lowerFullFsmPageCount(pageId / page::FSM_LEAF_COUNT);
+    }
+  }
+}
+
+/**
+ * Looks up the free space map for a page with room for a tuple of
+ * tupleSize bytes. The map may be behind, a write to the page can still
+ * find it full. The search starts after the leading map pages of the
+ * tablespace that map every page as full, and moves that hint past the
+ * full ones it finds, so a table filled in page order is not scanned from
+ * its first map page on every full page.
+ * @return the page, MAX_PAGE_ID if the map has none
+ */
+page_id buf::BufPool::findPageWithSpace(tablespace_id tablespaceId,
+                                        uint32_t tupleSize,
+                                        const char *tablespacePath) {
+  uint8_t minCategory = page::toMinFsmCategory(tupleSize);
+  if (minCategory >= page::FSM_CATEGORY_COUNT) {
+    return page::MAX_PAGE_ID;
+  }
+  tablespace::TablespaceGuard tablespace =
+      this->tablespaceCache.get(tablespaceId, tablespacePath);
+  if (!tablespace.isValid()) {
+    return page::MAX_PAGE_ID;
+  }
+  uint64_t filePageCount =
+      page::PageHandler::countPages(tablespace.getFileDescriptor());
+  uint64_t version = 0;
+  uint64_t fullCount = tablespace.getFullFsmPageCount(&version);
+  uint64_t leadingFullCount = fullCount;
+  bool leading = true;
+  page_id pageId = page::MAX_PAGE_ID;
+  for (page_id fsmPageId =
+           page::FIRST_FSM_PAGE_ID + fullCount * page::FSM_LEAF_COUNT;
+       fsmPageId < filePageCount && pageId == page::MAX_PAGE_ID;
+       fsmPageId += page::FSM_LEAF_COUNT) {
+    PageGuard guard =
+        fixPage(tablespaceId, fsmPageId, tablespacePath, LatchMode::SHARED);
+    if (!guard.isValid()) {
+      leading = false;
+      continue;
+    }
+    page::FsmPage fsmPage(guard.getPageHandler());
+    leading = leading && fsmPage.getLargestCategory() == 0;
+    if (leading) {
+      leadingFullCount++;
+    }
+    pageId = fsmPage.findPage(fsmPageId, minCategory);
+  }
+  if (leadingFullCount != fullCount) {
+    tablespace.raiseFullFsmPageCount(leadingFullCount, version);
+  }
+  return pageId;
+}
+
+/**
+ * Chains a new page after lastPageId, once it is full. Pages are chained
+ * in page_id order, the new page is lastPageId + 1, or the page after it
+ * if that one holds free space map. If lastPageId is not the last page
+ * anymore, another thread chained one meanwhile and the last page is
+ * returned instead.
+ *
+ * Pages are chained under the allocation mutex of the tablespace, so
+ * tables grow independently and the chain stays as it is found while the
+ * mutex is held. The file grows EXTENT_PAGE_COUNT empty pages at a time,
+ * synced before the page count of the header is raised and the link to
+ * the first of them is logged, since recovery only applies records to
+ * pages in the file; the last page is only latched exclusively afterwards
+ * to link it. The map page of the new page is always in the file with it.
+ * @return the last page, MAX_PAGE_ID if no page could be chained
+ */
+page_id buf::BufPool::allocatePage(tablespace_id tablespaceId,
+                                   page_id lastPageId,
+                                   const char *tablespacePath) {
+  tablespace::TablespaceGuard tablespace =
+      this->tablespaceCache.get(tablespaceId, tablespacePath);
+  if (!tablespace.isValid()) {
+    return page::MAX_PAGE_ID;
+  }
+  mysql_mutex_lock(tablespace.getAllocateMutex());
+  page_id tailPageId = lastPageId;
+  while (true) {
+    PageGuard guard =
+        fixPage(tablespaceId, tailPageId, tablespacePath, LatchMode::SHARED);
+    if (!guard.isValid()) {
+      tailPageId = page::MAX_PAGE_ID;
       break;
     }
-    if (element->next == nullptr) {
+    page_id nextPageId = guard.getPageHandler().getPage().getNextPageId();
+    if (nextPageId == page::MAX_PAGE_ID) {
       break;
     }
-    element = element->next;
+    tailPageId = nextPageId;
+  }
+  if (tailPageId != lastPageId) {
+    mysql_mutex_unlock(tablespace.getAllocateMutex());
+    return tailPageId;
+  }
+
+  page_id newPageId = lastPageId + 1;
+  if (page::isFsmPage(newPageId)) {
+    newPageId++;
+  }
+  file_handler::FileDescriptor fd = tablespace.getFileDescriptor();
+  tablespace::TablespaceHandler &handler = tablespace.getTablespaceHandler();
+  uint64_t filePageCount = page::PageHandler::countPages(fd);
+  bool grown = true;
+  if (std::max(newPageId, page::getFsmPageId(newPageId)) >= filePageCount) {
+    for (page_id pageId = filePageCount;
+         grown && pageId < newPageId + tablespace::EXTENT_PAGE_COUNT;
+         pageId++) {
+      grown = (page::isFsmPage(pageId)
+                   ? page::PageHandler::reserveNewPage(pageId)
+                   : page::PageHandler::reserveNewPage(
+                         pageId, handler.getSystemPageHeader()))
+                  .flush(fd);
+    }
+    grown = grown && FileUtil::sync(fd) == 0;
+  }
+  tablespace::TablespaceHeaderImpl &header = handler.getTablespaceHeader();
+  uint64_t pageCount = header.getPageCount();
+  if (grown) {
+    header.setPageCount(newPageId + 1);
   }
-  return exists;
+  // empty pages past the old end of the file are all a failure leaves
+  if (!grown || !handler.flushTablespaceHeader()) {
+    header.setPageCount(pageCount);
+    mysql_mutex_unlock(tablespace.getAllocateMutex());
+    return page::MAX_PAGE_ID;
+  }
+
+  PageGuard last =
+      fixPage(tablespaceId, lastPageId, tablespacePath, LatchMode::EXCLUSIVE);
+  if (!last.isValid()) {
+    mysql_mutex_unlock(tablespace.getAllocateMutex());
+    return page::MAX_PAGE_ID;
+  }
+  // on the flush list before the change is logged, see
+  // BufPoolInstance::write()
+  page::PageHandler &pageHandler = last.getPageHandler();
+  last.markDirty(this->redoLog != nullptr ? this->redoLog->getCurrentLsn()
+                                          : 0);
+  pageHandler.getPage().setNextPageId(newPageId);
+  if (this->redoLog != nullptr) {
+    pageHandler.getPageHeader().lsn = this->redoLog->appendNextPage(
+        tablespaceId, lastPageId, tablespacePath, newPageId);
+  }
+  last.release();
+  mysql_mutex_unlock(tablespace.getAllocateMutex());
+  return newPageId;
 }
 
-buf::Element *buf::BufPool::getElement(tablespace_id tablespaceId,
-                                       page_id pageId) {
-  Element *element = this->elements;
-  if (element == nullptr) {
-    return nullptr;
+/**
+ * Finds the last page of a tablespace from hintPageId, the page count of
+ * its header less one. The count is written after the file grows but
+ * before the link to the page is logged, and is not synced, so after a
+ * crash the page may not be chained or a later one may be: page n is
+ * chained if the page before it, free space map pages aside, links to it.
+ */
+page_id buf::BufPool::findLastPage(tablespace_id tablespaceId,
+                                   page_id hintPageId,
+                                   const char *tablespacePath) {
+  uint64_t filePageCount = 0;
+  {
+    tablespace::TablespaceGuard tablespace =
+        this->tablespaceCache.get(tablespaceId, tablespacePath);
+    if (tablespace.isValid()) {
+      filePageCount =
+          page::PageHandler::countPages(tablespace.getFileDescriptor());
+    }
+  }
+  if (filePageCount == 0) {
+    return 0;
   }
-  while(true) {
-    if (element->tableSpaceId == tablespaceId &&
-        element->getPageHandler().getPageHeader().id == pageId) {
-      return element;
+  page_id pageId = std::min<page_id>(hintPageId, filePageCount - 1);
+  while (pageId > 0) {
+    if (!page::isFsmPage(pageId)) {
+      page_id previousPageId = pageId - 1;
+      if (page::isFsmPage(previousPageId)) {
+        previousPageId--;
+      }
+      PageGuard previous = fixPage(tablespaceId, previousPageId,
+                                   tablespacePath, LatchMode::SHARED);
+      if (previous.isValid() &&
+          previous.getPageHandler().getPage().getNextPageId() == pageId) {
+        break;
+      }
     }
-    if (element->next == nullptr) {
-      break;
+    pageId--;
+  }
+  while (true) {
+    PageGuard guard =
+        fixPage(tablespaceId, pageId, tablespacePath, LatchMode::SHARED);
+    if (!guard.isValid() || guard.getPageHandler().getPage().getNextPageId() ==
+                                page::MAX_PAGE_ID) {
+      return pageId;
     }
-    element = element->next;
+    pageId = guard.getPageHandler().getPage().getNextPageId();
+  }
+}
+
+buf::Element *buf::BufPool::getElement(tablespace_id tablespaceId,
+                                       page_id pageId) {
+  return getInstance(tablespaceId, pageId)->getElement(tablespaceId, pageId);
+}
+
+buf::Element *buf::BufPool::putPage(tablespace_id tablespaceId,
+                                    page::PageHandler page,
+                                    const char *tablespacePath) {
+  return getInstance(tablespaceId, page.getPageHeader().id)
+      ->putPage(tablespaceId, page, tablespacePath);
+}
+
+bool buf::BufPool::isLastPage(tablespace_id tablespaceId, page_id pageId,
+                              const char *tablespacePath) {
+  return getInstance(tablespaceId, pageId)
+      ->isLastPage(tablespaceId, pageId, tablespacePath);
+}
+
+bool buf::BufPool::isLastTuple(tablespace_id tablespaceId, page_id pageId,
+                               uint64_t tupleCursor,
+                               const char *tablespacePath) {
+  return getInstance(tablespaceId, pageId)
+      ->isLastTuple(tablespaceId, pageId, tupleCursor, tablespacePath);
+}
+
+bool buf::BufPool::existPage(tablespace_id tablespaceId, page_id pageId) const {
+  return getInstance(tablespaceId, pageId)->existPage(tablespaceId, pageId);
+}
+
+uint64_t buf::BufPool::getInstanceCount() const {
+  return this->instances.size();
+}
+
+uint64_t buf::BufPool::getPageCount() const {
+  uint64_t pageCount = 0;
+  for (BufPoolInstance *instance : this->instances) {
+    pageCount += instance->getPageCount();
+  }
+  return pageCount;
+}
+
+uint64_t buf::BufPool::getMaxPageCount() const {
+  uint64_t maxPageCount = 0;
+  for (BufPoolInstance *instance : this->instances) {
+    maxPageCount += instance->getMaxPageCount();
   }
-  return nullptr;
+  return maxPageCount;
 }
 
-int buf::BufPool::read(uchar *buf, buf::ReadDescriptor readDescriptor) {
-  tablespace_id tablespaceId = readDescriptor.tablespaceId;
-  page_id pageId = readDescriptor.pageId;
+uint64_t buf::BufPool::getDirtyPageCount() const {
+  return this->stats->pagesDirty.load();
+}
+
+uint64_t buf::BufPool::getReadAheadPageCount() const {
+  return this->stats->readAheadPages.load();
+}
+
+uint64_t buf::BufPool::getReadAheadHitCount() const {
+  return this->stats->readAheadHits.load();
+}
 
-  if(!existPage(tablespaceId, pageId)) {
-    readFromFile(tablespaceId, pageId, readDescriptor.tablespacePath);
+uint64_t buf::BufPool::getReadAheadEvictedCount() const {
+  return this->stats->readAheadEvicted.load();
+}
+
+const buf::BufPoolStats &buf::BufPool::getStats() const {
+  return *this->stats;
+}
+
+tablespace::TablespaceCache &buf::BufPool::getTablespaceCache() {
+  return this->tablespaceCache;
+}
+
+const char *buf::BufPool::getAioEngineName() const {
+  return this->aio->getName();
+}
+
+uint64_t buf::BufPool::getOldPageCount() const {
+  uint64_t count = 0;
+  for (BufPoolInstance *instance : this->instances) {
+    count += instance->getOldPageCount();
   }
+  return count;
+}
 
-  Element *targetElement = getElement(tablespaceId, pageId);
-  assert(targetElement != nullptr);
+uint64_t buf::BufPool::getYoungMadeCount() const {
+  uint64_t count = 0;
+  for (BufPoolInstance *instance : this->instances) {
+    count += instance->getYoungMadeCount();
+  }
+  return count;
+}
 
-  page::PageHandler& pageHandler = targetElement->getPageHandler();
-  tuple::Tuple tuple = pageHandler.readTuple(readDescriptor.tupleCursor);
-  memcpy(buf, tuple.getData(), tuple.getSize());
-  return tuple.getSize();
+void buf::BufPool::setOldBlocksPct(uint64_t pct) {
+  for (BufPoolInstance *instance : this->instances) {
+    instance->setOldBlocksPct(pct);
+  }
 }
 
-void buf::BufPool::write(uchar *, buf::WriteDescriptor writeDescriptor) {
-  tablespace_id tablespaceId = writeDescriptor.tablespaceId;
-  page_id pageId = writeDescriptor.pageId;
+void buf::BufPool::setOldBlocksTime(uint64_t milliseconds) {
+  for (BufPoolInstance *instance : this->instances) {
+    instance->setOldBlocksTime(milliseconds);
+  }
+}
 
-  if(!existPage(tablespaceId, pageId)) {
-    readFromFile(tablespaceId, pageId, writeDescriptor.tablespacePath);
+/**
+ * Starts one page cleaner per instance. The flush rate is shared evenly
+ * between them.
+ */
+void buf::BufPool::startPageCleaner(uint64_t pagesPerSecond) {
+  for (BufPoolInstance *instance : this->instances) {
+    instance->startPageCleaner(pagesPerSecond / this->instances.size());
   }
+}
 
-  Element *targetElement = getElement(tablespaceId, pageId);
-  assert(targetElement != nullptr);
+void buf::BufPool::stopPageCleaner() {
+  for (BufPoolInstance *instance : this->instances) {
+    instance->stopPageCleaner();
+  }
+}
 
-  page::PageHandler& pageHandler = targetElement->getPageHandler();
-  pageHandler.insert(*writeDescriptor.tuple);
-  pageHandler.getPage().incrementTupleCount();
+void buf::BufPool::setFlushRate(uint64_t pagesPerSecond) {
+  for (BufPoolInstance *instance : this->instances) {
+    instance->setFlushRate(pagesPerSecond / this->instances.size());
+  }
 }
 
-bool buf::BufPool::isLastPage(tablespace_id tablespaceId, page_id pageId,
-                               const char *tablespacePath) {
-  if(!existPage(tablespaceId, pageId)) {
-    readFromFile(tablespaceId, pageId, tablespacePath);
+/**
+ * Writes back up to maxFlushCount of the dirty pages first changed before
+ * targetLsn, spread over the instances.
+ */
+uint64_t buf::BufPool::flushOldestPages(lsn_t targetLsn,
+                                        uint64_t maxFlushCount) {
+  // an even share each, the checkpoint waits for the slowest instance
+  uint64_t perInstance =
+      std::max<uint64_t>(maxFlushCount / this->instances.size(), 1);
+  uint64_t flushCount = 0;
+  for (BufPoolInstance *instance : this->instances) {
+    flushCount += instance->flushOldestPages(targetLsn, perInstance);
   }
-  Element *cursor = getElement(tablespaceId, pageId);
-  return cursor->getPageHandler().getPage().getNextPageId() == UINT64_MAX;
+  return flushCount;
 }
 
-bool buf::BufPool::isLastTuple(tablespace_id tablespaceId, page_id pageId,
-                                uint64_t tupleId, const char *tablespacePath) {
-  if(!existPage(tablespaceId, pageId)) {
-    readFromFile(tablespaceId, pageId, tablespacePath);
+/**
+ * @return the oldest LSN a page not yet written back may have a change
+ * of, LSN_MAX if every page is clean
+ */
+lsn_t buf::BufPool::getOldestModification() const {
+  lsn_t lsn = LSN_MAX;
+  for (const BufPoolInstance *instance : this->instances) {
+    lsn = std::min(lsn, instance->getOldestModification());
+  }
+  return lsn;
+}
+
+/**
+ * Syncs the tablespace files pages were written to, see
+ * TablespaceCache::syncWritten().
+ */
+bool buf::BufPool::syncWrittenTablespaces() {
+  return this->tablespaceCache.syncWritten();
+}
+
+uint64_t buf::BufPool::flushDirtyPages(uint64_t maxFlushCount) {
+  uint64_t flushCount = 0;
+  for (BufPoolInstance *instance : this->instances) {
+    if (flushCount >= maxFlushCount) {
+      break;
+    }
+    flushCount += instance->flushDirtyPages(maxFlushCount - flushCount);
+  }
+  return flushCount;
+}
+
+void buf::BufPool::flushAllDirtyPages() {
+  for (BufPoolInstance *instance : this->instances) {
+    instance->flushAllDirtyPages();
+  }
+}
+
+void buf::BufPool::startReadAhead() {
+  this->readAheadThread.start(this);
+}
+
+void buf::BufPool::stopReadAhead() {
+  this->readAheadThread.stop();
+}
+
+/**
+ * Asks the read-ahead thread to bring pageCount pages in, starting at
+ * firstPageId. Does nothing unless the thread runs.
+ */
+void buf::BufPool::readAhead(tablespace_id tablespaceId, page_id firstPageId,
+                             uint64_t pageCount, const char *tablespacePath) {
+  if (pageCount == 0) {
+    return;
+  }
+  this->readAheadThread.enqueue(
+      PageRun{tablespaceId, firstPageId, pageCount, tablespacePath});
+}
+
+/**
+ * Brings up to pageCount pages in, starting at firstPageId and stopping at
+ * the end of the tablespace file. Skips tablespaces whose file is gone or
+ * now belongs to another tablespace.
+ * @param readAhead counted in the read-ahead statistics
+ * @return number of pages read
+ */
+uint64_t buf::BufPool::prefetchPages(tablespace_id tablespaceId,
+                                     page_id firstPageId, uint64_t pageCount,
+                                     const char *tablespacePath,
+                                     bool readAhead) {
+  mysql_mutex_lock(&this->prefetchMutex);
+  auto registration = this->prefetchingTablespaces.insert(tablespaceId);
+  mysql_mutex_unlock(&this->prefetchMutex);
+
+  uint64_t filePageCount = 0;
+  {
+    tablespace::TablespaceGuard tablespace =
+        this->tablespaceCache.get(tablespaceId, tablespacePath);
+    if (tablespace.isValid()) {
+      filePageCount =
+          page::PageHandler::countPages(tablespace.getFileDescriptor());
+    }
+  }
+  page_id endPageId = std::min(firstPageId + pageCount, filePageCount);
+  // the pages of a group share an instance, which reads them together.
+  // Every group is submitted before any read is waited for.
+  file_handler::IoBatch batch;
+  for (page_id pageId = firstPageId; pageId < endPageId;) {
+    page_id groupEnd = std::min(
+        (pageId / INSTANCE_PAGE_GROUP + 1) * INSTANCE_PAGE_GROUP, endPageId);
+    getInstance(tablespaceId, pageId)
+        ->submitPrefetch(tablespaceId, pageId, groupEnd - pageId,
+                         tablespacePath, readAhead, batch);
+    pageId = groupEnd;
   }
-  Element *cursor = getElement(tablespaceId, pageId);
-  return cursor->getPageHandler().isLastTuple(tupleId);
+  uint64_t readCount = batch.wait();
+
+  mysql_mutex_lock(&this->prefetchMutex);
+  this->prefetchingTablespaces.erase(registration);
+  mysql_cond_broadcast(&this->prefetchCond);
+  mysql_mutex_unlock(&this->prefetchMutex);
+  return readCount;
+}
+
+/**
+ * @return the most recently used pct percent of the pages of every
+ * instance, each as a run of a single page
+ */
+std::vector<buf::PageRun> buf::BufPool::collectPages(
+    uint64_t pct) const {
+  std::vector<PageRun> pages;
+  for (BufPoolInstance *instance : this->instances) {
+    instance->collectPages(pages, pct);
+  }
+  return pages;
+}
+
+void buf::BufPool::discardTablespace(tablespace_id tablespaceId) {
+  this->readAheadThread.cancel(tablespaceId);
+  mysql_mutex_lock(&this->prefetchMutex);
+  while (this->prefetchingTablespaces.count(tablespaceId) > 0) {
+    mysql_cond_wait(&this->prefetchCond, &this->prefetchMutex);
+  }
+  mysql_mutex_unlock(&this->prefetchMutex);
+  for (BufPoolInstance *instance : this->instances) {
+    instance->discardTablespace(tablespaceId);
+  }
+}
+
+uint64_t buf::BufPool::getChunkCount() const {
+  mysql_mutex_lock(&this->resizeMutex);
+  uint64_t chunkCount = this->chunks.size();
+  mysql_mutex_unlock(&this->resizeMutex);
+  return chunkCount;
+}
+
+const buf::FrameArena &buf::BufPool::getChunk(uint64_t index) const {
+  mysql_mutex_lock(&this->resizeMutex);
+  assert(index < this->chunks.size());
+  const FrameArena *chunk = this->chunks[index];
+  mysql_mutex_unlock(&this->resizeMutex);
+  return *chunk;
 }
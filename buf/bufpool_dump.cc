@@ -0,0 +1,260 @@
+#include "bufpool_dump.h"
+
+#include <algorithm>
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
+
+#include "bufpool.h"
+#include "my_sys.h"
+#include "mysql/psi/mysql_thread.h"
+
+PSI_mutex_key buf_dump_mutex_key;
+PSI_cond_key buf_dump_cond_key;
+PSI_thread_key buf_dump_thread_key;
+
+namespace {
+
+struct DumpedPage {
+  tablespace_id tablespaceId;
+  page_id pageId;
+  std::string tablespacePath;
+};
+
+// the suffix of a dump being written, renamed once complete
+constexpr const char *INCOMPLETE_SUFFIX = ".incomplete";
+
+}
+
+void buf::BufPoolDump::start(bool loadAtStartup, uint64_t dumpInterval) {
+  if (this->running) {
+    return;
+  }
+  this->shutdown = false;
+  this->running = true;
+  this->loadAtStartup = loadAtStartup;
+  this->dumpInterval = dumpInterval;
+  mysql_mutex_init(buf_dump_mutex_key, &this->mutex, MY_MUTEX_INIT_FAST);
+  mysql_cond_init(buf_dump_cond_key, &this->cond);
+
+  my_thread_attr_t attr;
+  my_thread_attr_init(&attr);
+  my_thread_attr_setdetachstate(&attr, MY_THREAD_CREATE_JOINABLE);
+  mysql_thread_create(buf_dump_thread_key, &this->thread, &attr, run, this);
+  my_thread_attr_destroy(&attr);
+}
+
+/**
+ * Stops the thread, aborting a load in progress.
+ */
+void buf::BufPoolDump::stop() {
+  if (!this->running) {
+    return;
+  }
+  mysql_mutex_lock(&this->mutex);
+  this->shutdown = true;
+  mysql_cond_broadcast(&this->cond);
+  mysql_mutex_unlock(&this->mutex);
+
+  my_thread_join(&this->thread, nullptr);
+
+  this->running = false;
+  mysql_cond_destroy(&this->cond);
+  mysql_mutex_destroy(&this->mutex);
+}
+
+void buf::BufPoolDump::setDumpInterval(uint64_t seconds) {
+  if (!this->running) {
+    this->dumpInterval = seconds;
+    return;
+  }
+  mysql_mutex_lock(&this->mutex);
+  this->dumpInterval = seconds;
+  mysql_cond_broadcast(&this->cond);
+  mysql_mutex_unlock(&this->mutex);
+}
+
+void buf::BufPoolDump::setDumpPct(uint64_t pct) {
+  assert(pct > 0 && pct <= 100);
+  this->dumpPct = pct;
+}
+
+bool buf::BufPoolDump::isShuttingDown() {
+  if (!this->running) {
+    return false;
+  }
+  mysql_mutex_lock(&this->mutex);
+  bool shuttingDown = this->shutdown;
+  mysql_mutex_unlock(&this->mutex);
+  return shuttingDown;
+}
+
+/**
+ * Writes one "tablespace_id page_id tablespace_path" line per page, most
+ * recently used first. The file is written aside and renamed, so a crash
+ * while dumping leaves the previous dump in place.
+ * @return false when the file could not be written
+ */
+bool buf::BufPoolDump::dump() {
+  std::vector<PageRun> pages = this->bufPool->collectPages(this->dumpPct);
+
+  std::string incompletePath = this->path + INCOMPLETE_SUFFIX;
+  FILE *file = fopen(incompletePath.c_str(), "w");
+  if (file == nullptr) {
+    return false;
+  }
+  bool written = true;
+  for (const PageRun &page : pages) {
+    if (fprintf(file, "%" PRIu64 " %" PRIu64 " %s\n", page.tablespaceId,
+                page.firstPageId, page.tablespacePath.c_str()) < 0) {
+      written = false;
+      break;
+    }
+  }
+  if (fclose(file) != 0) {
+    written = false;
+  }
+  if (!written || rename(incompletePath.c_str(), this->path.c_str()) != 0) {
+    remove(incompletePath.c_str());
+    return false;
+  }
+  return true;
+}
+
+/**
+ * Reads back the pages of the last dump, sorted so that each tablespace
+ * is read front to back and adjacent pages come in with one prefetch.
+ * Pages of tablespaces dropped since the dump are skipped.
+ * @return number of pages read
+ */
+uint64_t buf::BufPoolDump::load() {
+  this->loadedPageCount = 0;
+  this->loadTotalPageCount = 0;
+  FILE *file = fopen(this->path.c_str(), "r");
+  if (file == nullptr) {
+    // nothing dumped yet
+    this->loadState = LoadState::COMPLETED;
+    return 0;
+  }
+  this->loadState = LoadState::RUNNING;
+
+  std::vector<DumpedPage> pages;
+  char line[FN_REFLEN + 64];
+  while (fgets(line, sizeof(line), file) != nullptr) {
+    uint64_t tablespaceId, pageId;
+    int pathStart;
+    if (sscanf(line, "%" SCNu64 " %" SCNu64 " %n", &tablespaceId, &pageId,
+               &pathStart) != 2) {
+      fclose(file);
+      this->loadState = LoadState::FAILED;
+      return 0;
+    }
+    std::string tablespacePath(line + pathStart);
+    if (!tablespacePath.empty() && tablespacePath.back() == '\n') {
+      tablespacePath.pop_back();
+    }
+    pages.push_back(DumpedPage{tablespaceId, pageId, tablespacePath});
+  }
+  fclose(file);
+
+  // the pool may have shrunk since the dump, keep the most recently used
+  if (pages.size() > this->bufPool->getMaxPageCount()) {
+    pages.resize(this->bufPool->getMaxPageCount());
+  }
+  std::sort(pages.begin(), pages.end(),
+            [](const DumpedPage &a, const DumpedPage &b) {
+              if (a.tablespaceId != b.tablespaceId) {
+                return a.tablespaceId < b.tablespaceId;
+              }
+              return a.pageId < b.pageId;
+            });
+  this->loadTotalPageCount = pages.size();
+
+  uint64_t readCount = 0;
+  size_t i = 0;
+  while (i < pages.size()) {
+    if (isShuttingDown()) {
+      this->loadState = LoadState::ABORTED;
+      return readCount;
+    }
+    // the run of adjacent pages starting at i
+    size_t end = i + 1;
+    while (end < pages.size() && end - i < LOAD_BATCH_SIZE &&
+           pages[end].tablespaceId == pages[i].tablespaceId &&
+           pages[end].pageId == pages[end - 1].pageId + 1) {
+      end++;
+    }
+    readCount += this->bufPool->prefetchPages(
+        pages[i].tablespaceId, pages[i].pageId, end - i,
+        pages[i].tablespacePath.c_str(), false);
+    this->loadedPageCount += end - i;
+    i = end;
+  }
+  this->loadState = LoadState::COMPLETED;
+  return readCount;
+}
+
+buf::LoadState buf::BufPoolDump::getLoadState() const {
+  return this->loadState;
+}
+
+uint64_t buf::BufPoolDump::getLoadedPageCount() const {
+  return this->loadedPageCount;
+}
+
+uint64_t buf::BufPoolDump::getLoadTotalPageCount() const {
+  return this->loadTotalPageCount;
+}
+
+void buf::BufPoolDump::getLoadStatus(char *buf, size_t size) const {
+  switch (this->loadState.load()) {
+    case LoadState::NOT_STARTED:
+      snprintf(buf, size, "not started");
+      break;
+    case LoadState::RUNNING:
+      snprintf(buf, size, "loaded %" PRIu64 "/%" PRIu64 " pages",
+               getLoadedPageCount(), getLoadTotalPageCount());
+      break;
+    case LoadState::COMPLETED:
+      snprintf(buf, size, "completed, %" PRIu64 " pages",
+               getLoadTotalPageCount());
+      break;
+    case LoadState::ABORTED:
+      snprintf(buf, size, "aborted at %" PRIu64 "/%" PRIu64 " pages",
+               getLoadedPageCount(), getLoadTotalPageCount());
+      break;
+    case LoadState::FAILED:
+      snprintf(buf, size, "failed to read %s", this->path.c_str());
+      break;
+  }
+}
+
+void *buf::BufPoolDump::run(void *arg) {
+  my_thread_init();
+  BufPoolDump *bufPoolDump = static_cast<BufPoolDump *>(arg);
+
+  if (bufPoolDump->loadAtStartup) {
+    bufPoolDump->load();
+  }
+
+  mysql_mutex_lock(&bufPoolDump->mutex);
+  while (!bufPoolDump->shutdown) {
+    if (bufPoolDump->dumpInterval == 0) {
+      mysql_cond_wait(&bufPoolDump->cond, &bufPoolDump->mutex);
+      continue;
+    }
+    struct timespec abstime;
+    set_timespec(&abstime, bufPoolDump->dumpInterval);
+    int err = mysql_cond_timedwait(&bufPoolDump->cond, &bufPoolDump->mutex,
+                                   &abstime);
+    if (is_timeout(err) && !bufPoolDump->shutdown) {
+      mysql_mutex_unlock(&bufPoolDump->mutex);
+      bufPoolDump->dump();
+      mysql_mutex_lock(&bufPoolDump->mutex);
+    }
+  }
+  mysql_mutex_unlock(&bufPoolDump->mutex);
+
+  my_thread_end();
+  return nullptr;
+}
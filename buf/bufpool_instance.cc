@@ -0,0 +1,1262 @@
+#include "bufpool_instance.h"
+#include <algorithm>
+#include <chrono>
+#include "my_sys.h"
+#include "my_systime.h"
+#include "mysql/psi/mysql_thread.h"
+#include "mysql/service_mysql_alloc.h"
+#include "page.h"
+#include "pax_page.h"
+#include "tablespace.h"
+
+PSI_mutex_key buf_pool_mutex_key;
+PSI_rwlock_key buf_block_latch_key;
+PSI_cond_key buf_pool_free_element_cond_key;
+PSI_cond_key page_cleaner_cond_key;
+PSI_thread_key page_cleaner_thread_key;
+
+// never 0, which stands for "not accessed yet"
+static uint64_t currentTimeMs() {
+  return std::chrono::duration_cast<std::chrono::milliseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count() + 1;
+}
+
+/**
+ * Sets up an instance without frames, they are given with addFrames().
+ * @param stats counters shared with the other instances of the pool
+ * @param tablespaceCache open files shared with the other instances
+ * @param aio engine shared with the other instances
+ */
+void buf::BufPoolInstance::init(BufPoolStats *stats,
+                                tablespace::TablespaceCache *tablespaceCache,
+                                file_handler::AioEngine *aio) {
+  this->stats = stats;
+  this->tablespaceCache = tablespaceCache;
+  this->aio = aio;
+  this->maxPageCount = 0;
+  this->lruOld = this->lru.end();
+  this->oldCount = 0;
+  mysql_mutex_init(buf_pool_mutex_key, &this->mutex, MY_MUTEX_INIT_FAST);
+  mysql_cond_init(buf_pool_free_element_cond_key, &this->freeElementCond);
+  mysql_cond_init(page_cleaner_cond_key, &this->cleanerCond);
+}
+
+void buf::BufPoolInstance::setRedoLog(redo::RedoLog *redoLog) {
+  this->redoLog = redoLog;
+}
+
+/**
+ * @return false if dirty pages could not be written back and were lost
+ */
+bool buf::BufPoolInstance::deinit() {
+  stopPageCleaner();
+  flushAllDirtyPages();
+  bool flushed = this->flushList.empty();
+  releaseAllPage();
+  mysql_cond_destroy(&this->cleanerCond);
+  mysql_cond_destroy(&this->freeElementCond);
+  mysql_mutex_destroy(&this->mutex);
+  return flushed;
+}
+
+void buf::BufPoolInstance::releaseAllPage() {
+  for (Element *element : this->frames) {
+    mysql_rwlock_destroy(&element->latch);
+    delete element;
+  }
+  this->frames.clear();
+  this->freeElements.clear();
+  this->withdrawingElements.clear();
+  this->withdrawnElements.clear();
+  this->pageTable.clear();
+  this->flushList.clear();
+  this->lru.clear();
+  this->lruOld = this->lru.end();
+  this->oldCount = 0;
+}
+
+/**
+ * Reads a page missing from the pool into a free element. The element is
+ * registered and pinned first, with the mutex released during the read:
+ * lookups of the page wait for it as for a prefetch, those of every other
+ * page go on meanwhile. The caller holds the mutex.
+ * @return nullptr if no element could be freed, or the page could not be
+ * read
+ */
+buf::Element *buf::BufPoolInstance::readFromFile(tablespace_id tablespaceId,
+                                         page_id pageId,
+                                         const char *tablespacePath) {
+  mysql_mutex_assert_owner(&this->mutex);
+  Element *element = allocateElement();
+  if (element == nullptr) {
+    return nullptr;
+  }
+  // allocateElement() may have waited and let another thread read it
+  Element *cached = lookupReadElement(tablespaceId, pageId);
+  if (cached != nullptr) {
+    freeElement(element);
+    accessElement(cached);
+    return cached;
+  }
+  PageKey key{tablespaceId, pageId};
+  element->getPageHandler().getPageHeader().id = pageId;
+  element->tableSpaceId = tablespaceId;
+  element->ioPending = true;
+  element->refCount++;
+  this->pageTable[key] = element;
+  mysql_mutex_unlock(&this->mutex);
+
+  // read straight into the frame. The file may be missing, or the page
+  // past its end, e.g. through a stale hint, or the read may fail.
+  bool read = false;
+  {
+    tablespace::TablespaceGuard tablespace =
+        this->tablespaceCache->get(tablespaceId, tablespacePath);
+    read = tablespace.isValid() && element->getPageHandler().readFromFile(
+                                       tablespace.getFileDescriptor());
+  }
+
+  mysql_mutex_lock(&this->mutex);
+  element->ioPending = false;
+  element->refCount--;
+  mysql_cond_broadcast(&this->freeElementCond);
+  if (!read) {
+    this->pageTable.erase(key);
+    freeElement(element);
+    return nullptr;
+  }
+  this->stats->bytesRead.add(page::PAGE_SIZE);
+  registerReadPage(element, tablespaceId, pageId, tablespacePath);
+  return element;
+}
+
+/**
+ * Caches the page just read into the frame of element.
+ */
+void buf::BufPoolInstance::registerReadPage(Element *element,
+                                            tablespace_id tablespaceId,
+                                            page_id pageId,
+                                            const char *tablespacePath) {
+  mysql_mutex_assert_owner(&this->mutex);
+  element->tableSpaceId = tablespaceId;
+  element->tablespacePath = tablespacePath;
+  element->dirty = false;
+  this->pageTable[PageKey{tablespaceId, pageId}] = element;
+  insertIntoLru(element);
+  // the read itself is the first access
+  element->accessTime = currentTimeMs();
+}
+
+buf::Element *buf::BufPoolInstance::putPage(tablespace_id tablespaceId,
+                                    page::PageHandler page,
+                                    const char *tablespacePath) {
+  mysql_mutex_lock(&this->mutex);
+  Element *element = registerPage(tablespaceId, page, tablespacePath);
+  mysql_mutex_unlock(&this->mutex);
+  return element;
+}
+
+buf::Element *buf::BufPoolInstance::registerPage(tablespace_id tablespaceId,
+                                         page::PageHandler &page,
+                                         const char *tablespacePath) {
+  mysql_mutex_assert_owner(&this->mutex);
+  PageKey key{tablespaceId, page.getPageHeader().id};
+  Element *element = lookupReadElement(tablespaceId, key.pageId);
+  if (element == nullptr) {
+    element = allocateElement();
+    if (element == nullptr) {
+      return nullptr;
+    }
+    this->pageTable[key] = element;
+    insertIntoLru(element);
+  } else {
+    removeFromFlushList(element);
+  }
+  element->tableSpaceId = tablespaceId;
+  element->tablespacePath = tablespacePath;
+  element->pageHandler = page;
+  return element;
+}
+
+/**
+ * Returns an element that is not registered in the page table.
+ * Takes a free one while there are any, otherwise evicts the least
+ * recently used clean element. When every unpinned
+ * element is dirty, waits up to PIN_WAIT_TIMEOUT seconds in all for the
+ * page cleaner to write some of them back. When every element is pinned,
+ * waits up to PIN_WAIT_TIMEOUT seconds for a page guard to be released.
+ * @return nullptr if every element stayed pinned or dirty, or the victim
+ * could not be written back
+ */
+buf::Element *buf::BufPoolInstance::allocateElement() {
+  mysql_mutex_assert_owner(&this->mutex);
+  if (!this->freeElements.empty()) {
+    Element *element = this->freeElements.back();
+    this->freeElements.pop_back();
+    return element;
+  }
+  // set once, every batch of the cleaner wakes the waiters up whether it
+  // wrote anything or not
+  struct timespec flushDeadline;
+  bool flushWaited = false;
+  while (true) {
+    Element *victim = findVictim(false);
+    if (victim == nullptr && !this->cleanerRunning) {
+      // nobody cleans in the background, write the victim back inline
+      victim = findVictim(true);
+      if (victim != nullptr && victim->dirty && !flushElement(victim)) {
+        return nullptr;
+      }
+    }
+    if (victim != nullptr && victim->withdrawing) {
+      evictElement(victim);
+      continue;
+    }
+    if (victim != nullptr) {
+      if (victim->prefetched) {
+        this->stats->readAheadEvicted.add();
+        victim->prefetched = false;
+      }
+      this->stats->pagesEvicted.add();
+      this->pageTable.erase(victim->getPageKey());
+      removeFromLru(victim);
+      return victim;
+    }
+    if (this->flushList.empty()) {
+      struct timespec abstime;
+      set_timespec(&abstime, PIN_WAIT_TIMEOUT);
+      this->unpinWaiters++;
+      int error = mysql_cond_timedwait(&this->freeElementCond, &this->mutex,
+                                       &abstime);
+      this->unpinWaiters--;
+      if (is_timeout(error)) {
+        return nullptr;
+      }
+      continue;
+    }
+    if (!flushWaited) {
+      set_timespec(&flushDeadline, PIN_WAIT_TIMEOUT);
+      flushWaited = true;
+    }
+    this->freeElementWaiters++;
+    mysql_cond_signal(&this->cleanerCond);
+    int error = mysql_cond_timedwait(&this->freeElementCond, &this->mutex,
+                                     &flushDeadline);
+    this->freeElementWaiters--;
+    if (is_timeout(error)) {
+      return nullptr;
+    }
+  }
+}
+
+/**
+ * Puts an element holding no page back for reuse, unless its frame is
+ * being withdrawn.
+ */
+void buf::BufPoolInstance::freeElement(Element *element) {
+  mysql_mutex_assert_owner(&this->mutex);
+  if (element->withdrawing) {
+    this->withdrawnElements.push_back(element);
+  } else {
+    this->freeElements.push_back(element);
+  }
+}
+
+/**
+ * Drops the clean and unpinned page of an element from the pool.
+ */
+void buf::BufPoolInstance::evictElement(Element *element) {
+  mysql_mutex_assert_owner(&this->mutex);
+  assert(element->refCount == 0 && !element->dirty);
+  if (element->prefetched) {
+    this->stats->readAheadEvicted.add();
+    element->prefetched = false;
+  }
+  this->stats->pagesEvicted.add();
+  this->pageTable.erase(element->getPageKey());
+  removeFromLru(element);
+  freeElement(element);
+}
+
+/**
+ * Moves the unpinned page of an element to a free one, keeping its place
+ * in the LRU list and the flush list.
+ */
+void buf::BufPoolInstance::relocateElement(Element *element, Element *target) {
+  mysql_mutex_assert_owner(&this->mutex);
+  assert(element->refCount == 0 && target->refCount == 0);
+  memcpy(target->frame, element->frame, page::PAGE_SIZE);
+  target->tableSpaceId = element->tableSpaceId;
+  target->tablespacePath = std::move(element->tablespacePath);
+  target->old = element->old;
+  target->accessTime = element->accessTime;
+  target->dirty = element->dirty;
+  target->oldestLsn = element->oldestLsn;
+  target->prefetched = element->prefetched;
+  target->lruPosition = element->lruPosition;
+  *target->lruPosition = target;
+  this->pageTable[target->getPageKey()] = target;
+
+  element->old = false;
+  element->dirty = false;
+  element->prefetched = false;
+  freeElement(element);
+}
+
+buf::Element *buf::BufPoolInstance::findVictim(bool allowDirty) {
+  mysql_mutex_assert_owner(&this->mutex);
+  for (auto it = this->lru.rbegin(); it != this->lru.rend(); ++it) {
+    Element *element = *it;
+    if (element->refCount > 0) {
+      continue;
+    }
+    if (element->dirty && !allowDirty) {
+      continue;
+    }
+    return element;
+  }
+  return nullptr;
+}
+
+/**
+ * Puts an element that just got a page at the head of the old segment, or
+ * at the head of the list while there is no old segment.
+ */
+void buf::BufPoolInstance::insertIntoLru(Element *element) {
+  mysql_mutex_assert_owner(&this->mutex);
+  if (this->oldCount > 0) {
+    element->lruPosition = this->lru.insert(this->lruOld, element);
+    element->old = true;
+    this->oldCount++;
+    this->lruOld = element->lruPosition;
+  } else {
+    this->lru.push_front(element);
+    element->lruPosition = this->lru.begin();
+    element->old = false;
+  }
+  element->accessTime = 0;
+  adjustOldSegment();
+}
+
+void buf::BufPoolInstance::removeFromLru(Element *element) {
+  mysql_mutex_assert_owner(&this->mutex);
+  if (element->old) {
+    if (this->lruOld == element->lruPosition) {
+      ++this->lruOld;
+    }
+    this->oldCount--;
+    element->old = false;
+  }
+  this->lru.erase(element->lruPosition);
+  adjustOldSegment();
+}
+
+void buf::BufPoolInstance::makeYoung(Element *element) {
+  mysql_mutex_assert_owner(&this->mutex);
+  if (element->old) {
+    if (this->lruOld == element->lruPosition) {
+      ++this->lruOld;
+    }
+    this->oldCount--;
+    element->old = false;
+    this->youngMadeCount++;
+  }
+  this->lru.splice(this->lru.begin(), this->lru, element->lruPosition);
+  adjustOldSegment();
+}
+
+/**
+ * Moves an accessed element in the LRU list. Old elements are made young
+ * only when accessed again at least oldBlocksTime after their first access.
+ */
+void buf::BufPoolInstance::accessElement(Element *element) {
+  mysql_mutex_assert_owner(&this->mutex);
+  if (!element->old) {
+    if (element->lruPosition != this->lru.begin()) {
+      makeYoung(element);
+    }
+    return;
+  }
+  uint64_t now = currentTimeMs();
+  if (element->accessTime == 0) {
+    element->accessTime = now;
+  } else if (now - element->accessTime >= this->oldBlocksTime) {
+    makeYoung(element);
+  }
+}
+
+/**
+ * Moves the boundary between the segments so that the old one holds
+ * oldBlocksPct of the list. It is only moved once the old segment is off by
+ * more than LRU_OLD_TOLERANCE, otherwise every page entering at the
+ * midpoint would be pushed straight into the young segment.
+ */
+void buf::BufPoolInstance::adjustOldSegment() {
+  uint64_t target = this->maxPageCount >= LRU_OLD_MIN_LEN
+                        ? this->lru.size() * this->oldBlocksPct / 100
+                        : 0;
+  if (this->oldCount + LRU_OLD_TOLERANCE >= target &&
+      this->oldCount <= target + LRU_OLD_TOLERANCE) {
+    return;
+  }
+  while (this->oldCount < target) {
+    --this->lruOld;
+    (*this->lruOld)->old = true;
+    this->oldCount++;
+  }
+  while (this->oldCount > target) {
+    (*this->lruOld)->old = false;
+    ++this->lruOld;
+    this->oldCount--;
+  }
+}
+
+void buf::BufPoolInstance::markDirty(Element *element, lsn_t oldestLsn) {
+  mysql_mutex_lock(&this->mutex);
+  addToFlushList(element, oldestLsn);
+  mysql_mutex_unlock(&this->mutex);
+}
+
+void buf::BufPoolInstance::addToFlushList(Element *element, lsn_t oldestLsn) {
+  mysql_mutex_assert_owner(&this->mutex);
+  if (!element->dirty) {
+    element->dirty = true;
+    element->oldestLsn = oldestLsn;
+    this->flushList.insert(element->getPageKey());
+    this->stats->pagesDirty.add();
+  }
+}
+
+void buf::BufPoolInstance::removeFromFlushList(Element *element) {
+  mysql_mutex_assert_owner(&this->mutex);
+  if (element->dirty) {
+    element->dirty = false;
+    this->flushList.erase(element->getPageKey());
+    this->stats->pagesDirty.add(-1);
+  }
+}
+
+/**
+ * Writes back the dirty and unpinned page of element.
+ * @return false if the page is still dirty, because its records could not
+ * be synced or the page could not be written
+ */
+bool buf::BufPoolInstance::flushElement(Element *element) {
+  mysql_mutex_assert_owner(&this->mutex);
+  tablespace::TablespaceGuard tablespace = this->tablespaceCache->get(
+      element->tableSpaceId, element->tablespacePath.c_str());
+  // the tablespace was dropped, there is nothing to write back to
+  if (!tablespace.isValid()) {
+    removeFromFlushList(element);
+    return true;
+  }
+  if (this->redoLog != nullptr &&
+      !this->redoLog->flushUpTo(
+          element->getPageHandler().getPageHeader().lsn)) {
+    return false;
+  }
+  bool flushed =
+      element->getPageHandler().flush(tablespace.getFileDescriptor());
+  tablespace.markWritten();
+  if (!flushed) {
+    return false;
+  }
+  removeFromFlushList(element);
+  this->stats->pagesFlushed.add();
+  this->stats->bytesWritten.add(page::PAGE_SIZE);
+  return true;
+}
+
+/**
+ * Writes back up to maxFlushCount dirty pages in (tablespace_id, page_id)
+ * order, only those first changed before targetLsn. The pages are pinned
+ * under the pool mutex and written without it; each run of adjacent pages
+ * of a tablespace goes out from the frames in one vectored write, and the
+ * runs are submitted together to the aio engine. The pages stay latched
+ * shared until every write completed. A page modified after its dirty
+ * flag was cleared here is put back on the flush list by its writer, one
+ * whose write failed or came back short by this function, with the LSN of
+ * its first change.
+ * @return number of written pages, or of pages of dropped tablespaces
+ */
+uint64_t buf::BufPoolInstance::flushBatch(uint64_t maxFlushCount,
+                                          lsn_t targetLsn) {
+  std::vector<Element *> batch;
+  std::vector<PageKey> keys;
+  std::vector<std::string> paths;
+  std::vector<uchar *> frames;
+  std::vector<lsn_t> oldestLsns;
+
+  mysql_mutex_lock(&this->mutex);
+  for (auto it = this->flushList.begin();
+       it != this->flushList.end() && batch.size() < maxFlushCount;) {
+    Element *element = lookupElement(it->tablespaceId, it->pageId);
+    assert(element != nullptr && element->dirty);
+    if (element->oldestLsn >= targetLsn) {
+      ++it;
+      continue;
+    }
+    // keeps the element from being evicted and re-read before it is written
+    element->refCount++;
+    element->dirty = false;
+    // holds the checkpoint back until the page is written
+    oldestLsns.push_back(element->oldestLsn);
+    this->flushingLsns.insert(element->oldestLsn);
+    batch.push_back(element);
+    keys.push_back(*it);
+    paths.push_back(element->tablespacePath);
+    it = this->flushList.erase(it);
+    this->stats->pagesDirty.add(-1);
+  }
+  mysql_mutex_unlock(&this->mutex);
+
+  for (Element *element : batch) {
+    frames.push_back(element->frame);
+  }
+  // in page order, writers only ever latch a single page
+  std::vector<bool> latched(batch.size(), false);
+  // set by the callbacks, a byte per page so that they never share one
+  std::vector<uint8_t> written(batch.size(), 0);
+  std::vector<file_handler::IoRequest> requests;
+  // the files written to, marked so that a checkpoint syncs them first
+  std::vector<std::shared_ptr<tablespace::TablespaceGuard>> tablespaces;
+  file_handler::IoBatch ioBatch;
+  // the records of every latched page, synced before any page is written
+  lsn_t maxLsn = 0;
+  for (size_t begin = 0; begin < batch.size();) {
+    // kept open until the write completed
+    auto tablespace = std::make_shared<tablespace::TablespaceGuard>(
+        this->tablespaceCache->get(keys[begin].tablespaceId,
+                                   paths[begin].c_str()));
+    size_t end = begin + 1;
+    while (end < batch.size() &&
+           keys[end].tablespaceId == keys[begin].tablespaceId &&
+           keys[end].pageId == keys[end - 1].pageId + 1) {
+      end++;
+    }
+    // the tablespace was dropped, there is nothing to write back to
+    if (tablespace->isValid()) {
+      for (size_t i = begin; i < end; i++) {
+        mysql_rwlock_rdlock(&batch[i]->latch);
+        latched[i] = true;
+        maxLsn = std::max(maxLsn,
+                          batch[i]->getPageHandler().getPageHeader().lsn);
+      }
+      requests.push_back(page::PageHandler::flushRequest(
+          tablespace->getFileDescriptor(), keys[begin].pageId,
+          frames.data() + begin, end - begin,
+          [&ioBatch, &written, begin, end, tablespace](size_t size) {
+            bool done = size == (end - begin) * page::PAGE_SIZE;
+            if (done) {
+              std::fill(written.begin() + begin, written.begin() + end, 1);
+            }
+            ioBatch.complete(done ? end - begin : 0);
+          }));
+      tablespaces.push_back(tablespace);
+    } else {
+      std::fill(written.begin() + begin, written.begin() + end, 1);
+    }
+    begin = end;
+  }
+  // no page is written before its records, every one goes back on the
+  // flush list
+  if (this->redoLog != nullptr && !this->redoLog->flushUpTo(maxLsn)) {
+    requests.clear();
+    tablespaces.clear();
+    for (size_t i = 0; i < batch.size(); i++) {
+      written[i] = !latched[i];
+    }
+  }
+  ioBatch.add(requests.size());
+  this->aio->submit(requests);
+  uint64_t writtenCount = ioBatch.wait();
+  for (size_t i = 0; i < batch.size(); i++) {
+    if (latched[i]) {
+      mysql_rwlock_unlock(&batch[i]->latch);
+    }
+  }
+  // before the pages stop holding the checkpoint back
+  for (std::shared_ptr<tablespace::TablespaceGuard> &tablespace :
+       tablespaces) {
+    tablespace->markWritten();
+  }
+
+  this->stats->pagesFlushed.add(writtenCount);
+  this->stats->bytesWritten.add(writtenCount * page::PAGE_SIZE);
+
+  uint64_t doneCount = 0;
+  mysql_mutex_lock(&this->mutex);
+  for (size_t i = 0; i < batch.size(); i++) {
+    batch[i]->refCount--;
+    if (written[i]) {
+      doneCount++;
+      continue;
+    }
+    // the page was written meanwhile if it is dirty again, still holding
+    // changes from before that
+    addToFlushList(batch[i], oldestLsns[i]);
+    batch[i]->oldestLsn = std::min(batch[i]->oldestLsn, oldestLsns[i]);
+  }
+  for (lsn_t lsn : oldestLsns) {
+    this->flushingLsns.erase(this->flushingLsns.find(lsn));
+  }
+  mysql_cond_broadcast(&this->freeElementCond);
+  mysql_mutex_unlock(&this->mutex);
+  return doneCount;
+}
+
+uint64_t buf::BufPoolInstance::flushDirtyPages(uint64_t maxFlushCount) {
+  return flushBatch(maxFlushCount);
+}
+
+/**
+ * Writes back up to maxFlushCount of the dirty pages first changed before
+ * targetLsn, so that a checkpoint can advance to it.
+ */
+uint64_t buf::BufPoolInstance::flushOldestPages(lsn_t targetLsn,
+                                                uint64_t maxFlushCount) {
+  return flushBatch(maxFlushCount, targetLsn);
+}
+
+/**
+ * @return the oldestLsn of the pages not yet written back, LSN_MAX if
+ * every page is clean
+ */
+lsn_t buf::BufPoolInstance::getOldestModification() const {
+  mysql_mutex_lock(&this->mutex);
+  lsn_t lsn = this->flushingLsns.empty() ? LSN_MAX
+                                         : *this->flushingLsns.begin();
+  for (const PageKey &key : this->flushList) {
+    lsn = std::min(lsn,
+                   lookupElement(key.tablespaceId, key.pageId)->oldestLsn);
+  }
+  mysql_mutex_unlock(&this->mutex);
+  return lsn;
+}
+
+void buf::BufPoolInstance::flushAllDirtyPages() {
+  while (flushBatch(getMaxPageCount()) > 0) {
+  }
+}
+
+/**
+ * Hands the frames of a new buffer pool chunk to the instance.
+ * @param frameRegion frameCount page images, a part of the chunk
+ */
+void buf::BufPoolInstance::addFrames(uchar *frameRegion, uint64_t frameCount) {
+  mysql_mutex_lock(&this->mutex);
+  this->maxPageCount += frameCount;
+  this->pageTable.reserve(this->maxPageCount);
+  std::vector<Element *> newElements;
+  newElements.reserve(frameCount);
+  for (uint64_t i = frameCount; i > 0; i--) {
+    Element *element = new Element(frameRegion + (i - 1) * page::PAGE_SIZE);
+    mysql_rwlock_init(buf_block_latch_key, &element->latch);
+    newElements.push_back(element);
+  }
+  this->frames.insert(this->frames.end(), newElements.begin(),
+                      newElements.end());
+  // handed out in frame order, after the frames of the older chunks, which
+  // are the last ones to be withdrawn
+  this->freeElements.insert(this->freeElements.begin(), newElements.begin(),
+                            newElements.end());
+  adjustOldSegment();
+  // threads waiting for a free element can take one of the new ones
+  mysql_cond_broadcast(&this->freeElementCond);
+  mysql_mutex_unlock(&this->mutex);
+}
+
+/**
+ * Starts giving back the frames of a chunk. Their elements are no longer
+ * handed out; the pages they hold are moved out by withdrawBatch().
+ * @param frameRegion frameCount page images, a part of the chunk
+ */
+void buf::BufPoolInstance::withdrawFrames(uchar *frameRegion,
+                                          uint64_t frameCount) {
+  uchar *frameRegionEnd = frameRegion + frameCount * page::PAGE_SIZE;
+  mysql_mutex_lock(&this->mutex);
+  assert(this->maxPageCount > frameCount);
+  for (Element *element : this->frames) {
+    if (element->frame >= frameRegion && element->frame < frameRegionEnd) {
+      element->withdrawing = true;
+      this->withdrawingElements.push_back(element);
+    }
+  }
+  assert(this->withdrawingElements.size() == frameCount);
+  auto firstWithdrawn =
+      std::stable_partition(this->freeElements.begin(), this->freeElements.end(),
+                            [](Element *element) { return !element->withdrawing; });
+  this->withdrawnElements.insert(this->withdrawnElements.end(), firstWithdrawn,
+                                 this->freeElements.end());
+  this->freeElements.erase(firstWithdrawn, this->freeElements.end());
+  this->maxPageCount -= frameCount;
+  adjustOldSegment();
+  mysql_mutex_unlock(&this->mutex);
+}
+
+/**
+ * Frees up to maxCount elements of the frames being withdrawn. Their
+ * pages are moved to free elements, made free by evicting from the LRU
+ * tail, so the most recently used pages stay cached. Pinned pages are
+ * retried by the next batch, dirty ones once they were written back.
+ * @return number of elements of the withdrawn frames still in use
+ */
+uint64_t buf::BufPoolInstance::withdrawBatch(uint64_t maxCount) {
+  mysql_mutex_lock(&this->mutex);
+  uint64_t count = 0;
+  for (auto it = this->withdrawingElements.begin();
+       it != this->withdrawingElements.end() && count < maxCount;) {
+    Element *element = *it;
+    if (lookupElement(element->tableSpaceId,
+                      element->getPageHandler().getPageHeader().id) !=
+        element) {
+      // freed since
+      it = this->withdrawingElements.erase(it);
+      continue;
+    }
+    if (element->refCount > 0) {
+      ++it;
+      continue;
+    }
+    count++;
+    if (this->freeElements.empty()) {
+      Element *victim = findVictim(false);
+      if (victim != nullptr && victim != element) {
+        evictElement(victim);
+      }
+    }
+    if (!this->freeElements.empty()) {
+      Element *target = this->freeElements.back();
+      this->freeElements.pop_back();
+      relocateElement(element, target);
+    } else if (!element->dirty) {
+      evictElement(element);
+    } else if (this->cleanerRunning) {
+      mysql_cond_signal(&this->cleanerCond);
+      ++it;
+      continue;
+    } else if (flushElement(element)) {
+      evictElement(element);
+    } else {
+      ++it;
+      continue;
+    }
+    it = this->withdrawingElements.erase(it);
+  }
+  uint64_t remaining = this->withdrawingElements.size();
+  mysql_mutex_unlock(&this->mutex);
+  return remaining;
+}
+
+/**
+ * Deletes the elements of the withdrawn frames, once withdrawBatch() freed
+ * all of them. The chunk can be unmapped afterwards.
+ */
+void buf::BufPoolInstance::releaseWithdrawnFrames() {
+  mysql_mutex_lock(&this->mutex);
+  assert(this->withdrawingElements.empty());
+  this->frames.erase(
+      std::remove_if(this->frames.begin(), this->frames.end(),
+                     [](Element *element) { return element->withdrawing; }),
+      this->frames.end());
+  for (Element *element : this->withdrawnElements) {
+    mysql_rwlock_destroy(&element->latch);
+    delete element;
+  }
+  this->withdrawnElements.clear();
+  mysql_mutex_unlock(&this->mutex);
+}
+
+/**
+ * Drops every cached page of a tablespace without writing it back.
+ * Called before the tablespace file is removed.
+ */
+void buf::BufPoolInstance::discardTablespace(tablespace_id tablespaceId) {
+  mysql_mutex_lock(&this->mutex);
+  while (true) {
+    bool pinned = false;
+    for (auto it = this->pageTable.begin(); it != this->pageTable.end();) {
+      Element *element = it->second;
+      if (element->tableSpaceId != tablespaceId) {
+        ++it;
+        continue;
+      }
+      if (element->refCount > 0) {
+        // a page guard may be held across calls, wait for its release
+        pinned = true;
+        ++it;
+        continue;
+      }
+      removeFromFlushList(element);
+      element->prefetched = false;
+      removeFromLru(element);
+      freeElement(element);
+      it = this->pageTable.erase(it);
+    }
+    if (!pinned) {
+      break;
+    }
+    this->unpinWaiters++;
+    mysql_cond_wait(&this->freeElementCond, &this->mutex);
+    this->unpinWaiters--;
+  }
+  mysql_mutex_unlock(&this->mutex);
+}
+
+void *buf::BufPoolInstance::runPageCleaner(void *arg) {
+  my_thread_init();
+  BufPoolInstance *bufPool = static_cast<BufPoolInstance *>(arg);
+
+  mysql_mutex_lock(&bufPool->mutex);
+  // the last batch found dirty pages but could write none of them back
+  bool wroteNothing = false;
+  while (!bufPool->cleanerShutdown) {
+    // flush right away while foreground threads wait for a clean element,
+    // otherwise flushRate pages once a second. After a batch that wrote
+    // nothing the waiters do not cut the second short, retrying the writes
+    // back to back would only keep the disk and the mutex busy.
+    if (wroteNothing || bufPool->freeElementWaiters == 0 ||
+        bufPool->flushList.empty()) {
+      struct timespec abstime;
+      set_timespec(&abstime, 1);
+      int error;
+      do {
+        error = mysql_cond_timedwait(&bufPool->cleanerCond, &bufPool->mutex,
+                                     &abstime);
+      } while (wroteNothing && !is_timeout(error) &&
+               !bufPool->cleanerShutdown);
+      if (bufPool->cleanerShutdown) {
+        break;
+      }
+    }
+    uint64_t flushRate = bufPool->flushRate;
+    bool dirty = !bufPool->flushList.empty();
+    mysql_mutex_unlock(&bufPool->mutex);
+    wroteNothing = bufPool->flushBatch(flushRate) == 0 && dirty;
+    mysql_mutex_lock(&bufPool->mutex);
+  }
+  mysql_mutex_unlock(&bufPool->mutex);
+
+  my_thread_end();
+  return nullptr;
+}
+
+uint64_t buf::BufPoolInstance::getOldPageCount() const {
+  mysql_mutex_lock(&this->mutex);
+  uint64_t count = this->oldCount;
+  mysql_mutex_unlock(&this->mutex);
+  return count;
+}
+
+uint64_t buf::BufPoolInstance::getYoungMadeCount() const {
+  mysql_mutex_lock(&this->mutex);
+  uint64_t count = this->youngMadeCount;
+  mysql_mutex_unlock(&this->mutex);
+  return count;
+}
+
+void buf::BufPoolInstance::setOldBlocksPct(uint64_t pct) {
+  mysql_mutex_lock(&this->mutex);
+  this->oldBlocksPct = pct;
+  adjustOldSegment();
+  mysql_mutex_unlock(&this->mutex);
+}
+
+void buf::BufPoolInstance::setOldBlocksTime(uint64_t milliseconds) {
+  mysql_mutex_lock(&this->mutex);
+  this->oldBlocksTime = milliseconds;
+  mysql_mutex_unlock(&this->mutex);
+}
+
+void buf::BufPoolInstance::startPageCleaner(uint64_t pagesPerSecond) {
+  mysql_mutex_lock(&this->mutex);
+  if (this->cleanerRunning) {
+    mysql_mutex_unlock(&this->mutex);
+    return;
+  }
+  this->flushRate = pagesPerSecond > 0 ? pagesPerSecond : 1;
+  this->cleanerShutdown = false;
+  this->cleanerRunning = true;
+  mysql_mutex_unlock(&this->mutex);
+
+  my_thread_attr_t attr;
+  my_thread_attr_init(&attr);
+  my_thread_attr_setdetachstate(&attr, MY_THREAD_CREATE_JOINABLE);
+  mysql_thread_create(page_cleaner_thread_key, &this->cleanerThread, &attr,
+                      runPageCleaner, this);
+  my_thread_attr_destroy(&attr);
+}
+
+void buf::BufPoolInstance::stopPageCleaner() {
+  mysql_mutex_lock(&this->mutex);
+  if (!this->cleanerRunning) {
+    mysql_mutex_unlock(&this->mutex);
+    return;
+  }
+  this->cleanerShutdown = true;
+  mysql_cond_signal(&this->cleanerCond);
+  mysql_mutex_unlock(&this->mutex);
+
+  my_thread_join(&this->cleanerThread, nullptr);
+
+  mysql_mutex_lock(&this->mutex);
+  this->cleanerRunning = false;
+  // waiters fall back to writing their victim back themselves
+  mysql_cond_broadcast(&this->freeElementCond);
+  mysql_mutex_unlock(&this->mutex);
+}
+
+void buf::BufPoolInstance::setFlushRate(uint64_t pagesPerSecond) {
+  mysql_mutex_lock(&this->mutex);
+  this->flushRate = pagesPerSecond > 0 ? pagesPerSecond : 1;
+  mysql_mutex_unlock(&this->mutex);
+}
+
+buf::Element *buf::BufPoolInstance::fetchElement(tablespace_id tablespaceId,
+                                         page_id pageId,
+                                         const char *tablespacePath) {
+  mysql_mutex_assert_owner(&this->mutex);
+  this->stats->pageLookups.add();
+  Element *element = lookupReadElement(tablespaceId, pageId);
+  if (element == nullptr) {
+    this->stats->pageMisses.add();
+    return readFromFile(tablespaceId, pageId, tablespacePath);
+  }
+  this->stats->pageHits.add();
+  if (element->prefetched) {
+    this->stats->readAheadHits.add();
+    element->prefetched = false;
+  }
+  accessElement(element);
+  return element;
+}
+
+buf::Element *buf::BufPoolInstance::lookupElement(tablespace_id tablespaceId,
+                                          page_id pageId) const {
+  auto it = this->pageTable.find(PageKey{tablespaceId, pageId});
+  if (it == this->pageTable.end()) {
+    return nullptr;
+  }
+  return it->second;
+}
+
+/**
+ * Like lookupElement(), but waits for a read of the page in progress to
+ * complete first.
+ */
+buf::Element *buf::BufPoolInstance::lookupReadElement(
+    tablespace_id tablespaceId, page_id pageId) {
+  mysql_mutex_assert_owner(&this->mutex);
+  Element *element = lookupElement(tablespaceId, pageId);
+  while (element != nullptr && element->ioPending) {
+    this->unpinWaiters++;
+    mysql_cond_wait(&this->freeElementCond, &this->mutex);
+    this->unpinWaiters--;
+    // the read may have failed and freed the element
+    element = lookupElement(tablespaceId, pageId);
+  }
+  return element;
+}
+
+bool buf::BufPoolInstance::existPage(tablespace_id tablespaceId, page_id pageId) const {
+  mysql_mutex_lock(&this->mutex);
+  bool exists = lookupElement(tablespaceId, pageId) != nullptr;
+  mysql_mutex_unlock(&this->mutex);
+  return exists;
+}
+
+buf::Element *buf::BufPoolInstance::getElement(tablespace_id tablespaceId,
+                                       page_id pageId) {
+  mysql_mutex_lock(&this->mutex);
+  Element *element = lookupReadElement(tablespaceId, pageId);
+  mysql_mutex_unlock(&this->mutex);
+  return element;
+}
+
+uint64_t buf::BufPoolInstance::getPageCount() const {
+  mysql_mutex_lock(&this->mutex);
+  uint64_t pageCount = this->pageTable.size();
+  mysql_mutex_unlock(&this->mutex);
+  return pageCount;
+}
+
+uint64_t buf::BufPoolInstance::getMaxPageCount() const {
+  mysql_mutex_lock(&this->mutex);
+  uint64_t maxPageCount = this->maxPageCount;
+  mysql_mutex_unlock(&this->mutex);
+  return maxPageCount;
+}
+
+/**
+ * Pins a page, reading it from the tablespace file when it is not cached,
+ * and latches it in the given mode. The latch is taken after the pool mutex
+ * is released, so waiting for it never blocks other pages of the instance.
+ * @return an invalid guard if every element of the instance is pinned or
+ * the tablespace file is gone
+ */
+buf::PageGuard buf::BufPoolInstance::fixPage(tablespace_id tablespaceId,
+                                             page_id pageId,
+                                             const char *tablespacePath,
+                                             LatchMode mode) {
+  mysql_mutex_lock(&this->mutex);
+  Element *element = fetchElement(tablespaceId, pageId, tablespacePath);
+  if (element == nullptr) {
+    mysql_mutex_unlock(&this->mutex);
+    return PageGuard();
+  }
+  element->refCount++;
+  mysql_mutex_unlock(&this->mutex);
+
+  if (mode == LatchMode::SHARED) {
+    mysql_rwlock_rdlock(&element->latch);
+  } else {
+    mysql_rwlock_wrlock(&element->latch);
+  }
+  return PageGuard(this, element, mode);
+}
+
+void buf::BufPoolInstance::unfixPage(Element *element) {
+  mysql_rwlock_unlock(&element->latch);
+
+  mysql_mutex_lock(&this->mutex);
+  assert(element->refCount > 0);
+  element->refCount--;
+  if (element->refCount == 0 && this->unpinWaiters > 0) {
+    mysql_cond_broadcast(&this->freeElementCond);
+  }
+  mysql_mutex_unlock(&this->mutex);
+}
+
+/**
+ * Brings the uncached pages of a range in the background, each run of
+ * adjacent ones with a single vectored read. The elements are registered
+ * and pinned until their read completes, lookups of those pages wait for
+ * it. The pages count as not accessed yet, they stay in the old segment
+ * until they are used. Stops when no element can be freed.
+ * @param readAhead counted in the read-ahead statistics
+ * @param batch completed with the number of pages read
+ */
+void buf::BufPoolInstance::submitPrefetch(tablespace_id tablespaceId,
+                                          page_id firstPageId,
+                                          uint64_t pageCount,
+                                          const char *tablespacePath,
+                                          bool readAhead,
+                                          file_handler::IoBatch &batch) {
+  // kept open until every read completed
+  auto tablespace = std::make_shared<tablespace::TablespaceGuard>(
+      this->tablespaceCache->get(tablespaceId, tablespacePath));
+  if (!tablespace->isValid()) {
+    return;
+  }
+  std::string path(tablespacePath);
+  mysql_mutex_lock(&this->mutex);
+  page_id endPageId = firstPageId + pageCount;
+  page_id pageId = firstPageId;
+  bool outOfElements = false;
+  while (!outOfElements && pageId < endPageId) {
+    if (lookupElement(tablespaceId, pageId) != nullptr) {
+      pageId++;
+      continue;
+    }
+    // the uncached pages from pageId on, read together
+    page_id runStart = pageId;
+    auto run = std::make_shared<std::vector<Element *>>();
+    std::vector<uchar *> frames;
+    while (pageId < endPageId) {
+      Element *element = allocateElement();
+      if (element == nullptr) {
+        outOfElements = true;
+        break;
+      }
+      // allocateElement() may have waited and let another thread read it
+      if (lookupElement(tablespaceId, pageId) != nullptr) {
+        freeElement(element);
+        break;
+      }
+      element->getPageHandler().getPageHeader().id = pageId;
+      element->tableSpaceId = tablespaceId;
+      element->ioPending = true;
+      element->refCount++;
+      this->pageTable[PageKey{tablespaceId, pageId}] = element;
+      run->push_back(element);
+      frames.push_back(element->frame);
+      pageId++;
+    }
+    if (run->empty()) {
+      continue;
+    }
+    std::vector<file_handler::IoRequest> requests;
+    requests.push_back(page::PageHandler::readRequest(
+        tablespace->getFileDescriptor(), runStart, frames.data(),
+        frames.size(),
+        [this, run, tablespaceId, runStart, path, readAhead, &batch,
+         tablespace](size_t readSize) {
+          completePrefetch(*run, tablespaceId, runStart, path, readAhead,
+                           readSize, batch);
+        }));
+    // never submitted under the mutex, completions take it. Submitting each
+    // run right away also lets allocateElement() wait for earlier ones.
+    batch.add(requests.size());
+    mysql_mutex_unlock(&this->mutex);
+    this->aio->submit(requests);
+    mysql_mutex_lock(&this->mutex);
+  }
+  mysql_mutex_unlock(&this->mutex);
+}
+
+/**
+ * Caches the pages of a run whose read completed, and frees the elements
+ * of pages beyond the end of the file.
+ */
+void buf::BufPoolInstance::completePrefetch(std::vector<Element *> &run,
+                                            tablespace_id tablespaceId,
+                                            page_id firstPageId,
+                                            const std::string &tablespacePath,
+                                            bool readAhead, size_t readSize,
+                                            file_handler::IoBatch &batch) {
+  uint64_t pagesRead = readSize == MY_FILE_ERROR ? 0 : readSize / page::PAGE_SIZE;
+  mysql_mutex_lock(&this->mutex);
+  for (size_t i = 0; i < run.size(); i++) {
+    Element *element = run[i];
+    element->ioPending = false;
+    element->refCount--;
+    if (i >= pagesRead) {
+      this->pageTable.erase(PageKey{tablespaceId, firstPageId + i});
+      freeElement(element);
+      continue;
+    }
+    registerReadPage(element, tablespaceId, firstPageId + i,
+                     tablespacePath.c_str());
+    element->accessTime = 0;
+    if (readAhead) {
+      element->prefetched = true;
+      this->stats->readAheadPages.add();
+    }
+  }
+  this->stats->bytesRead.add(pagesRead * page::PAGE_SIZE);
+  mysql_cond_broadcast(&this->freeElementCond);
+  mysql_mutex_unlock(&this->mutex);
+  batch.complete(pagesRead < run.size() ? pagesRead : run.size());
+}
+
+/**
+ * Appends the most recently used pct percent of the cached pages, most
+ * recently used first.
+ */
+void buf::BufPoolInstance::collectPages(std::vector<PageRun> &pages,
+                                        uint64_t pct) const {
+  mysql_mutex_lock(&this->mutex);
+  uint64_t count = (this->lru.size() * pct + 99) / 100;
+  for (auto it = this->lru.begin(); it != this->lru.end() && count > 0;
+       ++it, count--) {
+    Element *element = *it;
+    pages.push_back(PageRun{element->tableSpaceId,
+                            element->getPageHandler().getPageHeader().id, 1,
+                            element->tablespacePath});
+  }
+  mysql_mutex_unlock(&this->mutex);
+}
+
+int buf::BufPoolInstance::read(uchar *buf, buf::ReadDescriptor readDescriptor) {
+  PageGuard guard = fixPage(readDescriptor.tablespaceId, readDescriptor.pageId,
+                            readDescriptor.tablespacePath, LatchMode::SHARED);
+  if (!guard.isValid()) {
+    return -1;
+  }
+  page::PageHandler &pageHandler = guard.getPageHandler();
+  if (pageHandler.isPax()) {
+    return page::PaxPage(pageHandler.getPageBody())
+        .readRow(readDescriptor.tupleCursor, buf);
+  }
+  tuple::TupleView tuple = pageHandler.viewTuple(readDescriptor.tupleCursor);
+  memcpy(buf, tuple.getData(), tuple.getSize());
+  return tuple.getSize();
+}
+
+buf::WriteResult buf::BufPoolInstance::write(uchar *, buf::WriteDescriptor writeDescriptor) {
+  PageGuard guard = fixPage(writeDescriptor.tablespaceId, writeDescriptor.pageId,
+                            writeDescriptor.tablespacePath, LatchMode::EXCLUSIVE);
+  if (!guard.isValid()) {
+    return WriteResult::FAILED;
+  }
+  page::PageHandler& pageHandler = guard.getPageHandler();
+  if (!pageHandler.hasSpace(writeDescriptor.tuple->getSize())) {
+    return WriteResult::PAGE_FULL;
+  }
+  // on the flush list before the change is logged, so that a checkpoint
+  // taken meanwhile cannot pass the record of the change.
+  guard.markDirty(this->redoLog != nullptr ? this->redoLog->getCurrentLsn()
+                                           : 0);
+  pageHandler.insert(*writeDescriptor.tuple);
+  pageHandler.getPage().incrementTupleCount();
+  if (this->redoLog != nullptr) {
+    pageHandler.getPageHeader().lsn = this->redoLog->appendInsert(
+        writeDescriptor.tablespaceId, writeDescriptor.pageId,
+        writeDescriptor.tablespacePath, writeDescriptor.tuple->getData(),
+        writeDescriptor.tuple->getSize());
+  }
+  return WriteResult::WRITTEN;
+}
+
+/**
+ * @return false if the page could not be fixed
+ */
+bool buf::BufPoolInstance::isLastPage(tablespace_id tablespaceId, page_id pageId,
+                               const char *tablespacePath) {
+  PageGuard guard = fixPage(tablespaceId, pageId, tablespacePath,
+                            LatchMode::SHARED);
+  if (!guard.isValid()) {
+    return false;
+  }
+  return guard.getPageHandler().getPage().getNextPageId() == UINT64_MAX;
+}
+
+/**
+ * @return false if the page could not be fixed
+ */
+bool buf::BufPoolInstance::isLastTuple(tablespace_id tablespaceId, page_id pageId,
+                                uint64_t tupleId, const char *tablespacePath) {
+  PageGuard guard = fixPage(tablespaceId, pageId, tablespacePath,
+                            LatchMode::SHARED);
+  if (!guard.isValid()) {
+    return false;
+  }
+  return guard.getPageHandler().isLastTuple(tupleId);
+}
+
+buf::PageGuard::PageGuard(BufPoolInstance *instance, Element *element,
+                          LatchMode mode)
+    : instance(instance), element(element), mode(mode) {}
+
+buf::PageGuard::PageGuard(PageGuard &&other) noexcept
+    : instance(other.instance), element(other.element), mode(other.mode) {
+  other.instance = nullptr;
+  other.element = nullptr;
+}
+
+buf::PageGuard &buf::PageGuard::operator=(PageGuard &&other) noexcept {
+  if (this != &other) {
+    release();
+    this->instance = other.instance;
+    this->element = other.element;
+    this->mode = other.mode;
+    other.instance = nullptr;
+    other.element = nullptr;
+  }
+  return *this;
+}
+
+void buf::PageGuard::release() {
+  if (this->element == nullptr) {
+    return;
+  }
+  this->instance->unfixPage(this->element);
+  this->instance = nullptr;
+  this->element = nullptr;
+}
+
+void buf::PageGuard::markDirty(lsn_t oldestLsn) {
+  assert(this->element != nullptr && this->mode == LatchMode::EXCLUSIVE);
+  this->instance->markDirty(this->element, oldestLsn);
+}
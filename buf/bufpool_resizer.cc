@@ -0,0 +1,113 @@
+#include "bufpool_resizer.h"
+
+#include <cinttypes>
+#include <cstdio>
+
+#include "bufpool.h"
+#include "mysql/psi/mysql_thread.h"
+
+PSI_mutex_key buf_resize_mutex_key;
+PSI_cond_key buf_resize_cond_key;
+PSI_thread_key buf_resize_thread_key;
+
+void buf::BufPoolResizer::start() {
+  if (this->running) {
+    return;
+  }
+  this->shutdown = false;
+  this->running = true;
+  mysql_mutex_init(buf_resize_mutex_key, &this->mutex, MY_MUTEX_INIT_FAST);
+  mysql_cond_init(buf_resize_cond_key, &this->cond);
+
+  my_thread_attr_t attr;
+  my_thread_attr_init(&attr);
+  my_thread_attr_setdetachstate(&attr, MY_THREAD_CREATE_JOINABLE);
+  mysql_thread_create(buf_resize_thread_key, &this->thread, &attr, run, this);
+  my_thread_attr_destroy(&attr);
+}
+
+/**
+ * Stops the thread once the resize in progress, if any, finished.
+ */
+void buf::BufPoolResizer::stop() {
+  if (!this->running) {
+    return;
+  }
+  mysql_mutex_lock(&this->mutex);
+  this->shutdown = true;
+  mysql_cond_broadcast(&this->cond);
+  mysql_mutex_unlock(&this->mutex);
+
+  my_thread_join(&this->thread, nullptr);
+
+  this->requestedSize = 0;
+  this->running = false;
+  mysql_cond_destroy(&this->cond);
+  mysql_mutex_destroy(&this->mutex);
+}
+
+/**
+ * Asks for the pool to be resized to bufPoolSize pages. Replaces a
+ * request that did not start yet.
+ */
+void buf::BufPoolResizer::request(uint64_t bufPoolSize) {
+  if (!this->running || bufPoolSize == 0) {
+    return;
+  }
+  mysql_mutex_lock(&this->mutex);
+  this->requestedSize = bufPoolSize;
+  mysql_cond_signal(&this->cond);
+  mysql_mutex_unlock(&this->mutex);
+}
+
+buf::ResizeState buf::BufPoolResizer::getResizeState() const {
+  return this->resizeState;
+}
+
+void buf::BufPoolResizer::getResizeStatus(char *buf, size_t size) const {
+  switch (this->resizeState.load()) {
+    case ResizeState::NOT_STARTED:
+      snprintf(buf, size, "not started");
+      break;
+    case ResizeState::RUNNING:
+      snprintf(buf, size, "resizing to %" PRIu64 " pages", this->targetSize.load());
+      break;
+    case ResizeState::COMPLETED:
+      snprintf(buf, size, "completed, %" PRIu64 " pages",
+               this->bufPool->getMaxPageCount());
+      break;
+    case ResizeState::FAILED:
+      snprintf(buf, size, "failed to allocate %" PRIu64 " pages, %" PRIu64
+               " pages", this->targetSize.load(), this->bufPool->getMaxPageCount());
+      break;
+  }
+}
+
+void *buf::BufPoolResizer::run(void *arg) {
+  my_thread_init();
+  BufPoolResizer *resizer = static_cast<BufPoolResizer *>(arg);
+
+  mysql_mutex_lock(&resizer->mutex);
+  while (true) {
+    while (resizer->requestedSize == 0 && !resizer->shutdown) {
+      mysql_cond_wait(&resizer->cond, &resizer->mutex);
+    }
+    if (resizer->shutdown) {
+      break;
+    }
+    uint64_t bufPoolSize = resizer->requestedSize;
+    resizer->requestedSize = 0;
+    mysql_mutex_unlock(&resizer->mutex);
+
+    resizer->targetSize = bufPoolSize;
+    resizer->resizeState = ResizeState::RUNNING;
+    bool resized = resizer->bufPool->resize(bufPoolSize);
+    resizer->resizeState = resized ? ResizeState::COMPLETED : ResizeState::FAILED;
+
+    mysql_mutex_lock(&resizer->mutex);
+  }
+  mysql_mutex_unlock(&resizer->mutex);
+
+  my_thread_end();
+  return nullptr;
+}
@@ -0,0 +1,60 @@
+#include "frame_arena.h"
+#include <sys/mman.h>
+#include "mysql/psi/mysql_memory.h"
+
+static size_t roundUp(size_t size, size_t unit) {
+  return (size + unit - 1) / unit * unit;
+}
+
+bool buf::FrameArena::init(PSI_memory_key key, uint64_t frameCount,
+                           HugePageMode mode) {
+  size_t frameBytes = frameCount * page::PAGE_SIZE;
+  void *region = MAP_FAILED;
+#ifdef MAP_HUGETLB
+  if (mode == HugePageMode::EXPLICIT) {
+    this->regionSize = roundUp(frameBytes, HUGE_PAGE_SIZE);
+    region = mmap(nullptr, this->regionSize, PROT_READ | PROT_WRITE,
+                  MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    this->hugePageBacked = region != MAP_FAILED;
+  }
+#endif
+  if (region == MAP_FAILED) {
+    this->regionSize = mode == HugePageMode::OFF
+                           ? frameBytes
+                           : roundUp(frameBytes, HUGE_PAGE_SIZE);
+    region = mmap(nullptr, this->regionSize, PROT_READ | PROT_WRITE,
+                  MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (region == MAP_FAILED) {
+      this->regionSize = 0;
+      return false;
+    }
+#ifdef MADV_HUGEPAGE
+    if (mode != HugePageMode::OFF) {
+      this->hugePageBacked =
+          madvise(region, this->regionSize, MADV_HUGEPAGE) == 0;
+    }
+#endif
+  }
+  this->region = static_cast<uchar *>(region);
+  this->frameCount = frameCount;
+  this->memoryKey = key;
+#ifdef HAVE_PSI_MEMORY_INTERFACE
+  this->memoryKey =
+      PSI_MEMORY_CALL(memory_alloc)(key, this->regionSize, &this->owner);
+#endif
+  return true;
+}
+
+void buf::FrameArena::deinit() {
+  if (this->region == nullptr) {
+    return;
+  }
+#ifdef HAVE_PSI_MEMORY_INTERFACE
+  PSI_MEMORY_CALL(memory_free)(this->memoryKey, this->regionSize, this->owner);
+#endif
+  munmap(this->region, this->regionSize);
+  this->region = nullptr;
+  this->regionSize = 0;
+  this->frameCount = 0;
+  this->hugePageBacked = false;
+}
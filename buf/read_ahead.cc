@@ -0,0 +1,104 @@
+#include "read_ahead.h"
+#include "bufpool.h"
+#include "mysql/psi/mysql_thread.h"
+
+PSI_mutex_key read_ahead_mutex_key;
+PSI_cond_key read_ahead_cond_key;
+PSI_thread_key read_ahead_thread_key;
+
+void buf::ReadAhead::start(BufPool *bufPool) {
+  if (this->running) {
+    return;
+  }
+  this->bufPool = bufPool;
+  this->shutdown = false;
+  this->running = true;
+  mysql_mutex_init(read_ahead_mutex_key, &this->mutex, MY_MUTEX_INIT_FAST);
+  mysql_cond_init(read_ahead_cond_key, &this->cond);
+
+  my_thread_attr_t attr;
+  my_thread_attr_init(&attr);
+  my_thread_attr_setdetachstate(&attr, MY_THREAD_CREATE_JOINABLE);
+  mysql_thread_create(read_ahead_thread_key, &this->thread, &attr, run, this);
+  my_thread_attr_destroy(&attr);
+}
+
+void buf::ReadAhead::stop() {
+  if (!this->running) {
+    return;
+  }
+  mysql_mutex_lock(&this->mutex);
+  this->shutdown = true;
+  mysql_cond_broadcast(&this->cond);
+  mysql_mutex_unlock(&this->mutex);
+
+  my_thread_join(&this->thread, nullptr);
+
+  this->queue.clear();
+  this->running = false;
+  mysql_cond_destroy(&this->cond);
+  mysql_mutex_destroy(&this->mutex);
+}
+
+bool buf::ReadAhead::isRunning() {
+  return this->running;
+}
+
+void buf::ReadAhead::enqueue(PageRun request) {
+  if (!this->running) {
+    return;
+  }
+  mysql_mutex_lock(&this->mutex);
+  if (this->queue.size() < MAX_READ_AHEAD_QUEUE) {
+    this->queue.push_back(std::move(request));
+    mysql_cond_signal(&this->cond);
+  }
+  mysql_mutex_unlock(&this->mutex);
+}
+
+/**
+ * Drops the queued requests of a tablespace. The one being read is waited
+ * for by BufPool::discardTablespace().
+ */
+void buf::ReadAhead::cancel(tablespace_id tablespaceId) {
+  if (!this->running) {
+    return;
+  }
+  mysql_mutex_lock(&this->mutex);
+  for (auto it = this->queue.begin(); it != this->queue.end();) {
+    if (it->tablespaceId == tablespaceId) {
+      it = this->queue.erase(it);
+    } else {
+      ++it;
+    }
+  }
+  mysql_mutex_unlock(&this->mutex);
+}
+
+void *buf::ReadAhead::run(void *arg) {
+  my_thread_init();
+  ReadAhead *readAhead = static_cast<ReadAhead *>(arg);
+
+  mysql_mutex_lock(&readAhead->mutex);
+  while (true) {
+    while (readAhead->queue.empty() && !readAhead->shutdown) {
+      mysql_cond_wait(&readAhead->cond, &readAhead->mutex);
+    }
+    if (readAhead->shutdown) {
+      break;
+    }
+    PageRun request = std::move(readAhead->queue.front());
+    readAhead->queue.pop_front();
+    mysql_mutex_unlock(&readAhead->mutex);
+
+    readAhead->bufPool->prefetchPages(request.tablespaceId,
+                                      request.firstPageId, request.pageCount,
+                                      request.tablespacePath.c_str());
+
+    mysql_mutex_lock(&readAhead->mutex);
+  }
+  mysql_mutex_unlock(&readAhead->mutex);
+
+  my_thread_end();
+  return nullptr;
+}
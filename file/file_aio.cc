@@ -0,0 +1,340 @@
+#include "file_aio.h"
+
+#include <cerrno>
+
+#include "file_util.h"
+
+#ifdef HAVE_LIBURING
+#include <liburing.h>
+#endif
+
+PSI_mutex_key aio_mutex_key;
+PSI_cond_key aio_cond_key;
+PSI_thread_key aio_thread_key;
+PSI_mutex_key io_batch_mutex_key;
+PSI_cond_key io_batch_cond_key;
+
+namespace file_handler {
+
+namespace {
+
+/**
+ * Transfers the part of request after its first done bytes with a
+ * blocking positional read or write.
+ * @return done plus the bytes transferred, MY_FILE_ERROR on error
+ */
+size_t transferSynchronously(const IoRequest &request, size_t done) {
+  // the buffers after the first done bytes
+  std::vector<struct iovec> iov;
+  size_t skipped = 0;
+  for (const struct iovec &segment : request.iov) {
+    if (skipped + segment.iov_len <= done) {
+      skipped += segment.iov_len;
+      continue;
+    }
+    size_t offset = done > skipped ? done - skipped : 0;
+    iov.push_back({static_cast<char *>(segment.iov_base) + offset,
+                   segment.iov_len - offset});
+    skipped += segment.iov_len;
+  }
+  if (iov.empty()) {
+    return done;
+  }
+  size_t transferred =
+      request.type == IoType::READ
+          ? FileUtil::preadv(request.fd, iov.data(), iov.size(),
+                             request.offset + done)
+          : FileUtil::pwritev(request.fd, iov.data(), iov.size(),
+                              request.offset + done);
+  if (transferred == MY_FILE_ERROR) {
+    return MY_FILE_ERROR;
+  }
+  return done + transferred;
+}
+
+void startThread(my_thread_handle *thread, void *(*run)(void *), void *arg) {
+  my_thread_attr_t attr;
+  my_thread_attr_init(&attr);
+  my_thread_attr_setdetachstate(&attr, MY_THREAD_CREATE_JOINABLE);
+  mysql_thread_create(aio_thread_key, thread, &attr, run, arg);
+  my_thread_attr_destroy(&attr);
+}
+
+#ifdef HAVE_LIBURING
+
+/**
+ * The native engine, one io_uring per ring with a thread reaping its
+ * completions. Requests go to the rings in turn.
+ */
+class UringAio : public AioEngine {
+ private:
+  struct Ring {
+    struct io_uring uring;
+    // protects the submission queue and inFlight
+    mysql_mutex_t mutex;
+    // signalled when a request completes
+    mysql_cond_t cond;
+    uint64_t inFlight = 0;
+    my_thread_handle thread;
+  };
+  std::vector<Ring *> rings;
+  uint64_t queueDepth;
+  std::atomic<uint64_t> nextRing{0};
+  static void *run(void *arg);
+ public:
+  explicit UringAio(uint64_t queueDepth) : queueDepth(queueDepth) {}
+  ~UringAio() override { stop(); }
+  bool start(uint64_t ringCount);
+  void submit(std::vector<IoRequest> &requests) override;
+  void stop() override;
+  const char *getName() const override {
+    return "io_uring";
+  }
+};
+
+/**
+ * @return false if the kernel does not support io_uring
+ */
+bool UringAio::start(uint64_t ringCount) {
+  for (uint64_t i = 0; i < ringCount; i++) {
+    Ring *ring = new Ring();
+    if (io_uring_queue_init(this->queueDepth, &ring->uring, 0) < 0) {
+      delete ring;
+      stop();
+      return false;
+    }
+    mysql_mutex_init(aio_mutex_key, &ring->mutex, MY_MUTEX_INIT_FAST);
+    mysql_cond_init(aio_cond_key, &ring->cond);
+    this->rings.push_back(ring);
+    startThread(&ring->thread, run, ring);
+  }
+  return true;
+}
+
+void UringAio::submit(std::vector<IoRequest> &requests) {
+  Ring *ring = this->rings[this->nextRing++ % this->rings.size()];
+  mysql_mutex_lock(&ring->mutex);
+  for (IoRequest &request : requests) {
+    while (ring->inFlight >= this->queueDepth) {
+      io_uring_submit(&ring->uring);
+      mysql_cond_wait(&ring->cond, &ring->mutex);
+    }
+    struct io_uring_sqe *sqe = io_uring_get_sqe(&ring->uring);
+    // owned by the ring until it completes
+    IoRequest *submitted = new IoRequest(std::move(request));
+    if (submitted->type == IoType::READ) {
+      io_uring_prep_readv(sqe, submitted->fd, submitted->iov.data(),
+                          submitted->iov.size(), submitted->offset);
+    } else {
+      io_uring_prep_writev(sqe, submitted->fd, submitted->iov.data(),
+                           submitted->iov.size(), submitted->offset);
+    }
+    io_uring_sqe_set_data(sqe, submitted);
+    ring->inFlight++;
+  }
+  io_uring_submit(&ring->uring);
+  mysql_mutex_unlock(&ring->mutex);
+  requests.clear();
+}
+
+void UringAio::stop() {
+  for (Ring *ring : this->rings) {
+    mysql_mutex_lock(&ring->mutex);
+    while (ring->inFlight > 0) {
+      mysql_cond_wait(&ring->cond, &ring->mutex);
+    }
+    // a request without data stops the completion thread
+    struct io_uring_sqe *sqe = io_uring_get_sqe(&ring->uring);
+    io_uring_prep_nop(sqe);
+    io_uring_sqe_set_data(sqe, nullptr);
+    io_uring_submit(&ring->uring);
+    mysql_mutex_unlock(&ring->mutex);
+    my_thread_join(&ring->thread, nullptr);
+    io_uring_queue_exit(&ring->uring);
+    mysql_cond_destroy(&ring->cond);
+    mysql_mutex_destroy(&ring->mutex);
+    delete ring;
+  }
+  this->rings.clear();
+}
+
+void *UringAio::run(void *arg) {
+  my_thread_init();
+  Ring *ring = static_cast<Ring *>(arg);
+  while (true) {
+    struct io_uring_cqe *cqe;
+    if (io_uring_wait_cqe(&ring->uring, &cqe) < 0) {
+      continue;
+    }
+    IoRequest *request = static_cast<IoRequest *>(io_uring_cqe_get_data(cqe));
+    int res = cqe->res;
+    io_uring_cqe_seen(&ring->uring, cqe);
+    if (request == nullptr) {
+      break;
+    }
+    size_t result;
+    if (res < 0 && res != -EINTR && res != -EAGAIN) {
+      result = MY_FILE_ERROR;
+    } else if (res == 0 && request->type == IoType::READ) {
+      // at the end of the file
+      result = 0;
+    } else {
+      // short transfers and retryable errors are finished synchronously
+      size_t done = res < 0 ? 0 : res;
+      result = done < request->getSize()
+                   ? transferSynchronously(*request, done)
+                   : done;
+    }
+    request->callback(result);
+    delete request;
+
+    mysql_mutex_lock(&ring->mutex);
+    ring->inFlight--;
+    mysql_cond_broadcast(&ring->cond);
+    mysql_mutex_unlock(&ring->mutex);
+  }
+  my_thread_end();
+  return nullptr;
+}
+
+#endif
+
+}
+
+size_t IoRequest::getSize() const {
+  size_t size = 0;
+  for (const struct iovec &segment : this->iov) {
+    size += segment.iov_len;
+  }
+  return size;
+}
+
+/**
+ * Picks io_uring when configured and supported by the kernel, the thread
+ * pool otherwise.
+ */
+AioEngine *AioEngine::create(const AioConfig &config) {
+  uint64_t ringCount = config.ringCount > 0 ? config.ringCount : 1;
+  uint64_t queueDepth = config.queueDepth > 0 ? config.queueDepth : 1;
+#ifdef HAVE_LIBURING
+  if (config.useNativeAio) {
+    UringAio *uring = new UringAio(queueDepth);
+    if (uring->start(ringCount)) {
+      return uring;
+    }
+    delete uring;
+  }
+#endif
+  return new ThreadPoolAio(ringCount * FALLBACK_THREADS_PER_RING,
+                           ringCount * queueDepth);
+}
+
+ThreadPoolAio::ThreadPoolAio(uint64_t threadCount, uint64_t capacity)
+    : capacity(capacity) {
+  mysql_mutex_init(aio_mutex_key, &this->mutex, MY_MUTEX_INIT_FAST);
+  mysql_cond_init(aio_cond_key, &this->queueCond);
+  mysql_cond_init(aio_cond_key, &this->spaceCond);
+  this->threads.resize(threadCount);
+  for (my_thread_handle &thread : this->threads) {
+    startThread(&thread, run, this);
+  }
+}
+
+ThreadPoolAio::~ThreadPoolAio() {
+  stop();
+  mysql_cond_destroy(&this->spaceCond);
+  mysql_cond_destroy(&this->queueCond);
+  mysql_mutex_destroy(&this->mutex);
+}
+
+void ThreadPoolAio::submit(std::vector<IoRequest> &requests) {
+  mysql_mutex_lock(&this->mutex);
+  for (IoRequest &request : requests) {
+    while (this->queue.size() >= this->capacity) {
+      mysql_cond_wait(&this->spaceCond, &this->mutex);
+    }
+    this->queue.push_back(std::move(request));
+    mysql_cond_signal(&this->queueCond);
+  }
+  mysql_mutex_unlock(&this->mutex);
+  requests.clear();
+}
+
+/**
+ * Lets the threads complete the queued requests and joins them.
+ */
+void ThreadPoolAio::stop() {
+  mysql_mutex_lock(&this->mutex);
+  this->shutdown = true;
+  mysql_cond_broadcast(&this->queueCond);
+  mysql_mutex_unlock(&this->mutex);
+  for (my_thread_handle &thread : this->threads) {
+    my_thread_join(&thread, nullptr);
+  }
+  this->threads.clear();
+}
+
+void *ThreadPoolAio::run(void *arg) {
+  my_thread_init();
+  ThreadPoolAio *pool = static_cast<ThreadPoolAio *>(arg);
+  mysql_mutex_lock(&pool->mutex);
+  while (true) {
+    if (pool->queue.empty()) {
+      if (pool->shutdown) {
+        break;
+      }
+      mysql_cond_wait(&pool->queueCond, &pool->mutex);
+      continue;
+    }
+    IoRequest request = std::move(pool->queue.front());
+    pool->queue.pop_front();
+    mysql_cond_signal(&pool->spaceCond);
+    mysql_mutex_unlock(&pool->mutex);
+
+    request.callback(transferSynchronously(request, 0));
+
+    mysql_mutex_lock(&pool->mutex);
+  }
+  mysql_mutex_unlock(&pool->mutex);
+  my_thread_end();
+  return nullptr;
+}
+
+IoBatch::IoBatch() {
+  mysql_mutex_init(io_batch_mutex_key, &this->mutex, MY_MUTEX_INIT_FAST);
+  mysql_cond_init(io_batch_cond_key, &this->cond);
+}
+
+IoBatch::~IoBatch() {
+  mysql_cond_destroy(&this->cond);
+  mysql_mutex_destroy(&this->mutex);
+}
+
+void IoBatch::add(uint64_t requestCount) {
+  mysql_mutex_lock(&this->mutex);
+  this->pendingCount += requestCount;
+  mysql_mutex_unlock(&this->mutex);
+}
+
+void IoBatch::complete(uint64_t units) {
+  mysql_mutex_lock(&this->mutex);
+  assert(this->pendingCount > 0);
+  this->pendingCount--;
+  this->completedUnits += units;
+  if (this->pendingCount == 0) {
+    mysql_cond_broadcast(&this->cond);
+  }
+  mysql_mutex_unlock(&this->mutex);
+}
+
+uint64_t IoBatch::wait() {
+  mysql_mutex_lock(&this->mutex);
+  while (this->pendingCount > 0) {
+    mysql_cond_wait(&this->cond, &this->mutex);
+  }
+  uint64_t units = this->completedUnits;
+  mysql_mutex_unlock(&this->mutex);
+  return units;
+}
+
+} // namespace file_handler
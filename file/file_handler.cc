@@ -3,14 +3,35 @@
 //
 #include "file_handler.h"
 #include <fcntl.h>
+#include <atomic>
 
 #include "file_util.h"
 #include "file_config.h"
 
 namespace file_handler {
 
+static std::atomic<IoMode> ioMode{IoMode::BUFFERED};
+
+void setIoMode(IoMode mode) {
+  ioMode = mode;
+}
+
+IoMode getIoMode() {
+  return ioMode;
+}
+
 void File::open(const char *path) {
   fileDescriptor = FileUtil::open(fileKey, path, O_RDWR, MYF(myFlags));
+  applyIoMode();
+}
+
+/**
+ * Switches the file to direct I/O in DIRECT mode. Files on file systems
+ * without direct I/O, such as tmpfs, stay buffered.
+ */
+void File::applyIoMode() {
+  directIo = fileDescriptor >= 0 && getIoMode() == IoMode::DIRECT &&
+             FileUtil::setDirectIo(fileDescriptor);
 }
 
 void File::remove(const char *path) {
@@ -24,27 +45,36 @@ void File::close() const {
 File File::create(const char *path, PSI_file_key key) {
   FileDescriptor fd = FileUtil::create(
       key, path, 0, O_RDWR, MYF(0));
-  return File(fd, 0, key);
+  File file(fd, 0, key);
+  file.applyIoMode();
+  return file;
 }
 
 size_t File::read(uchar *buf, int size) const {
-  FileUtil::seek(fileDescriptor, 0, SEEK_SET, MYF(0));
-  return FileUtil::read(fileDescriptor, buf, size);
+  return FileUtil::pread(fileDescriptor, buf, size, 0);
 }
 
 size_t File::read(uchar *buf, int size, my_off_t offset) const {
-  FileUtil::seek(fileDescriptor, offset, SEEK_SET, MYF(0));
-  return FileUtil::read(fileDescriptor, buf, size);
+  return FileUtil::pread(fileDescriptor, buf, size, offset);
 }
 
 size_t File::write(uchar *buf, int size) const {
-  FileUtil::seek(fileDescriptor, 0, SEEK_SET, MYF(0));
-  return FileUtil::write(fileDescriptor, buf, size);
+  return FileUtil::pwrite(fileDescriptor, buf, size, 0);
 }
 
 size_t File::write(uchar *buf, int size, my_off_t offset) const {
-  FileUtil::seek(fileDescriptor, offset, SEEK_SET, MYF(0));
-  return FileUtil::write(fileDescriptor, buf, size);
+  return FileUtil::pwrite(fileDescriptor, buf, size, offset);
+}
+
+/**
+ * Reads into the buffers of iov in order with one syscall.
+ */
+size_t File::readv(const struct iovec *iov, int iovcnt, my_off_t offset) const {
+  return FileUtil::preadv(fileDescriptor, iov, iovcnt, offset);
+}
+
+size_t File::writev(const struct iovec *iov, int iovcnt, my_off_t offset) const {
+  return FileUtil::pwritev(fileDescriptor, iov, iovcnt, offset);
 }
 
 } // namespace file_handler
@@ -99,20 +99,37 @@
 
 #include "storage/toybox/ha_toybox.h"
 
+#include "bufpool_dump.h"
+#include "bufpool_resizer.h"
 #include "file_util.h"
+#include "fsm_page.h"
 #include "my_dbug.h"
 #include "mysql/psi/mysql_memory.h"
+#include "checkpointer.h"
+#include "my_rapidjson_size_t.h"
 #include "page.h"
+#include "pax_page.h"
+#include "predicate.h"
+#include "redo_log.h"
+#include "redo_recovery.h"
 #include "sql/field.h"
+#include "sql/item.h"
+#include "sql/item_cmpfunc.h"
+#include "sql/item_func.h"
+#include "sql/mysqld.h"
 #include "sql/sql_class.h"
 #include "sql/sql_plugin.h"
 #include "typelib.h"
 
+#include <rapidjson/document.h>
+
 extern PSI_file_key tablespace_key;
 extern PSI_file_key system_tablespace_key;
+extern PSI_file_key redo_log_file_key;
 static PSI_file_info all_toybox_files[] = {
     {&tablespace_key, "data", 0, 0, PSI_DOCUMENT_ME},
-    {&system_tablespace_key, "system", 0, 0, PSI_DOCUMENT_ME}
+    {&system_tablespace_key, "system", 0, 0, PSI_DOCUMENT_ME},
+    {&redo_log_file_key, "redo_log", 0, 0, PSI_DOCUMENT_ME}
 };
 
 static PSI_memory_key buffer_pool_key;
@@ -121,8 +138,89 @@ static PSI_memory_info all_toybox_memory[] = {
 };
 
 static PSI_mutex_key key_mutex_toybox_system;
+extern PSI_mutex_key buf_pool_mutex_key;
+extern PSI_mutex_key read_ahead_mutex_key;
+extern PSI_mutex_key prefetch_mutex_key;
+extern PSI_mutex_key buf_dump_mutex_key;
+extern PSI_mutex_key buf_pool_resize_mutex_key;
+extern PSI_mutex_key page_allocate_mutex_key;
+extern PSI_mutex_key buf_resize_mutex_key;
+extern PSI_mutex_key tablespace_cache_mutex_key;
+extern PSI_mutex_key tablespace_sync_mutex_key;
+extern PSI_mutex_key aio_mutex_key;
+extern PSI_mutex_key io_batch_mutex_key;
+extern PSI_mutex_key redo_log_mutex_key;
+extern PSI_mutex_key redo_checkpoint_mutex_key;
+extern PSI_mutex_key checkpointer_mutex_key;
+extern PSI_mutex_key checkpoint_flush_mutex_key;
 static PSI_mutex_info all_toybox_mutexes[] = {
-    {&key_mutex_toybox_system, "mutex_system", PSI_FLAG_SINGLETON, 0, PSI_DOCUMENT_ME}
+    {&key_mutex_toybox_system, "mutex_system", PSI_FLAG_SINGLETON, 0, PSI_DOCUMENT_ME},
+    {&buf_pool_mutex_key, "mutex_bufpool", 0, 0, PSI_DOCUMENT_ME},
+    {&read_ahead_mutex_key, "mutex_read_ahead", PSI_FLAG_SINGLETON, 0, PSI_DOCUMENT_ME},
+    {&prefetch_mutex_key, "mutex_prefetch", PSI_FLAG_SINGLETON, 0, PSI_DOCUMENT_ME},
+    {&buf_dump_mutex_key, "mutex_bufpool_dump", PSI_FLAG_SINGLETON, 0, PSI_DOCUMENT_ME},
+    {&buf_pool_resize_mutex_key, "mutex_bufpool_chunks", PSI_FLAG_SINGLETON, 0, PSI_DOCUMENT_ME},
+    {&page_allocate_mutex_key, "mutex_page_allocate", 0, 0, PSI_DOCUMENT_ME},
+    {&buf_resize_mutex_key, "mutex_bufpool_resizer", PSI_FLAG_SINGLETON, 0, PSI_DOCUMENT_ME},
+    {&tablespace_cache_mutex_key, "mutex_tablespace_cache", PSI_FLAG_SINGLETON, 0, PSI_DOCUMENT_ME},
+    {&tablespace_sync_mutex_key, "mutex_tablespace_sync", PSI_FLAG_SINGLETON, 0, PSI_DOCUMENT_ME},
+    {&aio_mutex_key, "mutex_aio", 0, 0, PSI_DOCUMENT_ME},
+    {&io_batch_mutex_key, "mutex_io_batch", 0, 0, PSI_DOCUMENT_ME},
+    {&redo_log_mutex_key, "mutex_redo_log", PSI_FLAG_SINGLETON, 0, PSI_DOCUMENT_ME},
+    {&redo_checkpoint_mutex_key, "mutex_redo_checkpoint", PSI_FLAG_SINGLETON, 0, PSI_DOCUMENT_ME},
+    {&checkpointer_mutex_key, "mutex_checkpointer", PSI_FLAG_SINGLETON, 0, PSI_DOCUMENT_ME},
+    {&checkpoint_flush_mutex_key, "mutex_checkpoint_flush", PSI_FLAG_SINGLETON, 0, PSI_DOCUMENT_ME}
+};
+
+extern PSI_rwlock_key buf_block_latch_key;
+static PSI_rwlock_info all_toybox_rwlocks[] = {
+    {&buf_block_latch_key, "latch_bufpool_block", 0, 0, PSI_DOCUMENT_ME}
+};
+
+extern PSI_cond_key buf_pool_free_element_cond_key;
+extern PSI_cond_key page_cleaner_cond_key;
+extern PSI_cond_key read_ahead_cond_key;
+extern PSI_cond_key prefetch_cond_key;
+extern PSI_cond_key buf_dump_cond_key;
+extern PSI_cond_key buf_resize_cond_key;
+extern PSI_cond_key tablespace_cache_cond_key;
+extern PSI_cond_key aio_cond_key;
+extern PSI_cond_key io_batch_cond_key;
+extern PSI_cond_key redo_log_write_cond_key;
+extern PSI_cond_key redo_log_flusher_cond_key;
+extern PSI_cond_key checkpointer_cond_key;
+static PSI_cond_info all_toybox_conds[] = {
+    {&buf_pool_free_element_cond_key, "cond_bufpool_free_element", 0, 0, PSI_DOCUMENT_ME},
+    {&page_cleaner_cond_key, "cond_page_cleaner", 0, 0, PSI_DOCUMENT_ME},
+    {&read_ahead_cond_key, "cond_read_ahead", PSI_FLAG_SINGLETON, 0, PSI_DOCUMENT_ME},
+    {&prefetch_cond_key, "cond_prefetch", PSI_FLAG_SINGLETON, 0, PSI_DOCUMENT_ME},
+    {&buf_dump_cond_key, "cond_bufpool_dump", PSI_FLAG_SINGLETON, 0, PSI_DOCUMENT_ME},
+    {&buf_resize_cond_key, "cond_bufpool_resizer", PSI_FLAG_SINGLETON, 0, PSI_DOCUMENT_ME},
+    {&tablespace_cache_cond_key, "cond_tablespace_cache", PSI_FLAG_SINGLETON, 0, PSI_DOCUMENT_ME},
+    {&aio_cond_key, "cond_aio", 0, 0, PSI_DOCUMENT_ME},
+    {&io_batch_cond_key, "cond_io_batch", 0, 0, PSI_DOCUMENT_ME},
+    {&redo_log_write_cond_key, "cond_redo_log_write", PSI_FLAG_SINGLETON, 0, PSI_DOCUMENT_ME},
+    {&redo_log_flusher_cond_key, "cond_log_flusher", PSI_FLAG_SINGLETON, 0, PSI_DOCUMENT_ME},
+    {&checkpointer_cond_key, "cond_checkpointer", PSI_FLAG_SINGLETON, 0, PSI_DOCUMENT_ME}
+};
+
+extern PSI_thread_key page_cleaner_thread_key;
+extern PSI_thread_key read_ahead_thread_key;
+extern PSI_thread_key buf_dump_thread_key;
+extern PSI_thread_key buf_resize_thread_key;
+extern PSI_thread_key aio_thread_key;
+extern PSI_thread_key log_flusher_thread_key;
+extern PSI_thread_key checkpointer_thread_key;
+extern PSI_thread_key recovery_worker_thread_key;
+static PSI_thread_info all_toybox_threads[] = {
+    {&page_cleaner_thread_key, "page_cleaner", "tb_pg_clean", 0, 0, PSI_DOCUMENT_ME},
+    {&read_ahead_thread_key, "read_ahead", "tb_read_ahead", PSI_FLAG_SINGLETON, 0, PSI_DOCUMENT_ME},
+    {&buf_dump_thread_key, "bufpool_dump", "tb_buf_dump", PSI_FLAG_SINGLETON, 0, PSI_DOCUMENT_ME},
+    {&buf_resize_thread_key, "bufpool_resizer", "tb_buf_resize", PSI_FLAG_SINGLETON, 0, PSI_DOCUMENT_ME},
+    {&aio_thread_key, "aio", "tb_aio", 0, 0, PSI_DOCUMENT_ME},
+    {&log_flusher_thread_key, "log_flusher", "tb_log_flush", PSI_FLAG_SINGLETON, 0, PSI_DOCUMENT_ME},
+    {&checkpointer_thread_key, "checkpointer", "tb_checkpoint", PSI_FLAG_SINGLETON, 0, PSI_DOCUMENT_ME},
+    {&recovery_worker_thread_key, "recovery_worker", "tb_recovery", 0, 0, PSI_DOCUMENT_ME}
 };
 
 static void init_toybox_psi_keys() {
@@ -135,6 +233,15 @@ static void init_toybox_psi_keys() {
 
     count = static_cast<int>(array_elements(all_toybox_mutexes));
     mysql_mutex_register(category, all_toybox_mutexes, count);
+
+    count = static_cast<int>(array_elements(all_toybox_rwlocks));
+    mysql_rwlock_register(category, all_toybox_rwlocks, count);
+
+    count = static_cast<int>(array_elements(all_toybox_conds));
+    mysql_cond_register(category, all_toybox_conds, count);
+
+    count = static_cast<int>(array_elements(all_toybox_threads));
+    mysql_thread_register(category, all_toybox_threads, count);
 }
 
 
@@ -143,8 +250,49 @@ static handler *toybox_create_handler(handlerton *hton, TABLE_SHARE *table,
 
 handlerton *toybox_hton;
 static buf::BufPool *bufPool;
+static buf::BufPoolDump *bufPoolDump;
+static buf::BufPoolResizer *bufPoolResizer;
+static redo::RedoLog *redoLog;
+static redo::Checkpointer *checkpointer;
 static mysql_mutex_t toybox_system_table_lock;
 
+// bytes, rounded down to whole pages per instance
+static ulonglong srv_buffer_pool_size = buf::DEFAULT_BUFFER_POOL_SIZE;
+static ulonglong srv_buffer_pool_chunk_size =
+    buf::DEFAULT_CHUNK_PAGES * page::PAGE_SIZE;
+// pages per second written back by the page cleaner
+static ulong srv_flush_rate = buf::DEFAULT_FLUSH_RATE;
+static ulong srv_buffer_pool_instances = buf::DEFAULT_INSTANCE_COUNT;
+static ulong srv_buffer_pool_huge_pages =
+    static_cast<ulong>(buf::HugePageMode::OFF);
+// pages read ahead of a table scan at a time, 0 disables read-ahead
+static ulong srv_read_ahead_window = buf::DEFAULT_READ_AHEAD_WINDOW;
+static ulong srv_old_blocks_pct = buf::DEFAULT_OLD_BLOCKS_PCT;
+static ulong srv_old_blocks_time = buf::DEFAULT_OLD_BLOCKS_TIME;
+static bool srv_buffer_pool_dump_at_shutdown = true;
+static bool srv_buffer_pool_load_at_startup = true;
+// seconds between dumps of the buffer pool, 0 dumps only at shutdown
+static ulong srv_buffer_pool_dump_interval = 0;
+static ulong srv_buffer_pool_dump_pct = buf::DEFAULT_DUMP_PCT;
+// tablespace files kept open, 0 uses half of open_files_limit
+static ulong srv_open_files = 0;
+static ulong srv_io_mode = static_cast<ulong>(file_handler::IoMode::BUFFERED);
+static bool srv_use_native_aio = true;
+static ulong srv_io_rings = file_handler::DEFAULT_IO_RINGS;
+static ulong srv_io_queue_depth = file_handler::DEFAULT_IO_QUEUE_DEPTH;
+static ulong srv_log_durability = static_cast<ulong>(redo::Durability::COMMIT);
+static ulonglong srv_log_buffer_size = redo::DEFAULT_LOG_BUFFER_SIZE;
+// bytes of redo recovery replays at most
+static ulonglong srv_log_max_checkpoint_age = redo::DEFAULT_MAX_CHECKPOINT_AGE;
+static ulong srv_recovery_threads = redo::DEFAULT_RECOVERY_THREADS;
+
+static uint64_t getOpenFilesCapacity(ulong openFiles) {
+  if (openFiles == 0) {
+    openFiles = open_files_limit / 2;
+  }
+  return std::max<uint64_t>(openFiles, tablespace::MIN_OPEN_FILES);
+}
+
 /* Interface to mysqld, to check system tables supported by SE */
 static bool toybox_is_supported_system_table(const char *db,
                                               const char *table_name,
@@ -160,12 +308,65 @@ static int toybox_init_func(void *p) {
   toybox_hton = (handlerton *)p;
   toybox_hton->state = SHOW_OPTION_YES;
   toybox_hton->create = toybox_create_handler;
-  toybox_hton->flags = HTON_CAN_RECREATE;
+  toybox_hton->flags = HTON_CAN_RECREATE | HTON_SUPPORTS_ENGINE_ATTRIBUTE;
   toybox_hton->is_supported_system_table = toybox_is_supported_system_table;
+  // before any tablespace file is opened
+  file_handler::setIoMode(static_cast<file_handler::IoMode>(srv_io_mode));
+  file_handler::AioConfig aioConfig;
+  aioConfig.useNativeAio = srv_use_native_aio;
+  aioConfig.ringCount = srv_io_rings;
+  aioConfig.queueDepth = srv_io_queue_depth;
   buf::BufPool *bp = new buf::BufPool();
-  bp->init_buffer_pool(buffer_pool_key, 100);
+  if (!bp->init_buffer_pool(
+          buffer_pool_key, srv_buffer_pool_size / page::PAGE_SIZE,
+          srv_buffer_pool_instances,
+          static_cast<buf::HugePageMode>(srv_buffer_pool_huge_pages),
+          srv_buffer_pool_chunk_size / page::PAGE_SIZE, aioConfig)) {
+    delete bp;
+    return 1;
+  }
+  bp->getTablespaceCache().setCapacity(getOpenFilesCapacity(srv_open_files));
+  bp->setOldBlocksPct(srv_old_blocks_pct);
+  bp->setOldBlocksTime(srv_old_blocks_time);
+
+  // brings the pages back to the last logged change before anything else
+  // reads them; recovered pages are flushed like any other dirty page.
+  redo::RedoLog *log = new redo::RedoLog();
+  if (!log->open(redo::LOG_FILE_PATH, srv_log_buffer_size)) {
+    delete log;
+    bp->deinit_buffer_pool();
+    delete bp;
+    return 1;
+  }
+  redo::RedoRecovery recovery(*bp, srv_recovery_threads);
+  if (recovery.recover(log->getFileDescriptor(), log->getCheckpointLsn()) ==
+      LSN_MAX) {
+    delete log;
+    bp->deinit_buffer_pool();
+    delete bp;
+    return 1;
+  }
+  bp->setRedoLog(log);
+  log->setDurability(static_cast<redo::Durability>(srv_log_durability));
+  log->startFlusher();
+  redoLog = log;
+
+  bp->startPageCleaner(srv_flush_rate);
+  bp->startReadAhead();
   bufPool = bp;
 
+  checkpointer =
+      new redo::Checkpointer(bufPool, redoLog, srv_log_max_checkpoint_age);
+  checkpointer->start();
+
+  bufPoolResizer = new buf::BufPoolResizer(bufPool);
+  bufPoolResizer->start();
+
+  bufPoolDump = new buf::BufPoolDump(bufPool, buf::BUFFER_POOL_DUMP_PATH);
+  bufPoolDump->setDumpPct(srv_buffer_pool_dump_pct);
+  bufPoolDump->start(srv_buffer_pool_load_at_startup,
+                     srv_buffer_pool_dump_interval);
+
   mysql_mutex_init(key_mutex_toybox_system, &toybox_system_table_lock, MY_MUTEX_INIT_FAST);
 
   system_table::SystemTablespaceHandler::create();
@@ -174,8 +375,24 @@ static int toybox_init_func(void *p) {
 }
 
 static int toybox_deinit_func(void *) {
-  bufPool->deinit_buffer_pool();
-  free(bufPool);
+  bufPoolDump->stop();
+  if (srv_buffer_pool_dump_at_shutdown) {
+    bufPoolDump->dump();
+  }
+  delete bufPoolDump;
+  bufPoolResizer->stop();
+  delete bufPoolResizer;
+  delete checkpointer;
+  // the last page writes still sync the log
+  bool flushed = bufPool->deinit_buffer_pool();
+  delete bufPool;
+  // every page is written and synced, nothing is replayed at the next
+  // startup. Otherwise the log is replayed from the last checkpoint.
+  if (flushed) {
+    redoLog->writeCheckpoint(redoLog->getCurrentLsn());
+  }
+  redoLog->close();
+  delete redoLog;
   return 0;
 }
 
@@ -280,10 +497,24 @@ int ha_toybox::open(const char *name, int, uint, const dd::Table *) {
   if (!(share = get_share())) return 1;
   thr_lock_data_init(&share->lock, &lock, nullptr);
 
-  tablespace::TablespaceHandler tablespaceHandler = tablespace::TablespaceHandler(tablespacePath);
-  share->tablespaceId = tablespaceHandler.getTablespaceHeader().getId();
+  // the file stays open in the tablespace cache for the page reads
+  tablespace::TablespaceGuard tablespace =
+      bufPool->getTablespaceCache().open(tablespacePath);
+  if (!tablespace.isValid()) return HA_ERR_NO_SUCH_TABLE;
+  share->tablespaceId = tablespace.getTablespaceId();
+  uint64_t pageCount =
+      tablespace.getTablespaceHandler().getTablespaceHeader().getPageCount();
+  share->layout =
+      tablespace.getTablespaceHandler().getSystemPageHeader().getLayout();
+  tablespace.release();
 
   strcpy(share->tablespacePath, tablespacePath);
+  if (share->lastPageId == page::MAX_PAGE_ID) {
+    share->lastPageId = bufPool->findLastPage(
+        share->tablespaceId, std::max<uint64_t>(pageCount, 1) - 1,
+        share->tablespacePath);
+    share->insertPageId = share->lastPageId.load();
+  }
   return 0;
 }
 
@@ -304,6 +535,8 @@ int ha_toybox::open(const char *name, int, uint, const dd::Table *) {
 
 int ha_toybox::close(void) {
   DBUG_TRACE;
+  releaseScanPage();
+  scanMapping.reset();
   return 0;
 }
 
@@ -343,7 +576,20 @@ int ha_toybox::close(void) {
 
 int ha_toybox::write_row(uchar *record) {
   DBUG_TRACE;
-  insert_to_page(record);
+  // the insert latches its page exclusively, an open scan of this handler
+  // must not keep it shared latched, nor view a stale mapped copy.
+  releaseScanPage();
+  // before logging the insert, so that the redo to replay stays bounded
+  checkpointer->makeSpace();
+  // the insert could not be logged
+  if (redoLog->hasFailed()) {
+    return HA_ERR_INTERNAL_ERROR;
+  }
+  int error = insert_to_page(record);
+  if (error != 0) {
+    return error;
+  }
+  rowsWritten = true;
   /*
     Example of a successful write_row. We don't store the data
     anywhere; they are thrown away. A real implementation will
@@ -353,13 +599,13 @@ int ha_toybox::write_row(uchar *record) {
   return 0;
 }
 
-void ha_toybox::insert_to_page(uchar *record) {
+int ha_toybox::insert_to_page(uchar *record) {
 
   // first byte is null bitmap
   uint8_t nullBitmap = *(record + 0);
   uint32_t recordSize = 0;
   for (Field **field = table->field; *field; field++) {
-    recordSize += (*field)->data_length();
+    recordSize += getColumnSize(**field);
   }
 
   std::vector<uint8_t> fixedLengthBuf(recordSize);
@@ -368,7 +614,7 @@ void ha_toybox::insert_to_page(uchar *record) {
 
   int insertPos = 0;
   for (Field **field = table->field; *field; field++) {
-    uint32 dataLength = (*field)->data_length();
+    uint32 dataLength = getColumnSize(**field);
     if (dataLength != 0) {
       // Fixed Size Column
       memcpy(fixedLengthBuf.data() + insertPos, record, dataLength);
@@ -377,13 +623,39 @@ void ha_toybox::insert_to_page(uchar *record) {
       insertPos += dataLength;
     }
   }
-  buf::WriteDescriptor writeDescriptor{
-      share->tablespaceId,
-      page_scan_now_cur,
-      share->tablespacePath,
-      insertTuple.get()
-  };
-  bufPool->write(fixedLengthBuf.data(), writeDescriptor);
+  if (recordSize > page::MAX_TUPLE_SIZE) {
+    return HA_ERR_TOO_BIG_ROW;
+  }
+  // once the page is full, the row goes to a page the free space map has
+  // room in, or to a new page after the last one
+  page_id pageId = share->insertPageId;
+  while (true) {
+    buf::WriteDescriptor writeDescriptor{
+        share->tablespaceId,
+        pageId,
+        share->tablespacePath,
+        insertTuple.get()
+    };
+    switch (bufPool->write(fixedLengthBuf.data(), writeDescriptor)) {
+      case buf::WriteResult::WRITTEN:
+        return 0;
+      case buf::WriteResult::FAILED:
+        return HA_ERR_OUT_OF_MEM;
+      case buf::WriteResult::PAGE_FULL:
+        break;
+    }
+    pageId = bufPool->findPageWithSpace(share->tablespaceId, recordSize,
+                                        share->tablespacePath);
+    if (pageId == page::MAX_PAGE_ID) {
+      pageId = bufPool->allocatePage(share->tablespaceId, share->lastPageId,
+                                     share->tablespacePath);
+      if (pageId == page::MAX_PAGE_ID) {
+        return HA_ERR_RECORD_FILE_FULL;
+      }
+      share->lastPageId = pageId;
+    }
+    share->insertPageId = pageId;
+  }
 }
 
 /**
@@ -526,15 +798,92 @@ int ha_toybox::index_last(uchar *) {
   filesort.cc, records.cc, sql_handler.cc, sql_select.cc, sql_table.cc and
   sql_update.cc
 */
-int ha_toybox::rnd_init(bool) {
+int ha_toybox::rnd_init(bool scan) {
   DBUG_TRACE;
+  releaseScanPage();
+  sequentialScan = scan;
   page_scan_now_cur = 0;
   page_row_scan_now_cur = 0;
+  filteredPageId = page::MAX_PAGE_ID;
+  if (file_handler::getIoMode() == file_handler::IoMode::MMAP) {
+    mapScanPage();
+    if (scan && scanMapping != nullptr) {
+      scanMapping->adviseSequential();
+    }
+  }
   return 0;
 }
 
 int ha_toybox::rnd_end() {
   DBUG_TRACE;
+  releaseScanPage();
+  scanMapping.reset();
+  return 0;
+}
+
+void ha_toybox::releaseScanPage() {
+  scanPage = nullptr;
+  mappedPage.reset();
+  scanGuard.release();
+}
+
+/**
+  Makes scanMapping hold the page under the scan cursor if the file has
+  it, mapping the file again if it grew.
+
+  @return false if the page is beyond the end of the file
+*/
+bool ha_toybox::mapScanPage() {
+  if (scanMapping != nullptr &&
+      page_scan_now_cur < scanMapping->getPageCount()) {
+    return true;
+  }
+  tablespace::TablespaceGuard tablespace = bufPool->getTablespaceCache().get(
+      share->tablespaceId, share->tablespacePath);
+  if (!tablespace.isValid()) {
+    return false;
+  }
+  scanMapping = tablespace.map(page_scan_now_cur);
+  return page_scan_now_cur < scanMapping->getPageCount();
+}
+
+/**
+  Makes scanPage the page under the scan cursor. In MMAP mode, a page the
+  buffer pool does not hold is viewed in place in the mapping of the file,
+  which is up to date since evicted pages were written back; cached ones
+  may be newer than the file and are read from the pool.
+
+  @return 0 or an error
+*/
+int ha_toybox::fixScanPage() {
+  bool mapped = file_handler::getIoMode() == file_handler::IoMode::MMAP;
+  if (mapped && !bufPool->existPage(share->tablespaceId, page_scan_now_cur) &&
+      mapScanPage()) {
+    scanGuard.release();
+    // the mapping is read-only, the view is only ever read
+    mappedPage.emplace(page::PageHandler::fromFrame(
+        const_cast<uchar *>(scanMapping->getPage(page_scan_now_cur))));
+    scanPage = &*mappedPage;
+  } else {
+    mappedPage.reset();
+    scanGuard = bufPool->fixPage(share->tablespaceId, page_scan_now_cur,
+                                 share->tablespacePath, buf::LatchMode::SHARED);
+    if (!scanGuard.isValid()) {
+      scanPage = nullptr;
+      return HA_ERR_OUT_OF_MEM;
+    }
+    scanPage = &scanGuard.getPageHandler();
+  }
+  // entering a new window, read the next one in the background
+  ulong window = srv_read_ahead_window;
+  if (sequentialScan && window > 0 && page_scan_now_cur % window == 0) {
+    if (mapped && scanMapping != nullptr) {
+      scanMapping->adviseWillNeed(page_scan_now_cur + 1, window);
+    } else {
+      bufPool->readAhead(share->tablespaceId, page_scan_now_cur + 1, window,
+                         share->tablespacePath);
+    }
+  }
   return 0;
 }
 
@@ -558,42 +907,71 @@ int ha_toybox::rnd_next(uchar *record) {
 
   // page_scan_now_cur = 今見ている pageId
   // page_row_scan_now_cur = 今見ている page 内の tuple cursor
-  if (bufPool->isLastPage(share->tablespaceId, page_scan_now_cur, share->tablespacePath)) {
-    if (bufPool->isLastTuple(share->tablespaceId, page_scan_now_cur,
-                             page_row_scan_now_cur, share->tablespacePath)) {
-      return HA_ERR_END_OF_FILE;
+  if (scanPage == nullptr ||
+      scanPage->getPageHeader().id != page_scan_now_cur) {
+    int error = fixScanPage();
+    if (error != 0) {
+      return error;
+    }
+  }
+  while (true) {
+    // once every tuple of a page was read, the scan goes on with the page
+    // chained after it
+    while (scanPage->isLastTuple(page_row_scan_now_cur)) {
+      page_id nextPageId = scanPage->getPage().getNextPageId();
+      if (nextPageId == page::MAX_PAGE_ID) {
+        return HA_ERR_END_OF_FILE;
+      }
+      page_scan_now_cur = nextPageId;
+      page_row_scan_now_cur = 0;
+      int error = fixScanPage();
+      if (error != 0) {
+        return error;
+      }
+    }
+    if (pageFilter == nullptr) {
+      break;
+    }
+    // the rows of a page are selected when it is entered, and again for
+    // those added since
+    if (filteredPageId != page_scan_now_cur ||
+        page_row_scan_now_cur >= pageFilter->getRowCount()) {
+      pageFilter->evaluate(*scanPage);
+      filteredPageId = page_scan_now_cur;
+    }
+    page_row_scan_now_cur = pageFilter->nextSelectedRow(page_row_scan_now_cur);
+    if (page_row_scan_now_cur < pageFilter->getRowCount()) {
+      break;
     }
   }
+  page::PageHandler &pageHandler = *scanPage;
 
   my_bitmap_map *org_bitmap;
   memset(record, 0, table->s->null_bytes);
   org_bitmap = tmp_use_all_columns(table, table->write_set);
 
-  int fixedSize = 0;
-  for (Field **field = table->field; *field; field++) {
-    fixedSize += (*field)->data_length();
+  if (pageHandler.isPax()) {
+    // only the minipages of the columns the statement reads are touched
+    page::PaxPage paxPage(pageHandler.getPageBody());
+    uchar *value = record + 1;
+    for (Field **field = table->field; *field; field++) {
+      uint32_t column = (*field)->field_index();
+      uint32_t valueSize = paxPage.getColumnSize(column);
+      if (bitmap_is_set(table->read_set, column)) {
+        memcpy(value, paxPage.getValue(page_row_scan_now_cur, column),
+               valueSize);
+      }
+      value += valueSize;
+    }
+  } else {
+    // read fix size columns straight from the pinned page
+    tuple::TupleView tuple = pageHandler.viewTuple(page_row_scan_now_cur);
+    memcpy(record + 1, tuple.getData(), tuple.getSize());
   }
 
-  std::vector<uint8_t> tupleBuf(fixedSize);
-  buf::ReadDescriptor readDescriptor{
-      share->tablespaceId,
-      page_scan_now_cur,
-      page_row_scan_now_cur,
-      share->tablespacePath,
-  };
-  // read fix size columns
-  int tupleSize = bufPool->read(tupleBuf.data(), readDescriptor);
-  memcpy(record + 1, tupleBuf.data(), tupleSize);
-
   tmp_restore_column_map(table->write_set, org_bitmap);
 
-  if (bufPool->isLastTuple(share->tablespaceId, page_scan_now_cur,
-                           page_row_scan_now_cur, share->tablespacePath)) {
-    page_scan_now_cur++;
-    page_row_scan_now_cur = 0;
-  } else {
-    page_row_scan_now_cur++;
-  }
+  page_row_scan_now_cur++;
 
   return 0;
 }
@@ -741,8 +1119,16 @@ int ha_toybox::delete_all_rows() {
   the section "locking functions for mysql" in lock.cc;
   copy_data_between_tables() in sql_table.cc.
 */
-int ha_toybox::external_lock(THD *, int) {
+int ha_toybox::external_lock(THD *, int lock_type) {
   DBUG_TRACE;
+  // toybox has no transactions, the end of the statement is the commit
+  if (lock_type == F_UNLCK && rowsWritten) {
+    rowsWritten = false;
+    // the rows are in the pages, but would be lost in a crash
+    if (!redoLog->commit()) {
+      return HA_ERR_INTERNAL_ERROR;
+    }
+  }
   return 0;
 }
 
@@ -790,6 +1176,217 @@ THR_LOCK_DATA **ha_toybox::store_lock(THD *, THR_LOCK_DATA **to,
   return to;
 }
 
+/**
+  @brief
+  Takes the comparisons of a column of this table with a constant out of
+  the condition of a scan, the whole condition or those ANDed in it, so
+  that rnd_next() evaluates them a page at a time with the compare kernels
+  and skips the rows failing them.
+
+  @details
+  Integer, FLOAT, DOUBLE and DATE columns are compared, the comparison
+  the server would make. The server still evaluates the whole condition
+  on the rows returned, so the condition is returned as is.
+
+  @see
+  predicate::PageFilter
+*/
+const Item *ha_toybox::cond_push(const Item *cond, bool) {
+  DBUG_TRACE;
+  std::vector<predicate::Predicate> predicates;
+  collectPredicates(cond, &predicates);
+  pageFilter.reset();
+  if (!predicates.empty()) {
+    pageFilter.reset(new predicate::PageFilter(std::move(predicates)));
+  }
+  filteredPageId = page::MAX_PAGE_ID;
+  return cond;
+}
+
+/**
+  @brief
+  Called at the end of a statement, the condition pushed for it no longer
+  holds.
+*/
+int ha_toybox::reset() {
+  DBUG_TRACE;
+  pageFilter.reset();
+  filteredPageId = page::MAX_PAGE_ID;
+  return 0;
+}
+
+void ha_toybox::collectPredicates(
+    const Item *cond, std::vector<predicate::Predicate> *predicates) {
+  if (cond->type() == Item::COND_ITEM &&
+      static_cast<const Item_cond *>(cond)->functype() ==
+          Item_func::COND_AND_FUNC) {
+    List_iterator_fast<Item> arguments(
+        *const_cast<Item_cond *>(static_cast<const Item_cond *>(cond))
+             ->argument_list());
+    for (const Item *argument = arguments++; argument != nullptr;
+         argument = arguments++) {
+      collectPredicates(argument, predicates);
+    }
+    return;
+  }
+  predicate::Predicate predicate;
+  if (toPredicate(cond, &predicate)) {
+    predicates->push_back(predicate);
+  }
+}
+
+/**
+  @return whether item compares a column of this table with a literal in
+  a way the compare kernels evaluate exactly, made into comparison
+*/
+bool ha_toybox::toPredicate(const Item *item, predicate::Predicate *comparison) {
+  if (item->type() != Item::FUNC_ITEM) {
+    return false;
+  }
+  const Item_func *func = static_cast<const Item_func *>(item);
+  if (func->argument_count() != 2) {
+    return false;
+  }
+  // the column on the left, 1 < id is id > 1
+  Item *column = func->arguments()[0];
+  Item *constant = func->arguments()[1];
+  bool swapped = column->type() != Item::FIELD_ITEM;
+  if (swapped) {
+    std::swap(column, constant);
+  }
+  switch (func->functype()) {
+    case Item_func::EQ_FUNC:
+      comparison->op = predicate::CompareOp::EQ;
+      break;
+    case Item_func::NE_FUNC:
+      comparison->op = predicate::CompareOp::NE;
+      break;
+    case Item_func::LT_FUNC:
+      comparison->op = swapped ? predicate::CompareOp::GT
+                              : predicate::CompareOp::LT;
+      break;
+    case Item_func::LE_FUNC:
+      comparison->op = swapped ? predicate::CompareOp::GE
+                              : predicate::CompareOp::LE;
+      break;
+    case Item_func::GT_FUNC:
+      comparison->op = swapped ? predicate::CompareOp::LT
+                              : predicate::CompareOp::GT;
+      break;
+    case Item_func::GE_FUNC:
+      comparison->op = swapped ? predicate::CompareOp::LE
+                              : predicate::CompareOp::GE;
+      break;
+    default:
+      return false;
+  }
+  if (column->type() != Item::FIELD_ITEM || !constant->basic_const_item()) {
+    return false;
+  }
+  Field *field = static_cast<Item_field *>(column)->field;
+  if (field->table != table) {
+    return false;
+  }
+
+  bool isUnsigned = field->is_unsigned();
+  switch (field->type()) {
+    case MYSQL_TYPE_TINY:
+      comparison->type =
+          isUnsigned ? predicate::ValueType::UINT8 : predicate::ValueType::INT8;
+      break;
+    case MYSQL_TYPE_SHORT:
+      comparison->type = isUnsigned ? predicate::ValueType::UINT16
+                                   : predicate::ValueType::INT16;
+      break;
+    case MYSQL_TYPE_INT24:
+      comparison->type = isUnsigned ? predicate::ValueType::UINT24
+                                   : predicate::ValueType::INT24;
+      break;
+    case MYSQL_TYPE_LONG:
+      comparison->type = isUnsigned ? predicate::ValueType::UINT32
+                                   : predicate::ValueType::INT32;
+      break;
+    case MYSQL_TYPE_LONGLONG:
+      // an unsigned value past INT64_MAX does not fit the kernels
+      if (isUnsigned) {
+        return false;
+      }
+      comparison->type = predicate::ValueType::INT64;
+      break;
+    case MYSQL_TYPE_FLOAT:
+      comparison->type = predicate::ValueType::FLOAT;
+      break;
+    case MYSQL_TYPE_DOUBLE:
+      comparison->type = predicate::ValueType::DOUBLE;
+      break;
+    case MYSQL_TYPE_DATE:
+      comparison->type = predicate::ValueType::DATE;
+      break;
+    default:
+      return false;
+  }
+  if (field->pack_length() != predicate::getValueSize(comparison->type)) {
+    return false;
+  }
+
+  Item *value = const_cast<Item *>(constant);
+  comparison->intValue = 0;
+  comparison->realValue = 0;
+  if (comparison->type == predicate::ValueType::DATE) {
+    // compared as a DATETIME, only a constant at midnight is a date
+    MYSQL_TIME time;
+    if (value->get_date(&time, 0) || time.hour != 0 || time.minute != 0 ||
+        time.second != 0 || time.second_part != 0) {
+      return false;
+    }
+    comparison->intValue = time.year * 512 + time.month * 32 + time.day;
+  } else if (predicate::isRealValueType(comparison->type)) {
+    // compared as doubles
+    if (value->type() != Item::INT_ITEM &&
+        value->type() != Item::DECIMAL_ITEM &&
+        value->type() != Item::REAL_ITEM) {
+      return false;
+    }
+    comparison->realValue = value->val_real();
+  } else {
+    // an integer column is compared with a DECIMAL or a DOUBLE as one
+    if (value->type() != Item::INT_ITEM) {
+      return false;
+    }
+    comparison->intValue = value->val_int();
+    if (value->unsigned_flag && comparison->intValue < 0) {
+      return false;
+    }
+  }
+  if (value->null_value) {
+    return false;
+  }
+
+  comparison->column = field->field_index();
+  // the columns before it in a tuple of a row page must have a fixed size
+  comparison->valueOffset = 0;
+  for (Field **before = table->field; *before != field; before++) {
+    switch ((*before)->type()) {
+      case MYSQL_TYPE_VARCHAR:
+      case MYSQL_TYPE_VAR_STRING:
+      case MYSQL_TYPE_BLOB:
+      case MYSQL_TYPE_TINY_BLOB:
+      case MYSQL_TYPE_MEDIUM_BLOB:
+      case MYSQL_TYPE_LONG_BLOB:
+      case MYSQL_TYPE_JSON:
+      case MYSQL_TYPE_GEOMETRY:
+        if (share->layout == tablespace::PageLayout::ROW) {
+          return false;
+        }
+        break;
+      default:
+        break;
+    }
+    comparison->valueOffset += (*before)->pack_length();
+  }
+  return true;
+}
+
 /**
   @brief
   Used to delete a table. By the time delete_table() has been called all
@@ -816,8 +1413,14 @@ int ha_toybox::delete_table(const char *from, const dd::Table *) {
   char tablespacePath[FN_REFLEN];
   FileUtil::convertToTableFilePath(tablespacePath, from, tablespace::FILE_EXT);
 
-  tablespace::TablespaceHandler tablespaceHandler = tablespace::TablespaceHandler(tablespacePath);
-  tablespaceHandler.remove();
+  tablespace::TablespaceGuard tablespace =
+      bufPool->getTablespaceCache().open(tablespacePath);
+  if (!tablespace.isValid()) return HA_ERR_NO_SUCH_TABLE;
+  tablespace_id tablespaceId = tablespace.getTablespaceId();
+  tablespace.release();
+  bufPool->discardTablespace(tablespaceId);
+  redoLog->discardTablespace(tablespaceId);
+  bufPool->getTablespaceCache().remove(tablespaceId, tablespacePath);
 
   return 0;
 }
@@ -890,9 +1493,24 @@ static MYSQL_THDVAR_UINT(create_count_thdvar, 0, nullptr, nullptr, nullptr, 0,
  * @param name ex) './[db name]/[tbl name]' without ext
  * @return
  */
-int ha_toybox::create(const char *name, TABLE *, HA_CREATE_INFO *,
-                       dd::Table *) {
+int ha_toybox::create(const char *name, TABLE *table_arg,
+                       HA_CREATE_INFO *create_info, dd::Table *) {
   DBUG_TRACE;
+  tablespace::PageLayout layout;
+  if (!parseLayout(create_info->engine_attribute, &layout)) {
+    return HA_WRONG_CREATE_OPTION;
+  }
+  std::vector<uint32_t> columnSizes;
+  for (Field **field = table_arg->field; *field; field++) {
+    columnSizes.push_back((*field)->pack_length());
+  }
+  if (layout == tablespace::PageLayout::PAX &&
+      (columnSizes.size() > tablespace::MAX_COLUMN_COUNT ||
+       page::PaxPage::computeCapacity(page::PAGE_BODY_SIZE, columnSizes.data(),
+                                      columnSizes.size()) == 0)) {
+    return HA_WRONG_CREATE_OPTION;
+  }
+
   mysql_mutex_lock(&toybox_system_table_lock);
   THD *thd = this->ha_thd();
   // FN_REFLEN is max table path size
@@ -905,24 +1523,85 @@ int ha_toybox::create(const char *name, TABLE *, HA_CREATE_INFO *,
 
   // TRUNCATE TABLE
   if (thd_sql_command(thd) == SQLCOM_TRUNCATE) {
-    tablespace::TablespaceHandler oldTablespace =
-        tablespace::TablespaceHandler(tablespacePath);
-    oldTablespace.remove();
+    tablespace::TablespaceGuard oldTablespace =
+        bufPool->getTablespaceCache().open(tablespacePath);
+    if (oldTablespace.isValid()) {
+      tablespace_id oldTablespaceId = oldTablespace.getTablespaceId();
+      oldTablespace.release();
+      bufPool->discardTablespace(oldTablespaceId);
+      redoLog->discardTablespace(oldTablespaceId);
+      bufPool->getTablespaceCache().remove(oldTablespaceId, tablespacePath);
+    }
   }
   // CREATE TABLE
   tablespace::TablespaceHandler newTablespaceHandler =
       tablespace::TablespaceHandler::create(tablespacePath, maxTablespaceId);
 
   strcpy(get_share()->tablespacePath, tablespacePath);
-
-  page::PageHandler pageHandler = page::PageHandler::reserveNewPage(0);
+  tablespace::SystemPageHeaderImpl &systemPage =
+      newTablespaceHandler.getSystemPageHeader();
+  systemPage.setLayout(layout, columnSizes.data(), columnSizes.size());
+  newTablespaceHandler.flushSystemPageHeader();
+  get_share()->layout = layout;
+
+  page::PageHandler pageHandler =
+      page::PageHandler::reserveNewPage(0, systemPage);
   pageHandler.flush(newTablespaceHandler.getFileDescriptor());
+  // the free space map of the first pages, empty
+  page::PageHandler::reserveNewPage(page::FIRST_FSM_PAGE_ID)
+      .flush(newTablespaceHandler.getFileDescriptor());
+  newTablespaceHandler.getTablespaceHeader().incrementPageCount();
+  newTablespaceHandler.flushTablespaceHeader();
+  get_share()->insertPageId = 0;
+  get_share()->lastPageId = 0;
+  // the redo log only records changes to pages already in the file
+  FileUtil::sync(newTablespaceHandler.getFileDescriptor());
 
   mysql_mutex_unlock(&toybox_system_table_lock);
 
   return 0;
 }
 
+/**
+ * Reads the layout of the pages of a new table from its ENGINE_ATTRIBUTE,
+ * a JSON object such as {"layout": "pax"}. The layout is ROW when the
+ * attribute or the key is missing.
+ * @return false if the attribute is not such an object
+ */
+bool ha_toybox::parseLayout(const LEX_CSTRING &engineAttribute,
+                            tablespace::PageLayout *layout) {
+  *layout = tablespace::PageLayout::ROW;
+  if (engineAttribute.length == 0) {
+    return true;
+  }
+  rapidjson::Document document;
+  document.Parse(engineAttribute.str, engineAttribute.length);
+  if (document.HasParseError() || !document.IsObject()) {
+    return false;
+  }
+  rapidjson::Value::ConstMemberIterator value = document.FindMember("layout");
+  if (value == document.MemberEnd()) {
+    return true;
+  }
+  if (!value->value.IsString()) {
+    return false;
+  }
+  if (strcmp(value->value.GetString(), "pax") == 0) {
+    *layout = tablespace::PageLayout::PAX;
+    return true;
+  }
+  return strcmp(value->value.GetString(), "row") == 0;
+}
+
+/**
+ * @return the bytes a column takes in a tuple, all of it in a PAX table
+ * where every value of a column has the same size
+ */
+uint32_t ha_toybox::getColumnSize(const Field &field) const {
+  return share->layout == tablespace::PageLayout::PAX ? field.pack_length()
+                                                      : field.data_length();
+}
+
 tablespace_id ha_toybox::getNewMaxTablespaceId() {
   system_table::SystemTablespaceHandler systemTablespaceHandler;
   return systemTablespaceHandler.getNewMaxTablespaceId();
@@ -988,7 +1667,281 @@ static MYSQL_THDVAR_LONGLONG(signed_longlong_thdvar, PLUGIN_VAR_RQCMDARG,
                              "LLONG_MIN..LLONG_MAX", nullptr, nullptr, -10,
                              LLONG_MIN, LLONG_MAX, 0);
 
+static void update_flush_rate(THD *, SYS_VAR *, void *var_ptr,
+                              const void *save) {
+  ulong flushRate = *static_cast<const ulong *>(save);
+  *static_cast<ulong *>(var_ptr) = flushRate;
+  bufPool->setFlushRate(flushRate);
+}
+
+static MYSQL_SYSVAR_ULONG(flush_rate, srv_flush_rate, PLUGIN_VAR_RQCMDARG,
+                          "Number of dirty pages the page cleaner writes back "
+                          "per second.",
+                          nullptr, update_flush_rate, buf::DEFAULT_FLUSH_RATE,
+                          1, ULONG_MAX, 0);
+
+static void update_buffer_pool_size(THD *, SYS_VAR *, void *var_ptr,
+                                    const void *save) {
+  ulonglong bufPoolSize = *static_cast<const ulonglong *>(save);
+  *static_cast<ulonglong *>(var_ptr) = bufPoolSize;
+  bufPoolResizer->request(bufPoolSize / page::PAGE_SIZE);
+}
+
+static MYSQL_SYSVAR_ULONGLONG(buffer_pool_size, srv_buffer_pool_size,
+                              PLUGIN_VAR_RQCMDARG,
+                              "Size of the buffer pool in bytes. It is resized "
+                              "in the background a chunk at a time, see "
+                              "toybox_buffer_pool_resize_status.",
+                              nullptr, update_buffer_pool_size,
+                              buf::DEFAULT_BUFFER_POOL_SIZE, page::PAGE_SIZE,
+                              ULLONG_MAX, page::PAGE_SIZE);
+
+static MYSQL_SYSVAR_ULONGLONG(buffer_pool_chunk_size,
+                              srv_buffer_pool_chunk_size,
+                              PLUGIN_VAR_RQCMDARG | PLUGIN_VAR_READONLY,
+                              "Bytes of each buffer pool instance allocated or "
+                              "freed at a time when the buffer pool is resized.",
+                              nullptr, nullptr,
+                              buf::DEFAULT_CHUNK_PAGES * page::PAGE_SIZE,
+                              page::PAGE_SIZE, ULLONG_MAX, page::PAGE_SIZE);
+
+static MYSQL_SYSVAR_ULONG(buffer_pool_instances, srv_buffer_pool_instances,
+                          PLUGIN_VAR_RQCMDARG | PLUGIN_VAR_READONLY,
+                          "Number of buffer pool instances. Pages are spread "
+                          "over them by (tablespace_id, page_id).",
+                          nullptr, nullptr, buf::DEFAULT_INSTANCE_COUNT, 1,
+                          buf::MAX_INSTANCE_COUNT, 0);
+
+const char *buffer_pool_huge_pages_names[] = {"OFF", "TRANSPARENT",
+                                              "EXPLICIT", NullS};
+
+TYPELIB buffer_pool_huge_pages_typelib = {
+    array_elements(buffer_pool_huge_pages_names) - 1,
+    "buffer_pool_huge_pages_typelib", buffer_pool_huge_pages_names, nullptr};
+
+static MYSQL_SYSVAR_ENUM(buffer_pool_huge_pages, srv_buffer_pool_huge_pages,
+                         PLUGIN_VAR_RQCMDARG | PLUGIN_VAR_READONLY,
+                         "Back the buffer pool frames with huge pages. "
+                         "TRANSPARENT asks for transparent huge pages, "
+                         "EXPLICIT uses reserved ones and falls back to normal "
+                         "pages when there are not enough.",
+                         nullptr, nullptr,
+                         static_cast<ulong>(buf::HugePageMode::OFF),
+                         &buffer_pool_huge_pages_typelib);
+
+static MYSQL_SYSVAR_ULONG(read_ahead_window, srv_read_ahead_window,
+                          PLUGIN_VAR_RQCMDARG,
+                          "Number of pages a table scan reads ahead in the "
+                          "background. 0 disables read-ahead.",
+                          nullptr, nullptr, buf::DEFAULT_READ_AHEAD_WINDOW, 0,
+                          buf::MAX_READ_AHEAD_WINDOW, 0);
+
+static void update_old_blocks_pct(THD *, SYS_VAR *, void *var_ptr,
+                                  const void *save) {
+  ulong pct = *static_cast<const ulong *>(save);
+  *static_cast<ulong *>(var_ptr) = pct;
+  bufPool->setOldBlocksPct(pct);
+}
+
+static MYSQL_SYSVAR_ULONG(old_blocks_pct, srv_old_blocks_pct,
+                          PLUGIN_VAR_RQCMDARG,
+                          "Percentage of the buffer pool LRU list kept as the "
+                          "old segment, where newly read pages enter.",
+                          nullptr, update_old_blocks_pct,
+                          buf::DEFAULT_OLD_BLOCKS_PCT, buf::MIN_OLD_BLOCKS_PCT,
+                          buf::MAX_OLD_BLOCKS_PCT, 0);
+
+static void update_old_blocks_time(THD *, SYS_VAR *, void *var_ptr,
+                                   const void *save) {
+  ulong milliseconds = *static_cast<const ulong *>(save);
+  *static_cast<ulong *>(var_ptr) = milliseconds;
+  bufPool->setOldBlocksTime(milliseconds);
+}
+
+static MYSQL_SYSVAR_ULONG(old_blocks_time, srv_old_blocks_time,
+                          PLUGIN_VAR_RQCMDARG,
+                          "Milliseconds a page stays in the old segment after "
+                          "its first access before another access can make it "
+                          "young.",
+                          nullptr, update_old_blocks_time,
+                          buf::DEFAULT_OLD_BLOCKS_TIME, 0, UINT_MAX32, 0);
+
+static MYSQL_SYSVAR_BOOL(buffer_pool_dump_at_shutdown,
+                         srv_buffer_pool_dump_at_shutdown, PLUGIN_VAR_RQCMDARG,
+                         "Write the list of cached pages to "
+                         "./toybox_buffer_pool at shutdown.",
+                         nullptr, nullptr, true);
+
+static MYSQL_SYSVAR_BOOL(buffer_pool_load_at_startup,
+                         srv_buffer_pool_load_at_startup,
+                         PLUGIN_VAR_RQCMDARG | PLUGIN_VAR_READONLY,
+                         "Read the pages listed in ./toybox_buffer_pool back "
+                         "into the buffer pool in the background at startup.",
+                         nullptr, nullptr, true);
+
+static void update_buffer_pool_dump_interval(THD *, SYS_VAR *, void *var_ptr,
+                                             const void *save) {
+  ulong seconds = *static_cast<const ulong *>(save);
+  *static_cast<ulong *>(var_ptr) = seconds;
+  bufPoolDump->setDumpInterval(seconds);
+}
+
+static MYSQL_SYSVAR_ULONG(buffer_pool_dump_interval,
+                          srv_buffer_pool_dump_interval, PLUGIN_VAR_RQCMDARG,
+                          "Seconds between dumps of the buffer pool. 0 dumps "
+                          "only at shutdown.",
+                          nullptr, update_buffer_pool_dump_interval, 0, 0,
+                          UINT_MAX32, 0);
+
+static void update_buffer_pool_dump_pct(THD *, SYS_VAR *, void *var_ptr,
+                                        const void *save) {
+  ulong pct = *static_cast<const ulong *>(save);
+  *static_cast<ulong *>(var_ptr) = pct;
+  bufPoolDump->setDumpPct(pct);
+}
+
+static MYSQL_SYSVAR_ULONG(buffer_pool_dump_pct, srv_buffer_pool_dump_pct,
+                          PLUGIN_VAR_RQCMDARG,
+                          "Percentage of the most recently used pages of each "
+                          "buffer pool instance to dump.",
+                          nullptr, update_buffer_pool_dump_pct,
+                          buf::DEFAULT_DUMP_PCT, 1, 100, 0);
+
+static void update_open_files(THD *, SYS_VAR *, void *var_ptr,
+                              const void *save) {
+  ulong openFiles = *static_cast<const ulong *>(save);
+  *static_cast<ulong *>(var_ptr) = openFiles;
+  bufPool->getTablespaceCache().setCapacity(getOpenFilesCapacity(openFiles));
+}
+
+static MYSQL_SYSVAR_ULONG(open_files, srv_open_files, PLUGIN_VAR_RQCMDARG,
+                          "Tablespace files kept open for reading and writing "
+                          "pages. The least recently used ones are closed "
+                          "beyond it. 0 uses half of open_files_limit.",
+                          nullptr, update_open_files, 0, 0, UINT_MAX32, 0);
+
+const char *io_mode_names[] = {"BUFFERED", "DIRECT", "MMAP", NullS};
+
+TYPELIB io_mode_typelib = {array_elements(io_mode_names) - 1,
+                           "io_mode_typelib", io_mode_names, nullptr};
+
+static MYSQL_SYSVAR_ENUM(io_mode, srv_io_mode,
+                         PLUGIN_VAR_RQCMDARG | PLUGIN_VAR_READONLY,
+                         "How tablespace files are read and written. DIRECT "
+                         "bypasses the OS page cache with O_DIRECT, so that "
+                         "pages are only cached by the buffer pool; files on "
+                         "file systems without direct I/O stay BUFFERED. MMAP "
+                         "is meant for tables that are mostly read: table "
+                         "scans read the pages the buffer pool does not hold "
+                         "in place from a read-only mapping of the file, "
+                         "writes still go through the buffer pool.",
+                         nullptr, nullptr,
+                         static_cast<ulong>(file_handler::IoMode::BUFFERED),
+                         &io_mode_typelib);
+
+static MYSQL_SYSVAR_BOOL(use_native_aio, srv_use_native_aio,
+                         PLUGIN_VAR_RQCMDARG | PLUGIN_VAR_READONLY,
+                         "Read and write pages with io_uring when the kernel "
+                         "supports it, with a pool of I/O threads otherwise.",
+                         nullptr, nullptr, true);
+
+static MYSQL_SYSVAR_ULONG(io_rings, srv_io_rings,
+                          PLUGIN_VAR_RQCMDARG | PLUGIN_VAR_READONLY,
+                          "Number of io_uring instances submitting page reads "
+                          "and writes. Without io_uring, each ring is served "
+                          "by 4 I/O threads.",
+                          nullptr, nullptr, file_handler::DEFAULT_IO_RINGS, 1,
+                          file_handler::MAX_IO_RINGS, 0);
+
+static MYSQL_SYSVAR_ULONG(io_queue_depth, srv_io_queue_depth,
+                          PLUGIN_VAR_RQCMDARG | PLUGIN_VAR_READONLY,
+                          "Number of page reads and writes each ring keeps in "
+                          "flight.",
+                          nullptr, nullptr,
+                          file_handler::DEFAULT_IO_QUEUE_DEPTH, 1,
+                          file_handler::MAX_IO_QUEUE_DEPTH, 0);
+
+const char *log_durability_names[] = {"COMMIT", "SECOND", "NONE", NullS};
+
+TYPELIB log_durability_typelib = {array_elements(log_durability_names) - 1,
+                                  "log_durability_typelib",
+                                  log_durability_names, nullptr};
+
+static void update_log_durability(THD *, SYS_VAR *, void *var_ptr,
+                                  const void *save) {
+  ulong durability = *static_cast<const ulong *>(save);
+  *static_cast<ulong *>(var_ptr) = durability;
+  redoLog->setDurability(static_cast<redo::Durability>(durability));
+}
+
+static MYSQL_SYSVAR_ENUM(log_durability, srv_log_durability,
+                         PLUGIN_VAR_RQCMDARG,
+                         "When the redo records of a statement are synced to "
+                         "disk. COMMIT syncs them before the statement "
+                         "returns, statements committing together share one "
+                         "sync. SECOND syncs them once per second, so a crash "
+                         "of the OS loses up to a second of changes. NONE "
+                         "leaves them to the OS until the pages they changed "
+                         "are written.",
+                         nullptr, update_log_durability,
+                         static_cast<ulong>(redo::Durability::COMMIT),
+                         &log_durability_typelib);
+
+static MYSQL_SYSVAR_ULONGLONG(log_buffer_size, srv_log_buffer_size,
+                              PLUGIN_VAR_RQCMDARG | PLUGIN_VAR_READONLY,
+                              "Bytes of redo records kept in memory before "
+                              "they are written to the log file.",
+                              nullptr, nullptr, redo::DEFAULT_LOG_BUFFER_SIZE,
+                              redo::MIN_LOG_BUFFER_SIZE, ULLONG_MAX, 0);
+
+static void update_log_max_checkpoint_age(THD *, SYS_VAR *, void *var_ptr,
+                                          const void *save) {
+  ulonglong maxAge = *static_cast<const ulonglong *>(save);
+  *static_cast<ulonglong *>(var_ptr) = maxAge;
+  checkpointer->setMaxAge(maxAge);
+}
+
+static MYSQL_SYSVAR_ULONGLONG(log_max_checkpoint_age,
+                              srv_log_max_checkpoint_age, PLUGIN_VAR_RQCMDARG,
+                              "Bytes of redo records after the checkpoint, "
+                              "which bounds the time recovery takes after a "
+                              "crash. Pages are flushed faster once half of it "
+                              "is used; past it, statements flush the oldest "
+                              "pages themselves before logging changes.",
+                              nullptr, update_log_max_checkpoint_age,
+                              redo::DEFAULT_MAX_CHECKPOINT_AGE,
+                              redo::MIN_MAX_CHECKPOINT_AGE, ULLONG_MAX, 0);
+
+static MYSQL_SYSVAR_ULONG(recovery_threads, srv_recovery_threads,
+                          PLUGIN_VAR_RQCMDARG | PLUGIN_VAR_READONLY,
+                          "Number of threads applying the redo log at "
+                          "startup. The records of a page are applied by one "
+                          "of them, in order.",
+                          nullptr, nullptr, redo::DEFAULT_RECOVERY_THREADS, 1,
+                          redo::MAX_RECOVERY_THREADS, 0);
+
 static SYS_VAR *toybox_system_variables[] = {
+    MYSQL_SYSVAR(buffer_pool_size),
+    MYSQL_SYSVAR(buffer_pool_chunk_size),
+    MYSQL_SYSVAR(flush_rate),
+    MYSQL_SYSVAR(buffer_pool_instances),
+    MYSQL_SYSVAR(buffer_pool_huge_pages),
+    MYSQL_SYSVAR(read_ahead_window),
+    MYSQL_SYSVAR(old_blocks_pct),
+    MYSQL_SYSVAR(old_blocks_time),
+    MYSQL_SYSVAR(buffer_pool_dump_at_shutdown),
+    MYSQL_SYSVAR(buffer_pool_load_at_startup),
+    MYSQL_SYSVAR(buffer_pool_dump_interval),
+    MYSQL_SYSVAR(buffer_pool_dump_pct),
+    MYSQL_SYSVAR(open_files),
+    MYSQL_SYSVAR(io_mode),
+    MYSQL_SYSVAR(use_native_aio),
+    MYSQL_SYSVAR(io_rings),
+    MYSQL_SYSVAR(io_queue_depth),
+    MYSQL_SYSVAR(log_durability),
+    MYSQL_SYSVAR(log_buffer_size),
+    MYSQL_SYSVAR(log_max_checkpoint_age),
+    MYSQL_SYSVAR(recovery_threads),
     MYSQL_SYSVAR(enum_var),
     MYSQL_SYSVAR(ulong_var),
     MYSQL_SYSVAR(double_var),
@@ -1003,52 +1956,174 @@ static SYS_VAR *toybox_system_variables[] = {
     MYSQL_SYSVAR(signed_longlong_thdvar),
     nullptr};
 
-// this is an toybox of SHOW_FUNC
-static int show_func_toybox(MYSQL_THD, SHOW_VAR *var, char *buf) {
+static int show_counter(SHOW_VAR *var, char *buf,
+                        const buf::ShardedCounter &counter) {
+  var->type = SHOW_LONGLONG;
+  var->value = buf;
+  *reinterpret_cast<longlong *>(buf) = counter.load();
+  return 0;
+}
+
+static int show_page_lookups(MYSQL_THD, SHOW_VAR *var, char *buf) {
+  return show_counter(var, buf, bufPool->getStats().pageLookups);
+}
+
+static int show_page_hits(MYSQL_THD, SHOW_VAR *var, char *buf) {
+  return show_counter(var, buf, bufPool->getStats().pageHits);
+}
+
+static int show_page_misses(MYSQL_THD, SHOW_VAR *var, char *buf) {
+  return show_counter(var, buf, bufPool->getStats().pageMisses);
+}
+
+static int show_pages_evicted(MYSQL_THD, SHOW_VAR *var, char *buf) {
+  return show_counter(var, buf, bufPool->getStats().pagesEvicted);
+}
+
+static int show_pages_dirty(MYSQL_THD, SHOW_VAR *var, char *buf) {
+  return show_counter(var, buf, bufPool->getStats().pagesDirty);
+}
+
+static int show_pages_flushed(MYSQL_THD, SHOW_VAR *var, char *buf) {
+  return show_counter(var, buf, bufPool->getStats().pagesFlushed);
+}
+
+static int show_read_ahead_pages(MYSQL_THD, SHOW_VAR *var, char *buf) {
+  return show_counter(var, buf, bufPool->getStats().readAheadPages);
+}
+
+static int show_read_ahead_hits(MYSQL_THD, SHOW_VAR *var, char *buf) {
+  return show_counter(var, buf, bufPool->getStats().readAheadHits);
+}
+
+static int show_read_ahead_evicted(MYSQL_THD, SHOW_VAR *var, char *buf) {
+  return show_counter(var, buf, bufPool->getStats().readAheadEvicted);
+}
+
+static int show_bytes_read(MYSQL_THD, SHOW_VAR *var, char *buf) {
+  return show_counter(var, buf, bufPool->getStats().bytesRead);
+}
+
+static int show_bytes_written(MYSQL_THD, SHOW_VAR *var, char *buf) {
+  return show_counter(var, buf, bufPool->getStats().bytesWritten);
+}
+
+static int show_open_files(MYSQL_THD, SHOW_VAR *var, char *buf) {
+  var->type = SHOW_LONGLONG;
+  var->value = buf;
+  *reinterpret_cast<longlong *>(buf) =
+      bufPool->getTablespaceCache().getOpenFileCount();
+  return 0;
+}
+
+static int show_io_engine(MYSQL_THD, SHOW_VAR *var, char *) {
   var->type = SHOW_CHAR;
-  var->value = buf;  // it's of SHOW_VAR_FUNC_BUFF_SIZE bytes
-  snprintf(buf, SHOW_VAR_FUNC_BUFF_SIZE,
-           "enum_var is %lu, ulong_var is %lu, "
-           "double_var is %f, signed_int_var is %d, "
-           "signed_long_var is %ld, signed_longlong_var is %lld",
-           srv_enum_var, srv_ulong_var, srv_double_var, srv_signed_int_var,
-           srv_signed_long_var, srv_signed_longlong_var);
+  var->value = const_cast<char *>(bufPool->getAioEngineName());
   return 0;
 }
 
-struct toybox_vars_t {
-  ulong var1;
-  double var2;
-  char var3[64];
-  bool var4;
-  bool var5;
-  ulong var6;
-};
+static int show_redo_log_lsn(MYSQL_THD, SHOW_VAR *var, char *buf) {
+  var->type = SHOW_LONGLONG;
+  var->value = buf;
+  *reinterpret_cast<longlong *>(buf) = redoLog->getCurrentLsn();
+  return 0;
+}
 
-toybox_vars_t toybox_vars = {100, 20.01, "three hundred", true, false, 8250};
+static int show_redo_log_flushed_lsn(MYSQL_THD, SHOW_VAR *var, char *buf) {
+  var->type = SHOW_LONGLONG;
+  var->value = buf;
+  *reinterpret_cast<longlong *>(buf) = redoLog->getFlushedLsn();
+  return 0;
+}
 
-static SHOW_VAR show_status_toybox[] = {
-    {"var1", (char *)&toybox_vars.var1, SHOW_LONG, SHOW_SCOPE_GLOBAL},
-    {"var2", (char *)&toybox_vars.var2, SHOW_DOUBLE, SHOW_SCOPE_GLOBAL},
-    {nullptr, nullptr, SHOW_UNDEF,
-     SHOW_SCOPE_UNDEF}  // null terminator required
-};
+static int show_redo_log_syncs(MYSQL_THD, SHOW_VAR *var, char *buf) {
+  var->type = SHOW_LONGLONG;
+  var->value = buf;
+  *reinterpret_cast<longlong *>(buf) = redoLog->getSyncCount();
+  return 0;
+}
 
-static SHOW_VAR show_array_toybox[] = {
-    {"array", (char *)show_status_toybox, SHOW_ARRAY, SHOW_SCOPE_GLOBAL},
-    {"var3", (char *)&toybox_vars.var3, SHOW_CHAR, SHOW_SCOPE_GLOBAL},
-    {"var4", (char *)&toybox_vars.var4, SHOW_BOOL, SHOW_SCOPE_GLOBAL},
-    {nullptr, nullptr, SHOW_UNDEF, SHOW_SCOPE_UNDEF}};
+static int show_redo_log_checkpoint_lsn(MYSQL_THD, SHOW_VAR *var,
+                                        char *buf) {
+  var->type = SHOW_LONGLONG;
+  var->value = buf;
+  *reinterpret_cast<longlong *>(buf) = redoLog->getCheckpointLsn();
+  return 0;
+}
+
+static int show_redo_log_checkpoint_age(MYSQL_THD, SHOW_VAR *var,
+                                        char *buf) {
+  var->type = SHOW_LONGLONG;
+  var->value = buf;
+  *reinterpret_cast<longlong *>(buf) = checkpointer->getAge();
+  return 0;
+}
+
+static int show_redo_log_sync_flushes(MYSQL_THD, SHOW_VAR *var, char *buf) {
+  var->type = SHOW_LONGLONG;
+  var->value = buf;
+  *reinterpret_cast<longlong *>(buf) = checkpointer->getSyncFlushCount();
+  return 0;
+}
+
+static int show_buffer_pool_load_status(MYSQL_THD, SHOW_VAR *var, char *buf) {
+  var->type = SHOW_CHAR;
+  var->value = buf;  // it's of SHOW_VAR_FUNC_BUFF_SIZE bytes
+  bufPoolDump->getLoadStatus(buf, SHOW_VAR_FUNC_BUFF_SIZE);
+  return 0;
+}
+
+static int show_buffer_pool_resize_status(MYSQL_THD, SHOW_VAR *var,
+                                          char *buf) {
+  var->type = SHOW_CHAR;
+  var->value = buf;  // it's of SHOW_VAR_FUNC_BUFF_SIZE bytes
+  bufPoolResizer->getResizeStatus(buf, SHOW_VAR_FUNC_BUFF_SIZE);
+  return 0;
+}
 
 static SHOW_VAR func_status[] = {
-    {"toybox_func_toybox", (char *)show_func_toybox, SHOW_FUNC,
+    {"toybox_buffer_pool_page_lookups", (char *)show_page_lookups, SHOW_FUNC,
+     SHOW_SCOPE_GLOBAL},
+    {"toybox_buffer_pool_page_hits", (char *)show_page_hits, SHOW_FUNC,
+     SHOW_SCOPE_GLOBAL},
+    {"toybox_buffer_pool_page_misses", (char *)show_page_misses, SHOW_FUNC,
+     SHOW_SCOPE_GLOBAL},
+    {"toybox_buffer_pool_pages_evicted", (char *)show_pages_evicted, SHOW_FUNC,
+     SHOW_SCOPE_GLOBAL},
+    {"toybox_buffer_pool_pages_dirty", (char *)show_pages_dirty, SHOW_FUNC,
+     SHOW_SCOPE_GLOBAL},
+    {"toybox_buffer_pool_pages_flushed", (char *)show_pages_flushed, SHOW_FUNC,
+     SHOW_SCOPE_GLOBAL},
+    {"toybox_read_ahead_pages", (char *)show_read_ahead_pages, SHOW_FUNC,
+     SHOW_SCOPE_GLOBAL},
+    {"toybox_read_ahead_hits", (char *)show_read_ahead_hits, SHOW_FUNC,
+     SHOW_SCOPE_GLOBAL},
+    {"toybox_read_ahead_evicted", (char *)show_read_ahead_evicted, SHOW_FUNC,
+     SHOW_SCOPE_GLOBAL},
+    {"toybox_buffer_pool_bytes_read", (char *)show_bytes_read, SHOW_FUNC,
+     SHOW_SCOPE_GLOBAL},
+    {"toybox_buffer_pool_bytes_written", (char *)show_bytes_written, SHOW_FUNC,
+     SHOW_SCOPE_GLOBAL},
+    {"toybox_tablespace_files_open", (char *)show_open_files, SHOW_FUNC,
      SHOW_SCOPE_GLOBAL},
-    {"toybox_status_var5", (char *)&toybox_vars.var5, SHOW_BOOL,
+    {"toybox_io_engine", (char *)show_io_engine, SHOW_FUNC,
      SHOW_SCOPE_GLOBAL},
-    {"toybox_status_var6", (char *)&toybox_vars.var6, SHOW_LONG,
+    {"toybox_redo_log_lsn", (char *)show_redo_log_lsn, SHOW_FUNC,
      SHOW_SCOPE_GLOBAL},
-    {"toybox_status", (char *)show_array_toybox, SHOW_ARRAY,
+    {"toybox_redo_log_flushed_lsn", (char *)show_redo_log_flushed_lsn,
+     SHOW_FUNC, SHOW_SCOPE_GLOBAL},
+    {"toybox_redo_log_syncs", (char *)show_redo_log_syncs, SHOW_FUNC,
      SHOW_SCOPE_GLOBAL},
+    {"toybox_redo_log_checkpoint_lsn", (char *)show_redo_log_checkpoint_lsn,
+     SHOW_FUNC, SHOW_SCOPE_GLOBAL},
+    {"toybox_redo_log_checkpoint_age", (char *)show_redo_log_checkpoint_age,
+     SHOW_FUNC, SHOW_SCOPE_GLOBAL},
+    {"toybox_redo_log_sync_flushes", (char *)show_redo_log_sync_flushes,
+     SHOW_FUNC, SHOW_SCOPE_GLOBAL},
+    {"toybox_buffer_pool_load_status", (char *)show_buffer_pool_load_status,
+     SHOW_FUNC, SHOW_SCOPE_GLOBAL},
+    {"toybox_buffer_pool_resize_status",
+     (char *)show_buffer_pool_resize_status, SHOW_FUNC, SHOW_SCOPE_GLOBAL},
     {nullptr, nullptr, SHOW_UNDEF, SHOW_SCOPE_UNDEF}};
 
 mysql_declare_plugin(toybox){
@@ -39,7 +39,11 @@
 */
 
 #include <sys/types.h>
+#include <atomic>
 #include <cinttypes>
+#include <memory>
+#include <optional>
+#include <vector>
 
 #include "my_base.h" /* ha_rows */
 #include "my_compiler.h"
@@ -48,9 +52,11 @@
 #include "thr_lock.h"    /* THR_LOCK, THR_LOCK_DATA */
 
 #include "bufpool.h"
+#include "predicate.h"
 #include "sql_string.h"
 #include "system_tablespace.h"
 #include "tablespace.h"
+#include "tablespace_mapping.h"
 
 #define PLUGIN_AUTHOR_ME "lrf141"
 
@@ -64,6 +70,13 @@ class Toybox_share : public Handler_share {
   // example: [database name]/[table name].[ext]
   char tablespacePath[FN_REFLEN];
   tablespace_id tablespaceId;
+  // the page rows are inserted into, the last page or one the free space
+  // map found room in, and the last page of the chain. MAX_PAGE_ID until
+  // the table is first opened.
+  std::atomic<page_id> insertPageId{page::MAX_PAGE_ID};
+  std::atomic<page_id> lastPageId{page::MAX_PAGE_ID};
+  // how the pages of the table lay out rows, read when it is opened
+  tablespace::PageLayout layout{tablespace::PageLayout::ROW};
 
   Toybox_share();
   ~Toybox_share() override {
@@ -80,6 +93,27 @@ class ha_toybox : public handler {
   Toybox_share *get_share();  ///< Get the share
   uint64_t page_scan_now_cur = 0;
   uint64_t page_row_scan_now_cur = 0;
+  // the page under the scan cursor, shared latched across rnd_next() calls
+  buf::PageGuard scanGuard;
+  // in MMAP mode, the page under the scan cursor when it is not in the
+  // buffer pool, viewed in scanMapping
+  std::shared_ptr<const tablespace::TablespaceMapping> scanMapping;
+  std::optional<page::PageHandler> mappedPage;
+  // points into scanGuard or mappedPage
+  page::PageHandler *scanPage = nullptr;
+  // rnd_init(scan=true), pages ahead of the cursor are read in advance
+  bool sequentialScan = false;
+  // rows were written since the table was locked, their redo records are
+  // committed when it is unlocked
+  bool rowsWritten = false;
+  // the comparisons taken from cond_push(), evaluated a page at a time so
+  // that rnd_next() skips the rows failing them. Dropped by reset().
+  std::unique_ptr<predicate::PageFilter> pageFilter;
+  // the page pageFilter was last evaluated on
+  page_id filteredPageId = page::MAX_PAGE_ID;
+  int fixScanPage();
+  bool mapScanPage();
+  void releaseScanPage();
 
  public:
   ha_toybox(handlerton *hton, TABLE_SHARE *table_arg);
@@ -286,7 +320,16 @@ class ha_toybox : public handler {
       THD *thd, THR_LOCK_DATA **to,
       enum thr_lock_type lock_type) override;  ///< required
 
-  void insert_to_page(uchar *record);
+  const Item *cond_push(const Item *cond, bool other_tbls_ok) override;
+  int reset() override;
 
+  int insert_to_page(uchar *record);
+  uint32_t getColumnSize(const Field &field) const;
+  void collectPredicates(const Item *cond,
+                         std::vector<predicate::Predicate> *predicates);
+  bool toPredicate(const Item *item, predicate::Predicate *comparison);
+
+  static bool parseLayout(const LEX_CSTRING &engineAttribute,
+                          tablespace::PageLayout *layout);
   tablespace_id getNewMaxTablespaceId();
 };
@@ -2,9 +2,19 @@
 #define TOYBOX_BUFFER_H
 
 #include <stdlib.h>
+#include <memory>
+#include <set>
+#include <vector>
 
+#include "bufpool_instance.h"
+#include "bufpool_stats.h"
+#include "file_aio.h"
+#include "frame_arena.h"
+#include "read_ahead.h"
+#include "redo_log.h"
 #include "page.h"
 #include "page_type.h"
+#include "tablespace_cache.h"
 #include "tablespace_type.h"
 #include "sql/psi_memory_key.h"
 #include "my_inttypes.h"
@@ -12,56 +22,118 @@
 
 namespace buf {
 
-struct ReadDescriptor {
-  tablespace_id tablespaceId;
-  page_id pageId;
-  uint64_t tupleCursor;
-  char *tablespacePath;
-};
-
-struct WriteDescriptor {
-  tablespace_id tablespaceId;
-  page_id pageId;
-  char *tablespacePath;
-  tuple::Tuple *tuple;
-};
-
-struct Element {
-  uint64_t tableSpaceId;
-  uint64_t refCount;
-  page::PageHandler pageHandler;
-  Element *next;
-  Element(tablespace_id tablespaceId, page::PageHandler page)
-      : tableSpaceId(tablespaceId),
-        refCount(0),
-        pageHandler(page),
-        next(nullptr) {}
-  page::PageHandler& getPageHandler() {
-    return pageHandler;
-  }
-};
-
-typedef struct Element Element;
+constexpr const uint64_t DEFAULT_BUFFER_POOL_SIZE = 8 * 1024 * 1024; // bytes
+constexpr const uint64_t DEFAULT_INSTANCE_COUNT = 1;
+constexpr const uint64_t MAX_INSTANCE_COUNT = 64;
+// adjacent pages of a tablespace are kept in the same instance in groups
+// of this many pages, so that runs of them can still be flushed together.
+constexpr const uint64_t INSTANCE_PAGE_GROUP = 64;
+// frames each instance gets from one buffer pool chunk. The pool grows and
+// shrinks a chunk at a time.
+constexpr const uint64_t DEFAULT_CHUNK_PAGES = 256;
+// frames of an instance freed at a time while shrinking, so that
+// foreground threads get the instance mutex in between
+constexpr const uint64_t RESIZE_BATCH_SIZE = 64;
 
+/**
+ * The buffer pool, split into instances chosen by hashing
+ * (tablespace_id, page_id). Each call is routed to the instance owning the
+ * page and only takes that instance's mutex.
+ *
+ * The frames are allocated in chunks, each split evenly between the
+ * instances, so that the pool can be resized while it is in use.
+ */
 class BufPool {
  private:
-  uint64_t maxPageCount;
-  void readFromFile(tablespace_id tablespaceId, page_id pageId,
-                    const char *tablespacePath);
-  void releaseAllPage();
+  std::vector<BufPoolInstance *> instances;
+  // counters of every instance, reset by init_buffer_pool()
+  std::unique_ptr<BufPoolStats> stats;
+  // the open tablespace files every instance reads and writes pages with
+  tablespace::TablespaceCache tablespaceCache;
+  // performs the page reads and writes of every instance
+  file_handler::AioEngine *aio = nullptr;
+  // the frames of every instance, the last chunk is removed first
+  std::vector<FrameArena *> chunks;
+  PSI_memory_key memoryKey;
+  HugePageMode hugePageMode = HugePageMode::OFF;
+  uint64_t chunkPages = DEFAULT_CHUNK_PAGES;
+  // serializes resize()
+  mutable mysql_mutex_t resizeMutex;
+  ReadAhead readAheadThread;
+  // tablespaces with a prefetch in progress, discardTablespace() waits for
+  // them before the file can be removed.
+  mysql_mutex_t prefetchMutex;
+  mysql_cond_t prefetchCond;
+  std::multiset<tablespace_id> prefetchingTablespaces;
+  redo::RedoLog *redoLog = nullptr;
+  BufPoolInstance *getInstance(tablespace_id tablespaceId,
+                               page_id pageId) const;
+  uint64_t getChunkPages(const FrameArena *chunk) const;
+  bool addChunk(uint64_t pagesPerInstance);
+  void removeChunk();
  public:
-  Element *elements = nullptr;
-  void init_buffer_pool(PSI_memory_key buf, int bufPoolSize);
-  void deinit_buffer_pool();
+  bool init_buffer_pool(PSI_memory_key buf, uint64_t bufPoolSize,
+                        int instanceCount = DEFAULT_INSTANCE_COUNT,
+                        HugePageMode hugePages = HugePageMode::OFF,
+                        uint64_t chunkPages = DEFAULT_CHUNK_PAGES,
+                        const file_handler::AioConfig &aioConfig =
+                            file_handler::AioConfig());
+  bool deinit_buffer_pool();
+  void setRedoLog(redo::RedoLog *redoLog);
+  bool resize(uint64_t bufPoolSize);
+  PageGuard fixPage(tablespace_id tablespaceId, page_id pageId,
+                    const char *tablespacePath, LatchMode mode);
   int read(uchar *buf, ReadDescriptor readDescriptor);
-  void write(uchar *buf, WriteDescriptor writeDescriptor);
+  WriteResult write(uchar *buf, WriteDescriptor writeDescriptor);
+  page_id allocatePage(tablespace_id tablespaceId, page_id lastPageId,
+                       const char *tablespacePath);
+  page_id findLastPage(tablespace_id tablespaceId, page_id hintPageId,
+                       const char *tablespacePath);
+  void updateFreeSpace(tablespace_id tablespaceId, page_id pageId,
+                       const char *tablespacePath);
+  page_id findPageWithSpace(tablespace_id tablespaceId, uint32_t tupleSize,
+                            const char *tablespacePath);
   Element* getElement(tablespace_id tablespaceId, page_id pageId);
+  Element* putPage(tablespace_id tablespaceId, page::PageHandler page,
+                   const char *tablespacePath);
   bool isLastPage(tablespace_id tablespaceId, page_id pageId, const char *tablespacePath);
   bool isLastTuple(tablespace_id tablespaceId, page_id pageId, uint64_t tupleCursor, const char *tablespacePath);
   bool existPage(tablespace_id tablespaceId, page_id pageId) const;
-  Element *getLastElement() const;
+  uint64_t getInstanceCount() const;
+  uint64_t getPageCount() const;
+  uint64_t getMaxPageCount() const;
+  uint64_t getChunkCount() const;
+  const FrameArena &getChunk(uint64_t index) const;
+  uint64_t getDirtyPageCount() const;
+  uint64_t getReadAheadPageCount() const;
+  uint64_t getReadAheadHitCount() const;
+  uint64_t getReadAheadEvictedCount() const;
+  const BufPoolStats &getStats() const;
+  tablespace::TablespaceCache &getTablespaceCache();
+  const char *getAioEngineName() const;
+  uint64_t getOldPageCount() const;
+  uint64_t getYoungMadeCount() const;
+  void setOldBlocksPct(uint64_t pct);
+  void setOldBlocksTime(uint64_t milliseconds);
+  void startPageCleaner(uint64_t pagesPerSecond);
+  void stopPageCleaner();
+  void setFlushRate(uint64_t pagesPerSecond);
+  void startReadAhead();
+  void stopReadAhead();
+  void readAhead(tablespace_id tablespaceId, page_id firstPageId,
+                 uint64_t pageCount, const char *tablespacePath);
+  uint64_t prefetchPages(tablespace_id tablespaceId, page_id firstPageId,
+                         uint64_t pageCount, const char *tablespacePath,
+                         bool readAhead = true);
+  std::vector<PageRun> collectPages(uint64_t pct) const;
+  uint64_t flushDirtyPages(uint64_t maxFlushCount);
+  uint64_t flushOldestPages(lsn_t targetLsn, uint64_t maxFlushCount);
+  lsn_t getOldestModification() const;
+  bool syncWrittenTablespaces();
+  void flushAllDirtyPages();
+  void discardTablespace(tablespace_id tablespaceId);
 };
 
 }
 
-#endif  // MYSQL_BUFFER_H
\ No newline at end of file
+#endif  // MYSQL_BUFFER_H
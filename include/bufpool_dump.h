@@ -0,0 +1,66 @@
+#ifndef TOYBOX_BUFPOOL_DUMP_H
+#define TOYBOX_BUFPOOL_DUMP_H
+
+#include <atomic>
+#include <string>
+#include <vector>
+
+#include "read_ahead.h"
+#include "my_inttypes.h"
+#include "my_thread.h"
+#include "mysql/psi/mysql_cond.h"
+#include "mysql/psi/mysql_mutex.h"
+
+namespace buf {
+
+class BufPool;
+
+// next to the system tablespace
+constexpr const char *BUFFER_POOL_DUMP_PATH = "./toybox_buffer_pool";
+constexpr const uint64_t DEFAULT_DUMP_PCT = 25;
+// pages of a tablespace loaded with one prefetch
+constexpr const uint64_t LOAD_BATCH_SIZE = 64;
+
+enum class LoadState { NOT_STARTED, RUNNING, COMPLETED, ABORTED, FAILED };
+
+/**
+ * Writes the (tablespace_id, page_id) pairs of the cached pages to a file
+ * and brings them back in after a restart. The pages are loaded in
+ * (tablespace_id, page_id) order, adjacent pages in batches, by a
+ * background thread that also dumps the pool every dumpInterval seconds.
+ */
+class BufPoolDump {
+ private:
+  BufPool *bufPool;
+  std::string path;
+  mysql_mutex_t mutex;
+  mysql_cond_t cond;
+  my_thread_handle thread;
+  bool running = false;
+  bool shutdown = false;
+  bool loadAtStartup = false;
+  uint64_t dumpInterval = 0;  // seconds, 0 disables periodic dumps
+  std::atomic<uint64_t> dumpPct{DEFAULT_DUMP_PCT};
+  std::atomic<LoadState> loadState{LoadState::NOT_STARTED};
+  std::atomic<uint64_t> loadedPageCount{0};
+  std::atomic<uint64_t> loadTotalPageCount{0};
+  static void *run(void *arg);
+  bool isShuttingDown();
+ public:
+  BufPoolDump(BufPool *bufPool, const char *path)
+      : bufPool(bufPool), path(path) {}
+  void start(bool loadAtStartup, uint64_t dumpInterval);
+  void stop();
+  void setDumpInterval(uint64_t seconds);
+  void setDumpPct(uint64_t pct);
+  bool dump();
+  uint64_t load();
+  LoadState getLoadState() const;
+  uint64_t getLoadedPageCount() const;
+  uint64_t getLoadTotalPageCount() const;
+  void getLoadStatus(char *buf, size_t size) const;
+};
+
+}
+
+#endif  // TOYBOX_BUFPOOL_DUMP_H
@@ -0,0 +1,328 @@
+#ifndef TOYBOX_BUFPOOL_INSTANCE_H
+#define TOYBOX_BUFPOOL_INSTANCE_H
+
+#include <stdlib.h>
+#include <list>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "bufpool_stats.h"
+#include "file_aio.h"
+#include "page.h"
+#include "page_type.h"
+#include "read_ahead.h"
+#include "redo_log.h"
+#include "tablespace_cache.h"
+#include "tablespace_type.h"
+#include "sql/psi_memory_key.h"
+#include "my_inttypes.h"
+#include "my_thread.h"
+#include "mysql/psi/mysql_cond.h"
+#include "mysql/psi/mysql_mutex.h"
+#include "mysql/psi/mysql_rwlock.h"
+#include "tuple.h"
+
+namespace buf {
+
+constexpr const uint64_t DEFAULT_FLUSH_RATE = 200; // pages per second
+// seconds to wait for a page guard release when every element is pinned
+constexpr const uint64_t PIN_WAIT_TIMEOUT = 1;
+// share of the LRU list kept as the old segment new pages enter at
+constexpr const uint64_t DEFAULT_OLD_BLOCKS_PCT = 37;
+constexpr const uint64_t MIN_OLD_BLOCKS_PCT = 5;
+constexpr const uint64_t MAX_OLD_BLOCKS_PCT = 95;
+// milliseconds a page stays old after its first access, so that the
+// accesses of a single scan never make it young
+constexpr const uint64_t DEFAULT_OLD_BLOCKS_TIME = 1000;
+// instances with fewer frames have no old segment and use a plain LRU
+constexpr const uint64_t LRU_OLD_MIN_LEN = 64;
+// pages the old segment may be off its share before the boundary moves
+constexpr const uint64_t LRU_OLD_TOLERANCE = 8;
+
+struct ReadDescriptor {
+  tablespace_id tablespaceId;
+  page_id pageId;
+  uint64_t tupleCursor;
+  char *tablespacePath;
+};
+
+struct WriteDescriptor {
+  tablespace_id tablespaceId;
+  page_id pageId;
+  char *tablespacePath;
+  tuple::Tuple *tuple;
+};
+
+enum class WriteResult {
+  WRITTEN,
+  // the page has no room for the tuple, it goes to the next page
+  PAGE_FULL,
+  // the page could not be brought in
+  FAILED
+};
+
+struct PageKey {
+  tablespace_id tablespaceId;
+  page_id pageId;
+  bool operator==(const PageKey &other) const {
+    return tablespaceId == other.tablespaceId && pageId == other.pageId;
+  }
+  // (tablespace_id, page_id) order, adjacent pages of a tablespace are
+  // neighbours in a sorted container.
+  bool operator<(const PageKey &other) const {
+    if (tablespaceId != other.tablespaceId) {
+      return tablespaceId < other.tablespaceId;
+    }
+    return pageId < other.pageId;
+  }
+};
+
+struct PageKeyHash {
+  size_t operator()(const PageKey &key) const {
+    // mix both ids so that sequential page ids of different tablespaces
+    // do not collide into the same buckets.
+    uint64_t hash = key.tablespaceId * 0x9E3779B97F4A7C15ULL + key.pageId;
+    hash ^= hash >> 31;
+    hash *= 0xBF58476D1CE4E5B9ULL;
+    hash ^= hash >> 29;
+    return static_cast<size_t>(hash);
+  }
+};
+
+enum class LatchMode { SHARED, EXCLUSIVE };
+
+struct Element;
+
+// most recently used first. The young segment is followed by the old one.
+typedef std::list<Element *> LruList;
+
+struct Element {
+  uint64_t tableSpaceId;
+  // pinned elements are never chosen as an eviction victim
+  uint64_t refCount;
+  // protects the page image. Only taken by pinned holders and never while
+  // holding the instance mutex.
+  mysql_rwlock_t latch;
+  // in the old segment of the LRU list
+  bool old;
+  // milliseconds, first access since the page entered the old segment,
+  // 0 until then
+  uint64_t accessTime;
+  // valid while the element holds a page
+  LruList::iterator lruPosition;
+  // modified in memory and not yet written back to the tablespace file
+  bool dirty;
+  // while dirty, an LSN not after the first logged change since the page
+  // was last written. Checkpoints never pass it.
+  lsn_t oldestLsn;
+  // brought in by read-ahead and not accessed since
+  bool prefetched;
+  // its frame is being given back by a shrinking buffer pool, the element
+  // is never handed out again
+  bool withdrawing;
+  // registered and pinned while its page is being read without the mutex,
+  // by a miss or in the background; lookups wait for the read to complete
+  bool ioPending;
+  std::string tablespacePath;
+  // a slot of a buffer pool chunk holding the page image
+  uchar *frame;
+  page::PageHandler pageHandler;
+  explicit Element(uchar *frame)
+      : tableSpaceId(0),
+        refCount(0),
+        old(false),
+        accessTime(0),
+        dirty(false),
+        oldestLsn(0),
+        prefetched(false),
+        withdrawing(false),
+        ioPending(false),
+        frame(frame),
+        pageHandler(page::PageHandler::fromFrame(frame)) {}
+  page::PageHandler& getPageHandler() {
+    return pageHandler;
+  }
+  PageKey getPageKey() {
+    return PageKey{tableSpaceId, pageHandler.getPageHeader().id};
+  }
+};
+
+typedef struct Element Element;
+
+typedef std::unordered_map<PageKey, Element *, PageKeyHash> PageTable;
+
+// dirty pages in (tablespace_id, page_id) order
+typedef std::set<PageKey> FlushList;
+
+class BufPoolInstance;
+
+/**
+ * A pinned and latched page. The page stays in the pool and its image may
+ * be used without the instance mutex until the guard is released or
+ * destroyed. Shared guards of a page coexist, an exclusive one excludes
+ * every other guard.
+ */
+class PageGuard {
+ private:
+  BufPoolInstance *instance = nullptr;
+  Element *element = nullptr;
+  LatchMode mode = LatchMode::SHARED;
+ public:
+  PageGuard() = default;
+  PageGuard(BufPoolInstance *instance, Element *element, LatchMode mode);
+  PageGuard(PageGuard &&other) noexcept;
+  PageGuard &operator=(PageGuard &&other) noexcept;
+  PageGuard(const PageGuard &) = delete;
+  PageGuard &operator=(const PageGuard &) = delete;
+  ~PageGuard() { release(); }
+  void release();
+  // only allowed under an exclusive guard. oldestLsn is not after the
+  // record of the change, which may be logged afterwards.
+  void markDirty(lsn_t oldestLsn = 0);
+  bool isValid() const {
+    return element != nullptr;
+  }
+  page_id getPageId() {
+    return element->getPageHandler().getPageHeader().id;
+  }
+  page::PageHandler &getPageHandler() {
+    return element->getPageHandler();
+  }
+};
+
+/**
+ * One partition of the buffer pool. Every instance has its own mutex,
+ * page table, LRU list, flush list and page cleaner, so threads working
+ * on pages of different instances never contend.
+ *
+ * Pages enter the LRU list at the head of its old segment and are only
+ * made young when accessed again oldBlocksTime after their first access.
+ * A table scan touches every page once, so it only cycles through the old
+ * segment and leaves the young one to the frequently used pages.
+ */
+class BufPoolInstance {
+ private:
+  uint64_t maxPageCount;
+  // protects everything below and the element metadata. Page images are
+  // protected by the element latches.
+  mutable mysql_mutex_t mutex;
+  // signalled whenever an element becomes clean or unpinned
+  mysql_cond_t freeElementCond;
+  // wakes the page cleaner up before its next scheduled round
+  mysql_cond_t cleanerCond;
+  // (tablespace_id, page_id) -> cached page
+  PageTable pageTable;
+  // one element per frame, created at init
+  std::vector<Element *> frames;
+  // elements holding no page, used before evicting anything
+  std::vector<Element *> freeElements;
+  // elements of frames being withdrawn that may still hold a page
+  std::vector<Element *> withdrawingElements;
+  // elements of frames being withdrawn that hold no page anymore
+  std::vector<Element *> withdrawnElements;
+  // elements holding a page. Victims are taken from the tail.
+  LruList lru;
+  // first element of the old segment, lru.end() when it is empty
+  LruList::iterator lruOld;
+  uint64_t oldCount = 0;
+  uint64_t oldBlocksPct = DEFAULT_OLD_BLOCKS_PCT;
+  uint64_t oldBlocksTime = DEFAULT_OLD_BLOCKS_TIME;
+  uint64_t youngMadeCount = 0;
+  FlushList flushList;
+  // oldestLsn of the pages taken off the flush list by flushBatch() and
+  // not yet written
+  std::multiset<lsn_t> flushingLsns;
+  // page cleaner state
+  my_thread_handle cleanerThread;
+  bool cleanerRunning = false;
+  bool cleanerShutdown = false;
+  uint64_t flushRate = DEFAULT_FLUSH_RATE;
+  // number of foreground threads waiting for a page to be unpinned
+  uint64_t unpinWaiters = 0;
+  // number of foreground threads waiting for a clean element
+  uint64_t freeElementWaiters = 0;
+  BufPoolStats *stats = nullptr;
+  // the open tablespace files, shared with the other instances
+  tablespace::TablespaceCache *tablespaceCache = nullptr;
+  // performs the reads and writes of prefetches and flush batches
+  file_handler::AioEngine *aio = nullptr;
+  // inserts are logged to it and pages are only written once their
+  // records are synced, nullptr while nothing is logged
+  redo::RedoLog *redoLog = nullptr;
+
+  Element *readFromFile(tablespace_id tablespaceId, page_id pageId,
+                        const char *tablespacePath);
+  void registerReadPage(Element *element, tablespace_id tablespaceId,
+                        page_id pageId, const char *tablespacePath);
+  Element *fetchElement(tablespace_id tablespaceId, page_id pageId,
+                        const char *tablespacePath);
+  Element *lookupElement(tablespace_id tablespaceId, page_id pageId) const;
+  Element *lookupReadElement(tablespace_id tablespaceId, page_id pageId);
+  void completePrefetch(std::vector<Element *> &run, tablespace_id tablespaceId,
+                        page_id firstPageId, const std::string &tablespacePath,
+                        bool readAhead, size_t readSize,
+                        file_handler::IoBatch &batch);
+  Element *registerPage(tablespace_id tablespaceId, page::PageHandler &page,
+                        const char *tablespacePath);
+  Element *allocateElement();
+  void freeElement(Element *element);
+  void evictElement(Element *element);
+  void relocateElement(Element *element, Element *target);
+  Element *findVictim(bool allowDirty);
+  void insertIntoLru(Element *element);
+  void removeFromLru(Element *element);
+  void makeYoung(Element *element);
+  void accessElement(Element *element);
+  void adjustOldSegment();
+  void addToFlushList(Element *element, lsn_t oldestLsn);
+  void removeFromFlushList(Element *element);
+  bool flushElement(Element *element);
+  uint64_t flushBatch(uint64_t maxFlushCount, lsn_t targetLsn = LSN_MAX);
+  void releaseAllPage();
+  static void *runPageCleaner(void *arg);
+ public:
+  void init(BufPoolStats *stats, tablespace::TablespaceCache *tablespaceCache,
+            file_handler::AioEngine *aio);
+  bool deinit();
+  void setRedoLog(redo::RedoLog *redoLog);
+  void addFrames(uchar *frameRegion, uint64_t frameCount);
+  void withdrawFrames(uchar *frameRegion, uint64_t frameCount);
+  uint64_t withdrawBatch(uint64_t maxCount);
+  void releaseWithdrawnFrames();
+  PageGuard fixPage(tablespace_id tablespaceId, page_id pageId,
+                    const char *tablespacePath, LatchMode mode);
+  void unfixPage(Element *element);
+  void markDirty(Element *element, lsn_t oldestLsn);
+  void submitPrefetch(tablespace_id tablespaceId, page_id firstPageId,
+                      uint64_t pageCount, const char *tablespacePath,
+                      bool readAhead, file_handler::IoBatch &batch);
+  void collectPages(std::vector<PageRun> &pages, uint64_t pct) const;
+  int read(uchar *buf, ReadDescriptor readDescriptor);
+  WriteResult write(uchar *buf, WriteDescriptor writeDescriptor);
+  Element* getElement(tablespace_id tablespaceId, page_id pageId);
+  Element* putPage(tablespace_id tablespaceId, page::PageHandler page,
+                   const char *tablespacePath);
+  bool isLastPage(tablespace_id tablespaceId, page_id pageId, const char *tablespacePath);
+  bool isLastTuple(tablespace_id tablespaceId, page_id pageId, uint64_t tupleCursor, const char *tablespacePath);
+  bool existPage(tablespace_id tablespaceId, page_id pageId) const;
+  uint64_t getPageCount() const;
+  uint64_t getMaxPageCount() const;
+  uint64_t getOldPageCount() const;
+  uint64_t getYoungMadeCount() const;
+  void setOldBlocksPct(uint64_t pct);
+  void setOldBlocksTime(uint64_t milliseconds);
+  void startPageCleaner(uint64_t pagesPerSecond);
+  void stopPageCleaner();
+  void setFlushRate(uint64_t pagesPerSecond);
+  uint64_t flushDirtyPages(uint64_t maxFlushCount);
+  uint64_t flushOldestPages(lsn_t targetLsn, uint64_t maxFlushCount);
+  lsn_t getOldestModification() const;
+  void flushAllDirtyPages();
+  void discardTablespace(tablespace_id tablespaceId);
+};
+
+}
+
+#endif  // TOYBOX_BUFPOOL_INSTANCE_H
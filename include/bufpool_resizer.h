@@ -0,0 +1,46 @@
+#ifndef TOYBOX_BUFPOOL_RESIZER_H
+#define TOYBOX_BUFPOOL_RESIZER_H
+
+#include <atomic>
+
+#include "my_inttypes.h"
+#include "my_thread.h"
+#include "mysql/psi/mysql_cond.h"
+#include "mysql/psi/mysql_mutex.h"
+
+namespace buf {
+
+class BufPool;
+
+enum class ResizeState { NOT_STARTED, RUNNING, COMPLETED, FAILED };
+
+/**
+ * Background thread resizing the buffer pool, so that setting
+ * toybox_buffer_pool_size returns right away. A request made while a
+ * resize runs is carried out once it finished.
+ */
+class BufPoolResizer {
+ private:
+  BufPool *bufPool;
+  mysql_mutex_t mutex;
+  mysql_cond_t cond;
+  my_thread_handle thread;
+  bool running = false;
+  bool shutdown = false;
+  // pages, 0 while there is no request
+  uint64_t requestedSize = 0;
+  std::atomic<ResizeState> resizeState{ResizeState::NOT_STARTED};
+  std::atomic<uint64_t> targetSize{0};
+  static void *run(void *arg);
+ public:
+  explicit BufPoolResizer(BufPool *bufPool) : bufPool(bufPool) {}
+  void start();
+  void stop();
+  void request(uint64_t bufPoolSize);
+  ResizeState getResizeState() const;
+  void getResizeStatus(char *buf, size_t size) const;
+};
+
+}
+
+#endif  // TOYBOX_BUFPOOL_RESIZER_H
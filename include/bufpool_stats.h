@@ -0,0 +1,70 @@
+#ifndef TOYBOX_BUFPOOL_STATS_H
+#define TOYBOX_BUFPOOL_STATS_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace buf {
+
+constexpr const size_t COUNTER_SHARD_COUNT = 32;
+constexpr const size_t CACHE_LINE_SIZE = 64;
+
+/**
+ * A counter split into cache line sized shards. Each thread adds to its
+ * own shard, so threads counting the same event never write to the same
+ * cache line and reading the counter takes no lock. The sum may miss
+ * concurrent additions.
+ */
+class ShardedCounter {
+ private:
+  struct alignas(CACHE_LINE_SIZE) Shard {
+    std::atomic<int64_t> value{0};
+  };
+  Shard shards[COUNTER_SHARD_COUNT];
+  static size_t getShardIndex() {
+    static std::atomic<size_t> nextShardIndex{0};
+    // threads are spread over the shards in the order they first count
+    thread_local size_t shardIndex =
+        nextShardIndex.fetch_add(1, std::memory_order_relaxed) %
+        COUNTER_SHARD_COUNT;
+    return shardIndex;
+  }
+ public:
+  void add(int64_t n = 1) {
+    shards[getShardIndex()].value.fetch_add(n, std::memory_order_relaxed);
+  }
+  int64_t load() const {
+    int64_t sum = 0;
+    for (const Shard &shard : shards) {
+      sum += shard.value.load(std::memory_order_relaxed);
+    }
+    return sum;
+  }
+};
+
+/**
+ * Counters shared by every instance of a buffer pool.
+ */
+struct BufPoolStats {
+  // pages asked for by fixPage(), found cached (hits) or read (misses)
+  ShardedCounter pageLookups;
+  ShardedCounter pageHits;
+  ShardedCounter pageMisses;
+  // pages dropped to make room for others
+  ShardedCounter pagesEvicted;
+  // pages on the flush lists, a gauge
+  ShardedCounter pagesDirty;
+  ShardedCounter pagesFlushed;
+  // pages brought in by read-ahead, used before eviction (hits) or not
+  ShardedCounter readAheadPages;
+  ShardedCounter readAheadHits;
+  ShardedCounter readAheadEvicted;
+  // page images read from and written to the tablespace files
+  ShardedCounter bytesRead;
+  ShardedCounter bytesWritten;
+};
+
+}
+
+#endif  // TOYBOX_BUFPOOL_STATS_H
@@ -0,0 +1,72 @@
+#ifndef TOYBOX_CHECKPOINTER_H
+#define TOYBOX_CHECKPOINTER_H
+
+#include <atomic>
+
+#include "my_inttypes.h"
+#include "my_thread.h"
+#include "mysql/psi/mysql_cond.h"
+#include "mysql/psi/mysql_mutex.h"
+#include "redo_log_type.h"
+
+namespace buf {
+class BufPool;
+}
+
+namespace redo {
+
+class RedoLog;
+
+// bytes of redo after the checkpoint, recovery replays at most this much
+constexpr const uint64_t DEFAULT_MAX_CHECKPOINT_AGE = 64 * 1024 * 1024;
+constexpr const uint64_t MIN_MAX_CHECKPOINT_AGE = 64 * 1024;
+// the background thread starts flushing the oldest pages once the age is
+// over this percentage of the maximum
+constexpr const uint64_t ADAPTIVE_FLUSH_LWM_PCT = 50;
+
+/**
+ * Advances the checkpoint while foreground threads keep changing pages
+ * (fuzzy checkpoints): the checkpoint moves to the oldest change still
+ * only in the buffer pool, no page is held back for it.
+ *
+ * A background thread checkpoints once a second and flushes the pages
+ * with the oldest changes faster the closer the age (redo after the
+ * checkpoint) gets to maxAge. A thread about to log a change flushes
+ * them itself once the age is over maxAge, so that recovery never has
+ * more than about maxAge bytes to replay.
+ */
+class Checkpointer {
+ private:
+  buf::BufPool *bufPool;
+  RedoLog *redoLog;
+  mysql_mutex_t mutex;
+  mysql_cond_t cond;
+  my_thread_handle thread;
+  bool running = false;
+  bool shutdown = false;
+  std::atomic<uint64_t> maxAge;
+  // serializes the flushes of foreground threads, the others wait for
+  // the one flushing
+  mysql_mutex_t flushMutex;
+  std::atomic<uint64_t> syncFlushCount{0};
+  static void *run(void *arg);
+ public:
+  Checkpointer(buf::BufPool *bufPool, RedoLog *redoLog,
+               uint64_t maxAge = DEFAULT_MAX_CHECKPOINT_AGE);
+  ~Checkpointer();
+  Checkpointer(const Checkpointer &) = delete;
+  Checkpointer &operator=(const Checkpointer &) = delete;
+  void start();
+  void stop();
+  bool checkpoint();
+  void adaptiveFlush();
+  void makeSpace();
+  void setMaxAge(uint64_t maxAge);
+  uint64_t getMaxAge() const;
+  uint64_t getAge() const;
+  uint64_t getSyncFlushCount() const;
+};
+
+}
+
+#endif  // TOYBOX_CHECKPOINTER_H
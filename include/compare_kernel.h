@@ -0,0 +1,36 @@
+#ifndef TOYBOX_COMPARE_KERNEL_H
+#define TOYBOX_COMPARE_KERNEL_H
+
+#include <cinttypes>
+
+namespace predicate {
+
+enum class CompareOp : uint8_t { EQ, NE, LT, LE, GT, GE };
+
+// the instruction sets the kernels are built for, the best one the CPU
+// supports is chosen at runtime
+enum class KernelIsa : uint8_t { SCALAR, SSE42, AVX2 };
+
+/**
+ * Compares count values, one after the other, with a constant and clears
+ * the bit of every row that does not compare true in selection, a bit per
+ * row from row 0. Bits of the other rows are left as they are.
+ */
+template <typename T>
+using CompareKernel = void (*)(const T *values, uint64_t count, CompareOp op,
+                               T constant, uint64_t *selection);
+
+struct CompareKernels {
+  KernelIsa isa;
+  CompareKernel<int32_t> compareInt32;
+  CompareKernel<int64_t> compareInt64;
+  CompareKernel<double> compareDouble;
+};
+
+bool isKernelIsaSupported(KernelIsa isa);
+const CompareKernels &getCompareKernels(KernelIsa isa);
+const CompareKernels &getCompareKernels();
+
+} // namespace predicate
+
+#endif  // TOYBOX_COMPARE_KERNEL_H
@@ -0,0 +1,117 @@
+#ifndef TOYBOX_FILE_AIO_H
+#define TOYBOX_FILE_AIO_H
+
+#include <sys/uio.h>
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <vector>
+
+#include "file_handler.h"
+#include "my_inttypes.h"
+#include "my_thread.h"
+#include "mysql/psi/mysql_cond.h"
+#include "mysql/psi/mysql_mutex.h"
+
+namespace file_handler {
+
+constexpr const uint64_t DEFAULT_IO_RINGS = 1;
+constexpr const uint64_t MAX_IO_RINGS = 64;
+// requests of a ring submitted and not completed yet
+constexpr const uint64_t DEFAULT_IO_QUEUE_DEPTH = 64;
+constexpr const uint64_t MAX_IO_QUEUE_DEPTH = 4096;
+// threads of a ring when io_uring is not available
+constexpr const uint64_t FALLBACK_THREADS_PER_RING = 4;
+
+enum class IoType { READ, WRITE };
+
+// gets the number of bytes transferred, MY_FILE_ERROR on error
+typedef std::function<void(size_t)> IoCallback;
+
+/**
+ * A vectored read or write. The buffers must stay valid and the file open
+ * until the callback ran.
+ */
+struct IoRequest {
+  IoType type;
+  FileDescriptor fd;
+  my_off_t offset;
+  std::vector<struct iovec> iov;
+  IoCallback callback;
+  size_t getSize() const;
+};
+
+struct AioConfig {
+  // use io_uring when it is available
+  bool useNativeAio = true;
+  uint64_t ringCount = DEFAULT_IO_RINGS;
+  uint64_t queueDepth = DEFAULT_IO_QUEUE_DEPTH;
+};
+
+/**
+ * Performs reads and writes in the background. Callbacks run on the
+ * engine's completion threads, so they must not wait for a lock held
+ * by a thread submitting requests.
+ */
+class AioEngine {
+ public:
+  virtual ~AioEngine() {}
+  // waits while the queues are full
+  virtual void submit(std::vector<IoRequest> &requests) = 0;
+  // completes every submitted request first
+  virtual void stop() = 0;
+  virtual const char *getName() const = 0;
+  static AioEngine *create(const AioConfig &config);
+};
+
+/**
+ * The portable engine, a pool of threads doing positional reads and
+ * writes.
+ */
+class ThreadPoolAio : public AioEngine {
+ private:
+  mysql_mutex_t mutex;
+  // signalled when a request is queued or the pool shuts down
+  mysql_cond_t queueCond;
+  // signalled when a request leaves the queue
+  mysql_cond_t spaceCond;
+  std::deque<IoRequest> queue;
+  uint64_t capacity;
+  bool shutdown = false;
+  std::vector<my_thread_handle> threads;
+  static void *run(void *arg);
+ public:
+  ThreadPoolAio(uint64_t threadCount, uint64_t capacity);
+  ~ThreadPoolAio() override;
+  void submit(std::vector<IoRequest> &requests) override;
+  void stop() override;
+  const char *getName() const override {
+    return "threads";
+  }
+};
+
+/**
+ * Waits for a set of requests submitted to an engine.
+ */
+class IoBatch {
+ private:
+  mysql_mutex_t mutex;
+  mysql_cond_t cond;
+  uint64_t pendingCount = 0;
+  uint64_t completedUnits = 0;
+ public:
+  IoBatch();
+  ~IoBatch();
+  IoBatch(const IoBatch &) = delete;
+  IoBatch &operator=(const IoBatch &) = delete;
+  // before the requests are submitted
+  void add(uint64_t requestCount);
+  // from the callback of each request, units are counted for the caller
+  void complete(uint64_t units);
+  // @return the units of every completed request
+  uint64_t wait();
+};
+
+}
+
+#endif  // TOYBOX_FILE_AIO_H
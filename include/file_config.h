@@ -11,6 +11,8 @@ namespace file_config {
 // Error handling flag. See "my_sys.h".
 constexpr const int MYF_STRICT_MODE = (MY_FAE | MY_WME);
 constexpr const int MYF_THROUGH_ALL_ERRORS = 0;
+// offsets, sizes and buffers of direct I/O are multiples of it
+constexpr const int IO_BLOCK_SIZE = 4096;
 }
 
 #endif  // TOYBOX_FILE_CONFIG_H
@@ -4,6 +4,8 @@
 #ifndef TOYBOX_FILE_DESCRIPTOR_H
 #define TOYBOX_FILE_DESCRIPTOR_H
 
+#include <sys/uio.h>
+
 #include "my_inttypes.h"
 #include "mysql/components/services/bits/psi_file_bits.h"
 
@@ -11,11 +13,28 @@ namespace file_handler {
 
 typedef int FileDescriptor;
 
+enum class IoMode {
+  // through the OS page cache
+  BUFFERED,
+  // bypassing the OS page cache where the file system supports it. Every
+  // read and write must be aligned to file_config::IO_BLOCK_SIZE.
+  DIRECT,
+  // BUFFERED, and table scans read the pages not in the buffer pool from
+  // a read-only mapping of the file
+  MMAP
+};
+
+// applies to the files opened or created afterwards
+void setIoMode(IoMode mode);
+IoMode getIoMode();
+
 class File {
  private:
   FileDescriptor fileDescriptor;
   myf myFlags;
   PSI_file_key fileKey;
+  bool directIo = false;
+  void applyIoMode();
  public:
   File() : fileDescriptor(-1), myFlags(0), fileKey(0) {}
   File(FileDescriptor fd, myf flags, PSI_file_key key)
@@ -26,32 +45,31 @@ class File {
       : myFlags(flags), fileKey(key) {
     open(path);
   }
+  // owns the descriptor, moving leaves the source closed
   File(File&& tmp) noexcept
       : fileDescriptor(tmp.fileDescriptor),
         myFlags(tmp.myFlags),
-        fileKey(tmp.fileKey) {}
-  File& operator=(File&& tmp) noexcept {
-    if (this != &tmp) {
-      fileDescriptor = tmp.fileDescriptor;
-      myFlags = tmp.myFlags;
-      fileKey = tmp.fileKey;
-    }
-    return *this;
+        fileKey(tmp.fileKey),
+        directIo(tmp.directIo) {
+    tmp.fileDescriptor = -1;
   }
-  File(const File& tmp) noexcept
-      : fileDescriptor(tmp.fileDescriptor),
-        myFlags(tmp.myFlags),
-        fileKey(tmp.fileKey) {}
-  File& operator=(const File& tmp) noexcept {
+  File& operator=(File&& tmp) noexcept {
     if (this != &tmp) {
+      if (fileDescriptor >= 0) {
+        close();
+      }
       fileDescriptor = tmp.fileDescriptor;
       myFlags = tmp.myFlags;
       fileKey = tmp.fileKey;
+      directIo = tmp.directIo;
+      tmp.fileDescriptor = -1;
     }
     return *this;
   }
+  File(const File& tmp) = delete;
+  File& operator=(const File& tmp) = delete;
   ~File() {
-    if (fileDescriptor <= 0) {
+    if (fileDescriptor >= 0) {
       close();
     }
   }
@@ -63,9 +81,14 @@ class File {
   size_t read(uchar *buf, int size, my_off_t offset) const;
   size_t write(uchar *buf, int size) const;
   size_t write(uchar *buf, int size, my_off_t offset) const;
+  size_t readv(const struct iovec *iov, int iovcnt, my_off_t offset) const;
+  size_t writev(const struct iovec *iov, int iovcnt, my_off_t offset) const;
   FileDescriptor getFileDescriptor() const {
     return fileDescriptor;
   }
+  bool isDirectIo() const {
+    return directIo;
+  }
 };
 
 } // namespace file_handler
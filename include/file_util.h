@@ -1,6 +1,8 @@
 #ifndef TOYBOX_FILE_UTIL_H
 #define TOYBOX_FILE_UTIL_H
 
+#include <sys/uio.h>
+
 #include "my_inttypes.h"
 #include "mysql/components/services/bits/psi_file_bits.h"
 
@@ -13,7 +15,16 @@ class FileUtil
   static File open(PSI_file_key key, const char *tableFilePath, int openFlag, myf flags);
   static size_t read(File fd, uchar *buf, int readSize);
   static size_t write(File fd, uchar *buf, int writeSize);
+  static size_t pread(File fd, uchar *buf, size_t readSize, my_off_t offset);
+  static size_t pwrite(File fd, const uchar *buf, size_t writeSize, my_off_t offset);
+  static size_t preadv(File fd, const struct iovec *iov, int iovcnt, my_off_t offset);
+  static size_t pwritev(File fd, const struct iovec *iov, int iovcnt, my_off_t offset);
   static void seek(File fd, my_off_t startPosition, int whence, myf flags);
+  static my_off_t size(File fd);
+  static bool setDirectIo(File fd);
+  static int sync(File fd);
+  static int truncate(File fd, my_off_t size);
+  static bool punchHole(File fd, my_off_t offset, my_off_t size);
   static void convertToTableFilePath(char *tableFilePath, const char *name, const char *ext);
 
  private:
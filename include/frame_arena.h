@@ -0,0 +1,53 @@
+#ifndef TOYBOX_FRAME_ARENA_H
+#define TOYBOX_FRAME_ARENA_H
+
+#include <stdlib.h>
+
+#include "page.h"
+#include "sql/psi_memory_key.h"
+#include "my_inttypes.h"
+
+struct PSI_thread;
+
+namespace buf {
+
+// sysvar order, see toybox_buffer_pool_huge_pages
+enum class HugePageMode : ulong { OFF, TRANSPARENT, EXPLICIT };
+
+constexpr const size_t HUGE_PAGE_SIZE = 2 * 1024 * 1024;
+
+/**
+ * One page aligned region holding a chunk of buffer pool frames, accounted
+ * to the buffer pool memory key. It can be backed by
+ * transparent huge pages (madvise) or explicit ones (MAP_HUGETLB), the
+ * latter falling back to normal pages when none are reserved.
+ */
+class FrameArena {
+ private:
+  PSI_memory_key memoryKey;
+  PSI_thread *owner = nullptr;
+  uchar *region = nullptr;
+  size_t regionSize = 0;
+  uint64_t frameCount = 0;
+  bool hugePageBacked = false;
+ public:
+  bool init(PSI_memory_key key, uint64_t frameCount, HugePageMode mode);
+  void deinit();
+  uchar *getFrame(uint64_t index) const {
+    assert(index < this->frameCount);
+    return this->region + index * page::PAGE_SIZE;
+  }
+  uint64_t getFrameCount() const {
+    return this->frameCount;
+  }
+  size_t getRegionSize() const {
+    return this->regionSize;
+  }
+  bool isHugePageBacked() const {
+    return this->hugePageBacked;
+  }
+};
+
+}
+
+#endif  // TOYBOX_FRAME_ARENA_H
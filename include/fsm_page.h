@@ -0,0 +1,61 @@
+#ifndef TOYBOX_FSM_PAGE_H
+#define TOYBOX_FSM_PAGE_H
+
+#include <cinttypes>
+
+#include "page.h"
+#include "page_type.h"
+
+namespace page {
+
+// the free space of a page is kept as one of this many categories, in 4
+// bits. A page of category c has at least c * FSM_CATEGORY_SIZE free bytes.
+constexpr const uint32_t FSM_CATEGORY_COUNT = 16;
+constexpr const uint32_t FSM_CATEGORY_SIZE = PAGE_BODY_SIZE / FSM_CATEGORY_COUNT;
+// pages mapped by one free space map page, a power of two so that the
+// categories form a complete binary tree of 2 * FSM_LEAF_COUNT - 1 nodes
+constexpr const uint64_t FSM_LEAF_COUNT = 2048;
+static_assert(FSM_LEAF_COUNT <= PAGE_BODY_SIZE);
+// free space map page k is page k * FSM_LEAF_COUNT + 1 and maps the pages
+// from k * FSM_LEAF_COUNT on, the first one follows the first data page
+constexpr const page_id FIRST_FSM_PAGE_ID = 1;
+
+inline page_id getFsmPageId(page_id pageId) {
+  return pageId / FSM_LEAF_COUNT * FSM_LEAF_COUNT + FIRST_FSM_PAGE_ID;
+}
+
+inline bool isFsmPage(page_id pageId) {
+  return pageId % FSM_LEAF_COUNT == FIRST_FSM_PAGE_ID;
+}
+
+uint8_t toFsmCategory(uint32_t freeBytes);
+uint8_t toMinFsmCategory(uint32_t tupleSize);
+
+/**
+ * A free space map page of a tablespace, viewed through the page holding
+ * it. The body is a max-tree of categories: the leaves are the pages it
+ * maps and every other node is the largest category below it, so a page
+ * with room for a tuple is found, and a category changed, in
+ * log2(FSM_LEAF_COUNT) steps.
+ *
+ * The map is a hint, it is not logged and may be behind the pages. An
+ * all zero body, such as that of a page just added to the file, maps
+ * every page as full.
+ */
+class FsmPage {
+ private:
+  uchar *body;
+  uint8_t getNode(uint64_t node) const;
+  void setNode(uint64_t node, uint8_t category);
+ public:
+  explicit FsmPage(PageHandler &pageHandler)
+      : body(pageHandler.getPageBody()) {}
+  uint8_t getCategory(page_id pageId) const;
+  bool setCategory(page_id pageId, uint8_t category);
+  uint8_t getLargestCategory() const;
+  page_id findPage(page_id fsmPageId, uint8_t minCategory) const;
+};
+
+} // namespace page
+
+#endif  // TOYBOX_FSM_PAGE_H
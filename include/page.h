@@ -5,22 +5,39 @@
 #define TOYBOX_PAGE_H
 
 #include <cinttypes>
+#include <cstring>
+#include <memory>
 
+#include "file_aio.h"
 #include "file_handler.h"
 #include "tablespace.h"
 #include "page_type.h"
+#include "redo_log_type.h"
 #include "tuple.h"
 
+// the size of every page, chosen when the engine is built
+#ifndef TOYBOX_PAGE_SIZE
+#define TOYBOX_PAGE_SIZE 4096
+#endif
+
 namespace page {
 
 constexpr const int PAGE_HEADER_SIZE = 40; // byte
-constexpr const int PAGE_SIZE = 4096;
+constexpr const int MIN_PAGE_SIZE = 4096;
+constexpr const int MAX_PAGE_SIZE = 65536;
+constexpr const int PAGE_SIZE = TOYBOX_PAGE_SIZE;
 constexpr const int PAGE_BODY_SIZE = PAGE_SIZE - PAGE_HEADER_SIZE;
 constexpr const int PAGE_START_POSITION = tablespace::TABLE_SPACE_START_POSITION +
-                                          tablespace::TABLE_SPACE_HEADER_SIZE +
+                                          tablespace::TABLE_SPACE_HEADER_BLOCK_SIZE +
                                           tablespace::SYSTEM_PAGE_SIZE;
 constexpr const page_id MAX_PAGE_ID = UINT64_MAX;
 constexpr const int SLOT_SIZE = 8; // byte
+// the largest tuple an empty page has room for
+constexpr const int MAX_TUPLE_SIZE = PAGE_BODY_SIZE - SLOT_SIZE;
+
+static_assert(PAGE_SIZE >= MIN_PAGE_SIZE && PAGE_SIZE <= MAX_PAGE_SIZE &&
+                  (PAGE_SIZE & (PAGE_SIZE - 1)) == 0,
+              "TOYBOX_PAGE_SIZE must be a power of two from 4 KB to 64 KB");
 
 struct __attribute__ ((__packed__)) Header {
   page_id id;
@@ -28,68 +45,147 @@ struct __attribute__ ((__packed__)) Header {
   page_id nextPageId;
   offset freeBegin;
   offset freeEnd;
+  // end of the last redo record applied to the page
+  lsn_t lsn;
+  // a tablespace::PageLayout, set when the page is reserved
+  uint8_t layout;
+  uint8_t reserve[PAGE_HEADER_SIZE - 37];
 };
 
-struct __attribute__ ((__packed__)) Page {
+/**
+ * The layout of a page of PageSize bytes. Only PAGE_SIZE is used by the
+ * engine, the others are instantiated so that the page sizes can be
+ * compared, see tests/page_bench.cc.
+ */
+template <int PageSize>
+struct __attribute__ ((__packed__)) BasicPage {
+  static constexpr const int BODY_SIZE = PageSize - PAGE_HEADER_SIZE;
   Header header;
-  uint8_t body[PAGE_BODY_SIZE];
+  uint8_t body[BODY_SIZE];
+};
+
+// a page image usable as a direct I/O buffer
+template <int PageSize>
+struct alignas(file_config::IO_BLOCK_SIZE) BasicAlignedPage {
+  BasicPage<PageSize> page;
 };
 
+using Page = BasicPage<PAGE_SIZE>;
+using AlignedPage = BasicAlignedPage<PAGE_SIZE>;
+
+static_assert(sizeof(Header) == PAGE_HEADER_SIZE);
+static_assert(sizeof(Page) == PAGE_SIZE);
+static_assert(PAGE_START_POSITION % file_config::IO_BLOCK_SIZE == 0);
+
 struct __attribute__ ((__packed__)) Slot {
   offset recordStartOffset;
   tuple_size size;
 };
 
-class PageImpl {
+template <int PageSize>
+class BasicPageImpl {
  private:
-  Page page;
+  using Page = BasicPage<PageSize>;
+  using AlignedPage = BasicAlignedPage<PageSize>;
+  // set unless the image lives in memory owned by someone else, such as a
+  // buffer pool frame
+  std::unique_ptr<AlignedPage> ownedPage;
+  Page *page;
  public:
-  explicit PageImpl(page_id pageId) : page(Page{Header{pageId, 0, MAX_PAGE_ID, 0, PAGE_BODY_SIZE}, {0}}) {}
+  explicit BasicPageImpl(page_id pageId)
+      : ownedPage(new AlignedPage{Page{Header{pageId, 0, MAX_PAGE_ID, 0, Page::BODY_SIZE, 0, 0, {0}}, {0}}}),
+        page(&ownedPage->page) {}
+  explicit BasicPageImpl(uchar *frame) : page(reinterpret_cast<Page *>(frame)) {}
+  BasicPageImpl(const BasicPageImpl &other)
+      : ownedPage(new AlignedPage{*other.page}), page(&ownedPage->page) {}
+  BasicPageImpl(BasicPageImpl &&other) = default;
+  // copies the image, a view keeps pointing to the same frame
+  BasicPageImpl &operator=(const BasicPageImpl &other) {
+    if (this != &other) {
+      memcpy(page, other.page, PageSize);
+    }
+    return *this;
+  }
   uint8_t *toBinary() {
-    return reinterpret_cast<uint8_t *>(&page);
+    return reinterpret_cast<uint8_t *>(page);
   }
 
   page_id getPageId() const {
-    return page.header.id;
+    return page->header.id;
   }
 
   page_id getNextPageId() const {
-    return page.header.nextPageId;
+    return page->header.nextPageId;
+  }
+
+  void setNextPageId(page_id nextPageId) {
+    page->header.nextPageId = nextPageId;
   }
 
   Header& getHeader() {
-    return page.header;
+    return page->header;
   }
 
   void incrementTupleCount() {
-    page.header.tupleCount++;
+    page->header.tupleCount++;
   }
 
   Page& getPage() {
-    return page;
+    return *page;
   }
 
   page::Slot getSlot(uint64_t tupleCursor) {
-    return *reinterpret_cast<Slot *>(page.body + SLOT_SIZE * tupleCursor);
+    return *reinterpret_cast<Slot *>(page->body + SLOT_SIZE * tupleCursor);
   }
 
   uchar *readTupleBySlot(page::Slot slot) {
-    return static_cast<uchar *>(page.body + slot.recordStartOffset);
+    return static_cast<uchar *>(page->body + slot.recordStartOffset);
   }
 };
 
-class PageHandler {
+/**
+ * Works on a page of PageSize bytes, see BasicPage. The members are
+ * instantiated in page.cc for every supported size.
+ */
+template <int PageSize>
+class BasicPageHandler {
  private:
-  PageImpl page;
+  BasicPageImpl<PageSize> page;
+  explicit BasicPageHandler(BasicPageImpl<PageSize> &&page)
+      : page(std::move(page)) {}
  public:
-  explicit PageHandler(page_id pageId) : page(PageImpl(pageId)) {}
-  static PageHandler reserveNewPage(page_id maxPageId);
-  void flush(file_handler::FileDescriptor fd);
-  void readFromFile(file_handler::FileDescriptor fd);
+  explicit BasicPageHandler(page_id pageId) : page(pageId) {}
+  // works on the page image stored in frame, e.g. a buffer pool frame
+  static BasicPageHandler fromFrame(uchar *frame) {
+    return BasicPageHandler(BasicPageImpl<PageSize>(frame));
+  }
+  static BasicPageHandler reserveNewPage(page_id maxPageId);
+  static BasicPageHandler reserveNewPage(
+      page_id newPageId, const tablespace::SystemPageHeaderImpl &systemPage);
+  bool flush(file_handler::FileDescriptor fd);
+  bool readFromFile(file_handler::FileDescriptor fd);
+  static uint64_t readPages(file_handler::FileDescriptor fd,
+                            page_id firstPageId, uchar *const *frames,
+                            uint64_t pageCount);
+  static file_handler::IoRequest flushRequest(
+      file_handler::FileDescriptor fd, page_id firstPageId,
+      uchar *const *frames, uint64_t pageCount,
+      file_handler::IoCallback callback);
+  static file_handler::IoRequest readRequest(
+      file_handler::FileDescriptor fd, page_id firstPageId,
+      uchar *const *frames, uint64_t pageCount,
+      file_handler::IoCallback callback);
+  static uint64_t countPages(file_handler::FileDescriptor fd);
   tuple::Tuple readTuple(uint64_t tupleCursor);
+  tuple::TupleView viewTuple(uint64_t tupleCursor);
+  bool hasSpace(uint32_t tupleSize);
+  bool isPax() {
+    return static_cast<tablespace::PageLayout>(getPageHeader().layout) ==
+           tablespace::PageLayout::PAX;
+  }
   void insert(tuple::Tuple t);
   bool isLastTuple(uint64_t tupleCursor);
-  PageImpl& getPage() {
+  BasicPageImpl<PageSize>& getPage() {
     return page;
   }
   uchar *getPageBody() {
@@ -100,6 +196,9 @@ class PageHandler {
   }
 };
 
+using PageImpl = BasicPageImpl<PAGE_SIZE>;
+using PageHandler = BasicPageHandler<PAGE_SIZE>;
+
 } // namespace page
 
 #endif  // TOYBOX_PAGE_H
@@ -0,0 +1,77 @@
+#ifndef TOYBOX_PAX_PAGE_H
+#define TOYBOX_PAX_PAGE_H
+
+#include <cinttypes>
+
+#include "my_inttypes.h"
+#include "page_type.h"
+
+namespace page {
+
+// minipages start on their own cache line
+constexpr const uint32_t PAX_MINIPAGE_ALIGNMENT = 64;
+
+struct __attribute__ ((__packed__)) PaxDirectory {
+  uint32_t columnCount;
+  // rows the page has room for
+  uint32_t capacity;
+  uint32_t rowSize;
+  uint32_t reserve;
+};
+
+// the values of one column, capacity of them one after the other
+struct __attribute__ ((__packed__)) PaxMinipage {
+  offset valueOffset;
+  tuple_size valueSize;
+};
+
+/**
+ * A page in the PAX (partition attributes across) layout, viewed through
+ * its body. The body starts with a PaxDirectory and a PaxMinipage per
+ * column, then holds a minipage per column: the value of row r in column
+ * c is at minipages[c].valueOffset + r * minipages[c].valueSize. A scan
+ * reading some of the columns only touches their minipages.
+ *
+ * Every row has the same size, the sum of the column sizes, so a page
+ * holds a fixed number of rows set when it is formatted.
+ */
+class PaxPage {
+ private:
+  uchar *body;
+  const PaxDirectory &getDirectory() const {
+    return *reinterpret_cast<const PaxDirectory *>(body);
+  }
+  const PaxMinipage &getMinipage(uint32_t column) const {
+    return reinterpret_cast<const PaxMinipage *>(body +
+                                                 sizeof(PaxDirectory))[column];
+  }
+ public:
+  explicit PaxPage(uchar *body) : body(body) {}
+  static uint32_t computeCapacity(uint32_t bodySize,
+                                  const uint32_t *columnSizes,
+                                  uint32_t columnCount);
+  uint32_t format(uint32_t bodySize, const uint32_t *columnSizes,
+                  uint32_t columnCount);
+  uint32_t getColumnCount() const {
+    return getDirectory().columnCount;
+  }
+  uint32_t getCapacity() const {
+    return getDirectory().capacity;
+  }
+  uint32_t getRowSize() const {
+    return getDirectory().rowSize;
+  }
+  uint32_t getColumnSize(uint32_t column) const {
+    return getMinipage(column).valueSize;
+  }
+  const uchar *getValue(uint64_t row, uint32_t column) const {
+    const PaxMinipage &minipage = getMinipage(column);
+    return body + minipage.valueOffset + row * minipage.valueSize;
+  }
+  void insert(uint64_t row, const uchar *tuple);
+  uint32_t readRow(uint64_t row, uchar *tuple) const;
+};
+
+} // namespace page
+
+#endif  // TOYBOX_PAX_PAGE_H
@@ -0,0 +1,85 @@
+#ifndef TOYBOX_PREDICATE_H
+#define TOYBOX_PREDICATE_H
+
+#include <cinttypes>
+#include <utility>
+#include <vector>
+
+#include "compare_kernel.h"
+#include "page.h"
+
+namespace predicate {
+
+// how a column value is stored in a page, little endian
+enum class ValueType : uint8_t {
+  INT8,
+  INT16,
+  INT24,
+  INT32,
+  INT64,
+  UINT8,
+  UINT16,
+  UINT24,
+  UINT32,
+  FLOAT,
+  DOUBLE,
+  // year * 512 + month * 32 + day in 3 bytes, as MySQL stores a DATE
+  DATE
+};
+
+uint32_t getValueSize(ValueType type);
+bool isRealValueType(ValueType type);
+
+/**
+ * A comparison of a column with a constant, column op constant. The
+ * constant is intValue for integer and date columns, realValue for FLOAT
+ * and DOUBLE ones, which are compared as doubles.
+ */
+struct Predicate {
+  // the minipage of the column in a PAX page
+  uint32_t column;
+  // the bytes before the column in a tuple of a row page
+  uint32_t valueOffset;
+  ValueType type;
+  CompareOp op;
+  int64_t intValue;
+  double realValue;
+};
+
+/**
+ * Evaluates predicates ANDed together over every row of a page at once,
+ * with the compare kernels, into a selection bitmap a bit per row, so
+ * that a scan skips the rows failing them without reading them.
+ *
+ * The values of a column are compared where they are when they sit one
+ * after the other in the width of a kernel, as in the minipage of an INT,
+ * BIGINT or DOUBLE column of a PAX page. Otherwise they are first copied,
+ * widened, out of the minipage or the tuples.
+ */
+class PageFilter {
+ private:
+  std::vector<Predicate> predicates;
+  const CompareKernels &kernels;
+  std::vector<uint64_t> selection;
+  uint64_t rowCount = 0;
+  std::vector<int32_t> int32Values;
+  std::vector<int64_t> int64Values;
+  std::vector<double> doubleValues;
+  void evaluate(page::PageHandler &pageHandler, const Predicate &predicate);
+ public:
+  explicit PageFilter(std::vector<Predicate> predicates,
+                      const CompareKernels &kernels = getCompareKernels())
+      : predicates(std::move(predicates)), kernels(kernels) {}
+  void evaluate(page::PageHandler &pageHandler);
+  uint64_t getRowCount() const {
+    return rowCount;
+  }
+  bool isSelected(uint64_t row) const {
+    return (selection[row / 64] >> (row % 64)) & 1;
+  }
+  uint64_t nextSelectedRow(uint64_t row) const;
+};
+
+} // namespace predicate
+
+#endif  // TOYBOX_PREDICATE_H
@@ -0,0 +1,56 @@
+#ifndef TOYBOX_READ_AHEAD_H
+#define TOYBOX_READ_AHEAD_H
+
+#include <deque>
+#include <string>
+
+#include "page_type.h"
+#include "tablespace_type.h"
+#include "my_inttypes.h"
+#include "my_thread.h"
+#include "mysql/psi/mysql_cond.h"
+#include "mysql/psi/mysql_mutex.h"
+
+namespace buf {
+
+class BufPool;
+
+constexpr const uint64_t DEFAULT_READ_AHEAD_WINDOW = 16; // pages
+constexpr const uint64_t MAX_READ_AHEAD_WINDOW = 256;
+// requests beyond this are dropped, read-ahead is only a hint
+constexpr const uint64_t MAX_READ_AHEAD_QUEUE = 64;
+
+// pageCount adjacent pages of a tablespace, starting at firstPageId
+struct PageRun {
+  tablespace_id tablespaceId;
+  page_id firstPageId;
+  uint64_t pageCount;
+  std::string tablespacePath;
+};
+
+/**
+ * Background thread bringing pages into the buffer pool ahead of a
+ * sequential scan, so that the scan finds them cached instead of waiting
+ * for one read per page.
+ */
+class ReadAhead {
+ private:
+  BufPool *bufPool = nullptr;
+  mysql_mutex_t mutex;
+  mysql_cond_t cond;
+  std::deque<PageRun> queue;
+  my_thread_handle thread;
+  bool running = false;
+  bool shutdown = false;
+  static void *run(void *arg);
+ public:
+  void start(BufPool *bufPool);
+  void stop();
+  bool isRunning();
+  void enqueue(PageRun request);
+  void cancel(tablespace_id tablespaceId);
+};
+
+}
+
+#endif  // TOYBOX_READ_AHEAD_H
@@ -0,0 +1,202 @@
+#ifndef TOYBOX_REDO_LOG_H
+#define TOYBOX_REDO_LOG_H
+
+#include <atomic>
+#include <cinttypes>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "file_config.h"
+#include "file_handler.h"
+#include "my_inttypes.h"
+#include "my_thread.h"
+#include "mysql/psi/mysql_cond.h"
+#include "mysql/psi/mysql_mutex.h"
+#include "page_type.h"
+#include "redo_log_type.h"
+#include "tablespace_type.h"
+
+namespace redo {
+
+constexpr const char *LOG_FILE_PATH = "./toyboxlog";
+// "TOYBXLOG"
+constexpr const uint64_t LOG_FILE_MAGIC = 0x474f4c5842594f54;
+constexpr const uint32_t LOG_FORMAT = 1;
+// the file header takes a whole block, records start after it
+constexpr const int LOG_HEADER_SIZE = file_config::IO_BLOCK_SIZE;
+constexpr const lsn_t LOG_START_LSN = LOG_HEADER_SIZE;
+// bytes of records kept in memory before they are written to the file
+constexpr const uint64_t DEFAULT_LOG_BUFFER_SIZE = 1024 * 1024;
+constexpr const uint64_t MIN_LOG_BUFFER_SIZE = 64 * 1024;
+// checkpoints go to the two slots in turn, in different sectors of the
+// file header, so that a torn write only loses the one being written
+constexpr const int CHECKPOINT_SLOT_COUNT = 2;
+constexpr const my_off_t CHECKPOINT_SLOT_OFFSETS[CHECKPOINT_SLOT_COUNT] = {
+    512, 1024};
+
+// sysvar order, see toybox_log_durability
+enum class Durability : ulong {
+  // a statement's records are synced before it returns
+  COMMIT,
+  // records are synced once per second in the background
+  SECOND,
+  // records are synced only before the pages they changed are written
+  NONE
+};
+
+enum class RecordType : uint8_t {
+  // payload: path of the tablespace file, logged before the first record
+  // of a tablespace
+  FILE_NAME = 1,
+  // payload: the tuple appended to the page
+  INSERT = 2,
+  // payload: the page_id of the page chained after the page
+  NEXT_PAGE = 3
+};
+
+struct __attribute__ ((__packed__)) LogFileHeader {
+  uint64_t magic;
+  uint32_t format;
+  uint8_t reserve[LOG_HEADER_SIZE - 12];
+};
+
+static_assert(sizeof(LogFileHeader) == LOG_HEADER_SIZE);
+
+struct __attribute__ ((__packed__)) CheckpointSlot {
+  // of the rest of the slot
+  uint32_t checksum;
+  // the slot with the highest number holds the last checkpoint
+  uint64_t number;
+  // recovery starts at this LSN, every page change logged before it is
+  // in the tablespace files
+  lsn_t lsn;
+};
+
+struct __attribute__ ((__packed__)) RecordHeader {
+  // of the rest of the header and the payload
+  uint32_t checksum;
+  uint32_t payloadSize;
+  uint8_t type;
+  tablespace_id tablespaceId;
+  page_id pageId;
+};
+
+constexpr const int RECORD_HEADER_SIZE = sizeof(RecordHeader);
+
+struct LogRecord {
+  RecordType type;
+  tablespace_id tablespaceId;
+  page_id pageId;
+  // valid until the next record is read
+  const uchar *payload;
+  uint32_t payloadSize;
+  // just past the record, the LSN of a page it was applied to
+  lsn_t lsn;
+};
+
+/**
+ * Reads the records of a log file in order, up to the first one that
+ * was not written completely.
+ */
+class LogReader {
+ private:
+  file_handler::FileDescriptor fd;
+  std::vector<uchar> buffer;
+  // LSN of buffer[0]
+  lsn_t bufferLsn;
+  size_t bufferSize = 0;
+  // the next record
+  lsn_t lsn;
+  bool fill(size_t size);
+ public:
+  explicit LogReader(file_handler::FileDescriptor fd,
+                     lsn_t startLsn = LOG_START_LSN);
+  bool next(LogRecord &record);
+  // the end of the last record read
+  lsn_t getLsn() const {
+    return lsn;
+  }
+};
+
+/**
+ * The redo log, one file the records of page changes are appended to.
+ * Records are buffered in memory and written by whichever thread first
+ * needs them on disk; threads needing them at the same time wait for that
+ * thread, so that a single sync covers every one of them (group commit).
+ */
+class RedoLog {
+ private:
+  file_handler::FileDescriptor fd = -1;
+  // protects everything below
+  mysql_mutex_t mutex;
+  // signalled when a write of the buffer completes
+  mysql_cond_t writeCond;
+  // signalled to stop the flusher
+  mysql_cond_t flusherCond;
+  // the records not yet handed to a write, up to currentLsn
+  std::vector<uchar> buffer;
+  uint64_t bufferCapacity = DEFAULT_LOG_BUFFER_SIZE;
+  lsn_t currentLsn = LOG_START_LSN;
+  lsn_t writtenLsn = LOG_START_LSN;
+  lsn_t flushedLsn = LOG_START_LSN;
+  // a thread is writing the buffer without the mutex
+  bool writing = false;
+  // a write or sync failed, nothing is written anymore
+  bool failed = false;
+  // the path of every tablespace whose FILE_NAME record was logged
+  std::unordered_map<tablespace_id, std::string> namedTablespaces;
+  lsn_t checkpointLsn = LOG_START_LSN;
+  uint64_t checkpointNumber = 0;
+  // the end of the FILE_NAME records logged by the last checkpoint
+  lsn_t namedLsn = 0;
+  // serializes writeCheckpoint()
+  mysql_mutex_t checkpointMutex;
+  std::atomic<Durability> durability{Durability::COMMIT};
+  std::atomic<uint64_t> syncCount{0};
+  bool flusherRunning = false;
+  bool flusherShutdown = false;
+  my_thread_handle flusherThread;
+  void append(RecordType type, tablespace_id tablespaceId, page_id pageId,
+              const uchar *payload, uint32_t payloadSize);
+  lsn_t appendPageChange(RecordType type, tablespace_id tablespaceId,
+                         page_id pageId, const char *tablespacePath,
+                         const uchar *payload, uint32_t payloadSize);
+  bool write(lsn_t lsn, bool sync);
+  void readCheckpoint();
+  static void *runFlusher(void *arg);
+ public:
+  RedoLog();
+  ~RedoLog();
+  RedoLog(const RedoLog &) = delete;
+  RedoLog &operator=(const RedoLog &) = delete;
+  bool open(const char *path,
+            uint64_t bufferCapacity = DEFAULT_LOG_BUFFER_SIZE);
+  void close();
+  lsn_t appendInsert(tablespace_id tablespaceId, page_id pageId,
+                     const char *tablespacePath, const uchar *tuple,
+                     uint32_t tupleSize);
+  lsn_t appendNextPage(tablespace_id tablespaceId, page_id pageId,
+                       const char *tablespacePath, page_id nextPageId);
+  bool writeUpTo(lsn_t lsn);
+  bool flushUpTo(lsn_t lsn);
+  bool commit();
+  bool hasFailed();
+  bool writeCheckpoint(lsn_t lsn);
+  void discardTablespace(tablespace_id tablespaceId);
+  void setDurability(Durability durability);
+  Durability getDurability() const;
+  void startFlusher();
+  void stopFlusher();
+  lsn_t getCurrentLsn();
+  lsn_t getFlushedLsn();
+  lsn_t getCheckpointLsn();
+  uint64_t getSyncCount() const;
+  file_handler::FileDescriptor getFileDescriptor() const {
+    return fd;
+  }
+};
+
+}
+
+#endif  // TOYBOX_REDO_LOG_H
@@ -0,0 +1,11 @@
+#ifndef TOYBOX_REDO_LOG_TYPE_H
+#define TOYBOX_REDO_LOG_TYPE_H
+
+#include <cinttypes>
+
+// a position in the redo log, the offset of a byte in its file
+typedef uint64_t lsn_t;
+
+constexpr const lsn_t LSN_MAX = UINT64_MAX;
+
+#endif  // TOYBOX_REDO_LOG_TYPE_H
@@ -0,0 +1,82 @@
+#ifndef TOYBOX_REDO_RECOVERY_H
+#define TOYBOX_REDO_RECOVERY_H
+
+#include <cinttypes>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "bufpool.h"
+#include "file_handler.h"
+#include "my_thread.h"
+#include "redo_log.h"
+#include "tablespace_type.h"
+
+namespace redo {
+
+constexpr const uint64_t DEFAULT_RECOVERY_THREADS = 4;
+constexpr const uint64_t MAX_RECOVERY_THREADS = 64;
+// bytes of record payloads read from the log before they are applied
+constexpr const size_t RECOVERY_BATCH_SIZE = 16 * 1024 * 1024;
+
+/**
+ * Re-applies the records of a log to the pages in a buffer pool. A record
+ * is skipped when the page already has it, that is, when the LSN of the
+ * page is not below the LSN of the record, so recovering twice is safe.
+ * The recovered pages are left dirty in the pool and nothing is logged.
+ *
+ * The records are read in batches and split between the workers by page
+ * group, like pages are between buffer pool instances, so that each page
+ * is changed by one worker in LSN order. A worker reads the pages of a
+ * group it has records for together, then applies every record of a page
+ * with one latch.
+ */
+class RedoRecovery {
+ private:
+  // a record of the batch, its payload copied out of the log
+  struct PendingRecord {
+    RecordType type;
+    tablespace_id tablespaceId;
+    page_id pageId;
+    lsn_t lsn;
+    size_t payloadOffset;
+    uint32_t payloadSize;
+  };
+  struct Worker {
+    RedoRecovery *recovery;
+    std::vector<PendingRecord> records;
+    my_thread_handle thread;
+    uint64_t appliedCount = 0;
+    uint64_t skippedCount = 0;
+    // a page of the batch could not be recovered
+    bool failed = false;
+  };
+  buf::BufPool &bufPool;
+  // the path of every tablespace named in the log
+  std::unordered_map<tablespace_id, std::string> tablespacePaths;
+  std::vector<uchar> payloads;
+  std::vector<Worker> workers;
+  uint64_t appliedCount = 0;
+  uint64_t skippedCount = 0;
+  bool applyBatch();
+  void applyRecords(Worker &worker);
+  static bool isDropped(tablespace_id tablespaceId,
+                        const char *tablespacePath);
+  bool applyPage(const PendingRecord *first, const PendingRecord *last,
+                 const char *tablespacePath, Worker &worker);
+  static void *runWorker(void *arg);
+ public:
+  explicit RedoRecovery(buf::BufPool &bufPool, uint64_t workerCount = 1);
+  lsn_t recover(file_handler::FileDescriptor fd,
+                lsn_t checkpointLsn = LOG_START_LSN);
+  uint64_t getAppliedCount() const {
+    return appliedCount;
+  }
+  uint64_t getSkippedCount() const {
+    return skippedCount;
+  }
+};
+
+}
+
+#endif  // TOYBOX_REDO_RECOVERY_H
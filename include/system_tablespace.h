@@ -8,6 +8,7 @@
 #include "mysql/components/services/bits/my_io_bits.h"
 #include "mysql/components/services/bits/psi_file_bits.h"
 
+#include "file_config.h"
 #include "file_handler.h"
 #include "tablespace_type.h"
 
@@ -17,6 +18,8 @@ namespace system_table {
 
 constexpr const char *SYSTEM_TABLESPACE_PATH = "./toyboxsys";
 constexpr const int SYSTEM_TABLESPACE_SIZE = 8;
+// read and written as a whole block for direct I/O
+constexpr const int SYSTEM_TABLESPACE_BLOCK_SIZE = file_config::IO_BLOCK_SIZE;
 
 // Error handling flag. See "my_sys.h".
 constexpr const int MYF_STRICT_MODE = (MY_FAE | MY_WME);
@@ -25,15 +28,18 @@ constexpr const int MAX_TABLE_ID_INITIAL_VALUE = 0;
 
 struct __attribute__ ((__packed__)) SystemTablespace {
   tablespace_id maxTablespaceId;
+  uint8_t reserve[SYSTEM_TABLESPACE_BLOCK_SIZE - SYSTEM_TABLESPACE_SIZE];
 };
 
+static_assert(sizeof(SystemTablespace) == SYSTEM_TABLESPACE_BLOCK_SIZE);
+
 class SystemTablespaceImpl {
  private:
-  SystemTablespace systemTablespace;
+  alignas(file_config::IO_BLOCK_SIZE) SystemTablespace systemTablespace;
  public:
-  SystemTablespaceImpl() : systemTablespace(SystemTablespace{0}) {}
+  SystemTablespaceImpl() : systemTablespace(SystemTablespace{0, {0}}) {}
   explicit SystemTablespaceImpl(tablespace_id tablespaceId)
-      : systemTablespace(SystemTablespace{tablespaceId}) {}
+      : systemTablespace(SystemTablespace{tablespaceId, {0}}) {}
   void incrementMaxTablespaceId();
   tablespace_id getMaxTablespaceId() const;
   uchar *toBinary();
@@ -8,6 +8,7 @@
 #include <utility>
 
 #include "tablespace_type.h"
+#include "file_config.h"
 #include "file_handler.h"
 #include "system_tablespace.h"
 
@@ -18,10 +19,13 @@ constexpr const char *FILE_EXT = ".toy";
 constexpr const int TABLE_SPACE_START_POSITION = 0;
 constexpr const int TABLE_SPACE_HEADER_START_POSITION
     = TABLE_SPACE_START_POSITION;
-constexpr const int TABLE_SPACE_HEADER_SIZE = 16;
+constexpr const int TABLE_SPACE_HEADER_SIZE = 24;
+// the header is padded to a whole block, so that everything after it
+// stays aligned for direct I/O
+constexpr const int TABLE_SPACE_HEADER_BLOCK_SIZE = file_config::IO_BLOCK_SIZE;
 constexpr const int SYSTEM_PAGE_HEADER_START_POSITION =
-    TABLE_SPACE_START_POSITION + TABLE_SPACE_HEADER_SIZE;
-constexpr const int SYSTEM_PAGE_HEADER_SIZE = 16;
+    TABLE_SPACE_START_POSITION + TABLE_SPACE_HEADER_BLOCK_SIZE;
+constexpr const int SYSTEM_PAGE_HEADER_SIZE = 24;
 constexpr const int SYSTEM_PAGE_SIZE = 4096;
 // TODO: replace to MySQL Column Max Size
 constexpr const int COLUMN_NAME_MAX_SIZE = 64;
@@ -29,39 +33,78 @@ constexpr const int FIX_SIZE_COLUMN = 0;
 constexpr const int VARIABLE_SIZE_COLUMN = 1;
 
 constexpr const int SYSTEM_PAGE_ID = 0;
+// pages the file grows by at a time, so that it is synced once for them
+constexpr const uint64_t EXTENT_PAGE_COUNT = 64;
+// the page size of tablespaces created before it was recorded
+constexpr const uint64_t LEGACY_PAGE_SIZE = 4096;
+// columns whose size the system page has room for
+constexpr const uint64_t MAX_COLUMN_COUNT =
+    (SYSTEM_PAGE_SIZE - SYSTEM_PAGE_HEADER_SIZE) / sizeof(uint32_t);
+
+// how the rows of a table are laid out in its pages
+enum class PageLayout : uint8_t {
+  // whole rows packed from the end of the page, found through slots
+  ROW = 0,
+  // a minipage per column, see page::PaxPage
+  PAX = 1
+};
 
 struct __attribute__ ((__packed__)) TablespaceHeader {
   tablespace_id id;
+  // pages chained from page 0, the file may hold unused ones after them
   uint64_t pageCount;
+  // bytes, the tablespace can only be opened by an engine built with it
+  uint64_t pageSize;
+};
+
+// what is read and written of the header
+struct __attribute__ ((__packed__)) TablespaceHeaderBlock {
+  TablespaceHeader header;
+  uint8_t reserve[TABLE_SPACE_HEADER_BLOCK_SIZE - TABLE_SPACE_HEADER_SIZE];
 };
 
+static_assert(sizeof(TablespaceHeader) == TABLE_SPACE_HEADER_SIZE);
+static_assert(sizeof(TablespaceHeaderBlock) == TABLE_SPACE_HEADER_BLOCK_SIZE);
+
 class TablespaceHeaderImpl {
  private:
-  TablespaceHeader tablespaceHeader{};
+  alignas(file_config::IO_BLOCK_SIZE) TablespaceHeaderBlock tablespaceHeader{};
  public:
   TablespaceHeaderImpl() {}
-  explicit TablespaceHeaderImpl(uint64_t tableId) {
-    tablespaceHeader = TablespaceHeader{tableId, 0};
+  TablespaceHeaderImpl(uint64_t tableId, uint64_t pageSize) {
+    tablespaceHeader.header = TablespaceHeader{tableId, 0, pageSize};
   }
   void read(file_handler::FileDescriptor fd);
   void incrementPageCount();
+  void setPageCount(uint64_t pageCount);
   tablespace_id getId();
   uint64_t getPageCount();
+  uint64_t getPageSize();
   uchar *toBinary();
 };
 
 struct __attribute__ ((__packed__)) SystemPageHeader {
   uint64_t pageId;
   uint64_t columnCount;
-  uint8_t reserve[SYSTEM_PAGE_SIZE - SYSTEM_PAGE_HEADER_SIZE];
+  // a PageLayout, ROW in tablespaces created before it was recorded
+  uint64_t layout;
+  // bytes of each column in a row, recorded for the PAX layout
+  uint32_t columnSizes[MAX_COLUMN_COUNT];
 };
 
+static_assert(sizeof(SystemPageHeader) == SYSTEM_PAGE_SIZE);
+
 class SystemPageHeaderImpl {
  private:
-  SystemPageHeader systemPageHeader;
+  alignas(file_config::IO_BLOCK_SIZE) SystemPageHeader systemPageHeader;
  public:
   SystemPageHeaderImpl() : systemPageHeader(SystemPageHeader{}) {}
   void read(file_handler::FileDescriptor fd);
+  bool setLayout(PageLayout layout, const uint32_t *columnSizes,
+                 uint64_t columnCount);
+  PageLayout getLayout() const;
+  uint64_t getColumnCount() const;
+  const uint32_t *getColumnSizes() const;
   uchar *toBinary();
 };
 
@@ -84,7 +127,7 @@ class TablespaceHandler {
   void remove();
   TablespaceHeaderImpl& getTablespaceHeader();
   SystemPageHeaderImpl& getSystemPageHeader();
-  void flushTablespaceHeader();
+  bool flushTablespaceHeader();
   void flushSystemPageHeader();
   file_handler::FileDescriptor getFileDescriptor();
 };
@@ -0,0 +1,140 @@
+#ifndef TOYBOX_TABLESPACE_CACHE_H
+#define TOYBOX_TABLESPACE_CACHE_H
+
+#include <cinttypes>
+#include <list>
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+#include "tablespace.h"
+#include "tablespace_mapping.h"
+#include "tablespace_type.h"
+#include "mysql/psi/mysql_cond.h"
+#include "mysql/psi/mysql_mutex.h"
+
+namespace tablespace {
+
+// open tablespace files kept when no limit is given
+constexpr const uint64_t DEFAULT_OPEN_FILES = 300;
+constexpr const uint64_t MIN_OPEN_FILES = 10;
+
+class TablespaceCache;
+
+/**
+ * An open tablespace file, shared by every user of the tablespace.
+ */
+struct CachedTablespace {
+  // owns the path the handler points into
+  std::string path;
+  TablespaceHandler handler;
+  uint64_t refCount = 0;
+  std::list<CachedTablespace *>::iterator lruPosition;
+  // created on the first map(), replaced when the file grew past it
+  std::shared_ptr<const TablespaceMapping> mapping;
+  // pages were written since the last sync, kept open until it
+  bool written = false;
+  // a sync failed and pages may be lost, see TablespaceCache::syncWritten()
+  bool syncFailed = false;
+  // serializes chaining pages to the tablespace, see BufPool::allocatePage()
+  mysql_mutex_t allocateMutex;
+  // the leading free space map pages that map every page as full, a hint
+  // found by BufPool::findPageWithSpace(). Bumped whenever it is lowered,
+  // so that a search does not raise it past a map page changed meanwhile.
+  uint64_t fullFsmPageCount = 0;
+  uint64_t fsmHintVersion = 0;
+  explicit CachedTablespace(const char *path);
+  ~CachedTablespace();
+  CachedTablespace(const CachedTablespace &) = delete;
+  CachedTablespace &operator=(const CachedTablespace &) = delete;
+};
+
+/**
+ * Pins an open tablespace file, which is not closed before the guard is
+ * released.
+ */
+class TablespaceGuard {
+ private:
+  TablespaceCache *cache = nullptr;
+  CachedTablespace *entry = nullptr;
+ public:
+  TablespaceGuard() = default;
+  TablespaceGuard(TablespaceCache *cache, CachedTablespace *entry)
+      : cache(cache), entry(entry) {}
+  TablespaceGuard(TablespaceGuard &&other) noexcept;
+  TablespaceGuard &operator=(TablespaceGuard &&other) noexcept;
+  TablespaceGuard(const TablespaceGuard &) = delete;
+  TablespaceGuard &operator=(const TablespaceGuard &) = delete;
+  ~TablespaceGuard() { release(); }
+  void release();
+  bool isValid() const {
+    return entry != nullptr;
+  }
+  tablespace_id getTablespaceId() {
+    return entry->handler.getTablespaceHeader().getId();
+  }
+  file_handler::FileDescriptor getFileDescriptor() {
+    return entry->handler.getFileDescriptor();
+  }
+  TablespaceHandler &getTablespaceHandler() {
+    return entry->handler;
+  }
+  mysql_mutex_t *getAllocateMutex() {
+    return &entry->allocateMutex;
+  }
+  std::shared_ptr<const TablespaceMapping> map(page_id pageId);
+  void markWritten();
+  uint64_t getFullFsmPageCount(uint64_t *version);
+  void raiseFullFsmPageCount(uint64_t count, uint64_t version);
+  void lowerFullFsmPageCount(uint64_t count);
+};
+
+/**
+ * The open tablespace files, keyed by tablespace_id. A file is opened on
+ * its first use and kept open for every later one, so that reading a page
+ * is a single positional read on a shared descriptor. Once more than
+ * capacity files are open, the least recently used unpinned ones are
+ * closed; pinned files are never closed, so capacity is a soft limit.
+ */
+class TablespaceCache {
+ private:
+  // protects everything below
+  mysql_mutex_t mutex;
+  // signalled whenever a file is unpinned
+  mysql_cond_t unpinCond;
+  // serializes syncWritten(), a caller returns once every file written
+  // before it was synced
+  mysql_mutex_t syncMutex;
+  uint64_t capacity = DEFAULT_OPEN_FILES;
+  std::unordered_map<tablespace_id, CachedTablespace *> tablespaces;
+  // most recently used first
+  std::list<CachedTablespace *> lru;
+  bool initialized = false;
+  TablespaceGuard pin(CachedTablespace *entry);
+  CachedTablespace *insert(CachedTablespace *entry);
+  void closeExcess();
+  void close(CachedTablespace *entry);
+  friend class TablespaceGuard;
+  void unpin(CachedTablespace *entry);
+  void markWritten(CachedTablespace *entry);
+  uint64_t getFullFsmPageCount(CachedTablespace *entry, uint64_t *version);
+  void raiseFullFsmPageCount(CachedTablespace *entry, uint64_t count,
+                             uint64_t version);
+  void lowerFullFsmPageCount(CachedTablespace *entry, uint64_t count);
+  std::shared_ptr<const TablespaceMapping> map(CachedTablespace *entry,
+                                               page_id pageId);
+ public:
+  void init(uint64_t capacity = DEFAULT_OPEN_FILES);
+  void deinit();
+  TablespaceGuard open(const char *path);
+  TablespaceGuard get(tablespace_id tablespaceId, const char *path);
+  void remove(tablespace_id tablespaceId, const char *path);
+  bool syncWritten();
+  void setCapacity(uint64_t capacity);
+  uint64_t getCapacity();
+  uint64_t getOpenFileCount();
+};
+
+}
+
+#endif  // TOYBOX_TABLESPACE_CACHE_H
@@ -0,0 +1,45 @@
+#ifndef TOYBOX_TABLESPACE_MAPPING_H
+#define TOYBOX_TABLESPACE_MAPPING_H
+
+#include <cinttypes>
+
+#include "file_handler.h"
+#include "my_inttypes.h"
+#include "page.h"
+#include "page_type.h"
+
+namespace tablespace {
+
+/**
+ * A read-only shared mapping of the pages of a tablespace file, as long
+ * as the file was when it was mapped. Page images are addressed at
+ * PAGE_START_POSITION + id * PAGE_SIZE, as in the file, and stay valid
+ * for the lifetime of the mapping even if the file is closed or grows.
+ */
+class TablespaceMapping {
+ private:
+  uchar *region = nullptr;
+  size_t regionSize = 0;
+  uint64_t pageCount = 0;
+ public:
+  explicit TablespaceMapping(file_handler::FileDescriptor fd);
+  ~TablespaceMapping();
+  TablespaceMapping(const TablespaceMapping &) = delete;
+  TablespaceMapping &operator=(const TablespaceMapping &) = delete;
+  uint64_t getPageCount() const {
+    return pageCount;
+  }
+  // nullptr for pages the file did not have when it was mapped
+  const uchar *getPage(page_id pageId) const {
+    if (pageId >= pageCount) {
+      return nullptr;
+    }
+    return region + page::PAGE_START_POSITION + pageId * page::PAGE_SIZE;
+  }
+  void adviseSequential() const;
+  void adviseWillNeed(page_id firstPageId, uint64_t pageCount) const;
+};
+
+}
+
+#endif  // TOYBOX_TABLESPACE_MAPPING_H
@@ -16,7 +16,7 @@ class Tuple {
  public:
   Tuple(uint32_t size, uint8_t nullBitmask)
       : nullBitmask(nullBitmask), data(size) {}
-  Tuple(uint32_t size, uint8_t nullBitmask, uint8_t *data)
+  Tuple(uint32_t size, uint8_t nullBitmask, const uint8_t *data)
       : nullBitmask(nullBitmask), data(size){
     memcpy(this->data.data(), data, size);
   }
@@ -31,6 +31,25 @@ class Tuple {
   }
 };
 
+/**
+ * A tuple stored in a page, read in place. Only valid while the page is
+ * pinned and latched.
+ */
+class TupleView {
+ private:
+  const uint8_t *data = nullptr;
+  uint32_t size = 0;
+ public:
+  TupleView() = default;
+  TupleView(const uint8_t *data, uint32_t size) : data(data), size(size) {}
+  uint32_t getSize() const {
+    return this->size;
+  }
+  const uint8_t *getData() const {
+    return this->data;
+  }
+};
+
 } // namespace tuple
 
 #endif  // TUPLE_TUPLE_H
@@ -0,0 +1,172 @@
+#include "checkpointer.h"
+
+#include <algorithm>
+
+#include "bufpool.h"
+#include "my_systime.h"
+#include "redo_log.h"
+
+PSI_mutex_key checkpointer_mutex_key;
+PSI_mutex_key checkpoint_flush_mutex_key;
+PSI_cond_key checkpointer_cond_key;
+PSI_thread_key checkpointer_thread_key;
+
+namespace redo {
+
+Checkpointer::Checkpointer(buf::BufPool *bufPool, RedoLog *redoLog,
+                           uint64_t maxAge)
+    : bufPool(bufPool), redoLog(redoLog),
+      maxAge(std::max(maxAge, MIN_MAX_CHECKPOINT_AGE)) {
+  mysql_mutex_init(checkpointer_mutex_key, &this->mutex, MY_MUTEX_INIT_FAST);
+  mysql_mutex_init(checkpoint_flush_mutex_key, &this->flushMutex,
+                   MY_MUTEX_INIT_FAST);
+  mysql_cond_init(checkpointer_cond_key, &this->cond);
+}
+
+Checkpointer::~Checkpointer() {
+  stop();
+  mysql_cond_destroy(&this->cond);
+  mysql_mutex_destroy(&this->flushMutex);
+  mysql_mutex_destroy(&this->mutex);
+}
+
+void Checkpointer::start() {
+  if (this->running) {
+    return;
+  }
+  this->shutdown = false;
+  this->running = true;
+
+  my_thread_attr_t attr;
+  my_thread_attr_init(&attr);
+  my_thread_attr_setdetachstate(&attr, MY_THREAD_CREATE_JOINABLE);
+  mysql_thread_create(checkpointer_thread_key, &this->thread, &attr, run,
+                      this);
+  my_thread_attr_destroy(&attr);
+}
+
+void Checkpointer::stop() {
+  if (!this->running) {
+    return;
+  }
+  mysql_mutex_lock(&this->mutex);
+  this->shutdown = true;
+  mysql_cond_signal(&this->cond);
+  mysql_mutex_unlock(&this->mutex);
+
+  my_thread_join(&this->thread, nullptr);
+  this->running = false;
+}
+
+/**
+ * Moves the checkpoint to the oldest change not yet in the tablespace
+ * files, or to the end of the log if every change is.
+ * @return false if the checkpoint could not be written
+ */
+bool Checkpointer::checkpoint() {
+  // read before the pages, a page changed in between is marked with an
+  // LSN at least this one
+  lsn_t lsn = this->redoLog->getCurrentLsn();
+  lsn = std::min(lsn, this->bufPool->getOldestModification());
+  // the pages written before lsn may not have left the OS cache yet
+  if (!this->bufPool->syncWrittenTablespaces()) {
+    return false;
+  }
+  return this->redoLog->writeCheckpoint(lsn);
+}
+
+/**
+ * Flushes pages with the oldest changes in proportion to how far the
+ * age is between the low water mark and maxAge, then checkpoints. Past
+ * maxAge every page changed before the low water mark is flushed.
+ */
+void Checkpointer::adaptiveFlush() {
+  checkpoint();
+  uint64_t maxAge = this->maxAge;
+  uint64_t lowWater = maxAge * ADAPTIVE_FLUSH_LWM_PCT / 100;
+  uint64_t age = getAge();
+  if (age <= lowWater) {
+    return;
+  }
+  uint64_t flushCount = UINT64_MAX;
+  if (age < maxAge) {
+    flushCount = std::max<uint64_t>(this->bufPool->getMaxPageCount() *
+                                        (age - lowWater) / (maxAge - lowWater),
+                                    1);
+  }
+  this->bufPool->flushOldestPages(this->redoLog->getCurrentLsn() - lowWater,
+                                  flushCount);
+  checkpoint();
+}
+
+/**
+ * Called before logging a change. Once the age is over maxAge, flushes
+ * the oldest pages and checkpoints until it is back under the low water
+ * mark, so that changes wait instead of the redo to replay growing.
+ */
+void Checkpointer::makeSpace() {
+  if (getAge() <= this->maxAge) {
+    return;
+  }
+  mysql_mutex_lock(&this->flushMutex);
+  // another thread may have made the space while this one waited
+  if (getAge() > this->maxAge) {
+    this->syncFlushCount++;
+    uint64_t lowWater = this->maxAge * ADAPTIVE_FLUSH_LWM_PCT / 100;
+    lsn_t checkpointLsn = this->redoLog->getCheckpointLsn();
+    while (getAge() > lowWater) {
+      this->bufPool->flushOldestPages(
+          this->redoLog->getCurrentLsn() - lowWater, UINT64_MAX);
+      if (!checkpoint() ||
+          this->redoLog->getCheckpointLsn() == checkpointLsn) {
+        // the oldest pages cannot be written, or are latched
+        break;
+      }
+      checkpointLsn = this->redoLog->getCheckpointLsn();
+    }
+  }
+  mysql_mutex_unlock(&this->flushMutex);
+}
+
+void Checkpointer::setMaxAge(uint64_t maxAge) {
+  this->maxAge = std::max(maxAge, MIN_MAX_CHECKPOINT_AGE);
+}
+
+uint64_t Checkpointer::getMaxAge() const {
+  return this->maxAge;
+}
+
+// bytes of redo a recovery would replay
+uint64_t Checkpointer::getAge() const {
+  lsn_t checkpointLsn = this->redoLog->getCheckpointLsn();
+  lsn_t currentLsn = this->redoLog->getCurrentLsn();
+  return currentLsn > checkpointLsn ? currentLsn - checkpointLsn : 0;
+}
+
+uint64_t Checkpointer::getSyncFlushCount() const {
+  return this->syncFlushCount;
+}
+
+void *Checkpointer::run(void *arg) {
+  my_thread_init();
+  Checkpointer *checkpointer = static_cast<Checkpointer *>(arg);
+
+  mysql_mutex_lock(&checkpointer->mutex);
+  while (!checkpointer->shutdown) {
+    struct timespec abstime;
+    set_timespec(&abstime, 1);
+    mysql_cond_timedwait(&checkpointer->cond, &checkpointer->mutex, &abstime);
+    if (checkpointer->shutdown) {
+      break;
+    }
+    mysql_mutex_unlock(&checkpointer->mutex);
+    checkpointer->adaptiveFlush();
+    mysql_mutex_lock(&checkpointer->mutex);
+  }
+  mysql_mutex_unlock(&checkpointer->mutex);
+
+  my_thread_end();
+  return nullptr;
+}
+
+} // namespace redo
@@ -0,0 +1,576 @@
+#include "redo_log.h"
+
+#include <fcntl.h>
+#include <algorithm>
+#include <cstring>
+
+#include "file_util.h"
+#include "my_sys.h"
+#include "my_systime.h"
+#include "page.h"
+
+PSI_file_key redo_log_file_key;
+PSI_mutex_key redo_log_mutex_key;
+PSI_mutex_key redo_checkpoint_mutex_key;
+PSI_cond_key redo_log_write_cond_key;
+PSI_cond_key redo_log_flusher_cond_key;
+PSI_thread_key log_flusher_thread_key;
+
+namespace redo {
+
+namespace {
+
+// bytes read from the file at once while scanning the log
+constexpr const size_t READ_CHUNK_SIZE = 1024 * 1024;
+
+/**
+ * @param record the header of a record followed by payloadSize bytes
+ */
+uint32_t checksum(const uchar *record, uint32_t payloadSize) {
+  return my_checksum(0, record + sizeof(uint32_t),
+                     RECORD_HEADER_SIZE - sizeof(uint32_t) + payloadSize);
+}
+
+} // namespace
+
+LogReader::LogReader(file_handler::FileDescriptor fd, lsn_t startLsn)
+    : fd(fd), buffer(READ_CHUNK_SIZE), bufferLsn(startLsn), lsn(startLsn) {}
+
+/**
+ * Makes sure the size bytes from lsn are in the buffer.
+ * @return false if the file ends before them
+ */
+bool LogReader::fill(size_t size) {
+  size_t offset = this->lsn - this->bufferLsn;
+  if (offset + size <= this->bufferSize) {
+    return true;
+  }
+  // keeps the unread bytes and reads after them
+  memmove(this->buffer.data(), this->buffer.data() + offset,
+          this->bufferSize - offset);
+  this->bufferSize -= offset;
+  this->bufferLsn = this->lsn;
+  if (this->buffer.size() < size) {
+    this->buffer.resize(size);
+  }
+  size_t readSize = FileUtil::pread(
+      this->fd, this->buffer.data() + this->bufferSize,
+      this->buffer.size() - this->bufferSize,
+      this->bufferLsn + this->bufferSize);
+  if (readSize == MY_FILE_ERROR) {
+    return false;
+  }
+  this->bufferSize += readSize;
+  return this->bufferSize >= size;
+}
+
+/**
+ * Reads the record at the current LSN. The log ends at the first record
+ * that is cut short or does not match its checksum, that is, one that
+ * was being written when the server stopped.
+ * @return false at the end of the log
+ */
+bool LogReader::next(LogRecord &record) {
+  if (!fill(RECORD_HEADER_SIZE)) {
+    return false;
+  }
+  RecordHeader header;
+  memcpy(&header, this->buffer.data() + (this->lsn - this->bufferLsn),
+         RECORD_HEADER_SIZE);
+  // no record is larger than a page, a larger size is garbage
+  if (header.payloadSize > page::PAGE_SIZE ||
+      !fill(RECORD_HEADER_SIZE + header.payloadSize)) {
+    return false;
+  }
+  const uchar *start = this->buffer.data() + (this->lsn - this->bufferLsn);
+  if (checksum(start, header.payloadSize) != header.checksum) {
+    return false;
+  }
+  RecordType type = static_cast<RecordType>(header.type);
+  if (type != RecordType::FILE_NAME && type != RecordType::INSERT &&
+      type != RecordType::NEXT_PAGE) {
+    return false;
+  }
+  this->lsn += RECORD_HEADER_SIZE + header.payloadSize;
+  record = LogRecord{type,
+                     header.tablespaceId,
+                     header.pageId,
+                     start + RECORD_HEADER_SIZE,
+                     header.payloadSize,
+                     this->lsn};
+  return true;
+}
+
+RedoLog::RedoLog() {
+  mysql_mutex_init(redo_log_mutex_key, &this->mutex, MY_MUTEX_INIT_FAST);
+  mysql_mutex_init(redo_checkpoint_mutex_key, &this->checkpointMutex,
+                   MY_MUTEX_INIT_FAST);
+  mysql_cond_init(redo_log_write_cond_key, &this->writeCond);
+  mysql_cond_init(redo_log_flusher_cond_key, &this->flusherCond);
+}
+
+RedoLog::~RedoLog() {
+  close();
+  mysql_cond_destroy(&this->flusherCond);
+  mysql_cond_destroy(&this->writeCond);
+  mysql_mutex_destroy(&this->checkpointMutex);
+  mysql_mutex_destroy(&this->mutex);
+}
+
+/**
+ * Opens the log at path, creating it if it does not exist. The records
+ * of an existing log are kept from its checkpoint up to the first
+ * incomplete one, which is cut off so that new records follow the last
+ * complete one.
+ * @return false if the file cannot be used as a log
+ */
+bool RedoLog::open(const char *path, uint64_t bufferCapacity) {
+  this->bufferCapacity = std::max(bufferCapacity, MIN_LOG_BUFFER_SIZE);
+  this->buffer.reserve(this->bufferCapacity);
+
+  lsn_t lsn = LOG_START_LSN;
+  this->fd = FileUtil::open(redo_log_file_key, path, O_RDWR, MYF(0));
+  if (this->fd < 0) {
+    this->fd = FileUtil::create(redo_log_file_key, path, 0, O_RDWR, MYF(0));
+    if (this->fd < 0) {
+      return false;
+    }
+    LogFileHeader header{LOG_FILE_MAGIC, LOG_FORMAT, {0}};
+    if (FileUtil::pwrite(this->fd, reinterpret_cast<uchar *>(&header),
+                         LOG_HEADER_SIZE, 0) != LOG_HEADER_SIZE ||
+        FileUtil::sync(this->fd) != 0) {
+      close();
+      return false;
+    }
+  } else {
+    LogFileHeader header;
+    if (FileUtil::pread(this->fd, reinterpret_cast<uchar *>(&header),
+                        LOG_HEADER_SIZE, 0) != LOG_HEADER_SIZE ||
+        header.magic != LOG_FILE_MAGIC || header.format != LOG_FORMAT) {
+      close();
+      return false;
+    }
+    readCheckpoint();
+    LogReader reader(this->fd, this->checkpointLsn);
+    LogRecord record;
+    // the names after the checkpoint are every name the next one needs
+    bool onlyNames = true;
+    while (reader.next(record)) {
+      if (record.type != RecordType::FILE_NAME) {
+        onlyNames = false;
+      } else if (record.payloadSize > 0) {
+        this->namedTablespaces[record.tablespaceId] = std::string(
+            reinterpret_cast<const char *>(record.payload),
+            record.payloadSize - 1);
+      }
+    }
+    lsn = reader.getLsn();
+    if (onlyNames) {
+      this->namedLsn = lsn;
+    }
+    if (FileUtil::truncate(this->fd, lsn) != 0 ||
+        FileUtil::sync(this->fd) != 0) {
+      close();
+      return false;
+    }
+  }
+
+  mysql_mutex_lock(&this->mutex);
+  this->currentLsn = lsn;
+  this->writtenLsn = lsn;
+  this->flushedLsn = lsn;
+  mysql_mutex_unlock(&this->mutex);
+  return true;
+}
+
+/**
+ * Stops the flusher and syncs every record before closing the file.
+ */
+void RedoLog::close() {
+  stopFlusher();
+  if (this->fd < 0) {
+    return;
+  }
+  mysql_mutex_lock(&this->mutex);
+  write(this->currentLsn, true);
+  mysql_mutex_unlock(&this->mutex);
+  FileUtil::close(this->fd, MYF(0));
+  this->fd = -1;
+}
+
+/**
+ * Logs that tuple was appended to a page.
+ * @return the LSN to store in the page
+ */
+lsn_t RedoLog::appendInsert(tablespace_id tablespaceId, page_id pageId,
+                            const char *tablespacePath, const uchar *tuple,
+                            uint32_t tupleSize) {
+  return appendPageChange(RecordType::INSERT, tablespaceId, pageId,
+                          tablespacePath, tuple, tupleSize);
+}
+
+/**
+ * Logs that nextPageId was chained after a page, the last one of its
+ * tablespace. nextPageId is in the file already.
+ * @return the LSN to store in the page
+ */
+lsn_t RedoLog::appendNextPage(tablespace_id tablespaceId, page_id pageId,
+                              const char *tablespacePath,
+                              page_id nextPageId) {
+  return appendPageChange(RecordType::NEXT_PAGE, tablespaceId, pageId,
+                          tablespacePath,
+                          reinterpret_cast<const uchar *>(&nextPageId),
+                          sizeof(nextPageId));
+}
+
+/**
+ * The first record of a tablespace is preceded by its path, so that
+ * recovery can open it.
+ */
+lsn_t RedoLog::appendPageChange(RecordType type, tablespace_id tablespaceId,
+                                page_id pageId, const char *tablespacePath,
+                                const uchar *payload, uint32_t payloadSize) {
+  mysql_mutex_lock(&this->mutex);
+  if (this->namedTablespaces.emplace(tablespaceId, tablespacePath).second) {
+    append(RecordType::FILE_NAME, tablespaceId, 0,
+           reinterpret_cast<const uchar *>(tablespacePath),
+           strlen(tablespacePath) + 1);
+  }
+  append(type, tablespaceId, pageId, payload, payloadSize);
+  lsn_t lsn = this->currentLsn;
+  mysql_mutex_unlock(&this->mutex);
+  return lsn;
+}
+
+/**
+ * Adds a record to the buffer, writing the buffer out first when the
+ * record does not fit. Nothing is added once the log failed, the
+ * statement logging the record fails with it, see commit(). The caller
+ * holds the mutex.
+ */
+void RedoLog::append(RecordType type, tablespace_id tablespaceId,
+                     page_id pageId, const uchar *payload,
+                     uint32_t payloadSize) {
+  size_t recordSize = RECORD_HEADER_SIZE + payloadSize;
+  while (!this->failed && !this->buffer.empty() &&
+         this->buffer.size() + recordSize > this->bufferCapacity) {
+    write(this->currentLsn, false);
+  }
+  if (this->failed) {
+    return;
+  }
+  size_t start = this->buffer.size();
+  this->buffer.resize(start + recordSize);
+  uchar *record = this->buffer.data() + start;
+  RecordHeader header{0, payloadSize, static_cast<uint8_t>(type),
+                      tablespaceId, pageId};
+  memcpy(record, &header, RECORD_HEADER_SIZE);
+  memcpy(record + RECORD_HEADER_SIZE, payload, payloadSize);
+  header.checksum = checksum(record, payloadSize);
+  memcpy(record, &header.checksum, sizeof(header.checksum));
+  this->currentLsn += recordSize;
+}
+
+/**
+ * Returns once the records up to lsn are written, and synced if sync.
+ * The first thread to get here writes everything buffered so far while
+ * the others wait; the next one to find its records missing does the
+ * same for every record appended in the meantime. The caller holds the
+ * mutex, which is released during the write.
+ *
+ * A failed write or sync fails the log for good, writtenLsn and
+ * flushedLsn stay where they were. The records are not written again: a
+ * sync after a failed one may succeed although the pages the kernel
+ * failed to write back were dropped from its cache.
+ * @return false if the log failed
+ */
+bool RedoLog::write(lsn_t lsn, bool sync) {
+  while (this->writtenLsn < lsn || (sync && this->flushedLsn < lsn)) {
+    if (this->failed) {
+      return false;
+    }
+    if (this->writing) {
+      mysql_cond_wait(&this->writeCond, &this->mutex);
+      continue;
+    }
+    this->writing = true;
+    std::vector<uchar> records;
+    records.swap(this->buffer);
+    lsn_t startLsn = this->writtenLsn;
+    lsn_t endLsn = this->currentLsn;
+    mysql_mutex_unlock(&this->mutex);
+
+    bool written =
+        records.empty() || FileUtil::pwrite(this->fd, records.data(),
+                                            records.size(),
+                                            startLsn) == records.size();
+    if (written && sync) {
+      written = FileUtil::sync(this->fd) == 0;
+      this->syncCount++;
+    }
+
+    mysql_mutex_lock(&this->mutex);
+    if (!written) {
+      this->failed = true;
+      this->writing = false;
+      mysql_cond_broadcast(&this->writeCond);
+      return false;
+    }
+    this->writtenLsn = endLsn;
+    if (sync) {
+      this->flushedLsn = endLsn;
+    }
+    // hands the allocation back unless records were appended meanwhile
+    if (this->buffer.empty()) {
+      records.clear();
+      this->buffer.swap(records);
+    }
+    this->writing = false;
+    mysql_cond_broadcast(&this->writeCond);
+  }
+  return true;
+}
+
+bool RedoLog::writeUpTo(lsn_t lsn) {
+  mysql_mutex_lock(&this->mutex);
+  bool written = write(lsn, false);
+  mysql_mutex_unlock(&this->mutex);
+  return written;
+}
+
+/**
+ * Syncs the records up to lsn. Page writes call this with the LSN of the
+ * page first, so that no page reaches the disk before its records.
+ * @return false if the records could not be synced, the page must not be
+ * written then
+ */
+bool RedoLog::flushUpTo(lsn_t lsn) {
+  mysql_mutex_lock(&this->mutex);
+  bool flushed = write(lsn, true);
+  mysql_mutex_unlock(&this->mutex);
+  return flushed;
+}
+
+/**
+ * Called at the end of a statement that changed pages. Only the COMMIT
+ * level waits for the records, the others leave them to the flusher.
+ * @return false if the records of the statement could not be synced, or
+ * the log failed before
+ */
+bool RedoLog::commit() {
+  mysql_mutex_lock(&this->mutex);
+  bool flushed = this->durability != Durability::COMMIT
+                     ? !this->failed
+                     : write(this->currentLsn, true);
+  mysql_mutex_unlock(&this->mutex);
+  return flushed;
+}
+
+/**
+ * @return whether a write or sync of the log failed, every change logged
+ * from then on is refused
+ */
+bool RedoLog::hasFailed() {
+  mysql_mutex_lock(&this->mutex);
+  bool failed = this->failed;
+  mysql_mutex_unlock(&this->mutex);
+  return failed;
+}
+
+/**
+ * Picks the valid checkpoint slot with the highest number. A log without
+ * one is recovered from its first record.
+ */
+void RedoLog::readCheckpoint() {
+  this->checkpointLsn = LOG_START_LSN;
+  this->checkpointNumber = 0;
+  for (my_off_t offset : CHECKPOINT_SLOT_OFFSETS) {
+    CheckpointSlot slot;
+    if (FileUtil::pread(this->fd, reinterpret_cast<uchar *>(&slot),
+                        sizeof(slot), offset) != sizeof(slot) ||
+        my_checksum(0, reinterpret_cast<uchar *>(&slot) + sizeof(uint32_t),
+                    sizeof(slot) - sizeof(uint32_t)) != slot.checksum ||
+        slot.lsn < LOG_START_LSN) {
+      continue;
+    }
+    if (slot.number > this->checkpointNumber) {
+      this->checkpointNumber = slot.number;
+      this->checkpointLsn = slot.lsn;
+    }
+  }
+}
+
+/**
+ * Records that every page change logged before lsn is in the tablespace
+ * files, so that recovery starts at lsn, which must be the start of a
+ * record. The part of the file before it is given back to the file
+ * system.
+ * @return false if the checkpoint could not be written
+ */
+bool RedoLog::writeCheckpoint(lsn_t lsn) {
+  mysql_mutex_lock(&this->checkpointMutex);
+  mysql_mutex_lock(&this->mutex);
+  if (lsn <= this->checkpointLsn) {
+    mysql_mutex_unlock(&this->mutex);
+    mysql_mutex_unlock(&this->checkpointMutex);
+    return true;
+  }
+  // records after lsn may belong to tablespaces named before it. Naming
+  // them again, and syncing the names before the checkpoint, lets
+  // recovery find every path after the checkpoint. Nothing was logged
+  // after the names of the last checkpoint if the log ends with them.
+  if (this->currentLsn != this->namedLsn) {
+    for (const auto &named : this->namedTablespaces) {
+      append(RecordType::FILE_NAME, named.first, 0,
+             reinterpret_cast<const uchar *>(named.second.c_str()),
+             named.second.size() + 1);
+    }
+    this->namedLsn = this->currentLsn;
+  }
+  if (!write(this->currentLsn, true)) {
+    mysql_mutex_unlock(&this->mutex);
+    mysql_mutex_unlock(&this->checkpointMutex);
+    return false;
+  }
+  lsn_t previousLsn = this->checkpointLsn;
+  uint64_t number = this->checkpointNumber + 1;
+  mysql_mutex_unlock(&this->mutex);
+
+  CheckpointSlot slot{0, number, lsn};
+  slot.checksum =
+      my_checksum(0, reinterpret_cast<uchar *>(&slot) + sizeof(uint32_t),
+                  sizeof(slot) - sizeof(uint32_t));
+  bool written =
+      FileUtil::pwrite(this->fd, reinterpret_cast<uchar *>(&slot),
+                       sizeof(slot),
+                       CHECKPOINT_SLOT_OFFSETS[number % CHECKPOINT_SLOT_COUNT]) ==
+          sizeof(slot) &&
+      FileUtil::sync(this->fd) == 0;
+  if (!written) {
+    // the failed sync may have dropped records as well
+    mysql_mutex_lock(&this->mutex);
+    this->failed = true;
+    mysql_mutex_unlock(&this->mutex);
+  } else {
+    mysql_mutex_lock(&this->mutex);
+    this->checkpointLsn = lsn;
+    this->checkpointNumber = number;
+    mysql_mutex_unlock(&this->mutex);
+    // whole blocks only, the block of the checkpoint is still read
+    my_off_t begin = previousLsn / file_config::IO_BLOCK_SIZE *
+                     file_config::IO_BLOCK_SIZE;
+    my_off_t end =
+        lsn / file_config::IO_BLOCK_SIZE * file_config::IO_BLOCK_SIZE;
+    begin = std::max<my_off_t>(begin, LOG_HEADER_SIZE);
+    if (end > begin) {
+      FileUtil::punchHole(this->fd, begin, end - begin);
+    }
+  }
+  mysql_mutex_unlock(&this->checkpointMutex);
+  return written;
+}
+
+/**
+ * Stops naming a dropped tablespace at checkpoints.
+ */
+void RedoLog::discardTablespace(tablespace_id tablespaceId) {
+  mysql_mutex_lock(&this->mutex);
+  this->namedTablespaces.erase(tablespaceId);
+  mysql_mutex_unlock(&this->mutex);
+}
+
+void RedoLog::setDurability(Durability durability) {
+  this->durability = durability;
+}
+
+Durability RedoLog::getDurability() const {
+  return this->durability;
+}
+
+void RedoLog::startFlusher() {
+  mysql_mutex_lock(&this->mutex);
+  if (this->flusherRunning) {
+    mysql_mutex_unlock(&this->mutex);
+    return;
+  }
+  this->flusherShutdown = false;
+  this->flusherRunning = true;
+  mysql_mutex_unlock(&this->mutex);
+
+  my_thread_attr_t attr;
+  my_thread_attr_init(&attr);
+  my_thread_attr_setdetachstate(&attr, MY_THREAD_CREATE_JOINABLE);
+  mysql_thread_create(log_flusher_thread_key, &this->flusherThread, &attr,
+                      runFlusher, this);
+  my_thread_attr_destroy(&attr);
+}
+
+void RedoLog::stopFlusher() {
+  mysql_mutex_lock(&this->mutex);
+  if (!this->flusherRunning) {
+    mysql_mutex_unlock(&this->mutex);
+    return;
+  }
+  this->flusherShutdown = true;
+  mysql_cond_signal(&this->flusherCond);
+  mysql_mutex_unlock(&this->mutex);
+
+  my_thread_join(&this->flusherThread, nullptr);
+
+  mysql_mutex_lock(&this->mutex);
+  this->flusherRunning = false;
+  mysql_mutex_unlock(&this->mutex);
+}
+
+/**
+ * Once a second, syncs the records at the SECOND level and writes them
+ * to the OS at the NONE level, which then only syncs ahead of page
+ * writes.
+ */
+void *RedoLog::runFlusher(void *arg) {
+  my_thread_init();
+  RedoLog *log = static_cast<RedoLog *>(arg);
+
+  mysql_mutex_lock(&log->mutex);
+  while (!log->flusherShutdown) {
+    struct timespec abstime;
+    set_timespec(&abstime, 1);
+    mysql_cond_timedwait(&log->flusherCond, &log->mutex, &abstime);
+    if (log->flusherShutdown) {
+      break;
+    }
+    // a failure is kept, the statements from then on report it
+    log->write(log->currentLsn, log->durability != Durability::NONE);
+  }
+  mysql_mutex_unlock(&log->mutex);
+
+  my_thread_end();
+  return nullptr;
+}
+
+lsn_t RedoLog::getCurrentLsn() {
+  mysql_mutex_lock(&this->mutex);
+  lsn_t lsn = this->currentLsn;
+  mysql_mutex_unlock(&this->mutex);
+  return lsn;
+}
+
+lsn_t RedoLog::getFlushedLsn() {
+  mysql_mutex_lock(&this->mutex);
+  lsn_t lsn = this->flushedLsn;
+  mysql_mutex_unlock(&this->mutex);
+  return lsn;
+}
+
+lsn_t RedoLog::getCheckpointLsn() {
+  mysql_mutex_lock(&this->mutex);
+  lsn_t lsn = this->checkpointLsn;
+  mysql_mutex_unlock(&this->mutex);
+  return lsn;
+}
+
+uint64_t RedoLog::getSyncCount() const {
+  return this->syncCount;
+}
+
+} // namespace redo
@@ -0,0 +1,243 @@
+#include "redo_recovery.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "my_sys.h"
+#include "mysql/psi/mysql_thread.h"
+
+PSI_thread_key recovery_worker_thread_key;
+
+namespace redo {
+
+RedoRecovery::RedoRecovery(buf::BufPool &bufPool, uint64_t workerCount)
+    : bufPool(bufPool),
+      workers(std::clamp<uint64_t>(workerCount, 1, MAX_RECOVERY_THREADS)) {
+  for (Worker &worker : this->workers) {
+    worker.recovery = this;
+  }
+}
+
+/**
+ * Applies every complete record of the log open at fd from checkpointLsn.
+ * The paths are collected first: the records right after a checkpoint
+ * may come before the names logged with it. Recovery stops at the first
+ * batch a page of which could not be recovered.
+ * @return the end of the last record, LSN_MAX if a page of a tablespace
+ * still in its file could not be read or changed
+ */
+lsn_t RedoRecovery::recover(file_handler::FileDescriptor fd,
+                            lsn_t checkpointLsn) {
+  LogReader names(fd, checkpointLsn);
+  LogRecord record;
+  while (names.next(record)) {
+    if (record.type == RecordType::FILE_NAME) {
+      this->tablespacePaths[record.tablespaceId] =
+          std::string(reinterpret_cast<const char *>(record.payload),
+                      strnlen(reinterpret_cast<const char *>(record.payload),
+                              record.payloadSize));
+    }
+  }
+
+  LogReader reader(fd, checkpointLsn);
+  while (reader.next(record)) {
+    if (record.type == RecordType::FILE_NAME) {
+      continue;
+    }
+    size_t hash = buf::PageKeyHash()(
+        buf::PageKey{record.tablespaceId,
+                     record.pageId / buf::INSTANCE_PAGE_GROUP});
+    this->workers[hash % this->workers.size()].records.push_back(
+        PendingRecord{record.type, record.tablespaceId, record.pageId,
+                      record.lsn, this->payloads.size(), record.payloadSize});
+    this->payloads.insert(this->payloads.end(), record.payload,
+                          record.payload + record.payloadSize);
+    if (this->payloads.size() >= RECOVERY_BATCH_SIZE && !applyBatch()) {
+      return LSN_MAX;
+    }
+  }
+  if (!applyBatch()) {
+    return LSN_MAX;
+  }
+  return reader.getLsn();
+}
+
+/**
+ * Applies the records read so far, each worker on its own thread. The
+ * batch is applied completely before the next one is read, so records of
+ * a page in different batches stay in order.
+ * @return false if a worker failed to recover a page
+ */
+bool RedoRecovery::applyBatch() {
+  if (this->workers.size() == 1) {
+    applyRecords(this->workers[0]);
+  } else {
+    my_thread_attr_t attr;
+    my_thread_attr_init(&attr);
+    my_thread_attr_setdetachstate(&attr, MY_THREAD_CREATE_JOINABLE);
+    for (Worker &worker : this->workers) {
+      if (!worker.records.empty()) {
+        mysql_thread_create(recovery_worker_thread_key, &worker.thread, &attr,
+                            runWorker, &worker);
+      }
+    }
+    my_thread_attr_destroy(&attr);
+    for (Worker &worker : this->workers) {
+      if (!worker.records.empty()) {
+        my_thread_join(&worker.thread, nullptr);
+      }
+    }
+  }
+  bool applied = true;
+  for (Worker &worker : this->workers) {
+    this->appliedCount += worker.appliedCount;
+    this->skippedCount += worker.skippedCount;
+    applied = applied && !worker.failed;
+    worker.appliedCount = 0;
+    worker.skippedCount = 0;
+    worker.failed = false;
+    worker.records.clear();
+  }
+  this->payloads.clear();
+  return applied;
+}
+
+/**
+ * Applies the records of a worker page by page, in (tablespace_id,
+ * page_id) order. The pages of a group with records are read with one
+ * prefetch before their records are applied. Pages of tablespaces dropped
+ * since, or never written to their file, are skipped. A tablespace is
+ * dropped when its file is gone, or holds another tablespace created at
+ * the same path since; a file that is there but cannot be opened fails
+ * the worker, as does a page of the file that cannot be fixed.
+ */
+void RedoRecovery::applyRecords(Worker &worker) {
+  std::vector<PendingRecord> &records = worker.records;
+  // stable, the records of a page stay in LSN order
+  std::stable_sort(records.begin(), records.end(),
+                   [](const PendingRecord &a, const PendingRecord &b) {
+                     return buf::PageKey{a.tablespaceId, a.pageId} <
+                            buf::PageKey{b.tablespaceId, b.pageId};
+                   });
+  tablespace_id tablespaceId = 0;
+  const char *tablespacePath = nullptr;
+  uint64_t filePageCount = 0;
+  for (size_t i = 0; i < records.size();) {
+    if (i == 0 || records[i].tablespaceId != tablespaceId) {
+      tablespaceId = records[i].tablespaceId;
+      auto path = this->tablespacePaths.find(tablespaceId);
+      tablespacePath =
+          path == this->tablespacePaths.end() ? nullptr : path->second.c_str();
+      filePageCount = 0;
+      if (tablespacePath != nullptr) {
+        tablespace::TablespaceGuard tablespace =
+            this->bufPool.getTablespaceCache().get(tablespaceId,
+                                                   tablespacePath);
+        if (tablespace.isValid()) {
+          filePageCount =
+              page::PageHandler::countPages(tablespace.getFileDescriptor());
+        } else if (!isDropped(tablespaceId, tablespacePath)) {
+          worker.failed = true;
+          return;
+        }
+      }
+    }
+    // the records of one page group of the tablespace
+    page_id group = records[i].pageId / buf::INSTANCE_PAGE_GROUP;
+    size_t groupEnd = i;
+    while (groupEnd < records.size() &&
+           records[groupEnd].tablespaceId == tablespaceId &&
+           records[groupEnd].pageId / buf::INSTANCE_PAGE_GROUP == group) {
+      groupEnd++;
+    }
+    page_id firstPageId = records[i].pageId;
+    page_id endPageId =
+        std::min<uint64_t>(records[groupEnd - 1].pageId + 1, filePageCount);
+    if (firstPageId < endPageId) {
+      this->bufPool.prefetchPages(tablespaceId, firstPageId,
+                                  endPageId - firstPageId, tablespacePath,
+                                  false);
+    }
+    while (i < groupEnd) {
+      size_t pageEnd = i;
+      while (pageEnd < groupEnd && records[pageEnd].pageId == records[i].pageId) {
+        pageEnd++;
+      }
+      if (records[i].pageId < filePageCount) {
+        if (!applyPage(&records[i], &records[pageEnd], tablespacePath,
+                       worker)) {
+          worker.failed = true;
+          return;
+        }
+      } else {
+        worker.skippedCount += pageEnd - i;
+      }
+      i = pageEnd;
+    }
+  }
+}
+
+/**
+ * Tells whether the tablespace was dropped after its records were logged.
+ * @return true if its file is gone, or now holds another tablespace
+ */
+bool RedoRecovery::isDropped(tablespace_id tablespaceId,
+                             const char *tablespacePath) {
+  if (my_access(tablespacePath, F_OK) != 0) {
+    return true;
+  }
+  tablespace::TablespaceHandler handler(tablespacePath);
+  return handler.getTablespaceHeader().getId() != tablespaceId;
+}
+
+/**
+ * Applies the records [first, last) of one page, skipping those the page
+ * has.
+ * @return false if the page could not be fixed
+ */
+bool RedoRecovery::applyPage(const PendingRecord *first,
+                             const PendingRecord *last,
+                             const char *tablespacePath, Worker &worker) {
+  buf::PageGuard guard =
+      this->bufPool.fixPage(first->tablespaceId, first->pageId,
+                            tablespacePath, buf::LatchMode::EXCLUSIVE);
+  if (!guard.isValid()) {
+    return false;
+  }
+  page::PageHandler &pageHandler = guard.getPageHandler();
+  for (const PendingRecord *record = first; record != last; record++) {
+    if (pageHandler.getPageHeader().lsn >= record->lsn) {
+      worker.skippedCount++;
+      continue;
+    }
+    uchar *payload = this->payloads.data() + record->payloadOffset;
+    if (record->type == RecordType::INSERT) {
+      pageHandler.insert(tuple::Tuple(record->payloadSize, 0, payload));
+      pageHandler.getPage().incrementTupleCount();
+    } else if (record->type == RecordType::NEXT_PAGE &&
+               record->payloadSize == sizeof(page_id)) {
+      page_id nextPageId;
+      memcpy(&nextPageId, payload, sizeof(nextPageId));
+      pageHandler.getPage().setNextPageId(nextPageId);
+    } else {
+      worker.skippedCount++;
+      continue;
+    }
+    pageHandler.getPageHeader().lsn = record->lsn;
+    // the start of the record, checkpoints stay before it until the page
+    // is written. Only the first change of the page counts.
+    guard.markDirty(record->lsn - RECORD_HEADER_SIZE - record->payloadSize);
+    worker.appliedCount++;
+  }
+  return true;
+}
+
+void *RedoRecovery::runWorker(void *arg) {
+  my_thread_init();
+  Worker *worker = static_cast<Worker *>(arg);
+  worker->recovery->applyRecords(*worker);
+  my_thread_end();
+  return nullptr;
+}
+
+} // namespace redo
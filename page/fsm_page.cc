@@ -0,0 +1,86 @@
+#include "fsm_page.h"
+
+#include <algorithm>
+#include <cassert>
+
+namespace page {
+
+/**
+ * @return the category of a page with freeBytes between its slots and
+ * its tuples
+ */
+uint8_t toFsmCategory(uint32_t freeBytes) {
+  return std::min(freeBytes / FSM_CATEGORY_SIZE, FSM_CATEGORY_COUNT - 1);
+}
+
+/**
+ * @return the lowest category sure to have room for a tuple of tupleSize
+ * bytes and its slot, FSM_CATEGORY_COUNT or more if none is
+ */
+uint8_t toMinFsmCategory(uint32_t tupleSize) {
+  uint32_t size = tupleSize + SLOT_SIZE;
+  return std::min<uint32_t>((size + FSM_CATEGORY_SIZE - 1) / FSM_CATEGORY_SIZE,
+                            FSM_CATEGORY_COUNT);
+}
+
+// node n is 4 bits of byte n / 2, its children are nodes 2n + 1 and 2n + 2
+uint8_t FsmPage::getNode(uint64_t node) const {
+  uint8_t byte = this->body[node / 2];
+  return node % 2 == 0 ? byte & 0x0f : byte >> 4;
+}
+
+void FsmPage::setNode(uint64_t node, uint8_t category) {
+  uchar &byte = this->body[node / 2];
+  byte = node % 2 == 0 ? (byte & 0xf0) | category
+                       : (byte & 0x0f) | (category << 4);
+}
+
+uint8_t FsmPage::getCategory(page_id pageId) const {
+  return getNode(FSM_LEAF_COUNT - 1 + pageId % FSM_LEAF_COUNT);
+}
+
+/**
+ * Sets the category of pageId, one of the pages mapped by this page.
+ * @return false if it had that category already, the page is unchanged
+ */
+bool FsmPage::setCategory(page_id pageId, uint8_t category) {
+  assert(category < FSM_CATEGORY_COUNT);
+  uint64_t node = FSM_LEAF_COUNT - 1 + pageId % FSM_LEAF_COUNT;
+  if (getNode(node) == category) {
+    return false;
+  }
+  setNode(node, category);
+  while (node > 0) {
+    node = (node - 1) / 2;
+    uint8_t largest = std::max(getNode(2 * node + 1), getNode(2 * node + 2));
+    if (getNode(node) == largest) {
+      break;
+    }
+    setNode(node, largest);
+  }
+  return true;
+}
+
+/**
+ * @return the largest category of the pages mapped, 0 if every one is full
+ */
+uint8_t FsmPage::getLargestCategory() const {
+  return getNode(0);
+}
+
+/**
+ * @return a page mapped by the page fsmPageId with at least minCategory,
+ * the one with the lowest id, or MAX_PAGE_ID if none has
+ */
+page_id FsmPage::findPage(page_id fsmPageId, uint8_t minCategory) const {
+  if (minCategory >= FSM_CATEGORY_COUNT || getNode(0) < minCategory) {
+    return MAX_PAGE_ID;
+  }
+  uint64_t node = 0;
+  while (node < FSM_LEAF_COUNT - 1) {
+    node = getNode(2 * node + 1) >= minCategory ? 2 * node + 1 : 2 * node + 2;
+  }
+  return fsmPageId - FIRST_FSM_PAGE_ID + (node - (FSM_LEAF_COUNT - 1));
+}
+
+} // namespace page
@@ -3,38 +3,179 @@
 //
 #include "page.h"
 #include <iostream>
+#include <vector>
 #include "file_config.h"
 #include "file_util.h"
+#include "pax_page.h"
 
 namespace page {
 
-PageHandler PageHandler::reserveNewPage(page_id newPageId) {
-  return PageHandler(newPageId);
+template <int PageSize>
+BasicPageHandler<PageSize> BasicPageHandler<PageSize>::reserveNewPage(
+    page_id newPageId) {
+  return BasicPageHandler(newPageId);
 }
 
-void PageHandler::flush(file_handler::FileDescriptor fd) {
-  FileUtil::seek(fd, PAGE_START_POSITION + page.getPageId() * PAGE_SIZE,
-                 SEEK_SET, MYF(file_config::MYF_STRICT_MODE));
-  size_t writeSize = FileUtil::write(fd, page.toBinary(), PAGE_SIZE);
-  assert(writeSize == PAGE_SIZE);
+/**
+ * Reserves a page laid out like the pages of the tablespace of
+ * systemPage. A PAX page is formatted for its columns right away, so that
+ * recovery finds it laid out in the file.
+ */
+template <int PageSize>
+BasicPageHandler<PageSize> BasicPageHandler<PageSize>::reserveNewPage(
+    page_id newPageId, const tablespace::SystemPageHeaderImpl &systemPage) {
+  BasicPageHandler pageHandler(newPageId);
+  if (systemPage.getLayout() == tablespace::PageLayout::PAX) {
+    PaxPage paxPage(pageHandler.getPageBody());
+    uint32_t capacity =
+        paxPage.format(BasicPage<PageSize>::BODY_SIZE,
+                       systemPage.getColumnSizes(), systemPage.getColumnCount());
+    assert(capacity > 0);
+    page::Header &header = pageHandler.getPageHeader();
+    header.layout = static_cast<uint8_t>(tablespace::PageLayout::PAX);
+    // room for the rows left, as the free space map expects
+    header.freeEnd = capacity * paxPage.getRowSize();
+  }
+  return pageHandler;
 }
 
-void PageHandler::readFromFile(file_handler::FileDescriptor fd) {
-  FileUtil::seek(fd, PAGE_START_POSITION + page.getPageId() * PAGE_SIZE,
-                 SEEK_SET, MYF(file_config::MYF_STRICT_MODE));
-  size_t readSize = FileUtil::read(fd, page.toBinary(), PAGE_SIZE);
-  assert(readSize == PAGE_SIZE);
+/**
+ * @return false if the page was not written completely
+ */
+template <int PageSize>
+bool BasicPageHandler<PageSize>::flush(file_handler::FileDescriptor fd) {
+  size_t writeSize = FileUtil::pwrite(
+      fd, page.toBinary(), PageSize,
+      PAGE_START_POSITION + page.getPageId() * PageSize);
+  return writeSize == PageSize;
 }
 
-void PageHandler::insert(tuple::Tuple t) {
+namespace {
+
+std::vector<struct iovec> toIovec(uchar *const *frames, uint64_t pageCount,
+                                  size_t pageSize) {
+  std::vector<struct iovec> iov(pageCount);
+  for (uint64_t i = 0; i < pageCount; i++) {
+    iov[i].iov_base = frames[i];
+    iov[i].iov_len = pageSize;
+  }
+  return iov;
+}
+
+}
+
+/**
+ * @return false if the page was not read completely, because of an error
+ * or because it is past the end of the file
+ */
+template <int PageSize>
+bool BasicPageHandler<PageSize>::readFromFile(
+    file_handler::FileDescriptor fd) {
+  size_t readSize = FileUtil::pread(
+      fd, page.toBinary(), PageSize,
+      PAGE_START_POSITION + page.getPageId() * PageSize);
+  return readSize == PageSize;
+}
+
+/**
+ * Reads pageCount adjacent pages starting at firstPageId into their frames
+ * with a single vectored read.
+ * @return number of pages read completely, fewer at the end of the file
+ */
+template <int PageSize>
+uint64_t BasicPageHandler<PageSize>::readPages(
+    file_handler::FileDescriptor fd, page_id firstPageId,
+    uchar *const *frames, uint64_t pageCount) {
+  std::vector<struct iovec> iov = toIovec(frames, pageCount, PageSize);
+  size_t readSize = FileUtil::preadv(
+      fd, iov.data(), iov.size(),
+      PAGE_START_POSITION + firstPageId * PageSize);
+  if (readSize == MY_FILE_ERROR) {
+    return 0;
+  }
+  return readSize / PageSize;
+}
+
+/**
+ * Builds a write of the images of pageCount adjacent pages starting at
+ * firstPageId from their frames, in a single vectored write, for an aio
+ * engine.
+ */
+template <int PageSize>
+file_handler::IoRequest BasicPageHandler<PageSize>::flushRequest(
+    file_handler::FileDescriptor fd, page_id firstPageId,
+    uchar *const *frames, uint64_t pageCount,
+    file_handler::IoCallback callback) {
+  return file_handler::IoRequest{
+      file_handler::IoType::WRITE, fd,
+      PAGE_START_POSITION + firstPageId * PageSize,
+      toIovec(frames, pageCount, PageSize), std::move(callback)};
+}
+
+/**
+ * Builds the asynchronous counterpart of readPages() for an aio engine.
+ * The callback gets fewer bytes than requested at the end of the file.
+ */
+template <int PageSize>
+file_handler::IoRequest BasicPageHandler<PageSize>::readRequest(
+    file_handler::FileDescriptor fd, page_id firstPageId,
+    uchar *const *frames, uint64_t pageCount,
+    file_handler::IoCallback callback) {
+  return file_handler::IoRequest{
+      file_handler::IoType::READ, fd,
+      PAGE_START_POSITION + firstPageId * PageSize,
+      toIovec(frames, pageCount, PageSize), std::move(callback)};
+}
+
+/**
+ * @return number of pages stored in the tablespace file
+ */
+template <int PageSize>
+uint64_t BasicPageHandler<PageSize>::countPages(
+    file_handler::FileDescriptor fd) {
+  my_off_t fileSize = FileUtil::size(fd);
+  if (fileSize <= static_cast<my_off_t>(PAGE_START_POSITION)) {
+    return 0;
+  }
+  return (fileSize - PAGE_START_POSITION) / PageSize;
+}
+
+/**
+ * @return whether a tuple of tupleSize bytes and its slot fit between the
+ * slots and the tuples of the page
+ */
+template <int PageSize>
+bool BasicPageHandler<PageSize>::hasSpace(uint32_t tupleSize) {
+  page::Header &header = page.getHeader();
+  if (isPax()) {
+    PaxPage paxPage(getPageBody());
+    return tupleSize == paxPage.getRowSize() &&
+           header.tupleCount < paxPage.getCapacity();
+  }
+  return header.freeEnd >= header.freeBegin &&
+         header.freeEnd - header.freeBegin >=
+             static_cast<uint64_t>(tupleSize) + page::SLOT_SIZE;
+}
+
+/**
+ * Appends t to the page, which must have room for it, see hasSpace().
+ * A full page is followed by a new one, see BufPool::allocatePage().
+ */
+template <int PageSize>
+void BasicPageHandler<PageSize>::insert(tuple::Tuple t) {
   page::Header &header = page.getHeader();
   uint32_t tupleSize = t.getSize();
   uint8_t *tupleData = t.getData();
+  assert(hasSpace(tupleSize));
+  if (isPax()) {
+    PaxPage(getPageBody()).insert(header.tupleCount, tupleData);
+    header.freeEnd -= tupleSize;
+    return;
+  }
   page::Slot newSlot = Slot{
       header.freeEnd - tupleSize,
       tupleSize
   };
-  // TODO: page split
   memcpy((page.getPage().body + header.freeBegin),
          reinterpret_cast<uchar *>(&newSlot), page::SLOT_SIZE);
   memcpy((page.getPage().body + header.freeEnd - tupleSize),
@@ -43,15 +184,43 @@ void PageHandler::insert(tuple::Tuple t) {
   header.freeEnd -= tupleSize;
 }
 
-tuple::Tuple PageHandler::readTuple(uint64_t tupleCursor) {
+template <int PageSize>
+tuple::Tuple BasicPageHandler<PageSize>::readTuple(uint64_t tupleCursor) {
+  if (isPax()) {
+    PaxPage paxPage(getPageBody());
+    tuple::Tuple tuple(paxPage.getRowSize(), 0);
+    paxPage.readRow(tupleCursor, tuple.getData());
+    return tuple;
+  }
+  tuple::TupleView view = viewTuple(tupleCursor);
+  return tuple::Tuple(view.getSize(), 0, view.getData());
+}
+
+/**
+ * @return the tuple in place in the page, without copying it. A PAX page
+ * has no tuple in one piece, see PaxPage.
+ */
+template <int PageSize>
+tuple::TupleView BasicPageHandler<PageSize>::viewTuple(
+    uint64_t tupleCursor) {
+  assert(!isPax());
   page::Slot targetSlot = page.getSlot(tupleCursor);
-  uchar *tupleBody = page.readTupleBySlot(targetSlot);
-  return tuple::Tuple(targetSlot.size, 0, tupleBody);
+  return tuple::TupleView(page.readTupleBySlot(targetSlot), targetSlot.size);
 }
 
-bool PageHandler::isLastTuple(uint64_t tupleCursor) {
+template <int PageSize>
+bool BasicPageHandler<PageSize>::isLastTuple(uint64_t tupleCursor) {
   page::Header &header = page.getHeader();
+  if (isPax()) {
+    return header.tupleCount == tupleCursor;
+  }
   return header.freeBegin == tupleCursor * SLOT_SIZE;
 }
 
+template class BasicPageHandler<4096>;
+template class BasicPageHandler<8192>;
+template class BasicPageHandler<16384>;
+template class BasicPageHandler<32768>;
+template class BasicPageHandler<65536>;
+
 } // namespace page
@@ -0,0 +1,95 @@
+#include "pax_page.h"
+
+#include <cassert>
+#include <cstring>
+
+namespace page {
+
+namespace {
+
+uint64_t roundUp(uint64_t size, uint64_t unit) {
+  return (size + unit - 1) / unit * unit;
+}
+
+uint64_t getDirectorySize(uint32_t columnCount) {
+  return sizeof(PaxDirectory) + columnCount * sizeof(PaxMinipage);
+}
+
+}
+
+/**
+ * @return the rows a body of bodySize bytes has room for once the
+ * directory and the padding of every minipage are taken, 0 if not one
+ */
+uint32_t PaxPage::computeCapacity(uint32_t bodySize,
+                                  const uint32_t *columnSizes,
+                                  uint32_t columnCount) {
+  uint64_t rowSize = 0;
+  for (uint32_t column = 0; column < columnCount; column++) {
+    rowSize += columnSizes[column];
+  }
+  // at most an alignment less one of padding before every minipage
+  uint64_t overhead =
+      roundUp(getDirectorySize(columnCount), PAX_MINIPAGE_ALIGNMENT) +
+      columnCount * (PAX_MINIPAGE_ALIGNMENT - 1);
+  if (rowSize == 0 || overhead >= bodySize) {
+    return 0;
+  }
+  return (bodySize - overhead) / rowSize;
+}
+
+/**
+ * Lays out an empty page for rows of the given columns.
+ * @return the rows the page has room for, 0 if the columns do not fit in
+ * which case the body is left as it was
+ */
+uint32_t PaxPage::format(uint32_t bodySize, const uint32_t *columnSizes,
+                         uint32_t columnCount) {
+  uint32_t capacity = computeCapacity(bodySize, columnSizes, columnCount);
+  if (capacity == 0) {
+    return 0;
+  }
+  PaxDirectory &directory = *reinterpret_cast<PaxDirectory *>(this->body);
+  directory = PaxDirectory{columnCount, capacity, 0, 0};
+  PaxMinipage *minipages =
+      reinterpret_cast<PaxMinipage *>(this->body + sizeof(PaxDirectory));
+  uint64_t valueOffset = getDirectorySize(columnCount);
+  for (uint32_t column = 0; column < columnCount; column++) {
+    valueOffset = roundUp(valueOffset, PAX_MINIPAGE_ALIGNMENT);
+    minipages[column] =
+        PaxMinipage{static_cast<offset>(valueOffset), columnSizes[column]};
+    valueOffset += static_cast<uint64_t>(capacity) * columnSizes[column];
+    directory.rowSize += columnSizes[column];
+  }
+  assert(valueOffset <= bodySize);
+  return capacity;
+}
+
+/**
+ * Splits tuple, the values of a row one after the other, between the
+ * minipages at row.
+ */
+void PaxPage::insert(uint64_t row, const uchar *tuple) {
+  assert(row < getCapacity());
+  for (uint32_t column = 0; column < getColumnCount(); column++) {
+    const PaxMinipage &minipage = getMinipage(column);
+    memcpy(this->body + minipage.valueOffset + row * minipage.valueSize,
+           tuple, minipage.valueSize);
+    tuple += minipage.valueSize;
+  }
+}
+
+/**
+ * Copies the values of row one after the other into tuple.
+ * @return the size of the row
+ */
+uint32_t PaxPage::readRow(uint64_t row, uchar *tuple) const {
+  for (uint32_t column = 0; column < getColumnCount(); column++) {
+    uint32_t valueSize = getColumnSize(column);
+    memcpy(tuple, getValue(row, column), valueSize);
+    tuple += valueSize;
+  }
+  return getRowSize();
+}
+
+} // namespace page
@@ -0,0 +1,285 @@
+#include "compare_kernel.h"
+
+#include <algorithm>
+#include <cassert>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define TOYBOX_X86_KERNELS
+#endif
+
+namespace predicate {
+
+namespace {
+
+// rows of a selection word
+constexpr const uint64_t WORD_ROWS = 64;
+
+// NE, LE and GE are compared as EQ, GT and LT and the result negated
+CompareOp toBaseOp(CompareOp op) {
+  switch (op) {
+    case CompareOp::NE:
+      return CompareOp::EQ;
+    case CompareOp::LE:
+      return CompareOp::GT;
+    case CompareOp::GE:
+      return CompareOp::LT;
+    default:
+      return op;
+  }
+}
+
+uint64_t getNegateMask(CompareOp op) {
+  return op == CompareOp::NE || op == CompareOp::LE || op == CompareOp::GE
+             ? ~0ULL
+             : 0;
+}
+
+template <typename T>
+bool compareValue(T value, CompareOp op, T constant) {
+  switch (op) {
+    case CompareOp::EQ:
+      return value == constant;
+    case CompareOp::NE:
+      return value != constant;
+    case CompareOp::LT:
+      return value < constant;
+    case CompareOp::LE:
+      return value <= constant;
+    case CompareOp::GT:
+      return value > constant;
+    case CompareOp::GE:
+      return value >= constant;
+  }
+  return false;
+}
+
+template <typename T>
+void compareScalar(const T *values, uint64_t count, CompareOp op, T constant,
+                   uint64_t *selection) {
+  for (uint64_t first = 0; first < count; first += WORD_ROWS) {
+    uint64_t rows = std::min(count - first, WORD_ROWS);
+    uint64_t mask = 0;
+    for (uint64_t row = 0; row < rows; row++) {
+      mask |= static_cast<uint64_t>(
+                  compareValue(values[first + row], op, constant))
+              << row;
+    }
+    // the rows past count keep their bits
+    if (rows < WORD_ROWS) {
+      mask |= ~0ULL << rows;
+    }
+    selection[first / WORD_ROWS] &= mask;
+  }
+}
+
+#ifdef TOYBOX_X86_KERNELS
+
+// the lanes of a vector compared at once, a bit per lane. Only EQ, GT and
+// LT are asked for, see toBaseOp().
+__attribute__((target("sse4.2")))
+int compareLanesSse42(const int32_t *values, __m128i constant, CompareOp op) {
+  __m128i vector = _mm_loadu_si128(reinterpret_cast<const __m128i *>(values));
+  __m128i result = op == CompareOp::EQ   ? _mm_cmpeq_epi32(vector, constant)
+                   : op == CompareOp::GT ? _mm_cmpgt_epi32(vector, constant)
+                                         : _mm_cmpgt_epi32(constant, vector);
+  return _mm_movemask_ps(_mm_castsi128_ps(result));
+}
+
+__attribute__((target("sse4.2")))
+int compareLanesSse42(const int64_t *values, __m128i constant, CompareOp op) {
+  __m128i vector = _mm_loadu_si128(reinterpret_cast<const __m128i *>(values));
+  __m128i result = op == CompareOp::EQ   ? _mm_cmpeq_epi64(vector, constant)
+                   : op == CompareOp::GT ? _mm_cmpgt_epi64(vector, constant)
+                                         : _mm_cmpgt_epi64(constant, vector);
+  return _mm_movemask_pd(_mm_castsi128_pd(result));
+}
+
+__attribute__((target("sse4.2")))
+int compareLanesSse42(const double *values, __m128d constant, CompareOp op) {
+  __m128d vector = _mm_loadu_pd(values);
+  __m128d result = op == CompareOp::EQ   ? _mm_cmpeq_pd(vector, constant)
+                   : op == CompareOp::GT ? _mm_cmpgt_pd(vector, constant)
+                                         : _mm_cmplt_pd(vector, constant);
+  return _mm_movemask_pd(result);
+}
+
+__attribute__((target("avx2")))
+int compareLanesAvx2(const int32_t *values, __m256i constant, CompareOp op) {
+  __m256i vector =
+      _mm256_loadu_si256(reinterpret_cast<const __m256i *>(values));
+  __m256i result = op == CompareOp::EQ ? _mm256_cmpeq_epi32(vector, constant)
+                   : op == CompareOp::GT
+                       ? _mm256_cmpgt_epi32(vector, constant)
+                       : _mm256_cmpgt_epi32(constant, vector);
+  return _mm256_movemask_ps(_mm256_castsi256_ps(result));
+}
+
+__attribute__((target("avx2")))
+int compareLanesAvx2(const int64_t *values, __m256i constant, CompareOp op) {
+  __m256i vector =
+      _mm256_loadu_si256(reinterpret_cast<const __m256i *>(values));
+  __m256i result = op == CompareOp::EQ ? _mm256_cmpeq_epi64(vector, constant)
+                   : op == CompareOp::GT
+                       ? _mm256_cmpgt_epi64(vector, constant)
+                       : _mm256_cmpgt_epi64(constant, vector);
+  return _mm256_movemask_pd(_mm256_castsi256_pd(result));
+}
+
+__attribute__((target("avx2")))
+int compareLanesAvx2(const double *values, __m256d constant, CompareOp op) {
+  __m256d vector = _mm256_loadu_pd(values);
+  __m256d result = op == CompareOp::EQ
+                       ? _mm256_cmp_pd(vector, constant, _CMP_EQ_OQ)
+                   : op == CompareOp::GT
+                       ? _mm256_cmp_pd(vector, constant, _CMP_GT_OQ)
+                       : _mm256_cmp_pd(vector, constant, _CMP_LT_OQ);
+  return _mm256_movemask_pd(result);
+}
+
+// Compares the whole words of values a vector at a time, the rows left
+// over as compareScalar() does.
+template <typename T, typename Vector, int Lanes>
+__attribute__((target("sse4.2")))
+void compareWordsSse42(const T *values, uint64_t count, CompareOp op,
+                       T constant, Vector constantVector,
+                       uint64_t *selection) {
+  CompareOp baseOp = toBaseOp(op);
+  uint64_t negateMask = getNegateMask(op);
+  uint64_t wordCount = count / WORD_ROWS;
+  for (uint64_t word = 0; word < wordCount; word++) {
+    const T *wordValues = values + word * WORD_ROWS;
+    uint64_t mask = 0;
+    for (uint64_t lane = 0; lane < WORD_ROWS; lane += Lanes) {
+      mask |= static_cast<uint64_t>(compareLanesSse42(
+                  wordValues + lane, constantVector, baseOp))
+              << lane;
+    }
+    selection[word] &= mask ^ negateMask;
+  }
+  compareScalar(values + wordCount * WORD_ROWS, count % WORD_ROWS, op,
+                constant, selection + wordCount);
+}
+
+template <typename T, typename Vector, int Lanes>
+__attribute__((target("avx2")))
+void compareWordsAvx2(const T *values, uint64_t count, CompareOp op,
+                      T constant, Vector constantVector, uint64_t *selection) {
+  CompareOp baseOp = toBaseOp(op);
+  uint64_t negateMask = getNegateMask(op);
+  uint64_t wordCount = count / WORD_ROWS;
+  for (uint64_t word = 0; word < wordCount; word++) {
+    const T *wordValues = values + word * WORD_ROWS;
+    uint64_t mask = 0;
+    for (uint64_t lane = 0; lane < WORD_ROWS; lane += Lanes) {
+      mask |= static_cast<uint64_t>(compareLanesAvx2(
+                  wordValues + lane, constantVector, baseOp))
+              << lane;
+    }
+    selection[word] &= mask ^ negateMask;
+  }
+  compareScalar(values + wordCount * WORD_ROWS, count % WORD_ROWS, op,
+                constant, selection + wordCount);
+}
+
+__attribute__((target("sse4.2")))
+void compareInt32Sse42(const int32_t *values, uint64_t count, CompareOp op,
+                       int32_t constant, uint64_t *selection) {
+  compareWordsSse42<int32_t, __m128i, 4>(
+      values, count, op, constant, _mm_set1_epi32(constant), selection);
+}
+
+__attribute__((target("sse4.2")))
+void compareInt64Sse42(const int64_t *values, uint64_t count, CompareOp op,
+                       int64_t constant, uint64_t *selection) {
+  compareWordsSse42<int64_t, __m128i, 2>(
+      values, count, op, constant, _mm_set1_epi64x(constant), selection);
+}
+
+__attribute__((target("sse4.2")))
+void compareDoubleSse42(const double *values, uint64_t count, CompareOp op,
+                        double constant, uint64_t *selection) {
+  compareWordsSse42<double, __m128d, 2>(values, count, op, constant,
+                                        _mm_set1_pd(constant), selection);
+}
+
+__attribute__((target("avx2")))
+void compareInt32Avx2(const int32_t *values, uint64_t count, CompareOp op,
+                      int32_t constant, uint64_t *selection) {
+  compareWordsAvx2<int32_t, __m256i, 8>(
+      values, count, op, constant, _mm256_set1_epi32(constant), selection);
+}
+
+__attribute__((target("avx2")))
+void compareInt64Avx2(const int64_t *values, uint64_t count, CompareOp op,
+                      int64_t constant, uint64_t *selection) {
+  compareWordsAvx2<int64_t, __m256i, 4>(
+      values, count, op, constant, _mm256_set1_epi64x(constant), selection);
+}
+
+__attribute__((target("avx2")))
+void compareDoubleAvx2(const double *values, uint64_t count, CompareOp op,
+                       double constant, uint64_t *selection) {
+  compareWordsAvx2<double, __m256d, 4>(values, count, op, constant,
+                                       _mm256_set1_pd(constant), selection);
+}
+
+const CompareKernels SSE42_KERNELS{KernelIsa::SSE42, compareInt32Sse42,
+                                   compareInt64Sse42, compareDoubleSse42};
+const CompareKernels AVX2_KERNELS{KernelIsa::AVX2, compareInt32Avx2,
+                                  compareInt64Avx2, compareDoubleAvx2};
+
+#endif  // TOYBOX_X86_KERNELS
+
+const CompareKernels SCALAR_KERNELS{KernelIsa::SCALAR, compareScalar<int32_t>,
+                                    compareScalar<int64_t>,
+                                    compareScalar<double>};
+
+}
+
+/**
+ * @return whether the CPU runs the kernels built for isa, asked with CPUID
+ */
+bool isKernelIsaSupported(KernelIsa isa) {
+  switch (isa) {
+    case KernelIsa::SCALAR:
+      return true;
+#ifdef TOYBOX_X86_KERNELS
+    case KernelIsa::SSE42:
+      return __builtin_cpu_supports("sse4.2");
+    case KernelIsa::AVX2:
+      return __builtin_cpu_supports("avx2");
+#endif
+    default:
+      return false;
+  }
+}
+
+const CompareKernels &getCompareKernels(KernelIsa isa) {
+  assert(isKernelIsaSupported(isa));
+#ifdef TOYBOX_X86_KERNELS
+  switch (isa) {
+    case KernelIsa::SSE42:
+      return SSE42_KERNELS;
+    case KernelIsa::AVX2:
+      return AVX2_KERNELS;
+    default:
+      break;
+  }
+#endif
+  return SCALAR_KERNELS;
+}
+
+/**
+ * @return the kernels of the widest instruction set the CPU supports,
+ * the scalar ones if it supports none
+ */
+const CompareKernels &getCompareKernels() {
+  static const CompareKernels &kernels = getCompareKernels(
+      isKernelIsaSupported(KernelIsa::AVX2)    ? KernelIsa::AVX2
+      : isKernelIsaSupported(KernelIsa::SSE42) ? KernelIsa::SSE42
+                                               : KernelIsa::SCALAR);
+  return kernels;
+}
+
+} // namespace predicate
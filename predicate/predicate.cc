@@ -0,0 +1,191 @@
+#include "predicate.h"
+
+#include <cassert>
+#include <cstring>
+#include <limits>
+#include "pax_page.h"
+
+namespace predicate {
+
+uint32_t getValueSize(ValueType type) {
+  switch (type) {
+    case ValueType::INT8:
+    case ValueType::UINT8:
+      return 1;
+    case ValueType::INT16:
+    case ValueType::UINT16:
+      return 2;
+    case ValueType::INT24:
+    case ValueType::UINT24:
+    case ValueType::DATE:
+      return 3;
+    case ValueType::INT32:
+    case ValueType::UINT32:
+    case ValueType::FLOAT:
+      return 4;
+    case ValueType::INT64:
+    case ValueType::DOUBLE:
+      return 8;
+  }
+  return 0;
+}
+
+bool isRealValueType(ValueType type) {
+  return type == ValueType::FLOAT || type == ValueType::DOUBLE;
+}
+
+namespace {
+
+int64_t readInt(const uchar *value, ValueType type) {
+  switch (type) {
+    case ValueType::INT8:
+      return static_cast<int8_t>(value[0]);
+    case ValueType::INT16: {
+      int16_t int16;
+      memcpy(&int16, value, sizeof(int16));
+      return int16;
+    }
+    case ValueType::INT24: {
+      int32_t int24 = value[0] | value[1] << 8 | value[2] << 16;
+      return int24 & 0x800000 ? int24 - 0x1000000 : int24;
+    }
+    case ValueType::INT32: {
+      int32_t int32;
+      memcpy(&int32, value, sizeof(int32));
+      return int32;
+    }
+    case ValueType::INT64: {
+      int64_t int64;
+      memcpy(&int64, value, sizeof(int64));
+      return int64;
+    }
+    case ValueType::UINT8:
+      return value[0];
+    case ValueType::UINT16: {
+      uint16_t uint16;
+      memcpy(&uint16, value, sizeof(uint16));
+      return uint16;
+    }
+    case ValueType::UINT24:
+    case ValueType::DATE:
+      return value[0] | value[1] << 8 | value[2] << 16;
+    case ValueType::UINT32: {
+      uint32_t uint32;
+      memcpy(&uint32, value, sizeof(uint32));
+      return uint32;
+    }
+    default:
+      assert(false);
+      return 0;
+  }
+}
+
+double readReal(const uchar *value, ValueType type) {
+  if (type == ValueType::FLOAT) {
+    float real;
+    memcpy(&real, value, sizeof(real));
+    return real;
+  }
+  double real;
+  memcpy(&real, value, sizeof(real));
+  return real;
+}
+
+const uchar *getValue(page::PageHandler &pageHandler,
+                      const Predicate &predicate, uint64_t row) {
+  if (pageHandler.isPax()) {
+    return page::PaxPage(pageHandler.getPageBody())
+        .getValue(row, predicate.column);
+  }
+  return pageHandler.viewTuple(row).getData() + predicate.valueOffset;
+}
+
+/**
+ * @return the values of the column of predicate in the first rowCount
+ * rows, in place if they are stored as T one after the other, or else
+ * copied into values as T
+ */
+template <typename T>
+const T *collectValues(page::PageHandler &pageHandler,
+                       const Predicate &predicate, uint64_t rowCount,
+                       bool isStoredAsT, std::vector<T> &values) {
+  if (isStoredAsT && pageHandler.isPax()) {
+    return reinterpret_cast<const T *>(getValue(pageHandler, predicate, 0));
+  }
+  values.resize(rowCount);
+  for (uint64_t row = 0; row < rowCount; row++) {
+    const uchar *value = getValue(pageHandler, predicate, row);
+    values[row] = isRealValueType(predicate.type)
+                      ? static_cast<T>(readReal(value, predicate.type))
+                      : static_cast<T>(readInt(value, predicate.type));
+  }
+  return values.data();
+}
+
+}
+
+/**
+ * Selects the rows of the page, those in it now, meeting every predicate.
+ * The page is pinned and latched.
+ */
+void PageFilter::evaluate(page::PageHandler &pageHandler) {
+  this->rowCount = pageHandler.getPageHeader().tupleCount;
+  this->selection.assign((this->rowCount + 63) / 64, ~0ULL);
+  if (this->rowCount % 64 != 0) {
+    this->selection.back() = ~0ULL >> (64 - this->rowCount % 64);
+  }
+  for (const Predicate &predicate : this->predicates) {
+    evaluate(pageHandler, predicate);
+  }
+}
+
+void PageFilter::evaluate(page::PageHandler &pageHandler,
+                          const Predicate &predicate) {
+  if (this->rowCount == 0) {
+    return;
+  }
+  if (isRealValueType(predicate.type)) {
+    // a FLOAT is compared as the double the server reads it as
+    const double *values =
+        collectValues(pageHandler, predicate, this->rowCount,
+                      predicate.type == ValueType::DOUBLE, this->doubleValues);
+    this->kernels.compareDouble(values, this->rowCount, predicate.op,
+                                predicate.realValue, this->selection.data());
+  } else if (predicate.type == ValueType::INT32 &&
+             predicate.intValue >= std::numeric_limits<int32_t>::min() &&
+             predicate.intValue <= std::numeric_limits<int32_t>::max()) {
+    const int32_t *values = collectValues(pageHandler, predicate,
+                                          this->rowCount, true,
+                                          this->int32Values);
+    this->kernels.compareInt32(values, this->rowCount, predicate.op,
+                               static_cast<int32_t>(predicate.intValue),
+                               this->selection.data());
+  } else {
+    const int64_t *values =
+        collectValues(pageHandler, predicate, this->rowCount,
+                      predicate.type == ValueType::INT64, this->int64Values);
+    this->kernels.compareInt64(values, this->rowCount, predicate.op,
+                               predicate.intValue, this->selection.data());
+  }
+}
+
+/**
+ * @return the first selected row from row on, getRowCount() if there is
+ * none
+ */
+uint64_t PageFilter::nextSelectedRow(uint64_t row) const {
+  if (row >= this->rowCount) {
+    return row;
+  }
+  uint64_t word = row / 64;
+  uint64_t bits = this->selection[word] & (~0ULL << (row % 64));
+  while (bits == 0) {
+    if (++word == this->selection.size()) {
+      return this->rowCount;
+    }
+    bits = this->selection[word];
+  }
+  return word * 64 + __builtin_ctzll(bits);
+}
+
+} // namespace predicate
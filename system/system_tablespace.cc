@@ -4,6 +4,8 @@
 #include "system_tablespace.h"
 #include <cassert>
 
+#include "file_util.h"
+
 PSI_file_key system_tablespace_key;
 
 namespace system_table {
@@ -23,14 +25,19 @@ uchar *SystemTablespaceImpl::toBinary() {
 SystemTablespaceHandler::SystemTablespaceHandler()
     : systemTablespace(SystemTablespaceImpl()) {
   file = file_handler::File(SYSTEM_TABLESPACE_PATH, MYF_STRICT_MODE, system_tablespace_key);
-  size_t readSize = file.read(systemTablespace.toBinary(), SYSTEM_TABLESPACE_SIZE);
-  assert(readSize == SYSTEM_TABLESPACE_SIZE);
+  // files written before the block padding are shorter
+  size_t readSize = file.read(systemTablespace.toBinary(),
+                              SYSTEM_TABLESPACE_BLOCK_SIZE);
+  assert(readSize != MY_FILE_ERROR && readSize >= SYSTEM_TABLESPACE_SIZE);
 }
 
 tablespace_id SystemTablespaceHandler::getNewMaxTablespaceId() {
   systemTablespace.incrementMaxTablespaceId();
-  size_t writeSize = file.write(systemTablespace.toBinary(), SYSTEM_TABLESPACE_SIZE);
-  assert(writeSize == SYSTEM_TABLESPACE_SIZE);
+  size_t writeSize = file.write(systemTablespace.toBinary(),
+                               SYSTEM_TABLESPACE_BLOCK_SIZE);
+  assert(writeSize == SYSTEM_TABLESPACE_BLOCK_SIZE);
+  // ids must never be reused after a crash, the redo log refers to them
+  FileUtil::sync(file.getFileDescriptor());
   return systemTablespace.getMaxTablespaceId();
 }
 
@@ -41,7 +48,8 @@ void SystemTablespaceHandler::create() {
         SYSTEM_TABLESPACE_PATH, system_tablespace_key
     );
     SystemTablespaceImpl tablespace(0);
-    fil.write(tablespace.toBinary(), SYSTEM_TABLESPACE_SIZE);
+    fil.write(tablespace.toBinary(), SYSTEM_TABLESPACE_BLOCK_SIZE);
+    FileUtil::sync(fil.getFileDescriptor());
   }
 }
 } // namespace system_table
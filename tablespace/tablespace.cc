@@ -2,25 +2,37 @@
 // Created by lrf141 on 9/16/23.
 //
 #include "tablespace.h"
+#include <cstddef>
 #include "file_config.h"
 #include "file_util.h"
+#include "page.h"
 
 PSI_file_key tablespace_key;
 
 namespace tablespace {
 
 void TablespaceHeaderImpl::read(file_handler::FileDescriptor fd) {
-  FileUtil::seek(fd, TABLE_SPACE_START_POSITION, SEEK_SET, MYF(file_config::MYF_STRICT_MODE));
-  size_t readSize = FileUtil::read(fd, toBinary(), TABLE_SPACE_HEADER_SIZE);
-  assert(readSize == TABLE_SPACE_HEADER_SIZE);
+  size_t readSize = FileUtil::pread(fd, toBinary(),
+                                    TABLE_SPACE_HEADER_BLOCK_SIZE,
+                                    TABLE_SPACE_HEADER_START_POSITION);
+  assert(readSize == TABLE_SPACE_HEADER_BLOCK_SIZE);
 }
 
 void TablespaceHeaderImpl::incrementPageCount() {
-  tablespaceHeader.pageCount++;
+  tablespaceHeader.header.pageCount++;
+}
+
+void TablespaceHeaderImpl::setPageCount(uint64_t pageCount) {
+  tablespaceHeader.header.pageCount = pageCount;
 }
 
 uint64_t TablespaceHeaderImpl::getPageCount() {
-  return tablespaceHeader.pageCount;
+  return tablespaceHeader.header.pageCount;
+}
+
+uint64_t TablespaceHeaderImpl::getPageSize() {
+  uint64_t pageSize = tablespaceHeader.header.pageSize;
+  return pageSize == 0 ? LEGACY_PAGE_SIZE : pageSize;
 }
 
 uchar *TablespaceHeaderImpl::toBinary() {
@@ -28,15 +40,47 @@ uchar *TablespaceHeaderImpl::toBinary() {
 }
 
 tablespace_id TablespaceHeaderImpl::getId() {
-  return tablespaceHeader.id;
+  return tablespaceHeader.header.id;
 }
 
 void SystemPageHeaderImpl::read(file_handler::FileDescriptor fd) {
-  FileUtil::seek(fd, SYSTEM_PAGE_HEADER_START_POSITION, SEEK_SET, MYF(file_config::MYF_STRICT_MODE));
-  size_t readSize = FileUtil::read(fd, toBinary(), SYSTEM_PAGE_SIZE);
+  size_t readSize = FileUtil::pread(fd, toBinary(), SYSTEM_PAGE_SIZE,
+                                    SYSTEM_PAGE_HEADER_START_POSITION);
   assert(readSize == SYSTEM_PAGE_SIZE);
 }
 
+/**
+ * Records the layout of the pages and the columns of their rows.
+ * @return false if there are more columns than the page has room for
+ */
+bool SystemPageHeaderImpl::setLayout(PageLayout layout,
+                                     const uint32_t *columnSizes,
+                                     uint64_t columnCount) {
+  if (columnCount > MAX_COLUMN_COUNT) {
+    return false;
+  }
+  systemPageHeader.layout = static_cast<uint64_t>(layout);
+  systemPageHeader.columnCount = columnCount;
+  memcpy(systemPageHeader.columnSizes, columnSizes,
+         columnCount * sizeof(uint32_t));
+  return true;
+}
+
+PageLayout SystemPageHeaderImpl::getLayout() const {
+  return static_cast<PageLayout>(systemPageHeader.layout);
+}
+
+uint64_t SystemPageHeaderImpl::getColumnCount() const {
+  return systemPageHeader.columnCount;
+}
+
+const uint32_t *SystemPageHeaderImpl::getColumnSizes() const {
+  // 4 byte aligned within the header, which is aligned itself
+  return reinterpret_cast<const uint32_t *>(
+      reinterpret_cast<const uchar *>(&systemPageHeader) +
+      offsetof(SystemPageHeader, columnSizes));
+}
+
 uchar *SystemPageHeaderImpl::toBinary() {
   return reinterpret_cast<uchar *>(&systemPageHeader);
 }
@@ -47,28 +91,31 @@ TablespaceHandler::TablespaceHandler(const char *path)
       systemPageHeader(SystemPageHeaderImpl())
 {
   file = file_handler::File(path, file_config::MYF_STRICT_MODE, tablespace_key);
-  size_t readSize = file.read(tablespaceHeader.toBinary(), TABLE_SPACE_HEADER_SIZE);
-  assert(readSize == TABLE_SPACE_HEADER_SIZE);
-  readSize = file.read(systemPageHeader.toBinary(), SYSTEM_PAGE_HEADER_SIZE);
-  assert(readSize == SYSTEM_PAGE_HEADER_SIZE);
+  size_t readSize = file.read(tablespaceHeader.toBinary(),
+                              TABLE_SPACE_HEADER_BLOCK_SIZE,
+                              TABLE_SPACE_HEADER_START_POSITION);
+  assert(readSize == TABLE_SPACE_HEADER_BLOCK_SIZE);
+  readSize = file.read(systemPageHeader.toBinary(), SYSTEM_PAGE_SIZE,
+                       SYSTEM_PAGE_HEADER_START_POSITION);
+  assert(readSize == SYSTEM_PAGE_SIZE);
 }
 
 TablespaceHandler TablespaceHandler::create(const char *path,
                                                        tablespace_id tablespaceId) {
   file_handler::File fil = file_handler::File::create(path, tablespace_key);
   assert(fil.getFileDescriptor() > 0);
-  TablespaceHeaderImpl header(tablespaceId);
+  TablespaceHeaderImpl header(tablespaceId, page::PAGE_SIZE);
   SystemPageHeaderImpl systemPage;
   size_t writeSize = fil.write(header.toBinary(),
-                               TABLE_SPACE_HEADER_SIZE,
+                               TABLE_SPACE_HEADER_BLOCK_SIZE,
                                TABLE_SPACE_START_POSITION);
-  assert(writeSize == TABLE_SPACE_HEADER_SIZE);
+  assert(writeSize == TABLE_SPACE_HEADER_BLOCK_SIZE);
   writeSize = fil.write(systemPage.toBinary(),
                         SYSTEM_PAGE_SIZE,
                         SYSTEM_PAGE_HEADER_START_POSITION);
   assert(writeSize == SYSTEM_PAGE_SIZE);
 
-  return TablespaceHandler(path, fil, header, systemPage);
+  return TablespaceHandler(path, std::move(fil), header, systemPage);
 }
 
 void TablespaceHandler::remove() {
@@ -87,11 +134,11 @@ file_handler::FileDescriptor TablespaceHandler::getFileDescriptor() {
   return file.getFileDescriptor();
 }
 
-void TablespaceHandler::flushTablespaceHeader() {
+bool TablespaceHandler::flushTablespaceHeader() {
   size_t writeSize = file.write(tablespaceHeader.toBinary(),
-                                TABLE_SPACE_HEADER_SIZE,
+                                TABLE_SPACE_HEADER_BLOCK_SIZE,
                                 TABLE_SPACE_HEADER_START_POSITION);
-  assert(writeSize == TABLE_SPACE_HEADER_SIZE);
+  return writeSize == TABLE_SPACE_HEADER_BLOCK_SIZE;
 }
 
 void TablespaceHandler::flushSystemPageHeader() {
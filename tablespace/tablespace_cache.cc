@@ -0,0 +1,384 @@
+#include "tablespace_cache.h"
+
+#include <algorithm>
+#include <iterator>
+#include <vector>
+
+#include "file_config.h"
+#include "file_util.h"
+#include "my_sys.h"
+#include "page.h"
+
+PSI_mutex_key tablespace_cache_mutex_key;
+PSI_mutex_key tablespace_sync_mutex_key;
+PSI_mutex_key page_allocate_mutex_key;
+PSI_cond_key tablespace_cache_cond_key;
+extern PSI_file_key tablespace_key;
+
+namespace tablespace {
+
+CachedTablespace::CachedTablespace(const char *path)
+    : path(path), handler(this->path.c_str()) {
+  mysql_mutex_init(page_allocate_mutex_key, &this->allocateMutex,
+                   MY_MUTEX_INIT_FAST);
+}
+
+CachedTablespace::~CachedTablespace() {
+  mysql_mutex_destroy(&this->allocateMutex);
+}
+
+TablespaceGuard::TablespaceGuard(TablespaceGuard &&other) noexcept
+    : cache(other.cache), entry(other.entry) {
+  other.cache = nullptr;
+  other.entry = nullptr;
+}
+
+TablespaceGuard &TablespaceGuard::operator=(TablespaceGuard &&other) noexcept {
+  if (this != &other) {
+    release();
+    this->cache = other.cache;
+    this->entry = other.entry;
+    other.cache = nullptr;
+    other.entry = nullptr;
+  }
+  return *this;
+}
+
+void TablespaceGuard::release() {
+  if (this->entry == nullptr) {
+    return;
+  }
+  this->cache->unpin(this->entry);
+  this->cache = nullptr;
+  this->entry = nullptr;
+}
+
+/**
+ * Maps the file read-only, see TablespaceCache::map().
+ */
+std::shared_ptr<const TablespaceMapping> TablespaceGuard::map(page_id pageId) {
+  return this->cache->map(this->entry, pageId);
+}
+
+/**
+ * Records that pages were written to the file, see
+ * TablespaceCache::syncWritten().
+ */
+void TablespaceGuard::markWritten() {
+  this->cache->markWritten(this->entry);
+}
+
+/**
+ * @return the leading free space map pages that map every page as full,
+ * with the version to raise the count from in version
+ */
+uint64_t TablespaceGuard::getFullFsmPageCount(uint64_t *version) {
+  return this->cache->getFullFsmPageCount(this->entry, version);
+}
+
+/**
+ * Raises the leading full free space map pages to count, unless the count
+ * was lowered since version was read.
+ */
+void TablespaceGuard::raiseFullFsmPageCount(uint64_t count,
+                                            uint64_t version) {
+  this->cache->raiseFullFsmPageCount(this->entry, count, version);
+}
+
+/**
+ * Lowers the leading full free space map pages to count, once a page
+ * mapped by map page count has room.
+ */
+void TablespaceGuard::lowerFullFsmPageCount(uint64_t count) {
+  this->cache->lowerFullFsmPageCount(this->entry, count);
+}
+
+void TablespaceCache::init(uint64_t capacity) {
+  assert(!this->initialized && capacity > 0);
+  mysql_mutex_init(tablespace_cache_mutex_key, &this->mutex,
+                   MY_MUTEX_INIT_FAST);
+  mysql_cond_init(tablespace_cache_cond_key, &this->unpinCond);
+  mysql_mutex_init(tablespace_sync_mutex_key, &this->syncMutex,
+                   MY_MUTEX_INIT_FAST);
+  this->capacity = capacity;
+  this->initialized = true;
+}
+
+/**
+ * Closes every file. None may be pinned anymore, and the written ones
+ * must have been synced with syncWritten().
+ */
+void TablespaceCache::deinit() {
+  if (!this->initialized) {
+    return;
+  }
+  for (CachedTablespace *entry : this->lru) {
+    assert(entry->refCount == 0);
+    delete entry;
+  }
+  this->lru.clear();
+  this->tablespaces.clear();
+  mysql_cond_destroy(&this->unpinCond);
+  mysql_mutex_destroy(&this->syncMutex);
+  mysql_mutex_destroy(&this->mutex);
+  this->initialized = false;
+}
+
+/**
+ * Opens the tablespace file at path, or returns the already open one of
+ * the same tablespace.
+ * @return an invalid guard when the file does not exist or has pages of
+ * another size than PAGE_SIZE
+ */
+TablespaceGuard TablespaceCache::open(const char *path) {
+  if (my_access(path, F_OK) != 0) {
+    return TablespaceGuard();
+  }
+  // the header has to be read to know the tablespace, outside the mutex
+  CachedTablespace *entry = new CachedTablespace(path);
+  if (entry->handler.getTablespaceHeader().getPageSize() != page::PAGE_SIZE) {
+    delete entry;
+    return TablespaceGuard();
+  }
+  mysql_mutex_lock(&this->mutex);
+  CachedTablespace *cached = insert(entry);
+  TablespaceGuard guard = pin(cached);
+  closeExcess();
+  mysql_mutex_unlock(&this->mutex);
+  if (cached != entry) {
+    delete entry;
+  }
+  return guard;
+}
+
+/**
+ * Returns the open file of the tablespace, opening it at path on a miss.
+ * @return an invalid guard when the file does not exist, now belongs to
+ * another tablespace or has pages of another size than PAGE_SIZE
+ */
+TablespaceGuard TablespaceCache::get(tablespace_id tablespaceId,
+                                     const char *path) {
+  mysql_mutex_lock(&this->mutex);
+  auto it = this->tablespaces.find(tablespaceId);
+  if (it != this->tablespaces.end()) {
+    TablespaceGuard guard = pin(it->second);
+    mysql_mutex_unlock(&this->mutex);
+    return guard;
+  }
+  mysql_mutex_unlock(&this->mutex);
+
+  if (my_access(path, F_OK) != 0) {
+    return TablespaceGuard();
+  }
+  CachedTablespace *entry = new CachedTablespace(path);
+  if (entry->handler.getTablespaceHeader().getId() != tablespaceId ||
+      entry->handler.getTablespaceHeader().getPageSize() != page::PAGE_SIZE) {
+    delete entry;
+    return TablespaceGuard();
+  }
+  mysql_mutex_lock(&this->mutex);
+  // another thread may have opened it meanwhile
+  CachedTablespace *cached = insert(entry);
+  TablespaceGuard guard = pin(cached);
+  closeExcess();
+  mysql_mutex_unlock(&this->mutex);
+  if (cached != entry) {
+    delete entry;
+  }
+  return guard;
+}
+
+/**
+ * Closes the file of the tablespace once nobody uses it and deletes it.
+ * The buffer pool must have discarded the pages of the tablespace.
+ */
+void TablespaceCache::remove(tablespace_id tablespaceId, const char *path) {
+  mysql_mutex_lock(&this->mutex);
+  auto it = this->tablespaces.find(tablespaceId);
+  if (it != this->tablespaces.end()) {
+    CachedTablespace *entry = it->second;
+    while (entry->refCount > 0) {
+      mysql_cond_wait(&this->unpinCond, &this->mutex);
+    }
+    close(entry);
+  }
+  mysql_mutex_unlock(&this->mutex);
+  FileUtil::remove(tablespace_key, path, MYF(file_config::MYF_STRICT_MODE));
+}
+
+/**
+ * Syncs every file pages were written to since its last sync, so that the
+ * pages survive a crash of the OS. Called before a checkpoint moves past
+ * the changes in them.
+ *
+ * A failed sync is not tried again: the kernel reports a writeback error
+ * once, so the next sync may succeed with the pages lost. The file keeps
+ * failing every later call instead, holding the checkpoint back until
+ * recovery writes the pages again at the next startup.
+ * @return false if a file could not be synced, now or before
+ */
+bool TablespaceCache::syncWritten() {
+  mysql_mutex_lock(&this->syncMutex);
+  bool synced = true;
+  std::vector<CachedTablespace *> written;
+  mysql_mutex_lock(&this->mutex);
+  for (CachedTablespace *entry : this->lru) {
+    if (entry->syncFailed) {
+      synced = false;
+    } else if (entry->written) {
+      entry->written = false;
+      entry->refCount++;
+      written.push_back(entry);
+    }
+  }
+  mysql_mutex_unlock(&this->mutex);
+
+  for (CachedTablespace *entry : written) {
+    if (FileUtil::sync(entry->handler.getFileDescriptor()) != 0) {
+      mysql_mutex_lock(&this->mutex);
+      entry->syncFailed = true;
+      mysql_mutex_unlock(&this->mutex);
+      synced = false;
+    }
+    unpin(entry);
+  }
+  mysql_mutex_unlock(&this->syncMutex);
+  return synced;
+}
+
+void TablespaceCache::setCapacity(uint64_t capacity) {
+  assert(capacity > 0);
+  mysql_mutex_lock(&this->mutex);
+  this->capacity = capacity;
+  closeExcess();
+  mysql_mutex_unlock(&this->mutex);
+}
+
+uint64_t TablespaceCache::getCapacity() {
+  mysql_mutex_lock(&this->mutex);
+  uint64_t capacity = this->capacity;
+  mysql_mutex_unlock(&this->mutex);
+  return capacity;
+}
+
+uint64_t TablespaceCache::getOpenFileCount() {
+  mysql_mutex_lock(&this->mutex);
+  uint64_t count = this->tablespaces.size();
+  mysql_mutex_unlock(&this->mutex);
+  return count;
+}
+
+TablespaceGuard TablespaceCache::pin(CachedTablespace *entry) {
+  mysql_mutex_assert_owner(&this->mutex);
+  entry->refCount++;
+  this->lru.splice(this->lru.begin(), this->lru, entry->lruPosition);
+  return TablespaceGuard(this, entry);
+}
+
+/**
+ * @return the entry registered for the tablespace of entry, entry itself
+ * unless the tablespace was already open
+ */
+CachedTablespace *TablespaceCache::insert(CachedTablespace *entry) {
+  mysql_mutex_assert_owner(&this->mutex);
+  tablespace_id tablespaceId = entry->handler.getTablespaceHeader().getId();
+  auto inserted = this->tablespaces.emplace(tablespaceId, entry);
+  if (!inserted.second) {
+    return inserted.first->second;
+  }
+  this->lru.push_front(entry);
+  entry->lruPosition = this->lru.begin();
+  return entry;
+}
+
+/**
+ * Closes the least recently used unpinned files until at most capacity
+ * are open. Files written since their last sync, or whose sync failed,
+ * are kept open as well, closing them would not write the pages through.
+ */
+void TablespaceCache::closeExcess() {
+  mysql_mutex_assert_owner(&this->mutex);
+  auto it = this->lru.end();
+  while (this->tablespaces.size() > this->capacity &&
+         it != this->lru.begin()) {
+    --it;
+    CachedTablespace *entry = *it;
+    if (entry->refCount > 0 || entry->written || entry->syncFailed) {
+      continue;
+    }
+    // erasing entry leaves the iterator at its successor
+    it = std::next(it);
+    close(entry);
+  }
+}
+
+void TablespaceCache::close(CachedTablespace *entry) {
+  mysql_mutex_assert_owner(&this->mutex);
+  assert(entry->refCount == 0);
+  this->tablespaces.erase(entry->handler.getTablespaceHeader().getId());
+  this->lru.erase(entry->lruPosition);
+  delete entry;
+}
+
+/**
+ * Returns the mapping of the file, mapping it again when it does not hold
+ * pageId yet and the file grew since.
+ */
+std::shared_ptr<const TablespaceMapping> TablespaceCache::map(
+    CachedTablespace *entry, page_id pageId) {
+  mysql_mutex_lock(&this->mutex);
+  std::shared_ptr<const TablespaceMapping> mapping = entry->mapping;
+  if (mapping == nullptr || pageId >= mapping->getPageCount()) {
+    // readers of the previous mapping keep it alive until they are done
+    mapping = std::make_shared<TablespaceMapping>(
+        entry->handler.getFileDescriptor());
+    entry->mapping = mapping;
+  }
+  mysql_mutex_unlock(&this->mutex);
+  return mapping;
+}
+
+void TablespaceCache::markWritten(CachedTablespace *entry) {
+  mysql_mutex_lock(&this->mutex);
+  entry->written = true;
+  mysql_mutex_unlock(&this->mutex);
+}
+
+uint64_t TablespaceCache::getFullFsmPageCount(CachedTablespace *entry,
+                                              uint64_t *version) {
+  mysql_mutex_lock(&this->mutex);
+  uint64_t count = entry->fullFsmPageCount;
+  *version = entry->fsmHintVersion;
+  mysql_mutex_unlock(&this->mutex);
+  return count;
+}
+
+void TablespaceCache::raiseFullFsmPageCount(CachedTablespace *entry,
+                                            uint64_t count, uint64_t version) {
+  mysql_mutex_lock(&this->mutex);
+  if (entry->fsmHintVersion == version) {
+    entry->fullFsmPageCount = std::max(entry->fullFsmPageCount, count);
+  }
+  mysql_mutex_unlock(&this->mutex);
+}
+
+void TablespaceCache::lowerFullFsmPageCount(CachedTablespace *entry,
+                                            uint64_t count) {
+  mysql_mutex_lock(&this->mutex);
+  entry->fullFsmPageCount = std::min(entry->fullFsmPageCount, count);
+  entry->fsmHintVersion++;
+  mysql_mutex_unlock(&this->mutex);
+}
+
+void TablespaceCache::unpin(CachedTablespace *entry) {
+  mysql_mutex_lock(&this->mutex);
+  assert(entry->refCount > 0);
+  entry->refCount--;
+  if (entry->refCount == 0) {
+    mysql_cond_broadcast(&this->unpinCond);
+    closeExcess();
+  }
+  mysql_mutex_unlock(&this->mutex);
+}
+
+} // namespace tablespace
@@ -0,0 +1,58 @@
+#include "tablespace_mapping.h"
+
+#include <sys/mman.h>
+#include <algorithm>
+
+namespace tablespace {
+
+/**
+ * Maps every whole page of the file. A file without pages, or one that
+ * cannot be mapped, gives a mapping without pages.
+ */
+TablespaceMapping::TablespaceMapping(file_handler::FileDescriptor fd) {
+  uint64_t pages = page::PageHandler::countPages(fd);
+  if (pages == 0) {
+    return;
+  }
+  size_t size = page::PAGE_START_POSITION + pages * page::PAGE_SIZE;
+  void *mapped = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+  if (mapped == MAP_FAILED) {
+    return;
+  }
+  this->region = static_cast<uchar *>(mapped);
+  this->regionSize = size;
+  this->pageCount = pages;
+}
+
+TablespaceMapping::~TablespaceMapping() {
+  if (this->region != nullptr) {
+    munmap(this->region, this->regionSize);
+  }
+}
+
+/**
+ * Hints the kernel that the pages are about to be read in order, so that
+ * it reads ahead aggressively and drops them early.
+ */
+void TablespaceMapping::adviseSequential() const {
+  if (this->region != nullptr) {
+    madvise(this->region, this->regionSize, MADV_SEQUENTIAL);
+  }
+}
+
+/**
+ * Asks the kernel to start reading up to pageCount pages from
+ * firstPageId in the background.
+ */
+void TablespaceMapping::adviseWillNeed(page_id firstPageId,
+                                       uint64_t pageCount) const {
+  if (firstPageId >= this->pageCount) {
+    return;
+  }
+  uint64_t count = std::min(pageCount, this->pageCount - firstPageId);
+  // page images are aligned to the OS page size, see PAGE_START_POSITION
+  madvise(const_cast<uchar *>(getPage(firstPageId)), count * page::PAGE_SIZE,
+          MADV_WILLNEED);
+}
+
+} // namespace tablespace
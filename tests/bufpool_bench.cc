@@ -0,0 +1,204 @@
+//
+// Microbenchmarks for the buffer pool.
+// Run with --gtest_filter='Microbenchmarks.*' on an optimized build.
+//
+#include <gtest/gtest.h>
+#include <atomic>
+#include <cstdio>
+#include <thread>
+#include "bufpool.h"
+#include "page.h"
+#include "tablespace.h"
+#include "unittest/gunit/benchmark.h"
+
+namespace {
+
+constexpr const tablespace_id BENCH_TABLESPACE_COUNT = 2;
+
+// Lookup cost must not depend on how many pages are cached.
+void BM_BufPoolLookup(size_t num_iterations, uint64_t cachedPageCount) {
+  StopBenchmarkTiming();
+
+  buf::BufPool bufPool;
+  bufPool.init_buffer_pool(0, cachedPageCount);
+  uint64_t pagesPerTablespace = cachedPageCount / BENCH_TABLESPACE_COUNT;
+  for (tablespace_id tablespaceId = 0; tablespaceId < BENCH_TABLESPACE_COUNT;
+       tablespaceId++) {
+    for (page_id pageId = 0; pageId < pagesPerTablespace; pageId++) {
+      bufPool.putPage(tablespaceId, page::PageHandler(pageId), "dummy");
+    }
+  }
+
+  size_t found = 0;
+  StartBenchmarkTiming();
+  for (size_t i = 0; i < num_iterations; i++) {
+    // stride over the page ids so that consecutive probes hit different buckets
+    uint64_t n = i * 7919;
+    buf::Element *element =
+        bufPool.getElement(n % BENCH_TABLESPACE_COUNT,
+                           (n / BENCH_TABLESPACE_COUNT) % pagesPerTablespace);
+    found += (element != nullptr);
+  }
+  StopBenchmarkTiming();
+
+  EXPECT_EQ(found, num_iterations);
+  bufPool.deinit_buffer_pool();
+}
+
+void BM_BufPoolLookup10Pages(size_t num_iterations) {
+  BM_BufPoolLookup(num_iterations, 10);
+}
+BENCHMARK(BM_BufPoolLookup10Pages)
+
+void BM_BufPoolLookup1kPages(size_t num_iterations) {
+  BM_BufPoolLookup(num_iterations, 1000);
+}
+BENCHMARK(BM_BufPoolLookup1kPages)
+
+void BM_BufPoolLookup100kPages(size_t num_iterations) {
+  BM_BufPoolLookup(num_iterations, 100000);
+}
+BENCHMARK(BM_BufPoolLookup100kPages)
+
+constexpr const char *BENCH_TABLESPACE_PATH = "./bufpool_bench";
+constexpr const uint64_t HOT_POOL_SIZE = 4 * buf::LRU_OLD_MIN_LEN;
+constexpr const page_id HOT_PAGE_COUNT = 32;
+
+// Point reads over a small hot set, optionally while another thread scans
+// a table much larger than the pool. The hot set must stay cached.
+void BM_BufPoolHotReads(size_t num_iterations, bool withScan) {
+  StopBenchmarkTiming();
+
+  tablespace_id hotTablespaceId = 1;
+  tablespace_id scannedTablespaceId = 2;
+  {
+    tablespace::TablespaceHandler tablespaceHandler =
+        tablespace::TablespaceHandler::create(BENCH_TABLESPACE_PATH,
+                                              hotTablespaceId);
+    for (page_id pageId = 0; pageId < HOT_PAGE_COUNT; pageId++) {
+      page::PageHandler::reserveNewPage(pageId).flush(
+          tablespaceHandler.getFileDescriptor());
+    }
+  }
+  buf::BufPool bufPool;
+  bufPool.init_buffer_pool(0, HOT_POOL_SIZE);
+  for (int round = 0; round < 2; round++) {
+    for (page_id pageId = 0; pageId < HOT_PAGE_COUNT; pageId++) {
+      bufPool.fixPage(hotTablespaceId, pageId, BENCH_TABLESPACE_PATH,
+                      buf::LatchMode::SHARED);
+    }
+  }
+
+  std::atomic<bool> scanning{withScan};
+  std::thread scanner([&]() {
+    for (page_id pageId = 0; scanning; pageId++) {
+      // every page of the scanned table is new to the pool and read once
+      bufPool.putPage(scannedTablespaceId, page::PageHandler(pageId), "dummy");
+      bufPool.fixPage(scannedTablespaceId, pageId, "dummy",
+                      buf::LatchMode::SHARED);
+    }
+  });
+
+  StartBenchmarkTiming();
+  for (size_t i = 0; i < num_iterations; i++) {
+    buf::PageGuard guard =
+        bufPool.fixPage(hotTablespaceId, (i * 7) % HOT_PAGE_COUNT,
+                        BENCH_TABLESPACE_PATH, buf::LatchMode::SHARED);
+  }
+  StopBenchmarkTiming();
+
+  scanning = false;
+  scanner.join();
+  for (page_id pageId = 0; pageId < HOT_PAGE_COUNT; pageId++) {
+    EXPECT_TRUE(bufPool.existPage(hotTablespaceId, pageId));
+  }
+  bufPool.deinit_buffer_pool();
+  std::remove(BENCH_TABLESPACE_PATH);
+}
+
+void BM_BufPoolHotReadsAlone(size_t num_iterations) {
+  BM_BufPoolHotReads(num_iterations, false);
+}
+BENCHMARK(BM_BufPoolHotReadsAlone)
+
+void BM_BufPoolHotReadsWithScan(size_t num_iterations) {
+  BM_BufPoolHotReads(num_iterations, true);
+}
+BENCHMARK(BM_BufPoolHotReadsWithScan)
+
+constexpr const char *IO_BENCH_TABLESPACE_PATH = "./bufpool_io_bench";
+constexpr const page_id IO_BENCH_PAGE_COUNT = 1024;
+// a quarter of the table, so that most fixes read or write back a page
+constexpr const uint64_t IO_BENCH_POOL_SIZE = IO_BENCH_PAGE_COUNT / 4;
+constexpr const uint32_t IO_BENCH_TUPLE_SIZE = 64;
+
+// Table scans and inserts over a table larger than the pool, with the
+// tablespace file opened in mode. In BUFFERED mode misses are mostly
+// served by the OS page cache, in DIRECT mode they go to the device.
+void BM_BufPoolIo(size_t num_iterations, file_handler::IoMode mode,
+                  bool insert) {
+  StopBenchmarkTiming();
+
+  file_handler::setIoMode(mode);
+  tablespace_id tablespaceId = 1;
+  {
+    tablespace::TablespaceHandler tablespaceHandler =
+        tablespace::TablespaceHandler::create(IO_BENCH_TABLESPACE_PATH,
+                                              tablespaceId);
+    for (page_id pageId = 0; pageId < IO_BENCH_PAGE_COUNT; pageId++) {
+      page::PageHandler::reserveNewPage(pageId).flush(
+          tablespaceHandler.getFileDescriptor());
+    }
+  }
+  buf::BufPool bufPool;
+  bufPool.init_buffer_pool(0, IO_BENCH_POOL_SIZE);
+  uint8_t data[IO_BENCH_TUPLE_SIZE] = {0};
+
+  StartBenchmarkTiming();
+  for (size_t i = 0; i < num_iterations; i++) {
+    page_id pageId = i % IO_BENCH_PAGE_COUNT;
+    if (!insert) {
+      bufPool.fixPage(tablespaceId, pageId, IO_BENCH_TABLESPACE_PATH,
+                      buf::LatchMode::SHARED);
+      continue;
+    }
+    buf::PageGuard guard =
+        bufPool.fixPage(tablespaceId, pageId, IO_BENCH_TABLESPACE_PATH,
+                        buf::LatchMode::EXCLUSIVE);
+    page::Header &header = guard.getPageHandler().getPageHeader();
+    if (header.freeEnd - header.freeBegin >=
+        IO_BENCH_TUPLE_SIZE + page::SLOT_SIZE) {
+      guard.getPageHandler().insert(
+          tuple::Tuple(IO_BENCH_TUPLE_SIZE, 0, data));
+    }
+    guard.markDirty();
+  }
+  bufPool.flushAllDirtyPages();
+  StopBenchmarkTiming();
+
+  bufPool.deinit_buffer_pool();
+  file_handler::setIoMode(file_handler::IoMode::BUFFERED);
+  std::remove(IO_BENCH_TABLESPACE_PATH);
+}
+
+void BM_BufPoolScanBuffered(size_t num_iterations) {
+  BM_BufPoolIo(num_iterations, file_handler::IoMode::BUFFERED, false);
+}
+BENCHMARK(BM_BufPoolScanBuffered)
+
+void BM_BufPoolScanDirect(size_t num_iterations) {
+  BM_BufPoolIo(num_iterations, file_handler::IoMode::DIRECT, false);
+}
+BENCHMARK(BM_BufPoolScanDirect)
+
+void BM_BufPoolInsertBuffered(size_t num_iterations) {
+  BM_BufPoolIo(num_iterations, file_handler::IoMode::BUFFERED, true);
+}
+BENCHMARK(BM_BufPoolInsertBuffered)
+
+void BM_BufPoolInsertDirect(size_t num_iterations) {
+  BM_BufPoolIo(num_iterations, file_handler::IoMode::DIRECT, true);
+}
+BENCHMARK(BM_BufPoolInsertDirect)
+
+}  // namespace
@@ -1,19 +1,46 @@
 #include <gtest/gtest.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
 #include "bufpool.h"
+#include "bufpool_dump.h"
+#include "bufpool_resizer.h"
+#include "fsm_page.h"
 #include "page.h"
+#include "tablespace.h"
 
 class BufPoolTest : public testing::Test {
  protected:
   buf::BufPool *sut;
+  char tablespacePath[16] = "./bufpool_test";
 
   void SetUp() override {
+    tablespace::TablespaceHandler tablespaceHandler =
+        tablespace::TablespaceHandler::create(tablespacePath, 1);
+    for (page_id pageId = 0; pageId < 4; pageId++) {
+      page::PageHandler::reserveNewPage(pageId).flush(
+          tablespaceHandler.getFileDescriptor());
+    }
     sut = new buf::BufPool();
+    sut->init_buffer_pool(0, 1024);
   }
 
   void TearDown() override {
     sut->deinit_buffer_pool();
     delete sut;
     sut = nullptr;
+    std::remove(tablespacePath);
+  }
+
+  page::PageHandler readPageFromFile(page_id pageId) {
+    tablespace::TablespaceHandler tablespaceHandler =
+        tablespace::TablespaceHandler(tablespacePath);
+    page::PageHandler pageHandler(pageId);
+    pageHandler.readFromFile(tablespaceHandler.getFileDescriptor());
+    return pageHandler;
   }
 };
 
@@ -22,7 +49,7 @@ TEST_F(BufPoolTest, isLastPage) {
   tablespace_id tablespaceId = 1;
   page_id pageId = 1;
   page::PageHandler pageHandler = page::PageHandler(pageId);
-  sut->elements = new buf::Element(tablespaceId, pageHandler);
+  sut->putPage(tablespaceId, pageHandler, "dummy");
 
   // Exercise
   bool isLastPage = sut->isLastPage(tablespaceId, pageId, "hoge");
@@ -36,11 +63,10 @@ TEST_F(BufPoolTest, isLastPageWithMorePages) {
   tablespace_id tablespaceId = 1;
   page_id pageId = 1;
   page::PageHandler pageHandler = page::PageHandler(pageId);
-  sut->elements = new buf::Element(tablespaceId, pageHandler);
+  sut->putPage(tablespaceId, pageHandler, "dummy");
 
   page::PageHandler page = page::PageHandler(pageId + 1);
-  buf::Element *lastElement = new buf::Element(tablespaceId + 1, page);
-  sut->elements->next = lastElement;
+  sut->putPage(tablespaceId + 1, page, "dummy");
 
   // Exercise
   bool isLastPage = sut->isLastPage(tablespaceId + 1, pageId + 1, "dummy");
@@ -49,6 +75,20 @@ TEST_F(BufPoolTest, isLastPageWithMorePages) {
   ASSERT_TRUE(isLastPage);
 }
 
+TEST_F(BufPoolTest, isLastPageOfMissingTablespace) {
+  // Setup
+  tablespace_id tablespaceId = 2;
+  page_id pageId = 1;
+
+  // Exercise
+  bool isLastPage = sut->isLastPage(tablespaceId, pageId, "./missing");
+  bool isLastTuple = sut->isLastTuple(tablespaceId, pageId, 0, "./missing");
+
+  // Verify
+  ASSERT_FALSE(isLastPage);
+  ASSERT_FALSE(isLastTuple);
+}
+
 TEST_F(BufPoolTest, isLastTuple) {
   // Setup
   tablespace_id tablespaceId = 1;
@@ -59,7 +99,7 @@ TEST_F(BufPoolTest, isLastTuple) {
   page::PageHandler pageHandler = page::PageHandler(pageId);
   pageHandler.getPageHeader().tupleCount = 1;
   pageHandler.insert(insertTuple);
-  sut->elements = new buf::Element(tablespaceId, pageHandler);
+  sut->putPage(tablespaceId, pageHandler, "dummy");
 
   // Exercise
   bool isLastTuple = sut->isLastTuple(tablespaceId, pageId, tupleCursor, "hoge");
@@ -83,14 +123,13 @@ TEST_F(BufPoolTest, getElement) {
   uint64_t tupleCursor = 1;
   page::PageHandler pageHandler = page::PageHandler(pageId);
   pageHandler.getPageHeader().tupleCount = tupleCursor;
-  sut->elements = new buf::Element(tablespaceId, pageHandler);
+  sut->putPage(tablespaceId, pageHandler, "dummy");
 
   // Exercise
   buf::Element *element = sut->getElement(tablespaceId, pageId);
 
   // Verify
   ASSERT_NE(element, nullptr);
-  ASSERT_EQ(element->next, nullptr);
   ASSERT_EQ(element->tableSpaceId, tablespaceId);
   ASSERT_EQ(element->refCount, 0);
   ASSERT_EQ(element->getPageHandler().getPageHeader().id, pageId);
@@ -111,7 +150,7 @@ TEST_F(BufPoolTest, existPage) {
   uint64_t tupleCursor = 1;
   page::PageHandler pageHandler = page::PageHandler(pageId);
   pageHandler.getPageHeader().tupleCount = tupleCursor;
-  sut->elements = new buf::Element(tablespaceId, pageHandler);
+  sut->putPage(tablespaceId, pageHandler, "dummy");
 
   // Exercise
   bool existPage = sut->existPage(tablespaceId, pageId);
@@ -129,22 +168,240 @@ TEST_F(BufPoolTest, write) {
   tablespace_id tablespaceId = 1;
   page_id pageId = 1;
   uchar buf[] = {1, 1, 1, 1};
-  char tablespacePath[] = "dummy";
   tuple::Tuple *newTuple = new tuple::Tuple(4, 0, buf);
   page::PageHandler pageHandler = page::PageHandler(pageId);
-  sut->elements = new buf::Element(tablespaceId, pageHandler);
+  sut->putPage(tablespaceId, pageHandler, tablespacePath);
   buf::WriteDescriptor writeDescriptor{tablespaceId, pageId, tablespacePath, newTuple};
 
   // Exercise
   sut->write(buf, writeDescriptor);
 
   // Verify
-  page::Header header = sut->elements->getPageHandler().getPageHeader();
+  page::Header header = sut->getElement(tablespaceId, pageId)->getPageHandler().getPageHeader();
   ASSERT_EQ(header.tupleCount, 1);
   ASSERT_EQ(header.freeBegin, page::SLOT_SIZE);
   ASSERT_EQ(header.freeEnd, page::PAGE_BODY_SIZE - 4);
 }
 
+TEST_F(BufPoolTest, writeToFullPage) {
+  // Setup
+  tablespace_id tablespaceId = 1;
+  page_id pageId = 2;
+  std::vector<uchar> buf(page::MAX_TUPLE_SIZE, 1);
+  tuple::Tuple largest(page::MAX_TUPLE_SIZE, 0, buf.data());
+  tuple::Tuple smallest(1, 0, buf.data());
+  buf::WriteDescriptor fill{tablespaceId, pageId, tablespacePath, &largest};
+  buf::WriteDescriptor overflow{tablespaceId, pageId, tablespacePath, &smallest};
+  ASSERT_EQ(sut->write(buf.data(), fill), buf::WriteResult::WRITTEN);
+
+  // Exercise
+  buf::WriteResult result = sut->write(buf.data(), overflow);
+
+  // Verify
+  ASSERT_EQ(result, buf::WriteResult::PAGE_FULL);
+  page::Header header = sut->getElement(tablespaceId, pageId)->getPageHandler().getPageHeader();
+  ASSERT_EQ(header.tupleCount, 1);
+}
+
+TEST_F(BufPoolTest, allocatePageChainsNewPage) {
+  // Setup
+  tablespace_id tablespaceId = 1;
+  page_id lastPageId = 3;
+
+  // Exercise
+  page_id newPageId = sut->allocatePage(tablespaceId, lastPageId, tablespacePath);
+
+  // Verify
+  ASSERT_EQ(newPageId, 4);
+  ASSERT_EQ(sut->getElement(tablespaceId, lastPageId)->getPageHandler().getPage().getNextPageId(),
+            newPageId);
+  tablespace::TablespaceHandler tablespaceHandler =
+      tablespace::TablespaceHandler(tablespacePath);
+  ASSERT_EQ(tablespaceHandler.getTablespaceHeader().getPageCount(), newPageId + 1);
+  // grown by a whole extent
+  ASSERT_EQ(page::PageHandler::countPages(tablespaceHandler.getFileDescriptor()),
+            newPageId + tablespace::EXTENT_PAGE_COUNT);
+}
+
+TEST_F(BufPoolTest, allocatePageFailsWhenFileCannotGrow) {
+  // Setup
+  tablespace_id tablespaceId = 1;
+  page_id lastPageId = 3;
+  // writes to the cached descriptor fail while it is open read only
+  int fd = sut->getTablespaceCache()
+               .get(tablespaceId, tablespacePath)
+               .getFileDescriptor();
+  int savedFd = dup(fd);
+  int readOnlyFd = open(tablespacePath, O_RDONLY);
+  ASSERT_EQ(dup2(readOnlyFd, fd), fd);
+
+  // Exercise
+  page_id newPageId = sut->allocatePage(tablespaceId, lastPageId, tablespacePath);
+  dup2(savedFd, fd);
+  close(readOnlyFd);
+  close(savedFd);
+
+  // Verify
+  ASSERT_EQ(newPageId, page::MAX_PAGE_ID);
+  ASSERT_EQ(sut->getElement(tablespaceId, lastPageId)->getPageHandler().getPage().getNextPageId(),
+            page::MAX_PAGE_ID);
+  ASSERT_EQ(sut->getTablespaceCache()
+                .get(tablespaceId, tablespacePath)
+                .getTablespaceHandler()
+                .getTablespaceHeader()
+                .getPageCount(),
+            0);
+  ASSERT_EQ(tablespace::TablespaceHandler(tablespacePath)
+                .getTablespaceHeader()
+                .getPageCount(),
+            0);
+  ASSERT_EQ(sut->allocatePage(tablespaceId, lastPageId, tablespacePath), 4);
+}
+
+TEST_F(BufPoolTest, allocatePaxPageAndReadRow) {
+  // Setup
+  tablespace_id tablespaceId = 1;
+  std::vector<uint32_t> columnSizes{4, 4};
+  {
+    tablespace::TablespaceHandler tablespaceHandler =
+        tablespace::TablespaceHandler(tablespacePath);
+    tablespaceHandler.getSystemPageHeader().setLayout(
+        tablespace::PageLayout::PAX, columnSizes.data(), columnSizes.size());
+    tablespaceHandler.flushSystemPageHeader();
+  }
+  std::vector<uchar> buf{1, 1, 1, 1, 2, 2, 2, 2};
+  tuple::Tuple row(8, 0, buf.data());
+  std::vector<uchar> readBuf(8);
+
+  // Exercise
+  page_id newPageId = sut->allocatePage(tablespaceId, 3, tablespacePath);
+  buf::WriteDescriptor writeDescriptor{tablespaceId, newPageId, tablespacePath, &row};
+  buf::WriteResult result = sut->write(buf.data(), writeDescriptor);
+  buf::ReadDescriptor readDescriptor{tablespaceId, newPageId, 0, tablespacePath};
+  int readSize = sut->read(readBuf.data(), readDescriptor);
+
+  // Verify
+  ASSERT_EQ(result, buf::WriteResult::WRITTEN);
+  ASSERT_EQ(readSize, 8);
+  ASSERT_EQ(readBuf, buf);
+  // the rest of the extent is formatted in the file
+  ASSERT_TRUE(readPageFromFile(newPageId + 1).isPax());
+}
+
+TEST_F(BufPoolTest, allocatePageAfterAnotherThread) {
+  // Setup
+  tablespace_id tablespaceId = 1;
+  page_id lastPageId = 3;
+  page_id newPageId = sut->allocatePage(tablespaceId, lastPageId, tablespacePath);
+
+  // Exercise
+  // a thread that found page 3 full too gets the page chained after it
+  page_id pageId = sut->allocatePage(tablespaceId, lastPageId, tablespacePath);
+
+  // Verify
+  ASSERT_EQ(pageId, newPageId);
+  ASSERT_EQ(sut->getElement(tablespaceId, newPageId)->getPageHandler().getPage().getNextPageId(),
+            page::MAX_PAGE_ID);
+}
+
+TEST_F(BufPoolTest, allocatePageWhileAnotherTablespaceAllocates) {
+  // Setup
+  tablespace_id tablespaceId = 1;
+  char otherPath[] = "./bufpool_test_other";
+  {
+    tablespace::TablespaceHandler tablespaceHandler =
+        tablespace::TablespaceHandler::create(otherPath, tablespaceId + 1);
+    page::PageHandler::reserveNewPage(0).flush(
+        tablespaceHandler.getFileDescriptor());
+  }
+  tablespace::TablespaceGuard tablespace =
+      sut->getTablespaceCache().get(tablespaceId, tablespacePath);
+  // as if a page of the first tablespace were being chained
+  mysql_mutex_lock(tablespace.getAllocateMutex());
+
+  // Exercise
+  page_id newPageId = sut->allocatePage(tablespaceId + 1, 0, otherPath);
+  mysql_mutex_unlock(tablespace.getAllocateMutex());
+
+  // Verify
+  ASSERT_EQ(newPageId, 2);
+  ASSERT_EQ(sut->allocatePage(tablespaceId, 3, tablespacePath), 4);
+  tablespace.release();
+  sut->discardTablespace(tablespaceId + 1);
+  sut->getTablespaceCache().remove(tablespaceId + 1, otherPath);
+}
+
+TEST_F(BufPoolTest, findLastPageFromStaleHint) {
+  // Setup
+  tablespace_id tablespaceId = 1;
+  page_id newPageId = sut->allocatePage(tablespaceId, 0, tablespacePath);
+
+  // Exercise
+  page_id fromAfter = sut->findLastPage(tablespaceId, 10, tablespacePath);
+  page_id fromBefore = sut->findLastPage(tablespaceId, 0, tablespacePath);
+
+  // Verify
+  // the free space map page is skipped
+  ASSERT_EQ(newPageId, 2);
+  ASSERT_EQ(fromAfter, newPageId);
+  ASSERT_EQ(fromBefore, newPageId);
+}
+
+TEST_F(BufPoolTest, fullPageFreeSpaceInMap) {
+  // Setup
+  tablespace_id tablespaceId = 1;
+  page_id pageId = 2;
+  uint32_t freeBytes = 4 * page::FSM_CATEGORY_SIZE;
+  std::vector<uchar> buf(page::PAGE_BODY_SIZE, 1);
+  tuple::Tuple filling(page::MAX_TUPLE_SIZE - freeBytes, 0, buf.data());
+  tuple::Tuple large(freeBytes, 0, buf.data());
+  buf::WriteDescriptor fill{tablespaceId, pageId, tablespacePath, &filling};
+  buf::WriteDescriptor overflow{tablespaceId, pageId, tablespacePath, &large};
+  sut->write(buf.data(), fill);
+  ASSERT_EQ(sut->findPageWithSpace(tablespaceId, 100, tablespacePath),
+            page::MAX_PAGE_ID);
+
+  // Exercise
+  buf::WriteResult result = sut->write(buf.data(), overflow);
+
+  // Verify
+  ASSERT_EQ(result, buf::WriteResult::PAGE_FULL);
+  ASSERT_EQ(sut->findPageWithSpace(tablespaceId, 100, tablespacePath), pageId);
+  ASSERT_EQ(sut->findPageWithSpace(tablespaceId, freeBytes, tablespacePath),
+            page::MAX_PAGE_ID);
+  ASSERT_TRUE(sut->getElement(tablespaceId, page::FIRST_FSM_PAGE_ID)->dirty);
+}
+
+TEST_F(BufPoolTest, findPageWithSpaceSkipsFullMapPages) {
+  // Setup
+  tablespace_id tablespaceId = 1;
+  page_id pageId = 2;
+  uint32_t freeBytes = 4 * page::FSM_CATEGORY_SIZE;
+  std::vector<uchar> buf(page::PAGE_BODY_SIZE, 1);
+  tuple::Tuple filling(page::MAX_TUPLE_SIZE - freeBytes, 0, buf.data());
+  tuple::Tuple large(freeBytes, 0, buf.data());
+  buf::WriteDescriptor fill{tablespaceId, pageId, tablespacePath, &filling};
+  buf::WriteDescriptor overflow{tablespaceId, pageId, tablespacePath, &large};
+  sut->write(buf.data(), fill);
+  tablespace::TablespaceGuard tablespace =
+      sut->getTablespaceCache().get(tablespaceId, tablespacePath);
+  uint64_t version = 0;
+
+  // Exercise
+  page_id beforeFull =
+      sut->findPageWithSpace(tablespaceId, 100, tablespacePath);
+  uint64_t fullCount = tablespace.getFullFsmPageCount(&version);
+  sut->write(buf.data(), overflow);
+
+  // Verify
+  // the only map page maps every page as full until page 2 is found full
+  ASSERT_EQ(beforeFull, page::MAX_PAGE_ID);
+  ASSERT_EQ(fullCount, 1);
+  ASSERT_EQ(tablespace.getFullFsmPageCount(&version), 0);
+  ASSERT_EQ(sut->findPageWithSpace(tablespaceId, 100, tablespacePath), pageId);
+  ASSERT_EQ(tablespace.getFullFsmPageCount(&version), 0);
+}
+
 TEST_F(BufPoolTest, writeAndRead) {
   // Setup
   tablespace_id tablespaceId = 1;
@@ -152,10 +409,9 @@ TEST_F(BufPoolTest, writeAndRead) {
   uint64_t tupleCursor = 0;
   uchar buf[] = {1, 1, 1, 1};
   uchar readBuf[] = {0, 0, 0, 0};
-  char tablespacePath[] = "dummy";
   tuple::Tuple *newTuple = new tuple::Tuple(4, 0, buf);
   page::PageHandler pageHandler = page::PageHandler(pageId);
-  sut->elements = new buf::Element(tablespaceId, pageHandler);
+  sut->putPage(tablespaceId, pageHandler, tablespacePath);
   buf::WriteDescriptor writeDescriptor{tablespaceId, pageId, tablespacePath, newTuple};
   buf::ReadDescriptor readDescriptor{tablespaceId, pageId, tupleCursor, tablespacePath};
 
@@ -164,7 +420,7 @@ TEST_F(BufPoolTest, writeAndRead) {
   int readSize = sut->read(readBuf, readDescriptor);
 
   // Verify
-  page::Header header = sut->elements->getPageHandler().getPageHeader();
+  page::Header header = sut->getElement(tablespaceId, pageId)->getPageHandler().getPageHeader();
   ASSERT_EQ(header.tupleCount, 1);
   ASSERT_EQ(header.freeBegin, page::SLOT_SIZE);
   ASSERT_EQ(header.freeEnd, page::PAGE_BODY_SIZE - 4);
@@ -173,3 +429,1050 @@ TEST_F(BufPoolTest, writeAndRead) {
     ASSERT_EQ(readBuf[i], 1);
   }
 }
+
+TEST_F(BufPoolTest, getElementWithManyPages) {
+  // Setup
+  tablespace_id tablespaceCount = 4;
+  page_id pageCount = 256;
+  for (tablespace_id tablespaceId = 1; tablespaceId <= tablespaceCount; tablespaceId++) {
+    for (page_id pageId = 0; pageId < pageCount; pageId++) {
+      sut->putPage(tablespaceId, page::PageHandler(pageId), "dummy");
+    }
+  }
+
+  // Exercise
+  buf::Element *element = sut->getElement(3, 128);
+  buf::Element *notCachedElement = sut->getElement(3, pageCount);
+
+  // Verify
+  ASSERT_EQ(sut->getPageCount(), tablespaceCount * pageCount);
+  ASSERT_NE(element, nullptr);
+  ASSERT_EQ(element->tableSpaceId, 3);
+  ASSERT_EQ(element->getPageHandler().getPageHeader().id, 128);
+  ASSERT_EQ(notCachedElement, nullptr);
+}
+
+TEST_F(BufPoolTest, putPageReplacesCachedPage) {
+  // Setup
+  tablespace_id tablespaceId = 1;
+  page_id pageId = 1;
+  uint8_t buf[] = {1, 1, 1, 1};
+  tuple::Tuple insertTuple{4, 0, buf};
+  page::PageHandler newPage = page::PageHandler(pageId);
+  newPage.insert(insertTuple);
+  sut->putPage(tablespaceId, page::PageHandler(pageId), "dummy");
+
+  // Exercise
+  sut->putPage(tablespaceId, newPage, "dummy");
+
+  // Verify
+  ASSERT_EQ(sut->getPageCount(), 1);
+  page::Header header = sut->getElement(tablespaceId, pageId)->getPageHandler().getPageHeader();
+  ASSERT_EQ(header.freeBegin, page::SLOT_SIZE);
+}
+
+TEST_F(BufPoolTest, evictWhenPoolIsFull) {
+  // Setup
+  tablespace_id tablespaceId = 1;
+  sut->deinit_buffer_pool();
+  sut->init_buffer_pool(0, 2);
+  sut->putPage(tablespaceId, page::PageHandler(0), "dummy");
+  sut->putPage(tablespaceId, page::PageHandler(1), "dummy");
+
+  // Exercise
+  sut->putPage(tablespaceId, page::PageHandler(2), "dummy");
+
+  // Verify
+  ASSERT_EQ(sut->getPageCount(), sut->getMaxPageCount());
+  ASSERT_FALSE(sut->existPage(tablespaceId, 0));
+  ASSERT_TRUE(sut->existPage(tablespaceId, 1));
+  ASSERT_TRUE(sut->existPage(tablespaceId, 2));
+}
+
+TEST_F(BufPoolTest, neverEvictPinnedPage) {
+  // Setup
+  tablespace_id tablespaceId = 1;
+  sut->deinit_buffer_pool();
+  sut->init_buffer_pool(0, 2);
+  buf::Element *pinned = sut->putPage(tablespaceId, page::PageHandler(0), "dummy");
+  pinned->refCount++;
+  sut->putPage(tablespaceId, page::PageHandler(1), "dummy");
+
+  // Exercise
+  sut->putPage(tablespaceId, page::PageHandler(2), "dummy");
+  sut->putPage(tablespaceId, page::PageHandler(3), "dummy");
+
+  // Verify
+  ASSERT_TRUE(sut->existPage(tablespaceId, 0));
+  ASSERT_TRUE(sut->existPage(tablespaceId, 3));
+  ASSERT_EQ(sut->getPageCount(), 2);
+
+  // all elements pinned
+  sut->getElement(tablespaceId, 3)->refCount++;
+  ASSERT_EQ(sut->putPage(tablespaceId, page::PageHandler(4), "dummy"), nullptr);
+}
+
+TEST_F(BufPoolTest, flushDirtyVictim) {
+  // Setup
+  char *path = tablespacePath;
+  tablespace_id tablespaceId = 1;
+  sut->deinit_buffer_pool();
+  sut->init_buffer_pool(0, 1);
+  uchar buf[] = {1, 2, 3, 4};
+  tuple::Tuple newTuple(4, 0, buf);
+  buf::WriteDescriptor writeDescriptor{tablespaceId, 0, path, &newTuple};
+  sut->write(buf, writeDescriptor);
+
+  // Exercise
+  sut->putPage(tablespaceId, page::PageHandler(1), path);
+
+  // Verify
+  ASSERT_FALSE(sut->existPage(tablespaceId, 0));
+  uchar readBuf[] = {0, 0, 0, 0};
+  buf::ReadDescriptor readDescriptor{tablespaceId, 0, 0, path};
+  ASSERT_EQ(sut->read(readBuf, readDescriptor), 4);
+  for (int i = 0; i < 4; i++) {
+    ASSERT_EQ(readBuf[i], buf[i]);
+  }
+}
+
+TEST_F(BufPoolTest, writeMarksPageDirty) {
+  // Setup
+  tablespace_id tablespaceId = 1;
+  uchar buf[] = {1, 1, 1, 1};
+  tuple::Tuple newTuple(4, 0, buf);
+  buf::WriteDescriptor writeDescriptor{tablespaceId, 2, tablespacePath, &newTuple};
+
+  // Exercise
+  sut->write(buf, writeDescriptor);
+  sut->write(buf, writeDescriptor);
+
+  // Verify
+  ASSERT_EQ(sut->getDirtyPageCount(), 1);
+  ASSERT_TRUE(sut->getElement(tablespaceId, 2)->dirty);
+  ASSERT_EQ(readPageFromFile(2).getPageHeader().tupleCount, 0);
+}
+
+TEST_F(BufPoolTest, flushDirtyPages) {
+  // Setup
+  tablespace_id tablespaceId = 1;
+  uchar buf[] = {1, 1, 1, 1};
+  tuple::Tuple newTuple(4, 0, buf);
+  for (page_id pageId : {3, 0, 1}) {
+    buf::WriteDescriptor writeDescriptor{tablespaceId, pageId, tablespacePath, &newTuple};
+    sut->write(buf, writeDescriptor);
+  }
+
+  // Exercise
+  uint64_t flushCount = sut->flushDirtyPages(2);
+
+  // Verify
+  ASSERT_EQ(flushCount, 2);
+  ASSERT_EQ(sut->getDirtyPageCount(), 1);
+  // flushed in page id order
+  ASSERT_EQ(readPageFromFile(0).getPageHeader().tupleCount, 1);
+  ASSERT_EQ(readPageFromFile(1).getPageHeader().tupleCount, 1);
+  ASSERT_EQ(readPageFromFile(3).getPageHeader().tupleCount, 0);
+  ASSERT_FALSE(sut->getElement(tablespaceId, 0)->dirty);
+  ASSERT_TRUE(sut->getElement(tablespaceId, 3)->dirty);
+}
+
+TEST_F(BufPoolTest, flushDirtyPagesKeepsFailedPages) {
+  // Setup
+  tablespace_id tablespaceId = 1;
+  uchar buf[] = {1, 1, 1, 1};
+  tuple::Tuple newTuple(4, 0, buf);
+  for (page_id pageId : {0, 1}) {
+    buf::WriteDescriptor writeDescriptor{tablespaceId, pageId, tablespacePath, &newTuple};
+    sut->write(buf, writeDescriptor);
+  }
+  lsn_t oldestLsn = sut->getElement(tablespaceId, 0)->oldestLsn;
+  // writes to the cached descriptor fail while it is open read only
+  int fd = sut->getTablespaceCache()
+               .get(tablespaceId, tablespacePath)
+               .getFileDescriptor();
+  int savedFd = dup(fd);
+  int readOnlyFd = open(tablespacePath, O_RDONLY);
+  ASSERT_EQ(dup2(readOnlyFd, fd), fd);
+
+  // Exercise
+  uint64_t failedCount = sut->flushDirtyPages(2);
+  dup2(savedFd, fd);
+  close(readOnlyFd);
+  close(savedFd);
+
+  // Verify
+  ASSERT_EQ(failedCount, 0);
+  ASSERT_EQ(sut->getDirtyPageCount(), 2);
+  ASSERT_TRUE(sut->getElement(tablespaceId, 0)->dirty);
+  ASSERT_EQ(sut->getElement(tablespaceId, 0)->oldestLsn, oldestLsn);
+  ASSERT_EQ(sut->getStats().pagesFlushed.load(), 0);
+  ASSERT_EQ(sut->flushDirtyPages(2), 2);
+  ASSERT_EQ(sut->getStats().pagesFlushed.load(), 2);
+  ASSERT_EQ(readPageFromFile(0).getPageHeader().tupleCount, 1);
+}
+
+TEST_F(BufPoolTest, pageCleanerFlushesInBackground) {
+  // Setup
+  tablespace_id tablespaceId = 1;
+  uchar buf[] = {1, 1, 1, 1};
+  tuple::Tuple newTuple(4, 0, buf);
+  buf::WriteDescriptor writeDescriptor{tablespaceId, 1, tablespacePath, &newTuple};
+  sut->startPageCleaner(buf::DEFAULT_FLUSH_RATE);
+
+  // Exercise
+  sut->write(buf, writeDescriptor);
+  for (int i = 0; i < 50 && sut->getDirtyPageCount() > 0; i++) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  }
+  sut->stopPageCleaner();
+
+  // Verify
+  ASSERT_EQ(sut->getDirtyPageCount(), 0);
+  ASSERT_EQ(readPageFromFile(1).getPageHeader().tupleCount, 1);
+}
+
+TEST_F(BufPoolTest, waitForPageCleanerWhenNoCleanElement) {
+  // Setup
+  tablespace_id tablespaceId = 1;
+  uchar buf[] = {1, 1, 1, 1};
+  tuple::Tuple newTuple(4, 0, buf);
+  sut->deinit_buffer_pool();
+  sut->init_buffer_pool(0, 2);
+  // a slow cleaner, so only demand from the foreground gets pages written
+  sut->startPageCleaner(1);
+  for (page_id pageId : {0, 1}) {
+    buf::WriteDescriptor writeDescriptor{tablespaceId, pageId, tablespacePath, &newTuple};
+    sut->write(buf, writeDescriptor);
+  }
+
+  // Exercise
+  buf::WriteDescriptor writeDescriptor{tablespaceId, 2, tablespacePath, &newTuple};
+  sut->write(buf, writeDescriptor);
+  sut->stopPageCleaner();
+
+  // Verify
+  ASSERT_EQ(sut->getPageCount(), 2);
+  ASSERT_TRUE(sut->existPage(tablespaceId, 2));
+  ASSERT_EQ(readPageFromFile(0).getPageHeader().tupleCount +
+                readPageFromFile(1).getPageHeader().tupleCount,
+            2);
+}
+
+TEST_F(BufPoolTest, deinitFlushesDirtyPages) {
+  // Setup
+  tablespace_id tablespaceId = 1;
+  uchar buf[] = {1, 1, 1, 1};
+  tuple::Tuple newTuple(4, 0, buf);
+  buf::WriteDescriptor writeDescriptor{tablespaceId, 0, tablespacePath, &newTuple};
+  sut->write(buf, writeDescriptor);
+
+  // Exercise
+  sut->deinit_buffer_pool();
+  sut->init_buffer_pool(0, 1024);
+
+  // Verify
+  ASSERT_EQ(readPageFromFile(0).getPageHeader().tupleCount, 1);
+}
+
+TEST_F(BufPoolTest, discardTablespace) {
+  // Setup
+  tablespace_id tablespaceId = 1;
+  uchar buf[] = {1, 1, 1, 1};
+  tuple::Tuple newTuple(4, 0, buf);
+  buf::WriteDescriptor writeDescriptor{tablespaceId, 0, tablespacePath, &newTuple};
+  sut->write(buf, writeDescriptor);
+  sut->putPage(tablespaceId + 1, page::PageHandler(0), "dummy");
+
+  // Exercise
+  sut->discardTablespace(tablespaceId);
+
+  // Verify
+  ASSERT_FALSE(sut->existPage(tablespaceId, 0));
+  ASSERT_TRUE(sut->existPage(tablespaceId + 1, 0));
+  ASSERT_EQ(sut->getDirtyPageCount(), 0);
+  ASSERT_EQ(readPageFromFile(0).getPageHeader().tupleCount, 0);
+}
+
+TEST_F(BufPoolTest, partitionIntoInstances) {
+  // Setup
+  sut->deinit_buffer_pool();
+
+  // Exercise
+  sut->init_buffer_pool(0, 1024, 4);
+  for (tablespace_id tablespaceId = 1; tablespaceId <= 4; tablespaceId++) {
+    for (page_id pageId = 0; pageId < 32; pageId++) {
+      sut->putPage(tablespaceId, page::PageHandler(pageId), "dummy");
+    }
+  }
+
+  // Verify
+  ASSERT_EQ(sut->getInstanceCount(), 4);
+  ASSERT_EQ(sut->getMaxPageCount(), 1024);
+  ASSERT_EQ(sut->getPageCount(), 128);
+  for (tablespace_id tablespaceId = 1; tablespaceId <= 4; tablespaceId++) {
+    for (page_id pageId = 0; pageId < 32; pageId++) {
+      ASSERT_TRUE(sut->existPage(tablespaceId, pageId));
+    }
+  }
+}
+
+TEST_F(BufPoolTest, adjacentPagesShareInstance) {
+  // Setup
+  sut->deinit_buffer_pool();
+  sut->init_buffer_pool(0, 8, 4);
+
+  // Exercise
+  for (page_id pageId = 0; pageId < buf::INSTANCE_PAGE_GROUP; pageId++) {
+    sut->putPage(1, page::PageHandler(pageId), "dummy");
+  }
+
+  // Verify
+  // the whole group competes for the 2 elements of a single instance
+  ASSERT_EQ(sut->getPageCount(), 2);
+  ASSERT_TRUE(sut->existPage(1, buf::INSTANCE_PAGE_GROUP - 1));
+}
+
+TEST_F(BufPoolTest, concurrentAccessToInstances) {
+  // Setup
+  sut->deinit_buffer_pool();
+  sut->init_buffer_pool(0, 64, 4);
+  constexpr int threadCount = 4;
+  constexpr int loopCount = 1000;
+
+  // Exercise
+  std::vector<std::thread> threads;
+  for (int t = 0; t < threadCount; t++) {
+    threads.emplace_back([this, t]() {
+      for (int i = 0; i < loopCount; i++) {
+        page_id pageId = (i * 7 + t) % 256;
+        sut->putPage(t + 1, page::PageHandler(pageId), "dummy");
+        sut->existPage(t + 1, pageId);
+      }
+    });
+  }
+  for (std::thread &thread : threads) {
+    thread.join();
+  }
+
+  // Verify
+  ASSERT_LE(sut->getPageCount(), sut->getMaxPageCount());
+}
+
+TEST_F(BufPoolTest, fixPagePinsUntilRelease) {
+  // Setup
+  tablespace_id tablespaceId = 1;
+
+  // Exercise
+  buf::PageGuard guard =
+      sut->fixPage(tablespaceId, 1, tablespacePath, buf::LatchMode::SHARED);
+
+  // Verify
+  ASSERT_TRUE(guard.isValid());
+  ASSERT_EQ(guard.getPageId(), 1);
+  ASSERT_EQ(sut->getElement(tablespaceId, 1)->refCount, 1);
+  guard.release();
+  ASSERT_FALSE(guard.isValid());
+  ASSERT_EQ(sut->getElement(tablespaceId, 1)->refCount, 0);
+}
+
+TEST_F(BufPoolTest, sharedGuardsCoexist) {
+  // Setup
+  tablespace_id tablespaceId = 1;
+  buf::PageGuard first =
+      sut->fixPage(tablespaceId, 0, tablespacePath, buf::LatchMode::SHARED);
+
+  // Exercise
+  buf::PageGuard second =
+      sut->fixPage(tablespaceId, 0, tablespacePath, buf::LatchMode::SHARED);
+
+  // Verify
+  ASSERT_TRUE(first.isValid());
+  ASSERT_TRUE(second.isValid());
+  ASSERT_EQ(sut->getElement(tablespaceId, 0)->refCount, 2);
+}
+
+TEST_F(BufPoolTest, moveGuardKeepsSinglePin) {
+  // Setup
+  tablespace_id tablespaceId = 1;
+  buf::PageGuard guard =
+      sut->fixPage(tablespaceId, 0, tablespacePath, buf::LatchMode::EXCLUSIVE);
+
+  // Exercise
+  buf::PageGuard moved = std::move(guard);
+  moved = sut->fixPage(tablespaceId, 1, tablespacePath, buf::LatchMode::EXCLUSIVE);
+
+  // Verify
+  ASSERT_FALSE(guard.isValid());
+  ASSERT_EQ(moved.getPageId(), 1);
+  ASSERT_EQ(sut->getElement(tablespaceId, 0)->refCount, 0);
+  ASSERT_EQ(sut->getElement(tablespaceId, 1)->refCount, 1);
+}
+
+TEST_F(BufPoolTest, exclusiveGuardBlocksSharedGuard) {
+  // Setup
+  tablespace_id tablespaceId = 1;
+  uchar buf[] = {1, 1, 1, 1};
+  tuple::Tuple newTuple(4, 0, buf);
+  buf::PageGuard writer =
+      sut->fixPage(tablespaceId, 0, tablespacePath, buf::LatchMode::EXCLUSIVE);
+  std::atomic<bool> fixed{false};
+  uint64_t tupleCount = 0;
+
+  // Exercise
+  std::thread reader([&]() {
+    buf::PageGuard guard =
+        sut->fixPage(tablespaceId, 0, tablespacePath, buf::LatchMode::SHARED);
+    fixed = true;
+    tupleCount = guard.getPageHandler().getPageHeader().tupleCount;
+  });
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  ASSERT_FALSE(fixed);
+  writer.getPageHandler().insert(newTuple);
+  writer.getPageHandler().getPage().incrementTupleCount();
+  writer.markDirty();
+  writer.release();
+  reader.join();
+
+  // Verify
+  ASSERT_TRUE(fixed);
+  ASSERT_EQ(tupleCount, 1);
+  ASSERT_EQ(sut->getDirtyPageCount(), 1);
+}
+
+TEST_F(BufPoolTest, giveUpWhenPageCleanerCannotWrite) {
+  // Setup
+  tablespace_id tablespaceId = 1;
+  uchar buf[] = {1, 1, 1, 1};
+  tuple::Tuple newTuple(4, 0, buf);
+  sut->deinit_buffer_pool();
+  sut->init_buffer_pool(0, 2);
+  sut->startPageCleaner(1);
+  for (page_id pageId : {0, 1}) {
+    buf::WriteDescriptor writeDescriptor{tablespaceId, pageId, tablespacePath, &newTuple};
+    sut->write(buf, writeDescriptor);
+  }
+  // writes to the cached descriptor fail while it is open read only
+  int fd = sut->getTablespaceCache()
+               .get(tablespaceId, tablespacePath)
+               .getFileDescriptor();
+  int savedFd = dup(fd);
+  int readOnlyFd = open(tablespacePath, O_RDONLY);
+  ASSERT_EQ(dup2(readOnlyFd, fd), fd);
+
+  // Exercise
+  buf::PageGuard guard =
+      sut->fixPage(tablespaceId, 2, tablespacePath, buf::LatchMode::SHARED);
+  dup2(savedFd, fd);
+  close(readOnlyFd);
+  close(savedFd);
+  sut->stopPageCleaner();
+
+  // Verify
+  ASSERT_FALSE(guard.isValid());
+  ASSERT_FALSE(sut->existPage(tablespaceId, 2));
+  ASSERT_EQ(sut->getDirtyPageCount(), 2);
+}
+
+TEST_F(BufPoolTest, waitForUnpinWhenEveryElementIsPinned) {
+  // Setup
+  tablespace_id tablespaceId = 1;
+  sut->deinit_buffer_pool();
+  sut->init_buffer_pool(0, 1);
+  buf::PageGuard scan =
+      sut->fixPage(tablespaceId, 0, tablespacePath, buf::LatchMode::SHARED);
+
+  // Exercise
+  std::thread releaser([&]() {
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    scan.release();
+  });
+  buf::PageGuard guard =
+      sut->fixPage(tablespaceId, 1, tablespacePath, buf::LatchMode::SHARED);
+  releaser.join();
+
+  // Verify
+  ASSERT_TRUE(guard.isValid());
+  ASSERT_FALSE(sut->existPage(tablespaceId, 0));
+}
+
+TEST_F(BufPoolTest, framesLiveInAlignedArena) {
+  // Setup
+  tablespace_id tablespaceId = 1;
+  sut->deinit_buffer_pool();
+  sut->init_buffer_pool(0, 8, 2);
+  const buf::FrameArena &arena = sut->getChunk(0);
+
+  // Exercise
+  for (page_id pageId = 0; pageId < 4; pageId++) {
+    sut->fixPage(tablespaceId, pageId, tablespacePath, buf::LatchMode::SHARED);
+  }
+
+  // Verify
+  ASSERT_EQ(arena.getFrameCount(), 8);
+  // aligned for direct I/O, pages larger than a memory page may not be
+  // aligned to their size
+  ASSERT_EQ(reinterpret_cast<uintptr_t>(arena.getFrame(0)) % file_config::IO_BLOCK_SIZE, 0);
+  for (page_id pageId = 0; pageId < 4; pageId++) {
+    uchar *image =
+        sut->getElement(tablespaceId, pageId)->getPageHandler().getPage().toBinary();
+    ASSERT_GE(image, arena.getFrame(0));
+    ASSERT_LE(image, arena.getFrame(7));
+    ASSERT_EQ((image - arena.getFrame(0)) % page::PAGE_SIZE, 0);
+    ASSERT_EQ(sut->getElement(tablespaceId, pageId)->getPageHandler().getPageHeader().id,
+              pageId);
+  }
+}
+
+TEST_F(BufPoolTest, hugePageArena) {
+  // Setup
+  sut->deinit_buffer_pool();
+
+  // Exercise
+  // explicit huge pages fall back to normal ones when none are reserved
+  ASSERT_TRUE(sut->init_buffer_pool(0, 16, 1, buf::HugePageMode::EXPLICIT));
+
+  // Verify
+  ASSERT_EQ(sut->getChunk(0).getRegionSize() % buf::HUGE_PAGE_SIZE, 0);
+  sut->putPage(1, page::PageHandler(0), "dummy");
+  ASSERT_TRUE(sut->existPage(1, 0));
+}
+
+TEST_F(BufPoolTest, prefetchPagesStopsAtEndOfFile) {
+  // Setup
+  tablespace_id tablespaceId = 1;
+
+  // Exercise
+  uint64_t readCount = sut->prefetchPages(tablespaceId, 1, 16, tablespacePath);
+
+  // Verify
+  ASSERT_EQ(readCount, 3);
+  ASSERT_EQ(sut->getReadAheadPageCount(), 3);
+  ASSERT_FALSE(sut->existPage(tablespaceId, 0));
+  ASSERT_TRUE(sut->existPage(tablespaceId, 3));
+  ASSERT_FALSE(sut->existPage(tablespaceId, 4));
+}
+
+TEST_F(BufPoolTest, pageMissesShareTablespaceFile) {
+  // Setup
+  tablespace_id tablespaceId = 1;
+
+  // Exercise
+  for (page_id pageId = 0; pageId < 4; pageId++) {
+    buf::PageGuard guard = sut->fixPage(tablespaceId, pageId, tablespacePath,
+                                        buf::LatchMode::SHARED);
+    ASSERT_TRUE(guard.isValid());
+  }
+
+  // Verify
+  ASSERT_EQ(sut->getTablespaceCache().getOpenFileCount(), 1);
+}
+
+TEST_F(BufPoolTest, fixPageOfMissingTablespace) {
+  // Exercise
+  buf::PageGuard guard =
+      sut->fixPage(2, 0, "./bufpool_missing", buf::LatchMode::SHARED);
+
+  // Verify
+  ASSERT_FALSE(guard.isValid());
+  ASSERT_FALSE(sut->existPage(2, 0));
+}
+
+TEST_F(BufPoolTest, concurrentMissesReadPageOnce) {
+  // Setup
+  tablespace_id tablespaceId = 1;
+  std::vector<std::thread> threads;
+
+  // Exercise
+  for (int i = 0; i < 8; i++) {
+    threads.emplace_back([&]() {
+      for (page_id pageId = 0; pageId < 4; pageId++) {
+        buf::PageGuard guard = sut->fixPage(tablespaceId, pageId,
+                                            tablespacePath,
+                                            buf::LatchMode::SHARED);
+        ASSERT_TRUE(guard.isValid());
+        ASSERT_EQ(guard.getPageHandler().getPageHeader().id, pageId);
+      }
+    });
+  }
+  for (std::thread &thread : threads) {
+    thread.join();
+  }
+
+  // Verify
+  // the other lookups of a page waited for its read
+  ASSERT_EQ(sut->getPageCount(), 4);
+  ASSERT_EQ(sut->getStats().bytesRead.load(), 4 * page::PAGE_SIZE);
+}
+
+TEST_F(BufPoolTest, fixPagePastEndOfFile) {
+  // Setup
+  tablespace_id tablespaceId = 1;
+
+  // Exercise
+  buf::PageGuard guard = sut->fixPage(tablespaceId, 10, tablespacePath,
+                                      buf::LatchMode::SHARED);
+
+  // Verify
+  ASSERT_FALSE(guard.isValid());
+  ASSERT_FALSE(sut->existPage(tablespaceId, 10));
+  ASSERT_EQ(sut->getPageCount(), 0);
+}
+
+TEST_F(BufPoolTest, prefetchPagesAroundCachedPage) {
+  // Setup
+  tablespace_id tablespaceId = 1;
+  sut->fixPage(tablespaceId, 1, tablespacePath, buf::LatchMode::SHARED);
+
+  // Exercise
+  uint64_t readCount = sut->prefetchPages(tablespaceId, 0, 4, tablespacePath);
+
+  // Verify
+  ASSERT_EQ(readCount, 3);
+  for (page_id pageId = 0; pageId < 4; pageId++) {
+    buf::PageGuard guard = sut->fixPage(tablespaceId, pageId, tablespacePath,
+                                        buf::LatchMode::SHARED);
+    ASSERT_EQ(guard.getPageId(), pageId);
+  }
+  ASSERT_EQ(sut->getStats().pageMisses.load(), 1);
+}
+
+TEST_F(BufPoolTest, readAheadHit) {
+  // Setup
+  tablespace_id tablespaceId = 1;
+  sut->prefetchPages(tablespaceId, 0, 2, tablespacePath);
+
+  // Exercise
+  sut->fixPage(tablespaceId, 0, tablespacePath, buf::LatchMode::SHARED);
+  sut->fixPage(tablespaceId, 0, tablespacePath, buf::LatchMode::SHARED);
+
+  // Verify
+  ASSERT_EQ(sut->getReadAheadHitCount(), 1);
+  ASSERT_EQ(sut->getReadAheadEvictedCount(), 0);
+}
+
+TEST_F(BufPoolTest, evictUnusedReadAheadPageFirst) {
+  // Setup
+  tablespace_id tablespaceId = 1;
+  sut->deinit_buffer_pool();
+  sut->init_buffer_pool(0, buf::LRU_OLD_MIN_LEN);
+  sut->setOldBlocksTime(0);
+  for (page_id pageId = 0; pageId < buf::LRU_OLD_MIN_LEN - 2; pageId++) {
+    sut->putPage(tablespaceId + 1, page::PageHandler(pageId), "dummy");
+  }
+  sut->fixPage(tablespaceId, 0, tablespacePath, buf::LatchMode::SHARED);
+  sut->fixPage(tablespaceId, 0, tablespacePath, buf::LatchMode::SHARED);
+  sut->prefetchPages(tablespaceId, 1, 1, tablespacePath);
+
+  // Exercise
+  for (page_id pageId = buf::LRU_OLD_MIN_LEN;
+       sut->existPage(tablespaceId, 1); pageId++) {
+    sut->putPage(tablespaceId + 1, page::PageHandler(pageId), "dummy");
+  }
+
+  // Verify
+  ASSERT_TRUE(sut->existPage(tablespaceId, 0));
+  ASSERT_EQ(sut->getReadAheadEvictedCount(), 1);
+}
+
+TEST_F(BufPoolTest, readAheadInBackground) {
+  // Setup
+  tablespace_id tablespaceId = 1;
+  sut->startReadAhead();
+
+  // Exercise
+  sut->readAhead(tablespaceId, 1, 3, tablespacePath);
+
+  // Verify
+  for (int i = 0; i < 100 && sut->getReadAheadPageCount() < 3; i++) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  sut->stopReadAhead();
+  ASSERT_EQ(sut->getReadAheadPageCount(), 3);
+  ASSERT_TRUE(sut->existPage(tablespaceId, 1));
+  ASSERT_TRUE(sut->existPage(tablespaceId, 3));
+}
+
+TEST_F(BufPoolTest, scanKeepsHotPages) {
+  // Setup
+  tablespace_id tablespaceId = 1;
+  tablespace_id scannedTablespaceId = 2;
+  sut->deinit_buffer_pool();
+  sut->init_buffer_pool(0, 2 * buf::LRU_OLD_MIN_LEN);
+  sut->setOldBlocksTime(0);
+  for (page_id pageId = 0; pageId < buf::LRU_OLD_MIN_LEN; pageId++) {
+    sut->putPage(scannedTablespaceId, page::PageHandler(pageId), "dummy");
+  }
+  for (page_id pageId = 0; pageId < 4; pageId++) {
+    sut->fixPage(tablespaceId, pageId, tablespacePath, buf::LatchMode::SHARED);
+    sut->fixPage(tablespaceId, pageId, tablespacePath, buf::LatchMode::SHARED);
+  }
+
+  // Exercise
+  // every scanned page is accessed once. A hot page is accessed far less
+  // often than the pool turns over, a plain LRU would evict it.
+  for (page_id pageId = buf::LRU_OLD_MIN_LEN;
+       pageId < 16 * buf::LRU_OLD_MIN_LEN; pageId++) {
+    sut->putPage(scannedTablespaceId, page::PageHandler(pageId), "dummy");
+    sut->fixPage(scannedTablespaceId, pageId, "dummy", buf::LatchMode::SHARED);
+    if (pageId % buf::LRU_OLD_MIN_LEN == 0) {
+      sut->fixPage(tablespaceId, pageId / buf::LRU_OLD_MIN_LEN % 4,
+                   tablespacePath, buf::LatchMode::SHARED);
+    }
+  }
+
+  // Verify
+  for (page_id pageId = 0; pageId < 4; pageId++) {
+    ASSERT_TRUE(sut->existPage(tablespaceId, pageId));
+  }
+  ASSERT_EQ(sut->getPageCount(), sut->getMaxPageCount());
+}
+
+TEST_F(BufPoolTest, makeYoungAfterOldBlocksTime) {
+  // Setup
+  tablespace_id tablespaceId = 1;
+  sut->deinit_buffer_pool();
+  sut->init_buffer_pool(0, 2 * buf::LRU_OLD_MIN_LEN);
+  sut->setOldBlocksTime(50);
+  for (page_id pageId = 0; pageId < 100; pageId++) {
+    sut->putPage(tablespaceId + 1, page::PageHandler(pageId), "dummy");
+  }
+  sut->fixPage(tablespaceId, 0, tablespacePath, buf::LatchMode::SHARED);
+
+  // Exercise
+  sut->fixPage(tablespaceId, 0, tablespacePath, buf::LatchMode::SHARED);
+  uint64_t youngMadeEarly = sut->getYoungMadeCount();
+  std::this_thread::sleep_for(std::chrono::milliseconds(60));
+  sut->fixPage(tablespaceId, 0, tablespacePath, buf::LatchMode::SHARED);
+
+  // Verify
+  ASSERT_EQ(youngMadeEarly, 0);
+  ASSERT_EQ(sut->getYoungMadeCount(), 1);
+}
+
+TEST_F(BufPoolTest, setOldBlocksPct) {
+  // Setup
+  sut->deinit_buffer_pool();
+  sut->init_buffer_pool(0, 2 * buf::LRU_OLD_MIN_LEN);
+  for (page_id pageId = 0; pageId < 100; pageId++) {
+    sut->putPage(2, page::PageHandler(pageId), "dummy");
+  }
+
+  // Exercise
+  sut->setOldBlocksPct(buf::MAX_OLD_BLOCKS_PCT);
+
+  // Verify
+  ASSERT_EQ(sut->getOldPageCount(), 95);
+}
+
+TEST_F(BufPoolTest, dumpAndLoadRestoresPages) {
+  // Setup
+  tablespace_id tablespaceId = 1;
+  const char *dumpPath = "./bufpool_test_dump";
+  for (page_id pageId = 0; pageId < 4; pageId++) {
+    sut->fixPage(tablespaceId, pageId, tablespacePath, buf::LatchMode::SHARED);
+  }
+  // a table dropped before the restart
+  sut->putPage(tablespaceId + 1, page::PageHandler(0), "dummy");
+  buf::BufPoolDump dump(sut, dumpPath);
+  dump.setDumpPct(100);
+  ASSERT_TRUE(dump.dump());
+  sut->deinit_buffer_pool();
+  sut->init_buffer_pool(0, 1024);
+  buf::BufPoolDump load(sut, dumpPath);
+
+  // Exercise
+  uint64_t readCount = load.load();
+
+  // Verify
+  ASSERT_EQ(readCount, 4);
+  for (page_id pageId = 0; pageId < 4; pageId++) {
+    ASSERT_TRUE(sut->existPage(tablespaceId, pageId));
+  }
+  ASSERT_FALSE(sut->existPage(tablespaceId + 1, 0));
+  ASSERT_EQ(sut->getReadAheadPageCount(), 0);
+  ASSERT_EQ(load.getLoadState(), buf::LoadState::COMPLETED);
+  ASSERT_EQ(load.getLoadedPageCount(), 5);
+  ASSERT_EQ(load.getLoadTotalPageCount(), 5);
+  std::remove(dumpPath);
+}
+
+TEST_F(BufPoolTest, loadWithoutDump) {
+  // Setup
+  buf::BufPoolDump sut2(sut, "./bufpool_test_no_dump");
+
+  // Exercise
+  uint64_t readCount = sut2.load();
+
+  // Verify
+  ASSERT_EQ(readCount, 0);
+  ASSERT_EQ(sut2.getLoadState(), buf::LoadState::COMPLETED);
+  ASSERT_EQ(sut->getPageCount(), 0);
+}
+
+TEST_F(BufPoolTest, dumpPctKeepsMostRecentlyUsedPages) {
+  // Setup
+  tablespace_id tablespaceId = 1;
+  const char *dumpPath = "./bufpool_test_dump";
+  for (page_id pageId = 0; pageId < 4; pageId++) {
+    sut->fixPage(tablespaceId, pageId, tablespacePath, buf::LatchMode::SHARED);
+  }
+  buf::BufPoolDump dump(sut, dumpPath);
+  dump.setDumpPct(50);
+
+  // Exercise
+  ASSERT_TRUE(dump.dump());
+
+  // Verify
+  sut->deinit_buffer_pool();
+  sut->init_buffer_pool(0, 1024);
+  buf::BufPoolDump load(sut, dumpPath);
+  ASSERT_EQ(load.load(), 2);
+  ASSERT_FALSE(sut->existPage(tablespaceId, 0));
+  ASSERT_FALSE(sut->existPage(tablespaceId, 1));
+  ASSERT_TRUE(sut->existPage(tablespaceId, 2));
+  ASSERT_TRUE(sut->existPage(tablespaceId, 3));
+  std::remove(dumpPath);
+}
+
+TEST_F(BufPoolTest, loadInBackground) {
+  // Setup
+  tablespace_id tablespaceId = 1;
+  const char *dumpPath = "./bufpool_test_dump";
+  sut->fixPage(tablespaceId, 2, tablespacePath, buf::LatchMode::SHARED);
+  buf::BufPoolDump dump(sut, dumpPath);
+  ASSERT_TRUE(dump.dump());
+  sut->deinit_buffer_pool();
+  sut->init_buffer_pool(0, 1024);
+  buf::BufPoolDump load(sut, dumpPath);
+
+  // Exercise
+  load.start(true, 0);
+
+  // Verify
+  for (int i = 0; i < 100 && load.getLoadState() != buf::LoadState::COMPLETED;
+       i++) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  load.stop();
+  ASSERT_EQ(load.getLoadState(), buf::LoadState::COMPLETED);
+  ASSERT_TRUE(sut->existPage(tablespaceId, 2));
+  std::remove(dumpPath);
+}
+
+TEST_F(BufPoolTest, growInChunks) {
+  // Setup
+  sut->deinit_buffer_pool();
+  sut->init_buffer_pool(0, 16, 2, buf::HugePageMode::OFF, 4);
+  ASSERT_EQ(sut->getChunkCount(), 2);
+
+  // Exercise
+  ASSERT_TRUE(sut->resize(26));
+
+  // Verify
+  // 13 pages per instance, the last chunk is partial
+  ASSERT_EQ(sut->getMaxPageCount(), 26);
+  ASSERT_EQ(sut->getChunkCount(), 4);
+  ASSERT_EQ(sut->getChunk(3).getFrameCount(), 2);
+}
+
+TEST_F(BufPoolTest, shrinkKeepsCachedPages) {
+  // Setup
+  tablespace_id tablespaceId = 1;
+  sut->deinit_buffer_pool();
+  sut->init_buffer_pool(0, 16, 1, buf::HugePageMode::OFF, 4);
+  // the first chunk is taken by pages used before
+  for (page_id pageId = 0; pageId < 4; pageId++) {
+    sut->putPage(tablespaceId + 1, page::PageHandler(pageId), "dummy");
+  }
+  for (page_id pageId = 0; pageId < 4; pageId++) {
+    buf::PageGuard guard = sut->fixPage(tablespaceId, pageId, tablespacePath,
+                                        buf::LatchMode::EXCLUSIVE);
+    guard.getPageHandler().getPage().incrementTupleCount();
+    guard.markDirty();
+  }
+
+  // Exercise
+  ASSERT_TRUE(sut->resize(4));
+
+  // Verify
+  ASSERT_EQ(sut->getMaxPageCount(), 4);
+  ASSERT_EQ(sut->getChunkCount(), 1);
+  uchar *chunkBegin = sut->getChunk(0).getFrame(0);
+  for (page_id pageId = 0; pageId < 4; pageId++) {
+    ASSERT_TRUE(sut->existPage(tablespaceId, pageId));
+    buf::Element *element = sut->getElement(tablespaceId, pageId);
+    ASSERT_GE(element->frame, chunkBegin);
+    ASSERT_LT(element->frame, chunkBegin + 4 * page::PAGE_SIZE);
+    ASSERT_EQ(element->getPageHandler().getPageHeader().id, pageId);
+    ASSERT_EQ(element->getPageHandler().getPageHeader().tupleCount, 1);
+  }
+  ASSERT_EQ(sut->getDirtyPageCount(), 4);
+}
+
+TEST_F(BufPoolTest, shrinkEvictsLeastRecentlyUsedPages) {
+  // Setup
+  tablespace_id tablespaceId = 1;
+  sut->deinit_buffer_pool();
+  sut->init_buffer_pool(0, 8, 1, buf::HugePageMode::OFF, 4);
+  for (page_id pageId = 0; pageId < 4; pageId++) {
+    sut->putPage(tablespaceId + 1, page::PageHandler(pageId), "dummy");
+  }
+  for (page_id pageId = 0; pageId < 4; pageId++) {
+    sut->fixPage(tablespaceId, pageId, tablespacePath, buf::LatchMode::SHARED);
+  }
+
+  // Exercise
+  ASSERT_TRUE(sut->resize(4));
+
+  // Verify
+  ASSERT_EQ(sut->getPageCount(), 4);
+  for (page_id pageId = 0; pageId < 4; pageId++) {
+    ASSERT_TRUE(sut->existPage(tablespaceId, pageId));
+    ASSERT_FALSE(sut->existPage(tablespaceId + 1, pageId));
+  }
+}
+
+TEST_F(BufPoolTest, shrinkWaitsForPinnedPage) {
+  // Setup
+  tablespace_id tablespaceId = 1;
+  sut->deinit_buffer_pool();
+  sut->init_buffer_pool(0, 8, 1, buf::HugePageMode::OFF, 4);
+  for (page_id pageId = 4; pageId < 8; pageId++) {
+    sut->putPage(tablespaceId + 1, page::PageHandler(pageId), "dummy");
+  }
+  buf::PageGuard guard = sut->fixPage(tablespaceId, 0, tablespacePath,
+                                      buf::LatchMode::SHARED);
+  std::atomic<bool> resized{false};
+
+  // Exercise
+  std::thread resizer([&]() {
+    sut->resize(4);
+    resized = true;
+  });
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  bool resizedWhilePinned = resized;
+  guard.release();
+  resizer.join();
+
+  // Verify
+  ASSERT_FALSE(resizedWhilePinned);
+  ASSERT_EQ(sut->getMaxPageCount(), 4);
+  ASSERT_TRUE(sut->existPage(tablespaceId, 0));
+}
+
+TEST_F(BufPoolTest, resizeInBackground) {
+  // Setup
+  sut->deinit_buffer_pool();
+  sut->init_buffer_pool(0, 8, 1, buf::HugePageMode::OFF, 4);
+  buf::BufPoolResizer resizer(sut);
+  resizer.start();
+
+  // Exercise
+  resizer.request(16);
+
+  // Verify
+  for (int i = 0;
+       i < 100 && resizer.getResizeState() != buf::ResizeState::COMPLETED; i++) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  resizer.stop();
+  ASSERT_EQ(resizer.getResizeState(), buf::ResizeState::COMPLETED);
+  ASSERT_EQ(sut->getMaxPageCount(), 16);
+}
+
+TEST_F(BufPoolTest, resizeWhileInUse) {
+  // Setup
+  tablespace_id tablespaceId = 1;
+  sut->deinit_buffer_pool();
+  sut->init_buffer_pool(0, 16, 2, buf::HugePageMode::OFF, 2);
+  std::atomic<bool> running{true};
+  std::vector<std::thread> readers;
+  for (int i = 0; i < 4; i++) {
+    readers.emplace_back([&, i]() {
+      for (uint64_t n = i; running; n++) {
+        buf::PageGuard guard = sut->fixPage(
+            tablespaceId, n % 4, tablespacePath, buf::LatchMode::SHARED);
+        ASSERT_EQ(guard.getPageId(), n % 4);
+        sut->putPage(tablespaceId + 1, page::PageHandler(n % 64), "dummy");
+      }
+    });
+  }
+
+  // Exercise
+  for (int round = 0; round < 10; round++) {
+    ASSERT_TRUE(sut->resize(round % 2 == 0 ? 4 : 32));
+  }
+  running = false;
+  for (std::thread &reader : readers) {
+    reader.join();
+  }
+
+  // Verify
+  ASSERT_EQ(sut->getMaxPageCount(), 32);
+  ASSERT_EQ(sut->getChunkCount(), 8);
+}
+
+TEST_F(BufPoolTest, countLookups) {
+  // Setup
+  tablespace_id tablespaceId = 1;
+
+  // Exercise
+  sut->fixPage(tablespaceId, 0, tablespacePath, buf::LatchMode::SHARED);
+  sut->fixPage(tablespaceId, 0, tablespacePath, buf::LatchMode::SHARED);
+  sut->fixPage(tablespaceId, 1, tablespacePath, buf::LatchMode::SHARED);
+
+  // Verify
+  const buf::BufPoolStats &stats = sut->getStats();
+  ASSERT_EQ(stats.pageLookups.load(), 3);
+  ASSERT_EQ(stats.pageHits.load(), 1);
+  ASSERT_EQ(stats.pageMisses.load(), 2);
+  ASSERT_EQ(stats.bytesRead.load(), 2 * page::PAGE_SIZE);
+}
+
+TEST_F(BufPoolTest, countFlushesAndEvictions) {
+  // Setup
+  tablespace_id tablespaceId = 1;
+  sut->deinit_buffer_pool();
+  sut->init_buffer_pool(0, 2);
+  for (page_id pageId = 0; pageId < 2; pageId++) {
+    buf::PageGuard guard = sut->fixPage(tablespaceId, pageId, tablespacePath,
+                                        buf::LatchMode::EXCLUSIVE);
+    guard.markDirty();
+  }
+  ASSERT_EQ(sut->getStats().pagesDirty.load(), 2);
+
+  // Exercise
+  sut->flushDirtyPages(1);
+  sut->fixPage(tablespaceId, 2, tablespacePath, buf::LatchMode::SHARED);
+
+  // Verify
+  const buf::BufPoolStats &stats = sut->getStats();
+  ASSERT_EQ(stats.pagesDirty.load(), 1);
+  ASSERT_EQ(stats.pagesFlushed.load(), 1);
+  ASSERT_EQ(stats.bytesWritten.load(), page::PAGE_SIZE);
+  ASSERT_EQ(stats.pagesEvicted.load(), 1);
+  ASSERT_TRUE(sut->existPage(tablespaceId, 1));
+}
+
+TEST(ShardedCounterTest, addFromManyThreads) {
+  // Setup
+  buf::ShardedCounter sut;
+  std::vector<std::thread> threads;
+
+  // Exercise
+  for (int i = 0; i < 8; i++) {
+    threads.emplace_back([&]() {
+      for (int n = 0; n < 1000; n++) {
+        sut.add();
+      }
+      sut.add(-10);
+    });
+  }
+  for (std::thread &thread : threads) {
+    thread.join();
+  }
+
+  // Verify
+  ASSERT_EQ(sut.load(), 8 * 990);
+}
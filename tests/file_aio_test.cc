@@ -0,0 +1,119 @@
+#include "file_aio.h"
+#include <gtest/gtest.h>
+#include <cstring>
+#include <memory>
+
+namespace {
+PSI_file_key aio_file_key_for_test;
+} // namespace
+
+class FileAioTest : public testing::Test {
+ protected:
+  std::unique_ptr<file_handler::AioEngine> sut;
+  const char *path = "./aio_dummy";
+  file_handler::File file;
+
+  void SetUp() override {
+    sut.reset(new file_handler::ThreadPoolAio(2, 4));
+    file = file_handler::File::create(path, aio_file_key_for_test);
+  }
+
+  void TearDown() override {
+    sut->stop();
+    file = file_handler::File();
+    std::remove(path);
+  }
+
+  file_handler::IoRequest request(file_handler::IoType type, uchar *buf,
+                                  size_t size, my_off_t offset,
+                                  file_handler::IoBatch &batch) {
+    return file_handler::IoRequest{
+        type, file.getFileDescriptor(), offset, {{buf, size}},
+        [&batch](size_t transferred) { batch.complete(transferred); }};
+  }
+};
+
+TEST_F(FileAioTest, writeAndReadInBackground) {
+  // Setup
+  uchar first[4] = {1, 2, 3, 4};
+  uchar second[4] = {5, 6, 7, 8};
+  file_handler::IoBatch writes;
+  std::vector<file_handler::IoRequest> requests;
+  requests.push_back(
+      request(file_handler::IoType::WRITE, first, sizeof(first), 0, writes));
+  requests.push_back(
+      request(file_handler::IoType::WRITE, second, sizeof(second), 4, writes));
+  writes.add(requests.size());
+  sut->submit(requests);
+  ASSERT_EQ(writes.wait(), 8);
+  uchar readValue[8] = {0};
+  file_handler::IoBatch reads;
+
+  // Exercise
+  requests.push_back(request(file_handler::IoType::READ, readValue,
+                             sizeof(readValue), 0, reads));
+  reads.add(requests.size());
+  sut->submit(requests);
+
+  // Verify
+  ASSERT_TRUE(requests.empty());
+  ASSERT_EQ(reads.wait(), 8);
+  uchar expected[8] = {1, 2, 3, 4, 5, 6, 7, 8};
+  ASSERT_EQ(memcmp(readValue, expected, 8), 0);
+}
+
+TEST_F(FileAioTest, readStopsAtEndOfFile) {
+  // Setup
+  uchar value[4] = {1, 2, 3, 4};
+  file.write(value, sizeof(value), 0);
+  uchar readValue[8] = {0};
+  file_handler::IoBatch batch;
+  std::vector<file_handler::IoRequest> requests;
+  requests.push_back(request(file_handler::IoType::READ, readValue,
+                             sizeof(readValue), 2, batch));
+
+  // Exercise
+  batch.add(requests.size());
+  sut->submit(requests);
+
+  // Verify
+  ASSERT_EQ(batch.wait(), 2);
+  ASSERT_EQ(readValue[0], 3);
+  ASSERT_EQ(readValue[1], 4);
+}
+
+TEST_F(FileAioTest, submitMoreRequestsThanQueueCapacity) {
+  // Setup
+  uchar values[64];
+  file_handler::IoBatch batch;
+  std::vector<file_handler::IoRequest> requests;
+  for (size_t i = 0; i < sizeof(values); i++) {
+    values[i] = i;
+    requests.push_back(
+        request(file_handler::IoType::WRITE, &values[i], 1, i, batch));
+  }
+
+  // Exercise
+  batch.add(requests.size());
+  sut->submit(requests);
+
+  // Verify
+  ASSERT_EQ(batch.wait(), sizeof(values));
+  uchar readValue[64] = {0};
+  ASSERT_EQ(file.read(readValue, sizeof(readValue), 0), sizeof(readValue));
+  ASSERT_EQ(memcmp(readValue, values, sizeof(values)), 0);
+}
+
+TEST(FileAioEngineTest, fallBackToThreads) {
+  // Setup
+  file_handler::AioConfig config;
+  config.useNativeAio = false;
+
+  // Exercise
+  std::unique_ptr<file_handler::AioEngine> sut(
+      file_handler::AioEngine::create(config));
+
+  // Verify
+  ASSERT_STREQ(sut->getName(), "threads");
+  sut->stop();
+}
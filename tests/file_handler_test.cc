@@ -3,6 +3,7 @@
 //
 #include "file_handler.h"
 #include <gtest/gtest.h>
+#include <cstring>
 #include <iostream>
 #include "mysql/psi/mysql_file.h"
 #include "template_utils.h"
@@ -50,6 +51,71 @@ TEST_F(FileHandlerTest, createAndOpenTest) {
   std::remove(path);
 }
 
+TEST_F(FileHandlerTest, moveTransfersDescriptor) {
+  // Setup
+  const char *path = "./dummy3";
+  file_handler::File file = file_handler::File::create(path, file_key_for_test);
+  file_handler::FileDescriptor fd = file.getFileDescriptor();
+
+  // Exercise
+  file_handler::File moved = std::move(file);
+
+  // Verify
+  ASSERT_EQ(moved.getFileDescriptor(), fd);
+  ASSERT_EQ(file.getFileDescriptor(), -1);
+
+  // Clean up
+  std::remove(path);
+}
+
+TEST_F(FileHandlerTest, readvAndWritevTest) {
+  // Setup
+  const char *path = "./dummy4";
+  file_handler::File sut = file_handler::File::create(path, file_key_for_test);
+  uchar first[4] = {1, 2, 3, 4};
+  uchar second[8] = {5, 6, 7, 8, 9, 10, 11, 12};
+  struct iovec writeIov[] = {{first, sizeof(first)}, {second, sizeof(second)}};
+  uchar readFirst[6] = {0};
+  uchar readSecond[6] = {0};
+  struct iovec readIov[] = {{readFirst, sizeof(readFirst)},
+                            {readSecond, sizeof(readSecond)}};
+
+  // Exercise
+  size_t writeSize = sut.writev(writeIov, 2, 16);
+  size_t readSize = sut.readv(readIov, 2, 16);
+
+  // Verify
+  ASSERT_EQ(writeSize, 12);
+  ASSERT_EQ(readSize, 12);
+  uchar expectedFirst[6] = {1, 2, 3, 4, 5, 6};
+  uchar expectedSecond[6] = {7, 8, 9, 10, 11, 12};
+  ASSERT_EQ(memcmp(readFirst, expectedFirst, 6), 0);
+  ASSERT_EQ(memcmp(readSecond, expectedSecond, 6), 0);
+
+  // Clean up
+  std::remove(path);
+}
+
+TEST_F(FileHandlerTest, readvStopsAtEndOfFile) {
+  // Setup
+  const char *path = "./dummy5";
+  file_handler::File sut = file_handler::File::create(path, file_key_for_test);
+  uchar value[4] = {1, 2, 3, 4};
+  sut.write(value, sizeof(value), 0);
+  uchar readValue[8] = {0};
+  struct iovec readIov[] = {{readValue, sizeof(readValue)}};
+
+  // Exercise
+  size_t readSize = sut.readv(readIov, 1, 2);
+
+  // Verify
+  ASSERT_EQ(readSize, 2);
+  ASSERT_EQ(readValue[0], 3);
+
+  // Clean up
+  std::remove(path);
+}
+
 TEST_F(FileHandlerTest, readAndWriteTest) {
   // Setup
   const char *path = "./dummy2";
@@ -0,0 +1,106 @@
+#include <gtest/gtest.h>
+#include "fsm_page.h"
+#include "page.h"
+
+class FsmPageTest : public testing::Test {
+ protected:
+  page::PageHandler *pageHandler;
+  page::FsmPage *sut;
+
+  void SetUp() override {
+    pageHandler = new page::PageHandler(page::FIRST_FSM_PAGE_ID);
+    sut = new page::FsmPage(*pageHandler);
+  }
+
+  void TearDown() override {
+    delete sut;
+    sut = nullptr;
+    delete pageHandler;
+    pageHandler = nullptr;
+  }
+};
+
+TEST_F(FsmPageTest, mapPagesToFsmPages) {
+  // Verify
+  ASSERT_EQ(page::getFsmPageId(0), page::FIRST_FSM_PAGE_ID);
+  ASSERT_EQ(page::getFsmPageId(page::FSM_LEAF_COUNT - 1),
+            page::FIRST_FSM_PAGE_ID);
+  ASSERT_EQ(page::getFsmPageId(page::FSM_LEAF_COUNT),
+            page::FSM_LEAF_COUNT + page::FIRST_FSM_PAGE_ID);
+  ASSERT_FALSE(page::isFsmPage(0));
+  ASSERT_TRUE(page::isFsmPage(page::FIRST_FSM_PAGE_ID));
+  ASSERT_TRUE(page::isFsmPage(page::FSM_LEAF_COUNT + page::FIRST_FSM_PAGE_ID));
+}
+
+TEST_F(FsmPageTest, categoryHasRoomForTuple) {
+  // Setup
+  uint32_t tupleSize = 1000;
+
+  // Exercise
+  uint8_t minCategory = page::toMinFsmCategory(tupleSize);
+
+  // Verify
+  ASSERT_GE(minCategory * page::FSM_CATEGORY_SIZE, tupleSize + page::SLOT_SIZE);
+  ASSERT_LT((minCategory - 1) * page::FSM_CATEGORY_SIZE,
+            tupleSize + page::SLOT_SIZE);
+  ASSERT_EQ(page::toFsmCategory(minCategory * page::FSM_CATEGORY_SIZE),
+            minCategory);
+  ASSERT_EQ(page::toFsmCategory(page::PAGE_BODY_SIZE),
+            page::FSM_CATEGORY_COUNT - 1);
+  ASSERT_GE(page::toMinFsmCategory(page::MAX_TUPLE_SIZE),
+            page::FSM_CATEGORY_COUNT);
+}
+
+TEST_F(FsmPageTest, emptyMapHasNoPage) {
+  // Exercise
+  page_id pageId = sut->findPage(page::FIRST_FSM_PAGE_ID, 1);
+
+  // Verify
+  ASSERT_EQ(pageId, page::MAX_PAGE_ID);
+}
+
+TEST_F(FsmPageTest, findPageWithCategory) {
+  // Setup
+  sut->setCategory(5, 3);
+  sut->setCategory(700, 9);
+  sut->setCategory(1500, 9);
+
+  // Exercise
+  page_id anyPage = sut->findPage(page::FIRST_FSM_PAGE_ID, 2);
+  page_id largePage = sut->findPage(page::FIRST_FSM_PAGE_ID, 4);
+  page_id noPage = sut->findPage(page::FIRST_FSM_PAGE_ID, 10);
+
+  // Verify
+  ASSERT_EQ(anyPage, 5);
+  ASSERT_EQ(largePage, 700);
+  ASSERT_EQ(noPage, page::MAX_PAGE_ID);
+  ASSERT_EQ(sut->getCategory(700), 9);
+}
+
+TEST_F(FsmPageTest, lowerCategory) {
+  // Setup
+  sut->setCategory(5, 3);
+  sut->setCategory(700, 9);
+
+  // Exercise
+  bool changed = sut->setCategory(700, 1);
+  bool unchanged = sut->setCategory(700, 1);
+
+  // Verify
+  ASSERT_TRUE(changed);
+  ASSERT_FALSE(unchanged);
+  ASSERT_EQ(sut->findPage(page::FIRST_FSM_PAGE_ID, 2), 5);
+  ASSERT_EQ(sut->findPage(page::FIRST_FSM_PAGE_ID, 4), page::MAX_PAGE_ID);
+}
+
+TEST_F(FsmPageTest, findPageOfLaterFsmPage) {
+  // Setup
+  page_id fsmPageId = 3 * page::FSM_LEAF_COUNT + page::FIRST_FSM_PAGE_ID;
+  sut->setCategory(3 * page::FSM_LEAF_COUNT + 10, 5);
+
+  // Exercise
+  page_id pageId = sut->findPage(fsmPageId, 5);
+
+  // Verify
+  ASSERT_EQ(pageId, 3 * page::FSM_LEAF_COUNT + 10);
+}
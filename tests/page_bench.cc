@@ -0,0 +1,174 @@
+//
+// Benchmarks for the page sizes the engine can be built with.
+// Run with --gtest_filter='Microbenchmarks.*' on an optimized build, the
+// tuples inserted or scanned per second are reported as MB/s.
+//
+#include <gtest/gtest.h>
+#include <cstdio>
+#include <memory>
+#include <vector>
+#include "file_handler.h"
+#include "file_util.h"
+#include "page.h"
+#include "tablespace.h"
+#include "unittest/gunit/benchmark.h"
+
+extern PSI_file_key tablespace_key;
+
+namespace {
+
+constexpr const char *PAGE_BENCH_PATH = "./page_bench";
+// the same table is split in pages of each size
+constexpr const uint64_t PAGE_BENCH_TABLE_SIZE = 4 * 1024 * 1024;
+constexpr const uint32_t PAGE_BENCH_TUPLE_SIZE = 100;
+
+template <int PageSize>
+using PageFrames = std::vector<std::unique_ptr<page::BasicAlignedPage<PageSize>>>;
+
+template <int PageSize>
+PageFrames<PageSize> allocateFrames(uint64_t frameCount) {
+  PageFrames<PageSize> frames;
+  for (uint64_t i = 0; i < frameCount; i++) {
+    frames.emplace_back(new page::BasicAlignedPage<PageSize>());
+  }
+  return frames;
+}
+
+// Fills every page of the table with tuples until none fits.
+template <int PageSize>
+uint64_t fillPages(PageFrames<PageSize> &frames, tuple::Tuple &tuple) {
+  page::Header emptyHeader =
+      page::BasicPageHandler<PageSize>(0).getPageHeader();
+  uint64_t tupleCount = 0;
+  for (page_id pageId = 0; pageId < frames.size(); pageId++) {
+    page::BasicPageHandler<PageSize> pageHandler =
+        page::BasicPageHandler<PageSize>::fromFrame(
+            reinterpret_cast<uchar *>(frames[pageId].get()));
+    pageHandler.getPageHeader() = emptyHeader;
+    pageHandler.getPageHeader().id = pageId;
+    while (pageHandler.hasSpace(tuple.getSize())) {
+      pageHandler.insert(tuple);
+      pageHandler.getPage().incrementTupleCount();
+      tupleCount++;
+    }
+  }
+  return tupleCount;
+}
+
+// Inserts into the pages of a table in memory, larger pages lose less
+// room to their headers and leftover space.
+template <int PageSize>
+void BM_PageInsert(size_t num_iterations) {
+  StopBenchmarkTiming();
+
+  PageFrames<PageSize> frames =
+      allocateFrames<PageSize>(PAGE_BENCH_TABLE_SIZE / PageSize);
+  std::vector<uchar> buf(PAGE_BENCH_TUPLE_SIZE, 1);
+  tuple::Tuple tuple(PAGE_BENCH_TUPLE_SIZE, 0, buf.data());
+
+  uint64_t tupleCount = 0;
+  StartBenchmarkTiming();
+  for (size_t i = 0; i < num_iterations; i++) {
+    tupleCount += fillPages<PageSize>(frames, tuple);
+  }
+  StopBenchmarkTiming();
+
+  SetBytesProcessed(tupleCount * PAGE_BENCH_TUPLE_SIZE);
+}
+
+// Scans the table from its file a page per read, as rnd_next() does, and
+// reads every tuple in place.
+template <int PageSize>
+void BM_PageScan(size_t num_iterations) {
+  StopBenchmarkTiming();
+
+  uint64_t pageCount = PAGE_BENCH_TABLE_SIZE / PageSize;
+  PageFrames<PageSize> frames = allocateFrames<PageSize>(pageCount);
+  std::vector<uchar> buf(PAGE_BENCH_TUPLE_SIZE, 1);
+  tuple::Tuple tuple(PAGE_BENCH_TUPLE_SIZE, 0, buf.data());
+  uint64_t tableTupleCount = fillPages<PageSize>(frames, tuple);
+  std::remove(PAGE_BENCH_PATH);
+  file_handler::File file =
+      file_handler::File::create(PAGE_BENCH_PATH, tablespace_key);
+  for (page_id pageId = 0; pageId < pageCount; pageId++) {
+    page::BasicPageHandler<PageSize>::fromFrame(
+        reinterpret_cast<uchar *>(frames[pageId].get()))
+        .flush(file.getFileDescriptor());
+  }
+  FileUtil::sync(file.getFileDescriptor());
+  uchar *frame = reinterpret_cast<uchar *>(frames[0].get());
+
+  uint64_t tupleCount = 0;
+  uint64_t checksum = 0;
+  StartBenchmarkTiming();
+  for (size_t i = 0; i < num_iterations; i++) {
+    for (page_id pageId = 0; pageId < pageCount; pageId++) {
+      page::BasicPageHandler<PageSize>::readPages(file.getFileDescriptor(),
+                                                  pageId, &frame, 1);
+      page::BasicPageHandler<PageSize> pageHandler =
+          page::BasicPageHandler<PageSize>::fromFrame(frame);
+      for (uint64_t cursor = 0; !pageHandler.isLastTuple(cursor); cursor++) {
+        checksum += pageHandler.viewTuple(cursor).getData()[0];
+        tupleCount++;
+      }
+    }
+  }
+  StopBenchmarkTiming();
+
+  EXPECT_EQ(tupleCount, num_iterations * tableTupleCount);
+  EXPECT_EQ(checksum, tupleCount);
+  SetBytesProcessed(tupleCount * PAGE_BENCH_TUPLE_SIZE);
+  file.remove(PAGE_BENCH_PATH);
+}
+
+void BM_PageInsert4k(size_t num_iterations) {
+  BM_PageInsert<4096>(num_iterations);
+}
+BENCHMARK(BM_PageInsert4k)
+
+void BM_PageInsert8k(size_t num_iterations) {
+  BM_PageInsert<8192>(num_iterations);
+}
+BENCHMARK(BM_PageInsert8k)
+
+void BM_PageInsert16k(size_t num_iterations) {
+  BM_PageInsert<16384>(num_iterations);
+}
+BENCHMARK(BM_PageInsert16k)
+
+void BM_PageInsert32k(size_t num_iterations) {
+  BM_PageInsert<32768>(num_iterations);
+}
+BENCHMARK(BM_PageInsert32k)
+
+void BM_PageInsert64k(size_t num_iterations) {
+  BM_PageInsert<65536>(num_iterations);
+}
+BENCHMARK(BM_PageInsert64k)
+
+void BM_PageScan4k(size_t num_iterations) {
+  BM_PageScan<4096>(num_iterations);
+}
+BENCHMARK(BM_PageScan4k)
+
+void BM_PageScan8k(size_t num_iterations) {
+  BM_PageScan<8192>(num_iterations);
+}
+BENCHMARK(BM_PageScan8k)
+
+void BM_PageScan16k(size_t num_iterations) {
+  BM_PageScan<16384>(num_iterations);
+}
+BENCHMARK(BM_PageScan16k)
+
+void BM_PageScan32k(size_t num_iterations) {
+  BM_PageScan<32768>(num_iterations);
+}
+BENCHMARK(BM_PageScan32k)
+
+void BM_PageScan64k(size_t num_iterations) {
+  BM_PageScan<65536>(num_iterations);
+}
+BENCHMARK(BM_PageScan64k)
+
+}  // namespace
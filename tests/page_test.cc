@@ -3,6 +3,7 @@
 //
 #include <gtest/gtest.h>
 #include <memory>
+#include <vector>
 #include "page.h"
 
 class PageTest : public testing::Test {
@@ -56,3 +57,81 @@ TEST_F(PageTest, readTuple) {
     ASSERT_EQ(*(res.getData() + i), 1);
   }
 }
+
+TEST_F(PageTest, viewTupleInPlace) {
+  // Setup
+  uint8_t tupleBody[] = {1, 2, 3, 4};
+  tuple::Tuple insertTuple = tuple::Tuple(4, 0, tupleBody);
+  sut->insert(insertTuple);
+
+  // Exercise
+  tuple::TupleView res = sut->viewTuple(0);
+
+  // Verify
+  ASSERT_EQ(res.getSize(), 4);
+  ASSERT_EQ(res.getData(), sut->getPageBody() + page::PAGE_BODY_SIZE - 4);
+  ASSERT_EQ(memcmp(res.getData(), tupleBody, 4), 0);
+}
+
+TEST_F(PageTest, fromFrameWorksInPlace) {
+  // Setup
+  std::vector<uchar> frame(page::PAGE_SIZE);
+  uint8_t tupleBody[] = {1, 1, 1, 1};
+  tuple::Tuple insertTuple = tuple::Tuple(4, 0, tupleBody);
+
+  // Exercise
+  page::PageHandler pageHandler = page::PageHandler::fromFrame(frame.data());
+  pageHandler = *sut;
+  pageHandler.insert(insertTuple);
+
+  // Verify
+  ASSERT_EQ(pageHandler.getPage().toBinary(), frame.data());
+  page::Page *framePage = reinterpret_cast<page::Page *>(frame.data());
+  ASSERT_EQ(framePage->header.id, 1);
+  ASSERT_EQ(framePage->header.freeBegin, 8);
+  ASSERT_EQ(sut->getPageHeader().freeBegin, 0);
+}
+
+TEST_F(PageTest, hasSpace) {
+  // Setup
+  std::vector<uint8_t> tupleBody(page::MAX_TUPLE_SIZE, 1);
+  tuple::Tuple insertTuple =
+      tuple::Tuple(page::MAX_TUPLE_SIZE, 0, tupleBody.data());
+
+  // Exercise
+  bool hasSpaceForLargest = sut->hasSpace(page::MAX_TUPLE_SIZE);
+  bool hasSpaceForLarger = sut->hasSpace(page::MAX_TUPLE_SIZE + 1);
+  sut->insert(insertTuple);
+
+  // Verify
+  ASSERT_TRUE(hasSpaceForLargest);
+  ASSERT_FALSE(hasSpaceForLarger);
+  ASSERT_FALSE(sut->hasSpace(1));
+}
+
+TEST_F(PageTest, insertIntoPaxPage) {
+  // Setup
+  tablespace::SystemPageHeaderImpl systemPage;
+  std::vector<uint32_t> columnSizes{4, 4};
+  systemPage.setLayout(tablespace::PageLayout::PAX, columnSizes.data(),
+                       columnSizes.size());
+  page::PageHandler paxPage = page::PageHandler::reserveNewPage(2, systemPage);
+  std::vector<uint8_t> tupleBody{1, 1, 1, 1, 2, 2, 2, 2};
+  tuple::Tuple insertTuple = tuple::Tuple(8, 0, tupleBody.data());
+  uint64_t freeEnd = paxPage.getPageHeader().freeEnd;
+
+  // Exercise
+  paxPage.insert(insertTuple);
+  paxPage.getPage().incrementTupleCount();
+
+  // Verify
+  ASSERT_TRUE(paxPage.isPax());
+  ASSERT_FALSE(sut->isPax());
+  ASSERT_EQ(paxPage.getPageHeader().freeEnd, freeEnd - 8);
+  ASSERT_FALSE(paxPage.isLastTuple(0));
+  ASSERT_TRUE(paxPage.isLastTuple(1));
+  ASSERT_FALSE(paxPage.hasSpace(4));
+  tuple::Tuple readTuple = paxPage.readTuple(0);
+  ASSERT_EQ(readTuple.getSize(), 8);
+  ASSERT_EQ(readTuple.getData()[4], 2);
+}
@@ -0,0 +1,85 @@
+#include <gtest/gtest.h>
+#include <vector>
+#include "page.h"
+#include "pax_page.h"
+
+class PaxPageTest : public testing::Test {
+ protected:
+  page::PageHandler *pageHandler;
+  page::PaxPage *sut;
+  std::vector<uint32_t> columnSizes{4, 8, 2};
+
+  void SetUp() override {
+    pageHandler = new page::PageHandler(0);
+    sut = new page::PaxPage(pageHandler->getPageBody());
+  }
+
+  void TearDown() override {
+    delete sut;
+    sut = nullptr;
+    delete pageHandler;
+    pageHandler = nullptr;
+  }
+};
+
+TEST_F(PaxPageTest, format) {
+  // Exercise
+  uint32_t capacity = sut->format(page::PAGE_BODY_SIZE, columnSizes.data(),
+                                  columnSizes.size());
+
+  // Verify
+  ASSERT_GT(capacity, 0);
+  ASSERT_EQ(capacity, page::PaxPage::computeCapacity(page::PAGE_BODY_SIZE,
+                                                     columnSizes.data(),
+                                                     columnSizes.size()));
+  ASSERT_EQ(sut->getCapacity(), capacity);
+  ASSERT_EQ(sut->getColumnCount(), 3);
+  ASSERT_EQ(sut->getRowSize(), 14);
+  ASSERT_EQ(sut->getColumnSize(1), 8);
+  // every minipage is on its own cache line and in the body
+  for (uint32_t column = 0; column < columnSizes.size(); column++) {
+    const uchar *first = sut->getValue(0, column);
+    ASSERT_EQ((first - pageHandler->getPageBody()) %
+                  page::PAX_MINIPAGE_ALIGNMENT,
+              0);
+    ASSERT_LE(sut->getValue(capacity, column),
+              pageHandler->getPageBody() + page::PAGE_BODY_SIZE);
+  }
+}
+
+TEST_F(PaxPageTest, insertSplitsRowIntoMinipages) {
+  // Setup
+  sut->format(page::PAGE_BODY_SIZE, columnSizes.data(), columnSizes.size());
+  std::vector<uint8_t> row{1, 1, 1, 1, 2, 2, 2, 2, 2, 2, 2, 2, 3, 3};
+  std::vector<uint8_t> read(row.size());
+
+  // Exercise
+  sut->insert(0, row.data());
+  sut->insert(1, row.data());
+
+  // Verify
+  ASSERT_EQ(sut->getValue(1, 0)[0], 1);
+  ASSERT_EQ(sut->getValue(1, 1)[7], 2);
+  ASSERT_EQ(sut->getValue(1, 2)[1], 3);
+  ASSERT_EQ(sut->getValue(1, 1), sut->getValue(0, 1) + 8);
+  ASSERT_EQ(sut->readRow(1, read.data()), row.size());
+  ASSERT_EQ(read, row);
+}
+
+TEST_F(PaxPageTest, refuseTooWideColumns) {
+  // Setup
+  std::vector<uint32_t> wideColumnSizes{page::PAGE_BODY_SIZE};
+  std::vector<uint32_t> manyColumnSizes(page::PAGE_BODY_SIZE /
+                                            page::PAX_MINIPAGE_ALIGNMENT,
+                                        1);
+
+  // Exercise
+  uint32_t wideCapacity = sut->format(
+      page::PAGE_BODY_SIZE, wideColumnSizes.data(), wideColumnSizes.size());
+  uint32_t manyCapacity = sut->format(
+      page::PAGE_BODY_SIZE, manyColumnSizes.data(), manyColumnSizes.size());
+
+  // Verify
+  ASSERT_EQ(wideCapacity, 0);
+  ASSERT_EQ(manyCapacity, 0);
+}
@@ -0,0 +1,83 @@
+//
+// Benchmarks for evaluating a pushed condition over the pages of a table.
+// Run with --gtest_filter='Microbenchmarks.*' on an optimized build, the
+// values compared per second are reported as MB/s.
+//
+#include <gtest/gtest.h>
+#include <cstring>
+#include <memory>
+#include <vector>
+#include "compare_kernel.h"
+#include "page.h"
+#include "predicate.h"
+#include "unittest/gunit/benchmark.h"
+
+namespace {
+
+constexpr const uint64_t PREDICATE_BENCH_PAGE_COUNT = 256;
+
+// PAX pages of an INT column and a DOUBLE column, full of rows
+std::vector<std::unique_ptr<page::PageHandler>> makePaxPages() {
+  tablespace::SystemPageHeaderImpl systemPage;
+  std::vector<uint32_t> columnSizes{4, 8};
+  systemPage.setLayout(tablespace::PageLayout::PAX, columnSizes.data(),
+                       columnSizes.size());
+  std::vector<std::unique_ptr<page::PageHandler>> pages;
+  std::vector<uint8_t> row(12);
+  for (page_id pageId = 0; pageId < PREDICATE_BENCH_PAGE_COUNT; pageId++) {
+    pages.emplace_back(new page::PageHandler(
+        page::PageHandler::reserveNewPage(pageId, systemPage)));
+    for (int32_t id = 0; pages.back()->hasSpace(row.size()); id++) {
+      memcpy(row.data(), &id, sizeof(id));
+      pages.back()->insert(tuple::Tuple(row.size(), 0, row.data()));
+      pages.back()->getPage().incrementTupleCount();
+    }
+  }
+  return pages;
+}
+
+// id > 100 over every page, with the kernels of isa
+void BM_PageFilter(size_t num_iterations, predicate::KernelIsa isa) {
+  StopBenchmarkTiming();
+
+  if (!predicate::isKernelIsaSupported(isa)) {
+    return;
+  }
+  std::vector<std::unique_ptr<page::PageHandler>> pages = makePaxPages();
+  predicate::PageFilter filter(
+      {predicate::Predicate{0, 0, predicate::ValueType::INT32,
+                            predicate::CompareOp::GT, 100, 0}},
+      predicate::getCompareKernels(isa));
+
+  uint64_t rowCount = 0;
+  uint64_t selectedCount = 0;
+  StartBenchmarkTiming();
+  for (size_t i = 0; i < num_iterations; i++) {
+    for (std::unique_ptr<page::PageHandler> &page : pages) {
+      filter.evaluate(*page);
+      rowCount += filter.getRowCount();
+      selectedCount += filter.getRowCount() - filter.nextSelectedRow(0);
+    }
+  }
+  StopBenchmarkTiming();
+
+  EXPECT_EQ(selectedCount, rowCount - num_iterations * pages.size() * 101);
+  SetBytesProcessed(rowCount * sizeof(int32_t));
+}
+
+void BM_PageFilterScalar(size_t num_iterations) {
+  BM_PageFilter(num_iterations, predicate::KernelIsa::SCALAR);
+}
+BENCHMARK(BM_PageFilterScalar)
+
+void BM_PageFilterSse42(size_t num_iterations) {
+  BM_PageFilter(num_iterations, predicate::KernelIsa::SSE42);
+}
+BENCHMARK(BM_PageFilterSse42)
+
+void BM_PageFilterAvx2(size_t num_iterations) {
+  BM_PageFilter(num_iterations, predicate::KernelIsa::AVX2);
+}
+BENCHMARK(BM_PageFilterAvx2)
+
+}  // namespace
@@ -0,0 +1,164 @@
+#include <gtest/gtest.h>
+#include <cstring>
+#include <random>
+#include <vector>
+#include "compare_kernel.h"
+#include "page.h"
+#include "predicate.h"
+
+class PredicateTest : public testing::Test {
+ protected:
+  const std::vector<predicate::KernelIsa> isas{predicate::KernelIsa::SCALAR,
+                                               predicate::KernelIsa::SSE42,
+                                               predicate::KernelIsa::AVX2};
+  const std::vector<predicate::CompareOp> ops{
+      predicate::CompareOp::EQ, predicate::CompareOp::NE,
+      predicate::CompareOp::LT, predicate::CompareOp::LE,
+      predicate::CompareOp::GT, predicate::CompareOp::GE};
+
+  // a row of an INT column and a DOUBLE column
+  std::vector<uint8_t> makeRow(int32_t id, double score) {
+    std::vector<uint8_t> row(12);
+    memcpy(row.data(), &id, sizeof(id));
+    memcpy(row.data() + sizeof(id), &score, sizeof(score));
+    return row;
+  }
+
+  void insertRows(page::PageHandler &pageHandler, uint64_t rowCount) {
+    for (uint64_t i = 0; i < rowCount; i++) {
+      std::vector<uint8_t> row = makeRow(i, i * 0.5);
+      pageHandler.insert(tuple::Tuple(row.size(), 0, row.data()));
+      pageHandler.getPage().incrementTupleCount();
+    }
+  }
+};
+
+TEST_F(PredicateTest, kernelsMatchScalar) {
+  // Setup
+  uint64_t count = 1000;
+  std::mt19937 random(42);
+  std::vector<int32_t> int32Values(count);
+  std::vector<int64_t> int64Values(count);
+  std::vector<double> doubleValues(count);
+  for (uint64_t i = 0; i < count; i++) {
+    int32Values[i] = random() % 100 - 50;
+    int64Values[i] = static_cast<int64_t>(int32Values[i]) << 33;
+    doubleValues[i] = int32Values[i] * 0.5;
+  }
+  const predicate::CompareKernels &scalar =
+      predicate::getCompareKernels(predicate::KernelIsa::SCALAR);
+
+  for (predicate::KernelIsa isa : isas) {
+    if (!predicate::isKernelIsaSupported(isa)) {
+      continue;
+    }
+    const predicate::CompareKernels &sut = predicate::getCompareKernels(isa);
+    for (predicate::CompareOp op : ops) {
+      // the bits past count are left set
+      std::vector<uint64_t> expected(count / 64 + 1, ~0ULL);
+      std::vector<uint64_t> int32Selection(expected);
+      std::vector<uint64_t> int64Selection(expected);
+      std::vector<uint64_t> doubleSelection(expected);
+
+      // Exercise
+      scalar.compareInt32(int32Values.data(), count, op, 7, expected.data());
+      sut.compareInt32(int32Values.data(), count, op, 7, int32Selection.data());
+      sut.compareInt64(int64Values.data(), count, op, 7LL << 33,
+                       int64Selection.data());
+      sut.compareDouble(doubleValues.data(), count, op, 3.5,
+                        doubleSelection.data());
+
+      // Verify
+      ASSERT_EQ(sut.isa, isa);
+      ASSERT_EQ(int32Selection, expected);
+      ASSERT_EQ(int64Selection, expected);
+      ASSERT_EQ(doubleSelection, expected);
+      ASSERT_EQ(expected.back() >> (count % 64), ~0ULL >> (count % 64));
+    }
+  }
+  ASSERT_TRUE(predicate::isKernelIsaSupported(
+      predicate::getCompareKernels().isa));
+}
+
+TEST_F(PredicateTest, filterRowPage) {
+  // Setup
+  page::PageHandler pageHandler(0);
+  insertRows(pageHandler, 100);
+  // id >= 10 AND score < 20.0
+  predicate::PageFilter sut({
+      predicate::Predicate{0, 0, predicate::ValueType::INT32,
+                           predicate::CompareOp::GE, 10, 0},
+      predicate::Predicate{1, 4, predicate::ValueType::DOUBLE,
+                           predicate::CompareOp::LT, 0, 20.0}});
+
+  // Exercise
+  sut.evaluate(pageHandler);
+
+  // Verify
+  ASSERT_EQ(sut.getRowCount(), 100);
+  ASSERT_EQ(sut.nextSelectedRow(0), 10);
+  ASSERT_TRUE(sut.isSelected(39));
+  ASSERT_FALSE(sut.isSelected(40));
+  ASSERT_EQ(sut.nextSelectedRow(40), 100);
+}
+
+TEST_F(PredicateTest, filterPaxPage) {
+  // Setup
+  tablespace::SystemPageHeaderImpl systemPage;
+  std::vector<uint32_t> columnSizes{4, 8};
+  systemPage.setLayout(tablespace::PageLayout::PAX, columnSizes.data(),
+                       columnSizes.size());
+  page::PageHandler pageHandler =
+      page::PageHandler::reserveNewPage(0, systemPage);
+  insertRows(pageHandler, 200);
+  // id > 70 AND id <> 100 AND score <= 90.0, the first compared in place
+  predicate::PageFilter sut({
+      predicate::Predicate{0, 0, predicate::ValueType::INT32,
+                           predicate::CompareOp::GT, 70, 0},
+      predicate::Predicate{0, 0, predicate::ValueType::INT32,
+                           predicate::CompareOp::NE, 100, 0},
+      predicate::Predicate{1, 4, predicate::ValueType::DOUBLE,
+                           predicate::CompareOp::LE, 0, 90.0}});
+
+  // Exercise
+  sut.evaluate(pageHandler);
+
+  // Verify
+  uint64_t selectedCount = 0;
+  for (uint64_t row = sut.nextSelectedRow(0); row < sut.getRowCount();
+       row = sut.nextSelectedRow(row + 1)) {
+    ASSERT_GT(row, 70);
+    ASSERT_NE(row, 100);
+    ASSERT_LE(row, 180);
+    selectedCount++;
+  }
+  ASSERT_EQ(selectedCount, 109);
+}
+
+TEST_F(PredicateTest, filterWidenedValues) {
+  // Setup
+  page::PageHandler pageHandler(0);
+  // a MEDIUMINT and a DATE, 3 bytes each
+  std::vector<std::vector<uint8_t>> rows{
+      {0xff, 0xff, 0xff, 0x21, 0xc8, 0x0f},  // -1, 2020-01-01
+      {0x05, 0x00, 0x00, 0x5f, 0xcb, 0x0f}}; // 5, 2021-10-31
+  for (std::vector<uint8_t> &row : rows) {
+    pageHandler.insert(tuple::Tuple(row.size(), 0, row.data()));
+    pageHandler.getPage().incrementTupleCount();
+  }
+  predicate::PageFilter negative({predicate::Predicate{
+      0, 0, predicate::ValueType::INT24, predicate::CompareOp::LT, 0, 0}});
+  predicate::PageFilter date({predicate::Predicate{
+      1, 3, predicate::ValueType::DATE, predicate::CompareOp::GT,
+      2020 * 512 + 12 * 32 + 31, 0}});
+
+  // Exercise
+  negative.evaluate(pageHandler);
+  date.evaluate(pageHandler);
+
+  // Verify
+  ASSERT_TRUE(negative.isSelected(0));
+  ASSERT_FALSE(negative.isSelected(1));
+  ASSERT_FALSE(date.isSelected(0));
+  ASSERT_TRUE(date.isSelected(1));
+}
@@ -0,0 +1,651 @@
+#include <gtest/gtest.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <string>
+#include <thread>
+#include <vector>
+#include "bufpool.h"
+#include "checkpointer.h"
+#include "file_util.h"
+#include "page.h"
+#include "pax_page.h"
+#include "redo_log.h"
+#include "redo_recovery.h"
+#include "tablespace.h"
+
+class RedoLogTest : public testing::Test {
+ protected:
+  redo::RedoLog *sut;
+  const char *logPath = "./redo_log_test";
+  char tablespacePath[24] = "./redo_log_tablespace";
+
+  void SetUp() override {
+    std::remove(logPath);
+    sut = new redo::RedoLog();
+    ASSERT_TRUE(sut->open(logPath));
+  }
+
+  void TearDown() override {
+    delete sut;
+    sut = nullptr;
+    std::remove(logPath);
+    std::remove(tablespacePath);
+  }
+
+  void reopen() {
+    delete sut;
+    sut = new redo::RedoLog();
+    ASSERT_TRUE(sut->open(logPath));
+  }
+
+  void createTablespace(tablespace_id tablespaceId, page_id pageCount) {
+    tablespace::TablespaceHandler tablespaceHandler =
+        tablespace::TablespaceHandler::create(tablespacePath, tablespaceId);
+    for (page_id pageId = 0; pageId < pageCount; pageId++) {
+      page::PageHandler::reserveNewPage(pageId).flush(
+          tablespaceHandler.getFileDescriptor());
+    }
+  }
+
+  // writes to the log fail until the returned descriptor is put back
+  int makeLogReadOnly() {
+    int savedFd = dup(sut->getFileDescriptor());
+    int readOnlyFd = open(logPath, O_RDONLY);
+    dup2(readOnlyFd, sut->getFileDescriptor());
+    close(readOnlyFd);
+    return savedFd;
+  }
+
+  void restoreLog(int savedFd) {
+    dup2(savedFd, sut->getFileDescriptor());
+    close(savedFd);
+  }
+
+  // the payloads are only valid while the reader is, keep a copy
+  std::vector<redo::LogRecord> readRecords(
+      std::vector<std::string> *payloads = nullptr) {
+    std::vector<redo::LogRecord> records;
+    redo::LogReader reader(sut->getFileDescriptor());
+    redo::LogRecord record;
+    while (reader.next(record)) {
+      if (payloads != nullptr) {
+        payloads->emplace_back(reinterpret_cast<const char *>(record.payload),
+                               record.payloadSize);
+      }
+      record.payload = nullptr;
+      records.push_back(record);
+    }
+    return records;
+  }
+};
+
+TEST_F(RedoLogTest, appendAndReadBack) {
+  // Setup
+  uchar tuple[] = {1, 2, 3, 4};
+
+  // Exercise
+  lsn_t first = sut->appendInsert(1, 0, tablespacePath, tuple, 4);
+  lsn_t second = sut->appendInsert(1, 2, tablespacePath, tuple, 2);
+  sut->commit();
+
+  // Verify
+  ASSERT_LT(first, second);
+  ASSERT_EQ(sut->getFlushedLsn(), second);
+  std::vector<std::string> payloads;
+  std::vector<redo::LogRecord> records = readRecords(&payloads);
+  ASSERT_EQ(records.size(), 3);
+  ASSERT_EQ(records[0].type, redo::RecordType::FILE_NAME);
+  ASSERT_STREQ(payloads[0].c_str(), tablespacePath);
+  ASSERT_EQ(records[2].type, redo::RecordType::INSERT);
+  ASSERT_EQ(records[2].pageId, 2);
+  ASSERT_EQ(records[2].payloadSize, 2);
+  ASSERT_EQ(records[2].lsn, second);
+}
+
+TEST_F(RedoLogTest, commitFailsWhenLogCannotBeWritten) {
+  // Setup
+  uchar tuple[] = {1, 2, 3, 4};
+  lsn_t flushedLsn = sut->getFlushedLsn();
+  lsn_t lsn = sut->appendInsert(1, 0, tablespacePath, tuple, 4);
+  int savedFd = makeLogReadOnly();
+
+  // Exercise
+  bool committed = sut->commit();
+  restoreLog(savedFd);
+
+  // Verify
+  ASSERT_FALSE(committed);
+  ASSERT_EQ(sut->getFlushedLsn(), flushedLsn);
+  // the log stays failed once the file can be written again
+  ASSERT_TRUE(sut->hasFailed());
+  ASSERT_FALSE(sut->commit());
+  sut->setDurability(redo::Durability::NONE);
+  ASSERT_FALSE(sut->commit());
+  ASSERT_EQ(sut->appendInsert(1, 1, tablespacePath, tuple, 4), lsn);
+  ASSERT_TRUE(readRecords().empty());
+}
+
+TEST_F(RedoLogTest, failedSyncIsNotRetried) {
+  // Setup
+  uchar tuple[] = {1, 2, 3, 4};
+  lsn_t lsn = sut->appendInsert(1, 0, tablespacePath, tuple, 4);
+  ASSERT_TRUE(sut->writeUpTo(lsn));
+  lsn_t flushedLsn = sut->getFlushedLsn();
+  // a pipe cannot be synced
+  int savedFd = dup(sut->getFileDescriptor());
+  int pipeFds[2];
+  ASSERT_EQ(pipe(pipeFds), 0);
+  dup2(pipeFds[0], sut->getFileDescriptor());
+
+  // Exercise
+  bool flushed = sut->flushUpTo(lsn);
+  restoreLog(savedFd);
+  close(pipeFds[0]);
+  close(pipeFds[1]);
+
+  // Verify
+  ASSERT_FALSE(flushed);
+  // a second sync could succeed without the records on disk
+  ASSERT_FALSE(sut->flushUpTo(lsn));
+  ASSERT_EQ(sut->getFlushedLsn(), flushedLsn);
+}
+
+TEST_F(RedoLogTest, reopenCutsOffTornRecord) {
+  // Setup
+  uchar tuple[] = {1, 2, 3, 4};
+  lsn_t lsn = sut->appendInsert(1, 0, tablespacePath, tuple, 4);
+  sut->commit();
+  // a record cut short by a crash
+  uchar torn[redo::RECORD_HEADER_SIZE + 2] = {0x12, 0x34, 0x56, 0x78, 4};
+  FileUtil::pwrite(sut->getFileDescriptor(), torn, sizeof(torn), lsn);
+
+  // Exercise
+  reopen();
+
+  // Verify
+  ASSERT_EQ(sut->getCurrentLsn(), lsn);
+  ASSERT_EQ(FileUtil::size(sut->getFileDescriptor()), lsn);
+  lsn_t next = sut->appendInsert(1, 1, tablespacePath, tuple, 4);
+  sut->commit();
+  // the tablespace is still named by the record before the torn one
+  std::vector<redo::LogRecord> records = readRecords();
+  ASSERT_EQ(records.size(), 3);
+  ASSERT_EQ(records.back().lsn, next);
+}
+
+TEST_F(RedoLogTest, durabilityNoneDoesNotSyncOnCommit) {
+  // Setup
+  uchar tuple[] = {1, 2, 3, 4};
+  sut->setDurability(redo::Durability::NONE);
+  uint64_t syncCount = sut->getSyncCount();
+
+  // Exercise
+  lsn_t lsn = sut->appendInsert(1, 0, tablespacePath, tuple, 4);
+  sut->commit();
+
+  // Verify
+  ASSERT_EQ(sut->getSyncCount(), syncCount);
+  ASSERT_LT(sut->getFlushedLsn(), lsn);
+  sut->flushUpTo(lsn);
+  ASSERT_EQ(sut->getFlushedLsn(), lsn);
+}
+
+TEST_F(RedoLogTest, concurrentCommitsShareSyncs) {
+  // Setup
+  int threadCount = 8;
+  int commitsPerThread = 50;
+  uchar tuple[64] = {0};
+  uint64_t syncCount = sut->getSyncCount();
+
+  // Exercise
+  std::vector<std::thread> threads;
+  for (int i = 0; i < threadCount; i++) {
+    threads.emplace_back([&, i]() {
+      for (int j = 0; j < commitsPerThread; j++) {
+        sut->appendInsert(i, j, tablespacePath, tuple, sizeof(tuple));
+        sut->commit();
+      }
+    });
+  }
+  for (std::thread &thread : threads) {
+    thread.join();
+  }
+
+  // Verify
+  ASSERT_EQ(sut->getFlushedLsn(), sut->getCurrentLsn());
+  ASSERT_LE(sut->getSyncCount() - syncCount, threadCount * commitsPerThread);
+  ASSERT_EQ(readRecords().size(),
+            threadCount * commitsPerThread + threadCount);
+}
+
+TEST_F(RedoLogTest, recoverUnflushedInsert) {
+  // Setup
+  tablespace_id tablespaceId = 1;
+  {
+    tablespace::TablespaceHandler tablespaceHandler =
+        tablespace::TablespaceHandler::create(tablespacePath, tablespaceId);
+    page::PageHandler::reserveNewPage(0).flush(
+        tablespaceHandler.getFileDescriptor());
+  }
+  buf::BufPool bufPool;
+  bufPool.init_buffer_pool(0, 16);
+  bufPool.setRedoLog(sut);
+  uchar buf[] = {1, 2, 3, 4};
+  tuple::Tuple newTuple(4, 0, buf);
+  buf::WriteDescriptor writeDescriptor{tablespaceId, 0, tablespacePath,
+                                       &newTuple};
+  bufPool.write(buf, writeDescriptor);
+  sut->commit();
+  // the page never reaches the file, as if the server crashed
+  bufPool.discardTablespace(tablespaceId);
+  bufPool.setRedoLog(nullptr);
+  bufPool.deinit_buffer_pool();
+  bufPool.init_buffer_pool(0, 16);
+  redo::RedoRecovery recovery(bufPool);
+
+  // Exercise
+  lsn_t lsn = recovery.recover(sut->getFileDescriptor());
+
+  // Verify
+  ASSERT_EQ(lsn, sut->getCurrentLsn());
+  ASSERT_EQ(recovery.getAppliedCount(), 1);
+  page::Header header =
+      bufPool.getElement(tablespaceId, 0)->getPageHandler().getPageHeader();
+  ASSERT_EQ(header.tupleCount, 1);
+  ASSERT_EQ(header.lsn, lsn);
+  // applying the log again leaves the page as it is
+  redo::RedoRecovery again(bufPool);
+  again.recover(sut->getFileDescriptor());
+  ASSERT_EQ(again.getAppliedCount(), 0);
+  bufPool.deinit_buffer_pool();
+}
+
+TEST_F(RedoLogTest, recoverInsertIntoPaxPage) {
+  // Setup
+  tablespace_id tablespaceId = 1;
+  std::vector<uint32_t> columnSizes{2, 2};
+  {
+    tablespace::TablespaceHandler tablespaceHandler =
+        tablespace::TablespaceHandler::create(tablespacePath, tablespaceId);
+    tablespace::SystemPageHeaderImpl &systemPage =
+        tablespaceHandler.getSystemPageHeader();
+    systemPage.setLayout(tablespace::PageLayout::PAX, columnSizes.data(),
+                         columnSizes.size());
+    tablespaceHandler.flushSystemPageHeader();
+    page::PageHandler::reserveNewPage(0, systemPage)
+        .flush(tablespaceHandler.getFileDescriptor());
+  }
+  buf::BufPool bufPool;
+  bufPool.init_buffer_pool(0, 16);
+  bufPool.setRedoLog(sut);
+  uchar buf[] = {1, 2, 3, 4};
+  tuple::Tuple newTuple(4, 0, buf);
+  buf::WriteDescriptor writeDescriptor{tablespaceId, 0, tablespacePath,
+                                       &newTuple};
+  bufPool.write(buf, writeDescriptor);
+  sut->commit();
+  // the page never reaches the file, as if the server crashed
+  bufPool.discardTablespace(tablespaceId);
+  bufPool.setRedoLog(nullptr);
+  bufPool.deinit_buffer_pool();
+  bufPool.init_buffer_pool(0, 16);
+  redo::RedoRecovery recovery(bufPool);
+
+  // Exercise
+  recovery.recover(sut->getFileDescriptor());
+
+  // Verify
+  ASSERT_EQ(recovery.getAppliedCount(), 1);
+  page::PageHandler &pageHandler =
+      bufPool.getElement(tablespaceId, 0)->getPageHandler();
+  ASSERT_TRUE(pageHandler.isPax());
+  ASSERT_EQ(pageHandler.getPageHeader().tupleCount, 1);
+  ASSERT_EQ(page::PaxPage(pageHandler.getPageBody()).getValue(0, 1)[1], 4);
+  bufPool.deinit_buffer_pool();
+}
+
+TEST_F(RedoLogTest, flushPageAfterItsRecords) {
+  // Setup
+  tablespace_id tablespaceId = 1;
+  {
+    tablespace::TablespaceHandler tablespaceHandler =
+        tablespace::TablespaceHandler::create(tablespacePath, tablespaceId);
+    page::PageHandler::reserveNewPage(0).flush(
+        tablespaceHandler.getFileDescriptor());
+  }
+  sut->setDurability(redo::Durability::NONE);
+  buf::BufPool bufPool;
+  bufPool.init_buffer_pool(0, 16);
+  bufPool.setRedoLog(sut);
+  uchar buf[] = {1, 2, 3, 4};
+  tuple::Tuple newTuple(4, 0, buf);
+  buf::WriteDescriptor writeDescriptor{tablespaceId, 0, tablespacePath,
+                                       &newTuple};
+  bufPool.write(buf, writeDescriptor);
+  sut->commit();
+  ASSERT_LT(sut->getFlushedLsn(), sut->getCurrentLsn());
+
+  // Exercise
+  bufPool.flushDirtyPages(1);
+
+  // Verify
+  ASSERT_EQ(sut->getFlushedLsn(), sut->getCurrentLsn());
+  bufPool.deinit_buffer_pool();
+}
+
+TEST_F(RedoLogTest, keepPageDirtyWhenItsRecordsFail) {
+  // Setup
+  tablespace_id tablespaceId = 1;
+  createTablespace(tablespaceId, 1);
+  sut->setDurability(redo::Durability::NONE);
+  buf::BufPool bufPool;
+  bufPool.init_buffer_pool(0, 16);
+  bufPool.setRedoLog(sut);
+  uchar buf[] = {1, 2, 3, 4};
+  tuple::Tuple newTuple(4, 0, buf);
+  buf::WriteDescriptor writeDescriptor{tablespaceId, 0, tablespacePath,
+                                       &newTuple};
+  bufPool.write(buf, writeDescriptor);
+  int savedFd = makeLogReadOnly();
+
+  // Exercise
+  uint64_t flushCount = bufPool.flushDirtyPages(1);
+  restoreLog(savedFd);
+
+  // Verify
+  ASSERT_EQ(flushCount, 0);
+  ASSERT_EQ(bufPool.getDirtyPageCount(), 1);
+  {
+    tablespace::TablespaceHandler tablespaceHandler(tablespacePath);
+    page::PageHandler pageHandler(0);
+    pageHandler.readFromFile(tablespaceHandler.getFileDescriptor());
+    ASSERT_EQ(pageHandler.getPageHeader().tupleCount, 0);
+  }
+  // nor once the file can be written again, the log failed
+  ASSERT_EQ(bufPool.flushDirtyPages(1), 0);
+  ASSERT_FALSE(bufPool.deinit_buffer_pool());
+}
+
+TEST_F(RedoLogTest, checkpointSurvivesReopen) {
+  // Setup
+  uchar tuple[] = {1, 2, 3, 4};
+  sut->appendInsert(1, 0, tablespacePath, tuple, 4);
+  lsn_t lsn = sut->appendInsert(1, 1, tablespacePath, tuple, 4);
+
+  // Exercise
+  ASSERT_TRUE(sut->writeCheckpoint(lsn));
+  reopen();
+
+  // Verify
+  ASSERT_EQ(sut->getCheckpointLsn(), lsn);
+  // the tablespace was named again at the checkpoint
+  redo::LogReader reader(sut->getFileDescriptor(), lsn);
+  redo::LogRecord record;
+  ASSERT_TRUE(reader.next(record));
+  ASSERT_EQ(record.type, redo::RecordType::FILE_NAME);
+  ASSERT_FALSE(reader.next(record));
+  // nothing new was logged, the next checkpoint names nothing
+  lsn_t currentLsn = sut->getCurrentLsn();
+  ASSERT_TRUE(sut->writeCheckpoint(currentLsn));
+  ASSERT_EQ(sut->getCurrentLsn(), currentLsn);
+  ASSERT_EQ(sut->getCheckpointLsn(), currentLsn);
+}
+
+TEST_F(RedoLogTest, checkpointStopsAtUnflushedPage) {
+  // Setup
+  tablespace_id tablespaceId = 1;
+  createTablespace(tablespaceId, 1);
+  buf::BufPool bufPool;
+  bufPool.init_buffer_pool(0, 16);
+  bufPool.setRedoLog(sut);
+  redo::Checkpointer checkpointer(&bufPool, sut);
+  uchar buf[] = {1, 2, 3, 4};
+  tuple::Tuple newTuple(4, 0, buf);
+  buf::WriteDescriptor writeDescriptor{tablespaceId, 0, tablespacePath,
+                                       &newTuple};
+  lsn_t lsn = sut->getCurrentLsn();
+  bufPool.write(buf, writeDescriptor);
+
+  // Exercise
+  ASSERT_TRUE(checkpointer.checkpoint());
+
+  // Verify
+  ASSERT_LE(sut->getCheckpointLsn(), lsn);
+  bufPool.flushAllDirtyPages();
+  ASSERT_TRUE(checkpointer.checkpoint());
+  ASSERT_GT(sut->getCheckpointLsn(), lsn);
+  bufPool.deinit_buffer_pool();
+}
+
+TEST_F(RedoLogTest, checkpointWaitsForTablespaceSync) {
+  // Setup
+  tablespace_id tablespaceId = 1;
+  createTablespace(tablespaceId, 1);
+  buf::BufPool bufPool;
+  bufPool.init_buffer_pool(0, 16);
+  bufPool.setRedoLog(sut);
+  redo::Checkpointer checkpointer(&bufPool, sut);
+  uchar buf[] = {1, 2, 3, 4};
+  tuple::Tuple newTuple(4, 0, buf);
+  buf::WriteDescriptor writeDescriptor{tablespaceId, 0, tablespacePath,
+                                       &newTuple};
+  lsn_t lsn = sut->getCurrentLsn();
+  bufPool.write(buf, writeDescriptor);
+  bufPool.flushAllDirtyPages();
+  // a pipe cannot be synced, the page stays in the OS cache only
+  int fd = bufPool.getTablespaceCache()
+               .get(tablespaceId, tablespacePath)
+               .getFileDescriptor();
+  int savedFd = dup(fd);
+  int pipeFds[2];
+  ASSERT_EQ(pipe(pipeFds), 0);
+  dup2(pipeFds[0], fd);
+
+  // Exercise
+  bool checkpointed = checkpointer.checkpoint();
+  dup2(savedFd, fd);
+  close(savedFd);
+  close(pipeFds[0]);
+  close(pipeFds[1]);
+
+  // Verify
+  ASSERT_FALSE(checkpointed);
+  ASSERT_LE(sut->getCheckpointLsn(), lsn);
+  // a sync that succeeds now proves nothing, the page may be lost
+  ASSERT_FALSE(checkpointer.checkpoint());
+  ASSERT_LE(sut->getCheckpointLsn(), lsn);
+  ASSERT_FALSE(bufPool.deinit_buffer_pool());
+}
+
+TEST_F(RedoLogTest, makeSpaceBoundsCheckpointAge) {
+  // Setup
+  tablespace_id tablespaceId = 1;
+  page_id pageCount = 128;
+  createTablespace(tablespaceId, pageCount);
+  sut->setDurability(redo::Durability::NONE);
+  buf::BufPool bufPool;
+  bufPool.init_buffer_pool(0, 256);
+  bufPool.setRedoLog(sut);
+  redo::Checkpointer checkpointer(&bufPool, sut,
+                                  redo::MIN_MAX_CHECKPOINT_AGE);
+  uchar buf[1024] = {0};
+  tuple::Tuple newTuple(sizeof(buf), 0, buf);
+  uint64_t recordSize = redo::RECORD_HEADER_SIZE + sizeof(buf);
+
+  // Exercise
+  for (page_id pageId = 0; pageId < pageCount; pageId++) {
+    checkpointer.makeSpace();
+    // Verify
+    ASSERT_LE(checkpointer.getAge(), redo::MIN_MAX_CHECKPOINT_AGE);
+    buf::WriteDescriptor writeDescriptor{tablespaceId, pageId,
+                                         tablespacePath, &newTuple};
+    ASSERT_EQ(bufPool.write(buf, writeDescriptor), buf::WriteResult::WRITTEN);
+    ASSERT_LE(checkpointer.getAge(),
+              redo::MIN_MAX_CHECKPOINT_AGE + recordSize);
+  }
+  ASSERT_GT(checkpointer.getSyncFlushCount(), 0);
+  ASSERT_LT(bufPool.getDirtyPageCount(), pageCount);
+  bufPool.deinit_buffer_pool();
+}
+
+TEST_F(RedoLogTest, recoverFromCheckpoint) {
+  // Setup
+  tablespace_id tablespaceId = 1;
+  createTablespace(tablespaceId, 2);
+  buf::BufPool bufPool;
+  bufPool.init_buffer_pool(0, 16);
+  bufPool.setRedoLog(sut);
+  redo::Checkpointer checkpointer(&bufPool, sut);
+  uchar buf[] = {1, 2, 3, 4};
+  tuple::Tuple newTuple(4, 0, buf);
+  buf::WriteDescriptor flushed{tablespaceId, 0, tablespacePath, &newTuple};
+  bufPool.write(buf, flushed);
+  bufPool.flushAllDirtyPages();
+  ASSERT_TRUE(checkpointer.checkpoint());
+  buf::WriteDescriptor unflushed{tablespaceId, 1, tablespacePath, &newTuple};
+  bufPool.write(buf, unflushed);
+  sut->commit();
+  // the second page never reaches the file, as if the server crashed
+  bufPool.discardTablespace(tablespaceId);
+  bufPool.setRedoLog(nullptr);
+  bufPool.deinit_buffer_pool();
+  reopen();
+  bufPool.init_buffer_pool(0, 16);
+  redo::RedoRecovery recovery(bufPool);
+
+  // Exercise
+  recovery.recover(sut->getFileDescriptor(), sut->getCheckpointLsn());
+
+  // Verify
+  ASSERT_EQ(recovery.getAppliedCount(), 1);
+  ASSERT_EQ(recovery.getSkippedCount(), 0);
+  page::Header header =
+      bufPool.getElement(tablespaceId, 1)->getPageHandler().getPageHeader();
+  ASSERT_EQ(header.tupleCount, 1);
+  bufPool.deinit_buffer_pool();
+}
+
+TEST_F(RedoLogTest, recoverWithWorkers) {
+  // Setup
+  tablespace_id tablespaceId = 1;
+  page_id pageCount = 200;
+  int insertsPerPage = 3;
+  createTablespace(tablespaceId, pageCount);
+  sut->setDurability(redo::Durability::NONE);
+  for (int i = 0; i < insertsPerPage; i++) {
+    for (page_id pageId = 0; pageId < pageCount; pageId++) {
+      uchar tuple[] = {static_cast<uchar>(i), 2, 3, 4};
+      sut->appendInsert(tablespaceId, pageId, tablespacePath, tuple, 4);
+    }
+  }
+  // a tablespace that was dropped since
+  uchar tuple[] = {1, 2, 3, 4};
+  sut->appendInsert(2, 0, "./redo_log_dropped", tuple, 4);
+  sut->flushUpTo(sut->getCurrentLsn());
+  buf::BufPool bufPool;
+  // room for every page in any instance, none is evicted
+  bufPool.init_buffer_pool(0, 1024, 4);
+  redo::RedoRecovery recovery(bufPool, 4);
+
+  // Exercise
+  lsn_t lsn = recovery.recover(sut->getFileDescriptor());
+
+  // Verify
+  ASSERT_EQ(lsn, sut->getCurrentLsn());
+  ASSERT_EQ(recovery.getAppliedCount(), pageCount * insertsPerPage);
+  ASSERT_EQ(recovery.getSkippedCount(), 1);
+  for (page_id pageId = 0; pageId < pageCount; pageId++) {
+    page::PageHandler &pageHandler =
+        bufPool.getElement(tablespaceId, pageId)->getPageHandler();
+    ASSERT_EQ(pageHandler.getPageHeader().tupleCount, insertsPerPage);
+    // in LSN order
+    for (int i = 0; i < insertsPerPage; i++) {
+      ASSERT_EQ(pageHandler.viewTuple(i).getData()[0], i);
+    }
+  }
+  bufPool.deinit_buffer_pool();
+}
+
+TEST_F(RedoLogTest, recoverSkipsTablespaceCreatedAtSamePath) {
+  // Setup
+  tablespace_id tablespaceId = 1;
+  createTablespace(tablespaceId, 1);
+  sut->setDurability(redo::Durability::NONE);
+  uchar tuple[] = {1, 2, 3, 4};
+  sut->appendInsert(tablespaceId, 0, tablespacePath, tuple, 4);
+  sut->flushUpTo(sut->getCurrentLsn());
+  // dropped and created again, as TRUNCATE does
+  std::remove(tablespacePath);
+  createTablespace(tablespaceId + 1, 1);
+  buf::BufPool bufPool;
+  bufPool.init_buffer_pool(0, 16);
+  redo::RedoRecovery recovery(bufPool);
+
+  // Exercise
+  lsn_t lsn = recovery.recover(sut->getFileDescriptor());
+
+  // Verify
+  ASSERT_EQ(lsn, sut->getCurrentLsn());
+  ASSERT_EQ(recovery.getAppliedCount(), 0);
+  ASSERT_EQ(recovery.getSkippedCount(), 1);
+  bufPool.deinit_buffer_pool();
+}
+
+TEST_F(RedoLogTest, recoverFailsWhenTablespaceCannotBeOpened) {
+  // Setup
+  tablespace_id tablespaceId = 1;
+  createTablespace(tablespaceId, 1);
+  sut->setDurability(redo::Durability::NONE);
+  uchar tuple[] = {1, 2, 3, 4};
+  sut->appendInsert(tablespaceId, 0, tablespacePath, tuple, 4);
+  sut->flushUpTo(sut->getCurrentLsn());
+  {
+    // still there, but of pages the pool cannot hold
+    tablespace::TablespaceHandler tablespaceHandler(tablespacePath);
+    tablespaceHandler.getTablespaceHeader() =
+        tablespace::TablespaceHeaderImpl(tablespaceId, page::PAGE_SIZE * 2);
+    tablespaceHandler.flushTablespaceHeader();
+  }
+  buf::BufPool bufPool;
+  bufPool.init_buffer_pool(0, 16);
+  redo::RedoRecovery recovery(bufPool);
+
+  // Exercise
+  lsn_t lsn = recovery.recover(sut->getFileDescriptor());
+
+  // Verify
+  ASSERT_EQ(lsn, LSN_MAX);
+  ASSERT_EQ(recovery.getAppliedCount(), 0);
+  bufPool.deinit_buffer_pool();
+}
+
+TEST_F(RedoLogTest, recoverNextPage) {
+  // Setup
+  tablespace_id tablespaceId = 1;
+  createTablespace(tablespaceId, 1);
+  buf::BufPool bufPool;
+  bufPool.init_buffer_pool(0, 16);
+  bufPool.setRedoLog(sut);
+  page_id newPageId = bufPool.allocatePage(tablespaceId, 0, tablespacePath);
+  sut->commit();
+  // the link never reaches the file, as if the server crashed
+  bufPool.discardTablespace(tablespaceId);
+  bufPool.setRedoLog(nullptr);
+  bufPool.deinit_buffer_pool();
+  reopen();
+  bufPool.init_buffer_pool(0, 16);
+  redo::RedoRecovery recovery(bufPool);
+
+  // Exercise
+  recovery.recover(sut->getFileDescriptor());
+
+  // Verify
+  ASSERT_EQ(newPageId, 2);
+  ASSERT_EQ(recovery.getAppliedCount(), 1);
+  ASSERT_EQ(bufPool.getElement(tablespaceId, 0)
+                ->getPageHandler()
+                .getPage()
+                .getNextPageId(),
+            newPageId);
+  bufPool.deinit_buffer_pool();
+}
@@ -0,0 +1,161 @@
+#include "tablespace_cache.h"
+#include <gtest/gtest.h>
+#include <filesystem>
+#include "file_util.h"
+#include "page.h"
+
+class TablespaceCacheTest : public testing::Test {
+ protected:
+  tablespace::TablespaceCache sut;
+  const char *path1 = "./cache1";
+  const char *path2 = "./cache2";
+  const char *path3 = "./cache3";
+
+  void SetUp() override {
+    tablespace::TablespaceHandler::create(path1, 1);
+    tablespace::TablespaceHandler::create(path2, 2);
+    tablespace::TablespaceHandler::create(path3, 3);
+    sut.init(2);
+  }
+
+  void TearDown() override {
+    sut.deinit();
+    for (const char *path : {path1, path2, path3}) {
+      if (std::filesystem::is_regular_file(path)) {
+        std::remove(path);
+      }
+    }
+  }
+};
+
+TEST_F(TablespaceCacheTest, shareOpenFile) {
+  // Setup
+  file_handler::FileDescriptor fd;
+  {
+    tablespace::TablespaceGuard guard = sut.open(path1);
+    ASSERT_TRUE(guard.isValid());
+    ASSERT_EQ(guard.getTablespaceId(), 1);
+    fd = guard.getFileDescriptor();
+  }
+
+  // Exercise
+  tablespace::TablespaceGuard guard = sut.get(1, path1);
+
+  // Verify
+  ASSERT_TRUE(guard.isValid());
+  ASSERT_EQ(guard.getFileDescriptor(), fd);
+  ASSERT_EQ(sut.getOpenFileCount(), 1);
+}
+
+TEST_F(TablespaceCacheTest, closeLeastRecentlyUsedFile) {
+  // Setup
+  sut.get(1, path1);
+  sut.get(2, path2);
+  sut.get(1, path1);
+
+  // Exercise
+  sut.get(3, path3);
+
+  // Verify
+  ASSERT_EQ(sut.getOpenFileCount(), 2);
+  // tablespace 2 was closed, reopening it closes tablespace 1
+  sut.get(2, path2);
+  sut.get(3, path3);
+  ASSERT_EQ(sut.getOpenFileCount(), 2);
+}
+
+TEST_F(TablespaceCacheTest, keepPinnedFilesOpen) {
+  // Setup
+  tablespace::TablespaceGuard guard1 = sut.get(1, path1);
+  tablespace::TablespaceGuard guard2 = sut.get(2, path2);
+
+  // Exercise
+  tablespace::TablespaceGuard guard3 = sut.get(3, path3);
+
+  // Verify
+  ASSERT_TRUE(guard3.isValid());
+  ASSERT_EQ(sut.getOpenFileCount(), 3);
+  guard1.release();
+  ASSERT_EQ(sut.getOpenFileCount(), 2);
+}
+
+TEST_F(TablespaceCacheTest, skipFileOfAnotherTablespace) {
+  // Exercise
+  tablespace::TablespaceGuard guard = sut.get(2, path1);
+
+  // Verify
+  ASSERT_FALSE(guard.isValid());
+  ASSERT_EQ(sut.getOpenFileCount(), 0);
+}
+
+TEST_F(TablespaceCacheTest, removeClosesAndDeletesFile) {
+  // Setup
+  sut.get(1, path1);
+
+  // Exercise
+  sut.remove(1, path1);
+
+  // Verify
+  ASSERT_EQ(sut.getOpenFileCount(), 0);
+  ASSERT_FALSE(std::filesystem::is_regular_file(path1));
+  ASSERT_FALSE(sut.get(1, path1).isValid());
+}
+
+TEST_F(TablespaceCacheTest, mapPagesInPlace) {
+  // Setup
+  tablespace::TablespaceGuard guard = sut.get(1, path1);
+  page::PageHandler pageHandler = page::PageHandler::reserveNewPage(1);
+  pageHandler.getPageHeader().tupleCount = 3;
+  page::PageHandler::reserveNewPage(0).flush(guard.getFileDescriptor());
+  pageHandler.flush(guard.getFileDescriptor());
+
+  // Exercise
+  std::shared_ptr<const tablespace::TablespaceMapping> mapping = guard.map(0);
+
+  // Verify
+  ASSERT_EQ(mapping->getPageCount(), 2);
+  ASSERT_EQ(mapping->getPage(2), nullptr);
+  page::PageHandler view = page::PageHandler::fromFrame(
+      const_cast<uchar *>(mapping->getPage(1)));
+  ASSERT_EQ(view.getPageHeader().id, 1);
+  ASSERT_EQ(view.getPageHeader().tupleCount, 3);
+}
+
+TEST_F(TablespaceCacheTest, mapAgainWhenFileGrew) {
+  // Setup
+  tablespace::TablespaceGuard guard = sut.get(1, path1);
+  page::PageHandler::reserveNewPage(0).flush(guard.getFileDescriptor());
+  std::shared_ptr<const tablespace::TablespaceMapping> first = guard.map(0);
+  page::PageHandler::reserveNewPage(1).flush(guard.getFileDescriptor());
+
+  // Exercise
+  std::shared_ptr<const tablespace::TablespaceMapping> cached = guard.map(0);
+  std::shared_ptr<const tablespace::TablespaceMapping> grown = guard.map(1);
+
+  // Verify
+  ASSERT_EQ(cached, first);
+  ASSERT_NE(grown, first);
+  ASSERT_EQ(first->getPageCount(), 1);
+  ASSERT_EQ(grown->getPageCount(), 2);
+}
+
+TEST_F(TablespaceCacheTest, refuseOtherPageSize) {
+  // Setup
+  {
+    tablespace::TablespaceHandler tablespaceHandler(path1);
+    uint64_t pageSize = page::PAGE_SIZE * 2;
+    FileUtil::pwrite(tablespaceHandler.getFileDescriptor(),
+                     reinterpret_cast<uchar *>(&pageSize), sizeof(pageSize),
+                     tablespace::TABLE_SPACE_HEADER_START_POSITION +
+                         offsetof(tablespace::TablespaceHeader, pageSize));
+  }
+
+  // Exercise
+  tablespace::TablespaceGuard opened = sut.open(path1);
+  tablespace::TablespaceGuard got = sut.get(1, path1);
+
+  // Verify
+  ASSERT_FALSE(opened.isValid());
+  ASSERT_FALSE(got.isValid());
+  ASSERT_EQ(sut.getOpenFileCount(), 0);
+}
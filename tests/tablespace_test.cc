@@ -3,6 +3,8 @@
 #include <gtest/gtest.h>
 #include <filesystem>
 #include <iostream>
+#include <vector>
+#include "page.h"
 #include "system_tablespace.h"
 
 class TablespaceTest : public testing::Test {
@@ -39,6 +41,7 @@ TEST_F(TablespaceTest, createAndOpenTablespace) {
   ASSERT_GT(sut->getFileDescriptor(), 0);
   ASSERT_EQ(sut->getTablespaceHeader().getId(), 1);
   ASSERT_EQ(sut->getTablespaceHeader().getPageCount(), 0);
+  ASSERT_EQ(sut->getTablespaceHeader().getPageSize(), page::PAGE_SIZE);
 }
 
 TEST_F(TablespaceTest, updateTablespaceHeader) {
@@ -56,6 +59,31 @@ TEST_F(TablespaceTest, updateTablespaceHeader) {
   ASSERT_EQ(sut->getTablespaceHeader().getPageCount(), 1);
 }
 
+TEST_F(TablespaceTest, recordPageLayout) {
+  // Setup
+  std::vector<uint32_t> columnSizes{4, 8};
+  {
+    tablespace::TablespaceHandler tablespaceHandler = tablespace::TablespaceHandler(path2);
+    ASSERT_EQ(tablespaceHandler.getSystemPageHeader().getLayout(),
+              tablespace::PageLayout::ROW);
+    ASSERT_TRUE(tablespaceHandler.getSystemPageHeader().setLayout(
+        tablespace::PageLayout::PAX, columnSizes.data(), columnSizes.size()));
+    tablespaceHandler.flushSystemPageHeader();
+  }
+
+  // Exercise
+  sut = new tablespace::TablespaceHandler(path2);
+
+  // Verify
+  tablespace::SystemPageHeaderImpl &systemPage = sut->getSystemPageHeader();
+  ASSERT_EQ(systemPage.getLayout(), tablespace::PageLayout::PAX);
+  ASSERT_EQ(systemPage.getColumnCount(), 2);
+  ASSERT_EQ(systemPage.getColumnSizes()[1], 8);
+  ASSERT_FALSE(systemPage.setLayout(tablespace::PageLayout::PAX,
+                                    columnSizes.data(),
+                                    tablespace::MAX_COLUMN_COUNT + 1));
+}
+
 TEST_F(TablespaceTest, removeTablespace) {
   // Setup
   sut = new tablespace::TablespaceHandler(path2);
@@ -67,3 +95,30 @@ TEST_F(TablespaceTest, removeTablespace) {
   bool existFile = std::filesystem::is_regular_file(path2);
   ASSERT_FALSE(existFile);
 }
+
+TEST_F(TablespaceTest, readAndWriteInDirectIoMode) {
+  // Setup
+  file_handler::setIoMode(file_handler::IoMode::DIRECT);
+  {
+    tablespace::TablespaceHandler tablespaceHandler =
+        tablespace::TablespaceHandler::create(path1, 1);
+    tablespaceHandler.getTablespaceHeader().incrementPageCount();
+    tablespaceHandler.flushTablespaceHeader();
+    page::PageHandler::reserveNewPage(0).flush(
+        tablespaceHandler.getFileDescriptor());
+  }
+
+  // Exercise
+  sut = new tablespace::TablespaceHandler(path1);
+  page::PageHandler pageHandler(0);
+  pageHandler.getPageHeader().tupleCount = 1;
+  pageHandler.readFromFile(sut->getFileDescriptor());
+  file_handler::setIoMode(file_handler::IoMode::BUFFERED);
+
+  // Verify
+  ASSERT_EQ(sut->getTablespaceHeader().getId(), 1);
+  ASSERT_EQ(sut->getTablespaceHeader().getPageCount(), 1);
+  ASSERT_EQ(pageHandler.getPageHeader().tupleCount, 0);
+  ASSERT_EQ(std::filesystem::file_size(path1),
+            page::PAGE_START_POSITION + page::PAGE_SIZE);
+}
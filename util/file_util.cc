@@ -4,6 +4,89 @@
 #include "file_util.h"
 
 #include <mysql/psi/mysql_file.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
+#include <climits>
+#include <vector>
+
+namespace {
+
+/**
+ * Reads or writes every byte of iov starting at offset, continuing after
+ * short transfers. Reads stop early at the end of the file.
+ * @return number of bytes transferred, MY_FILE_ERROR on error
+ */
+template <typename Transfer>
+size_t transferVectored(Transfer transfer, File fd, const struct iovec *iov,
+                        int iovcnt, my_off_t offset) {
+  // advanced past the transferred bytes, the caller's array is left as is
+  std::vector<struct iovec> remaining(iov, iov + iovcnt);
+  struct iovec *current = remaining.data();
+  int count = iovcnt;
+  size_t total = 0;
+  while (count > 0) {
+    ssize_t transferred =
+        transfer(fd, current, count < IOV_MAX ? count : IOV_MAX, offset + total);
+    if (transferred < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return MY_FILE_ERROR;
+    }
+    if (transferred == 0) {
+      break;
+    }
+    total += transferred;
+    size_t left = transferred;
+    while (count > 0 && left >= current->iov_len) {
+      left -= current->iov_len;
+      current++;
+      count--;
+    }
+    if (count > 0) {
+      current->iov_base = static_cast<char *>(current->iov_base) + left;
+      current->iov_len -= left;
+    }
+  }
+  return total;
+}
+
+#ifdef HAVE_PSI_FILE_INTERFACE
+size_t iovecSize(const struct iovec *iov, int iovcnt) {
+  size_t size = 0;
+  for (int i = 0; i < iovcnt; i++) {
+    size += iov[i].iov_len;
+  }
+  return size;
+}
+
+#endif
+
+/**
+ * Runs a vectored transfer as one PSI file wait, like mysql_file_pread()
+ * does for a single buffer.
+ */
+template <typename Transfer>
+size_t instrumentedTransfer(Transfer transfer, PSI_file_operation operation,
+                            File fd, const struct iovec *iov, int iovcnt,
+                            my_off_t offset) {
+#ifdef HAVE_PSI_FILE_INTERFACE
+  PSI_file_locker_state state;
+  PSI_file_locker *locker = PSI_FILE_CALL(get_thread_file_descriptor_locker)(
+      &state, fd, operation);
+  if (locker != nullptr) {
+    PSI_FILE_CALL(start_file_wait)(locker, iovecSize(iov, iovcnt), __FILE__,
+                                   __LINE__);
+    size_t result = transferVectored(transfer, fd, iov, iovcnt, offset);
+    PSI_FILE_CALL(end_file_wait)(locker, result == MY_FILE_ERROR ? 0 : result);
+    return result;
+  }
+#endif
+  return transferVectored(transfer, fd, iov, iovcnt, offset);
+}
+
+}
 
 
 // tableFilePath = "./[database]/[table].[ext]
@@ -35,6 +118,31 @@ size_t FileUtil::write(File fd, uchar *buf, int writeSize) {
   return mysql_file_write(fd, buf, writeSize, MYF(0));
 }
 
+/**
+ * Reads at offset without moving the file position, so that threads
+ * sharing a descriptor do not race on it.
+ */
+size_t FileUtil::pread(File fd, uchar *buf, size_t readSize, my_off_t offset) {
+  return mysql_file_pread(fd, buf, readSize, offset, MYF(0));
+}
+
+size_t FileUtil::pwrite(File fd, const uchar *buf, size_t writeSize, my_off_t offset) {
+  return mysql_file_pwrite(fd, buf, writeSize, offset, MYF(0));
+}
+
+/**
+ * Reads into the buffers of iov in order with a single syscall, starting
+ * at offset.
+ * @return number of bytes read, less than requested at the end of the file
+ */
+size_t FileUtil::preadv(File fd, const struct iovec *iov, int iovcnt, my_off_t offset) {
+  return instrumentedTransfer(::preadv, PSI_FILE_READ, fd, iov, iovcnt, offset);
+}
+
+size_t FileUtil::pwritev(File fd, const struct iovec *iov, int iovcnt, my_off_t offset) {
+  return instrumentedTransfer(::pwritev, PSI_FILE_WRITE, fd, iov, iovcnt, offset);
+}
+
 /**
  *
  * @param fd file descriptor
@@ -43,6 +151,48 @@ size_t FileUtil::write(File fd, uchar *buf, int writeSize) {
  * @param flags myf
  */
 void FileUtil::seek(File fd, my_off_t position, int whence, myf flags) {
-  mysql_file_seek(fd, 0, MY_SEEK_SET, flags);
   mysql_file_seek(fd, position, whence, flags);
 }
+
+my_off_t FileUtil::size(File fd) {
+  return mysql_file_seek(fd, 0, MY_SEEK_END, MYF(0));
+}
+
+/**
+ * Makes reads and writes of fd bypass the OS page cache.
+ * @return false if the file system does not support it
+ */
+bool FileUtil::setDirectIo(File fd) {
+#ifdef O_DIRECT
+  int flags = fcntl(fd, F_GETFL);
+  return flags != -1 && fcntl(fd, F_SETFL, flags | O_DIRECT) != -1;
+#else
+  return false;
+#endif
+}
+
+/**
+ * Forces the written data of fd to the device, without the metadata not
+ * needed to read it back (fdatasync where available).
+ */
+int FileUtil::sync(File fd) {
+  return mysql_file_sync(fd, MYF(0));
+}
+
+int FileUtil::truncate(File fd, my_off_t size) {
+  return ftruncate(fd, size);
+}
+
+/**
+ * Gives the blocks of [offset, offset + size) back to the file system.
+ * They read back as zeros and the size of the file is kept.
+ * @return false if the file system does not support it
+ */
+bool FileUtil::punchHole(File fd, my_off_t offset, my_off_t size) {
+#ifdef FALLOC_FL_PUNCH_HOLE
+  return fallocate(fd, FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE, offset,
+                   size) == 0;
+#else
+  return false;
+#endif
+}